@@ -13,4 +13,9 @@ AbstractWebSocket::AbstractWebSocket(QObject *parent)
 
 AbstractWebSocket::~AbstractWebSocket() = default;
 
+qint64 AbstractWebSocket::sendUtf8TextMessage(const QByteArray &message)
+{
+    return sendTextMessage(QString::fromUtf8(message));
+}
+
 #include "moc_abstractwebsocket.cpp"
@@ -20,6 +20,8 @@ public:
 
     virtual void openUrl(const QUrl &url) = 0;
     [[nodiscard]] virtual qint64 sendTextMessage(const QString &message) = 0;
+    // Sends an UTF-8 encoded text frame, returns the number of bytes sent
+    [[nodiscard]] virtual qint64 sendUtf8TextMessage(const QByteArray &message);
     virtual bool isValid() const = 0;
     virtual void flush() = 0;
     virtual void close() = 0;
@@ -35,7 +37,8 @@ public:
 Q_SIGNALS:
     void disconnected();
     void connected();
-    void textMessageReceived(const QString &message);
+    // UTF-8 encoded text frame
+    void textMessageReceived(const QByteArray &message);
     void sslErrors(const QList<QSslError> &errors);
     void socketError(QAbstractSocket::SocketError error, const QString &errorString);
 };
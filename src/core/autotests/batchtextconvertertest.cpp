@@ -0,0 +1,82 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "batchtextconvertertest.h"
+#include "batchtextconverter.h"
+#include "textconverter.h"
+#include <QTest>
+using namespace Qt::Literals::StringLiterals;
+
+QTEST_GUILESS_MAIN(BatchTextConverterTest)
+
+BatchTextConverterTest::BatchTextConverterTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void BatchTextConverterTest::shouldFindChunkEnd_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("startPosition");
+    QTest::addColumn<int>("chunkSize");
+    QTest::addColumn<int>("chunkEnd");
+
+    QTest::newRow("empty") << QString() << 0 << 10 << 0;
+    QTest::newRow("smaller-than-chunk") << u"foo bla"_s << 0 << 10 << 7;
+    QTest::newRow("paragraph") << u"foo bla\n\nfoo\nbla\n\nbla"_s << 0 << 4 << 7;
+    QTest::newRow("second-paragraph") << u"foo bla\n\nfoo\nbla\n\nbla"_s << 7 << 4 << 16;
+    QTest::newRow("line") << u"foo bla\nfoo bla\nfoo"_s << 0 << 4 << 7;
+    QTest::newRow("no-separator") << u"foo bla foo bla"_s << 0 << 4 << 7;
+    QTest::newRow("no-whitespace") << u"foobarfoobar"_s << 0 << 4 << 4;
+    QTest::newRow("no-whitespace-code-block-marker") << u"foo```bar"_s << 0 << 4 << 3;
+    QTest::newRow("code-block") << u"foo\n```\nbla\n\nbla\n```\n\nfoo"_s << 0 << 5 << 20;
+    QTest::newRow("code-block-not-closed") << u"foo\n```\nbla\n\nbla\nbla"_s << 0 << 2 << 3;
+    QTest::newRow("inside-code-block") << u"```\nfoo\nbar\nbaz\n```"_s << 0 << 4 << 7;
+}
+
+void BatchTextConverterTest::shouldFindChunkEnd()
+{
+    QFETCH(QString, text);
+    QFETCH(int, startPosition);
+    QFETCH(int, chunkSize);
+    QFETCH(int, chunkEnd);
+    QCOMPARE(BatchTextConverter::chunkEnd(text, startPosition, chunkSize), static_cast<qsizetype>(chunkEnd));
+}
+
+void BatchTextConverterTest::shouldSplitCodeBlock()
+{
+    const QString text = u"```cpp\nbar\nbaz\n```"_s;
+    const BatchTextConverter::TextChunk first = BatchTextConverter::textChunk(text, 0, {}, 8);
+    QCOMPARE(first.end, static_cast<qsizetype>(10));
+    QCOMPARE(first.text, u"```cpp\nbar\n```"_s);
+    QCOMPARE(first.openCodeBlockFence, u"```cpp"_s);
+
+    const BatchTextConverter::TextChunk second = BatchTextConverter::textChunk(text, first.end, first.openCodeBlockFence, 8);
+    QCOMPARE(second.end, text.size());
+    QCOMPARE(second.text, u"```cpp\nbaz\n```"_s);
+    QVERIFY(second.openCodeBlockFence.isEmpty());
+}
+
+void BatchTextConverterTest::shouldUseColorsOfSettings()
+{
+    // Worker threads must not read the color scheme
+    auto colors = std::make_shared<TextConverter::TextColors>();
+    colors->negativeText = QColor(0x12, 0x34, 0x56);
+    colors->negativeBackground = QColor(0x65, 0x43, 0x21);
+    BatchTextConverter::Settings settings;
+    settings.userName = u"foo"_s;
+    settings.colors = colors;
+
+    Message message;
+    message.setMessageId("msg1"_ba);
+    message.setText(u"hello @foo"_s);
+    const QList<BatchTextConverter::Result> results = BatchTextConverter::convertMessages(settings, {message});
+    QCOMPARE(results.count(), 1);
+    QCOMPARE(results.at(0).messageId, "msg1"_ba);
+    QVERIFY(results.at(0).convertedText.contains(u"color:#123456;background-color:#654321;"_s));
+}
+
+#include "moc_batchtextconvertertest.cpp"
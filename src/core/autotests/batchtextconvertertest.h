@@ -0,0 +1,22 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class BatchTextConverterTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchTextConverterTest(QObject *parent = nullptr);
+    ~BatchTextConverterTest() override = default;
+private Q_SLOTS:
+    void shouldFindChunkEnd_data();
+    void shouldFindChunkEnd();
+    void shouldSplitCodeBlock();
+    void shouldUseColorsOfSettings();
+};
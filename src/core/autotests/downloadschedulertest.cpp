@@ -0,0 +1,265 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "downloadschedulertest.h"
+#include "downloadscheduler.h"
+#include <QTest>
+
+QTEST_GUILESS_MAIN(DownloadSchedulerTest)
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+DownloadScheduler::Request createRequest(const QString &url, DownloadScheduler::Priority priority = DownloadScheduler::Priority::Attachment)
+{
+    DownloadScheduler::Request request;
+    request.url = QUrl(url);
+    request.localFileUrl = QUrl::fromLocalFile(u"/tmp/"_s + request.url.fileName());
+    request.priority = priority;
+    return request;
+}
+}
+
+DownloadSchedulerTest::DownloadSchedulerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void DownloadSchedulerTest::shouldHaveDefaultValues()
+{
+    DownloadScheduler scheduler;
+    QCOMPARE(scheduler.maximumDownloadsPerHost(), DownloadScheduler::defaultMaximumDownloadsPerHost);
+    QCOMPARE(scheduler.pendingCount(), 0);
+    QCOMPARE(scheduler.runningCount(u"foo.kde.org"_s), 0);
+    QVERIFY(scheduler.minimumRetryDelay() == DownloadScheduler::defaultMinimumRetryDelay);
+
+    const DownloadScheduler::Request request;
+    QVERIFY(request.url.isEmpty());
+    QVERIFY(request.localFileUrl.isEmpty());
+    QCOMPARE(request.mimeType, "text/plain"_ba);
+    QVERIFY(request.requiredAuthentication);
+    QCOMPARE(request.priority, DownloadScheduler::Priority::Attachment);
+    QVERIFY(!request.requester);
+    QVERIFY(!scheduler.currentRequester());
+}
+
+void DownloadSchedulerTest::shouldLimitDownloadsPerHost()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMaximumDownloadsPerHost(2);
+    QList<QUrl> started;
+    scheduler.setStartFunction([&started](const DownloadScheduler::Request &request) {
+        started.append(request.url);
+    });
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/1.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/2.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/3.png"_s));
+    // Other hosts have their own limit
+    scheduler.enqueue(createRequest(u"https://bla.kde.org/1.png"_s));
+    QCOMPARE(started.count(), 3);
+    QCOMPARE(scheduler.runningCount(u"foo.kde.org"_s), 2);
+    QCOMPARE(scheduler.runningCount(u"bla.kde.org"_s), 1);
+    QVERIFY(scheduler.isPending(QUrl(u"https://foo.kde.org/3.png"_s)));
+
+    scheduler.downloadFinished(QUrl(u"https://foo.kde.org/1.png"_s), true);
+    QCOMPARE(started.count(), 4);
+    QCOMPARE(started.last(), QUrl(u"https://foo.kde.org/3.png"_s));
+    QCOMPARE(scheduler.runningCount(u"foo.kde.org"_s), 2);
+    QCOMPARE(scheduler.pendingCount(), 0);
+}
+
+void DownloadSchedulerTest::shouldStartHighestPriorityFirst()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMaximumDownloadsPerHost(1);
+    QList<QUrl> started;
+    scheduler.setStartFunction([&started](const DownloadScheduler::Request &request) {
+        started.append(request.url);
+    });
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/running.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/preview.png"_s, DownloadScheduler::Priority::Preview));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/emoji.png"_s, DownloadScheduler::Priority::Emoji));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/avatar.png"_s, DownloadScheduler::Priority::Avatar));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/attachment.png"_s));
+    QCOMPARE(started.count(), 1);
+
+    const QStringList expected{u"attachment.png"_s, u"avatar.png"_s, u"emoji.png"_s, u"preview.png"_s};
+    for (const QString &fileName : expected) {
+        scheduler.downloadFinished(started.last(), true);
+        QCOMPARE(started.last().fileName(), fileName);
+    }
+}
+
+void DownloadSchedulerTest::shouldDownloadUrlOnce()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMaximumDownloadsPerHost(1);
+    QList<QUrl> started;
+    scheduler.setStartFunction([&started](const DownloadScheduler::Request &request) {
+        started.append(request.url);
+    });
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/1.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/1.png"_s));
+    QCOMPARE(started.count(), 1);
+    QVERIFY(scheduler.isRunning(QUrl(u"https://foo.kde.org/1.png"_s)));
+
+    // A pending request gets the highest priority requested
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/2.png"_s, DownloadScheduler::Priority::Avatar));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/3.png"_s, DownloadScheduler::Priority::Preview));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/3.png"_s, DownloadScheduler::Priority::Attachment));
+    QCOMPARE(scheduler.pendingCount(), 2);
+    scheduler.downloadFinished(QUrl(u"https://foo.kde.org/1.png"_s), true);
+    QCOMPARE(started.last(), QUrl(u"https://foo.kde.org/3.png"_s));
+
+    // Downloaded file can be downloaded again (e.g. cache was cleaned)
+    scheduler.downloadFinished(QUrl(u"https://foo.kde.org/3.png"_s), true);
+    scheduler.downloadFinished(QUrl(u"https://foo.kde.org/2.png"_s), true);
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/1.png"_s));
+    QCOMPARE(started.count(), 4);
+}
+
+void DownloadSchedulerTest::shouldCancelPendingDownloads()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMaximumDownloadsPerHost(1);
+    QList<QUrl> started;
+    scheduler.setStartFunction([&started](const DownloadScheduler::Request &request) {
+        started.append(request.url);
+    });
+    QObject view;
+    scheduler.setCurrentRequester(&view);
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/1.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/2.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/3.png"_s, DownloadScheduler::Priority::Avatar));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/4.png"_s, DownloadScheduler::Priority::Preview));
+    scheduler.setCurrentRequester(nullptr);
+
+    scheduler.cancel(QUrl(u"https://foo.kde.org/4.png"_s));
+    QVERIFY(!scheduler.isPending(QUrl(u"https://foo.kde.org/4.png"_s)));
+    // Running download is not cancelled
+    scheduler.cancelPending(&view, DownloadScheduler::Priority::Attachment);
+    QVERIFY(scheduler.isRunning(QUrl(u"https://foo.kde.org/1.png"_s)));
+    QCOMPARE(scheduler.pendingCount(), 1);
+
+    scheduler.downloadFinished(QUrl(u"https://foo.kde.org/1.png"_s), true);
+    QCOMPARE(started.last(), QUrl(u"https://foo.kde.org/3.png"_s));
+    QCOMPARE(scheduler.pendingCount(), 0);
+
+    // Cancelled url can be requested again
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/2.png"_s));
+    QCOMPARE(scheduler.pendingCount(), 1);
+}
+
+void DownloadSchedulerTest::shouldCancelOnlyRequesterDownloads()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMaximumDownloadsPerHost(1);
+    scheduler.setStartFunction([](const DownloadScheduler::Request &) { });
+    QObject view;
+    QObject otherView;
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/running.png"_s));
+
+    scheduler.setCurrentRequester(&view);
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/view.png"_s));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/shared.png"_s));
+    // Explicit downloads are not cancelled by the view which displays them too
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/explicit.png"_s));
+    scheduler.setCurrentRequester(&otherView);
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/shared.png"_s));
+    scheduler.setCurrentRequester(nullptr);
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/explicit.png"_s, DownloadScheduler::Priority::Explicit));
+    scheduler.enqueue(createRequest(u"https://foo.kde.org/other.png"_s));
+    QCOMPARE(scheduler.pendingCount(), 4);
+
+    scheduler.cancelPending(&view, DownloadScheduler::Priority::Attachment);
+    QCOMPARE(scheduler.pendingCount(), 3);
+    QVERIFY(!scheduler.isPending(QUrl(u"https://foo.kde.org/view.png"_s)));
+    QVERIFY(scheduler.isPending(QUrl(u"https://foo.kde.org/shared.png"_s)));
+    QVERIFY(scheduler.isPending(QUrl(u"https://foo.kde.org/explicit.png"_s)));
+    QVERIFY(scheduler.isPending(QUrl(u"https://foo.kde.org/other.png"_s)));
+
+    // Requests without requester are never cancelled
+    scheduler.cancelPending(nullptr, DownloadScheduler::Priority::Attachment);
+    QCOMPARE(scheduler.pendingCount(), 3);
+}
+
+void DownloadSchedulerTest::shouldNotRetryFailedDownloads()
+{
+    DownloadScheduler scheduler;
+    int startCount = 0;
+    scheduler.setStartFunction([&startCount](const DownloadScheduler::Request &) {
+        ++startCount;
+    });
+    const QUrl url(u"https://foo.kde.org/1.png"_s);
+    scheduler.enqueue(createRequest(url.toString()));
+    scheduler.downloadFinished(url, false);
+    QVERIFY(scheduler.hasFailed(url));
+    QCOMPARE(scheduler.runningCount(u"foo.kde.org"_s), 0);
+    scheduler.enqueue(createRequest(url.toString()));
+    QCOMPARE(startCount, 1);
+
+    // Finishing twice (done then destroyed) is ignored
+    const QUrl otherUrl(u"https://foo.kde.org/2.png"_s);
+    scheduler.enqueue(createRequest(otherUrl.toString()));
+    scheduler.downloadFinished(otherUrl, true);
+    scheduler.downloadFinished(otherUrl, false);
+    QVERIFY(!scheduler.hasFailed(otherUrl));
+}
+
+void DownloadSchedulerTest::shouldRetryFailedDownloads()
+{
+    DownloadScheduler scheduler;
+    int startCount = 0;
+    scheduler.setStartFunction([&startCount](const DownloadScheduler::Request &) {
+        ++startCount;
+    });
+    const QUrl url(u"https://foo.kde.org/1.png"_s);
+    scheduler.enqueue(createRequest(url.toString()));
+    scheduler.downloadFinished(url, false);
+
+    // Requested by the user
+    scheduler.enqueue(createRequest(url.toString(), DownloadScheduler::Priority::Explicit));
+    QCOMPARE(startCount, 2);
+    QVERIFY(!scheduler.hasFailed(url));
+    scheduler.downloadFinished(url, false);
+    QVERIFY(scheduler.hasFailed(url));
+
+    // Network is back
+    scheduler.clearFailedUrls();
+    QVERIFY(!scheduler.hasFailed(url));
+    scheduler.enqueue(createRequest(url.toString()));
+    QCOMPARE(startCount, 3);
+}
+
+void DownloadSchedulerTest::shouldRetryFailedDownloadsAfterDelay()
+{
+    DownloadScheduler scheduler;
+    scheduler.setMinimumRetryDelay(std::chrono::milliseconds(0));
+    int startCount = 0;
+    scheduler.setStartFunction([&startCount](const DownloadScheduler::Request &) {
+        ++startCount;
+    });
+    const QUrl url(u"https://foo.kde.org/1.png"_s);
+    scheduler.enqueue(createRequest(url.toString()));
+    scheduler.downloadFinished(url, false);
+    // Delay expired
+    QVERIFY(!scheduler.hasFailed(url));
+    scheduler.enqueue(createRequest(url.toString()));
+    QCOMPARE(startCount, 2);
+    scheduler.downloadFinished(url, true);
+    QVERIFY(!scheduler.hasFailed(url));
+}
+
+void DownloadSchedulerTest::shouldIncreaseRetryDelay()
+{
+    using namespace std::chrono_literals;
+    QVERIFY(DownloadScheduler::retryDelay(30s, 1) == 30s);
+    QVERIFY(DownloadScheduler::retryDelay(30s, 2) == 60s);
+    QVERIFY(DownloadScheduler::retryDelay(30s, 4) == 240s);
+    QVERIFY(DownloadScheduler::retryDelay(30s, 100) == DownloadScheduler::maximumRetryDelay);
+}
+
+#include "moc_downloadschedulertest.cpp"
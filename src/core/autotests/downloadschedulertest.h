@@ -0,0 +1,28 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class DownloadSchedulerTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DownloadSchedulerTest(QObject *parent = nullptr);
+    ~DownloadSchedulerTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldLimitDownloadsPerHost();
+    void shouldStartHighestPriorityFirst();
+    void shouldDownloadUrlOnce();
+    void shouldCancelPendingDownloads();
+    void shouldCancelOnlyRequesterDownloads();
+    void shouldNotRetryFailedDownloads();
+    void shouldRetryFailedDownloads();
+    void shouldRetryFailedDownloadsAfterDelay();
+    void shouldIncreaseRetryDelay();
+};
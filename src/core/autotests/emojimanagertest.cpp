@@ -118,7 +118,12 @@ void EmojiManagerTest::shouldDeleteEmojiCustom()
 
     const QString deleteJsonFile = QLatin1StringView(RUQOLA_DATA_DIR) + "/json/restapi/"_L1 + deleteName + ".json"_L1;
     const auto objDelete = AutoTestHelper::loadJsonArrayObject(deleteJsonFile);
+    const quint64 revision = manager.emojiRevision();
+    QCOMPARE(manager.replacementTable()->revision, revision);
     manager.deleteEmojiCustom(objDelete);
+    // Texts converted with the deleted emoji must be converted again
+    QVERIFY(manager.emojiRevision() != revision);
+    QCOMPARE(manager.replacementTable()->revision, manager.emojiRevision());
     // qDebug() << " manager.customEmojiList() " << manager.customEmojiList();
     QCOMPARE(manager.customEmojiList(), customEmoji);
 }
@@ -0,0 +1,48 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "highlightedcodecachetest.h"
+#include "highlightedcodecache.h"
+#include "texthighlighter.h"
+#include <QTest>
+using namespace Qt::Literals::StringLiterals;
+
+QTEST_GUILESS_MAIN(HighlightedCodeCacheTest)
+
+HighlightedCodeCacheTest::HighlightedCodeCacheTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void HighlightedCodeCacheTest::shouldGenerateDifferentKeys()
+{
+    const QByteArray key = HighlightedCodeCache::cacheKey(u"C++"_s, u"Breeze Light"_s, u"int a = 0;"_s);
+    QCOMPARE(key, HighlightedCodeCache::cacheKey(u"C++"_s, u"Breeze Light"_s, u"int a = 0;"_s));
+    QVERIFY(key != HighlightedCodeCache::cacheKey(u"C"_s, u"Breeze Light"_s, u"int a = 0;"_s));
+    QVERIFY(key != HighlightedCodeCache::cacheKey(u"C++"_s, u"Breeze Dark"_s, u"int a = 0;"_s));
+    QVERIFY(key != HighlightedCodeCache::cacheKey(u"C++"_s, u"Breeze Light"_s, u"int a = 1;"_s));
+    QVERIFY(HighlightedCodeCache::cacheKey(u"a"_s, u"bc"_s, QString()) != HighlightedCodeCache::cacheKey(u"ab"_s, u"c"_s, QString()));
+}
+
+void HighlightedCodeCacheTest::shouldStoreHighlightedCode()
+{
+    HighlightedCodeCache cache;
+    const QByteArray key = HighlightedCodeCache::cacheKey(u"C++"_s, u"Breeze Light"_s, u"int a = 0;"_s);
+    QVERIFY(cache.highlightedCode(key).isEmpty());
+    cache.insert(key, u"<code>foo</code>"_s);
+    QCOMPARE(cache.highlightedCode(key), u"<code>foo</code>"_s);
+    cache.insert(key, u"<code>bla</code>"_s);
+    QCOMPARE(cache.highlightedCode(key), u"<code>bla</code>"_s);
+    cache.clear();
+    QVERIFY(cache.highlightedCode(key).isEmpty());
+}
+
+void HighlightedCodeCacheTest::shouldGeneratePlainCode()
+{
+    QCOMPARE(TextHighlighter::plainCode(u"a <b>\n  c"_s), u"<code>a&nbsp;&lt;b&gt;<br>&nbsp;&nbsp;c</code>"_s);
+}
+
+#include "moc_highlightedcodecachetest.cpp"
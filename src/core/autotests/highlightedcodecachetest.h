@@ -0,0 +1,21 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class HighlightedCodeCacheTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HighlightedCodeCacheTest(QObject *parent = nullptr);
+    ~HighlightedCodeCacheTest() override = default;
+private Q_SLOTS:
+    void shouldGenerateDifferentKeys();
+    void shouldStoreHighlightedCode();
+    void shouldGeneratePlainCode();
+};
@@ -0,0 +1,135 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "loginbootstraptest.h"
+#include "loginbootstrap.h"
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(LoginBootstrapTest)
+using namespace Qt::Literals::StringLiterals;
+
+LoginBootstrapTest::LoginBootstrapTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void LoginBootstrapTest::shouldHaveDefaultValues()
+{
+    LoginBootstrap bootstrap;
+    QVERIFY(!bootstrap.isRunning());
+    QVERIFY(!bootstrap.deferredTasksStarted());
+    QVERIFY(bootstrap.taskDurations().isEmpty());
+    QVERIFY(!bootstrap.isFinished(u"foo"_s));
+}
+
+void LoginBootstrapTest::shouldStartDeferredTasksAfterCriticalTasks()
+{
+    LoginBootstrap bootstrap;
+    QSignalSpy criticalSpy(&bootstrap, &LoginBootstrap::criticalTasksFinished);
+    QSignalSpy finishedSpy(&bootstrap, &LoginBootstrap::finished);
+    QStringList started;
+    auto job = new QObject(this);
+    bootstrap.addTask(u"deferred"_s, LoginBootstrap::Stage::Deferred, [&started]() {
+        started.append(u"deferred"_s);
+        return nullptr;
+    });
+    bootstrap.addTask(u"critical1"_s, LoginBootstrap::Stage::Critical, [&started, job]() {
+        started.append(u"critical1"_s);
+        return job;
+    });
+    bootstrap.addTask(u"critical2"_s, LoginBootstrap::Stage::Critical, [&started]() {
+        started.append(u"critical2"_s);
+        return nullptr;
+    });
+    bootstrap.start();
+    QVERIFY(bootstrap.isRunning());
+    // Critical tasks run in parallel
+    QCOMPARE(started, (QStringList{u"critical1"_s, u"critical2"_s}));
+    QVERIFY(bootstrap.isFinished(u"critical2"_s));
+    QVERIFY(!bootstrap.isFinished(u"critical1"_s));
+    QCOMPARE(criticalSpy.count(), 0);
+
+    delete job;
+    QCOMPARE(criticalSpy.count(), 1);
+    QVERIFY(!bootstrap.deferredTasksStarted());
+    QCOMPARE(started.count(), 2);
+
+    // Started from the event loop
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(bootstrap.deferredTasksStarted());
+    QCOMPARE(started.last(), u"deferred"_s);
+    QVERIFY(!bootstrap.isRunning());
+}
+
+void LoginBootstrapTest::shouldStartTaskAfterDependencies()
+{
+    LoginBootstrap bootstrap;
+    QStringList started;
+    auto job = new QObject(this);
+    bootstrap.addTask(
+        u"second"_s,
+        LoginBootstrap::Stage::Critical,
+        [&started]() {
+            started.append(u"second"_s);
+            return nullptr;
+        },
+        {u"first"_s, u"unknown"_s});
+    bootstrap.addTask(u"first"_s, LoginBootstrap::Stage::Critical, [&started, job]() {
+        started.append(u"first"_s);
+        return job;
+    });
+    bootstrap.start();
+    QCOMPARE(started, QStringList{u"first"_s});
+
+    job->deleteLater();
+    QTRY_VERIFY(bootstrap.isFinished(u"second"_s));
+    QCOMPARE(started, (QStringList{u"first"_s, u"second"_s}));
+}
+
+void LoginBootstrapTest::shouldRecordDurations()
+{
+    LoginBootstrap bootstrap;
+    QSignalSpy finishedSpy(&bootstrap, &LoginBootstrap::finished);
+    QPointer<QObject> job = new QObject(this);
+    bootstrap.addTask(u"slow"_s, LoginBootstrap::Stage::Critical, [job]() {
+        return job.data();
+    });
+    bootstrap.addTask(u"fast"_s, LoginBootstrap::Stage::Deferred, []() {
+        return nullptr;
+    });
+    bootstrap.start();
+    QTest::qWait(50);
+    delete job;
+    QVERIFY(finishedSpy.wait());
+
+    const QHash<QString, qint64> durations = bootstrap.taskDurations();
+    QCOMPARE(durations.count(), 1);
+    QVERIFY(durations.value(u"slow"_s) >= 50);
+    // Its request isn't followed
+    QVERIFY(!durations.contains(u"fast"_s));
+    QVERIFY(bootstrap.isFinished(u"fast"_s));
+}
+
+void LoginBootstrapTest::shouldIgnoreTasksAfterClear()
+{
+    LoginBootstrap bootstrap;
+    QSignalSpy criticalSpy(&bootstrap, &LoginBootstrap::criticalTasksFinished);
+    auto job = new QObject(this);
+    bootstrap.addTask(u"critical"_s, LoginBootstrap::Stage::Critical, [job]() {
+        return job;
+    });
+    bootstrap.start();
+    bootstrap.clear();
+    QVERIFY(!bootstrap.isRunning());
+
+    delete job;
+    QCOMPARE(criticalSpy.count(), 0);
+    QVERIFY(bootstrap.taskDurations().isEmpty());
+}
+
+#include "moc_loginbootstraptest.cpp"
@@ -0,0 +1,23 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class LoginBootstrapTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoginBootstrapTest(QObject *parent = nullptr);
+    ~LoginBootstrapTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldStartDeferredTasksAfterCriticalTasks();
+    void shouldStartTaskAfterDependencies();
+    void shouldRecordDurations();
+    void shouldIgnoreTasksAfterClear();
+};
@@ -6,11 +6,15 @@
 
 #include "messagesmodeltest.h"
 #include "accountmanager.h"
+#include "colorsandmessageviewstyle.h"
+#include "messages/messagestore.h"
 #include "model/messagesmodel.h"
+#include "quotedtextcache.h"
 #include "rocketchataccount.h"
 #include "rocketchataccountsettings.h"
 #include "ruqola.h"
 #include "test_model_helpers.h"
+#include <QSignalSpy>
 #include <QStandardPaths>
 #include <QTest>
 
@@ -254,6 +258,157 @@ void MessagesModelTest::shouldAddMessages()
     QCOMPARE(model.index(6, 0).data(MessagesModel::OriginalMessage).toString(), QStringLiteral("modified"));
 }
 
+void MessagesModelTest::shouldMergeMessagesWithoutReset()
+{
+    MessagesModel model;
+    Message input;
+    fillTestMessage(input);
+    auto makeMessage = [&](const char *id, qint64 timestamp) {
+        input.setMessageId(QByteArray(id));
+        input.setTimeStamp(timestamp);
+        return input;
+    };
+    model.addMessages({makeMessage("msgA", 2), makeMessage("msgB", 6)});
+    QCOMPARE(model.rowCount(), 2);
+
+    QSignalSpy rowsInsertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy modelResetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    input.setText(QStringLiteral("modified"));
+    model.addMessages({makeMessage("msgF", 9),
+                       makeMessage("msgE", 4),
+                       makeMessage("msgC", 1),
+                       makeMessage("msgD", 3),
+                       makeMessage("msgB", 6), // update
+                       makeMessage("msgD", 3)}); // twice in list
+    QCOMPARE(modelResetSpy.count(), 0);
+    // Updated row is emitted at next frame
+    QCOMPARE(dataChangedSpy.count(), 0);
+    QVERIFY(dataChangedSpy.wait());
+    QCOMPARE(dataChangedSpy.count(), 1);
+    // One insertion per run of new messages
+    QCOMPARE(rowsInsertedSpy.count(), 3);
+    QCOMPARE(rowsInsertedSpy.at(0).at(1).toInt(), 0);
+    QCOMPARE(rowsInsertedSpy.at(0).at(2).toInt(), 0);
+    QCOMPARE(rowsInsertedSpy.at(1).at(1).toInt(), 2);
+    QCOMPARE(rowsInsertedSpy.at(1).at(2).toInt(), 3);
+    QCOMPARE(rowsInsertedSpy.at(2).at(1).toInt(), 5);
+    QCOMPARE(rowsInsertedSpy.at(2).at(2).toInt(), 5);
+
+    QCOMPARE(extractMessageIds(model),
+             QByteArrayList() << "msgC"
+                              << "msgA"
+                              << "msgD"
+                              << "msgE"
+                              << "msgB"
+                              << "msgF");
+    QCOMPARE(model.index(4, 0).data(MessagesModel::OriginalMessage).toString(), QStringLiteral("modified"));
+}
+
+void MessagesModelTest::shouldCoalesceDataChanged()
+{
+    MessagesModel model;
+    Message input;
+    fillTestMessage(input);
+    auto makeMessage = [&](const char *id, qint64 timestamp) {
+        input.setMessageId(QByteArray(id));
+        input.setTimeStamp(timestamp);
+        return input;
+    };
+    model.addMessages({makeMessage("msgA", 1), makeMessage("msgB", 2), makeMessage("msgC", 3), makeMessage("msgD", 4)});
+    QCOMPARE(model.rowCount(), 4);
+
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    QVERIFY(model.setData(model.index(1, 0), true, MessagesModel::ShowTranslatedMessage));
+    QVERIFY(model.setData(model.index(0, 0), true, MessagesModel::ShowTranslatedMessage));
+    QVERIFY(model.setData(model.index(1, 0), false, MessagesModel::ShowTranslatedMessage));
+    QVERIFY(model.setData(model.index(3, 0), true, MessagesModel::ShowIgnoredMessage));
+    QVERIFY(model.setData(model.index(2, 0), true, MessagesModel::LocalTranslation));
+    // Removed before being emitted
+    model.deleteMessage(QByteArrayLiteral("msgC"));
+    QCOMPARE(dataChangedSpy.count(), 0);
+
+    QVERIFY(dataChangedSpy.wait());
+    // Adjacent rows with same roles are merged
+    QCOMPARE(dataChangedSpy.count(), 2);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 0);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(2).value<QList<int>>(), QList<int>{MessagesModel::ShowTranslatedMessage});
+    QCOMPARE(dataChangedSpy.at(1).at(0).toModelIndex().row(), 2);
+    QCOMPARE(dataChangedSpy.at(1).at(1).toModelIndex().row(), 2);
+    QCOMPARE(dataChangedSpy.at(1).at(2).value<QList<int>>(), QList<int>{MessagesModel::ShowIgnoredMessage});
+}
+
+void MessagesModelTest::shouldUpdateRowsOfDownloadedFile()
+{
+    MessagesModel model(QByteArrayLiteral("roomId"), Ruqola::self()->rocketChatAccount());
+    model.activate();
+    Message input;
+    fillTestMessage(input);
+    auto makeMessage = [&](const char *id, qint64 timestamp, const QString &imageUrlPreview = {}) {
+        input.setMessageId(QByteArray(id));
+        input.setTimeStamp(timestamp);
+        MessageAttachments attachments;
+        if (!imageUrlPreview.isEmpty()) {
+            MessageAttachment attachment;
+            attachment.setAttachmentId(QByteArray(id) + "_att");
+            attachment.setImageUrlPreview(imageUrlPreview);
+            attachments.setMessageAttachments({attachment});
+        }
+        input.setAttachments(attachments);
+        return input;
+    };
+    const QString imageUrl = QStringLiteral("https://www.kde.org/file-upload/foo/image.png");
+    model.addMessages({makeMessage("msgA", 1),
+                       makeMessage("msgB", 2, imageUrl),
+                       makeMessage("msgC", 3, imageUrl),
+                       makeMessage("msgD", 4, QStringLiteral("https://www.kde.org/file-upload/bla/other.png"))});
+    QCOMPARE(model.rowCount(), 4);
+
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    Q_EMIT Ruqola::self()->rocketChatAccount()->fileDownloaded(QStringLiteral("/file-upload/foo/image.png"), QUrl());
+    QVERIFY(dataChangedSpy.wait());
+    QCOMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 2);
+
+    // Index follows removed and updated messages
+    model.deleteMessage(QByteArrayLiteral("msgB"));
+    model.addMessages({makeMessage("msgD", 4, imageUrl)});
+    QVERIFY(dataChangedSpy.wait());
+    dataChangedSpy.clear();
+    Q_EMIT Ruqola::self()->rocketChatAccount()->fileDownloaded(QStringLiteral("/file-upload/foo/image.png"), QUrl());
+    QVERIFY(dataChangedSpy.wait());
+    QCOMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).toModelIndex().row(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(1).toModelIndex().row(), 2);
+    model.deactivate();
+}
+
+void MessagesModelTest::shouldShareMessagesBetweenModels()
+{
+    auto account = Ruqola::self()->rocketChatAccount();
+    MessagesModel roomModel(QByteArrayLiteral("roomId"), account);
+    MessagesModel searchModel(QByteArrayLiteral("roomId"), account);
+    Message input;
+    fillTestMessage(input);
+    input.setMessageId(QByteArrayLiteral("sharedMsg"));
+    roomModel.addMessages({input});
+    searchModel.addMessages({input});
+    QCOMPARE(account->messageStore()->holderCount(QByteArrayLiteral("sharedMsg")), 2);
+
+    // Edit received by one model is applied to the other one
+    input.setText(QStringLiteral("edited"));
+    input.setUpdatedAt(input.updatedAt() + 1);
+    roomModel.addMessages({input});
+    QCOMPARE(searchModel.index(0, 0).data(MessagesModel::OriginalMessage).toString(), QStringLiteral("edited"));
+
+    searchModel.clear();
+    QCOMPARE(account->messageStore()->holderCount(QByteArrayLiteral("sharedMsg")), 1);
+    roomModel.deleteMessage(QByteArrayLiteral("sharedMsg"));
+    QCOMPARE(account->messageStore()->holderCount(QByteArrayLiteral("sharedMsg")), 0);
+}
+
 void MessagesModelTest::shouldUpdateFirstMessage()
 {
     MessagesModel model;
@@ -333,4 +488,63 @@ void MessagesModelTest::shouldFindPrevNextMessage()
     QCOMPARE(model.findNextMessageAfter(QByteArrayLiteral("msgA"), isByMe).messageId(), QByteArrayLiteral("msgC"));
 }
 
+void MessagesModelTest::shouldConvertQuotingMessagesAgain()
+{
+    MessagesModel model;
+    Message input;
+    fillTestMessage(input);
+    auto makeMessage = [&](const char *id, qint64 timestamp, const QString &text) {
+        input.setMessageId(QByteArray(id));
+        input.setTimeStamp(timestamp);
+        input.setText(text);
+        return input;
+    };
+    model.addMessages({makeMessage("quotedId", 1, QStringLiteral("first version")),
+                       makeMessage("quotingId", 2, QStringLiteral("[ ](https://www.kde.org/channel/all?msg=quotedId) answer")),
+                       makeMessage("otherId", 3, QStringLiteral("other"))});
+    auto convertedText = [&model](int row) {
+        return model.index(row, 0).data(MessagesModel::MessageConvertedText).toString();
+    };
+    QVERIFY(convertedText(0).contains(QStringLiteral("first version")));
+    QVERIFY(convertedText(1).contains(QStringLiteral("first version")));
+    QVERIFY(convertedText(2).contains(QStringLiteral("other")));
+
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    Message edited = makeMessage("quotedId", 1, QStringLiteral("second version"));
+    edited.setUpdatedAt(46);
+    edited.setEditedAt(90);
+    model.addMessages({edited});
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(convertedText(0).contains(QStringLiteral("second version")));
+    // Quoting message is converted again
+    QVERIFY(convertedText(1).contains(QStringLiteral("second version")));
+    QVERIFY(!convertedText(1).contains(QStringLiteral("first version")));
+    QVERIFY(convertedText(2).contains(QStringLiteral("other")));
+
+    // Edited and quoting rows are repainted
+    QVERIFY(dataChangedSpy.wait());
+    QSet<int> changedRows;
+    for (const QList<QVariant> &arguments : std::as_const(dataChangedSpy)) {
+        const QModelIndex topLeft = arguments.at(0).toModelIndex();
+        const QModelIndex bottomRight = arguments.at(1).toModelIndex();
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            changedRows.insert(row);
+        }
+    }
+    QVERIFY(changedRows.contains(0));
+    QVERIFY(changedRows.contains(1));
+    QVERIFY(!changedRows.contains(2));
+}
+
+void MessagesModelTest::shouldClearQuotedTextCacheWhenColorsChange()
+{
+    MessagesModel model;
+    const QByteArray key = QByteArrayLiteral("quotedMessageKey");
+    QuotedTextCache::self().insert(key, QStringLiteral("<span style=\"color:#ff0000\">quote</span>"));
+    QVERIFY(!QuotedTextCache::self().quotedText(key).isEmpty());
+
+    Q_EMIT ColorsAndMessageViewStyle::self().needToUpdateColors();
+    QVERIFY(QuotedTextCache::self().quotedText(key).isEmpty());
+}
+
 #include "moc_messagesmodeltest.cpp"
@@ -23,7 +23,13 @@ private Q_SLOTS:
     void shouldRemoveNotExistingMessage();
     void shouldDetectDateChange();
     void shouldAddMessages();
+    void shouldMergeMessagesWithoutReset();
+    void shouldCoalesceDataChanged();
+    void shouldUpdateRowsOfDownloadedFile();
+    void shouldShareMessagesBetweenModels();
     void shouldUpdateFirstMessage();
     void shouldAllowEditing();
     void shouldFindPrevNextMessage();
+    void shouldConvertQuotingMessagesAgain();
+    void shouldClearQuotedTextCacheWhenColorsChange();
 };
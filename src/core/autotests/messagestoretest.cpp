@@ -0,0 +1,88 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagestoretest.h"
+#include "messages/messagestore.h"
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(MessageStoreTest)
+
+static Message createMessage(const QString &text, qint64 updatedAt)
+{
+    Message message;
+    message.setMessageId(QByteArrayLiteral("msg1"));
+    message.setText(text);
+    message.setTimeStamp(10);
+    message.setUpdatedAt(updatedAt);
+    return message;
+}
+
+MessageStoreTest::MessageStoreTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void MessageStoreTest::shouldHaveDefaultValues()
+{
+    MessageStore store;
+    QCOMPARE(store.count(), 0);
+    QCOMPARE(store.holderCount(QByteArrayLiteral("msg1")), 0);
+}
+
+void MessageStoreTest::shouldShareSnapshot()
+{
+    MessageStore store;
+    QSignalSpy updatedSpy(&store, &MessageStore::messageUpdated);
+    const Message first = store.acquire(createMessage(QStringLiteral("foo"), 5));
+    // Same version parsed again: stored snapshot is returned
+    const Message second = store.acquire(createMessage(QStringLiteral("foo"), 5));
+    QCOMPARE(second, first);
+    QVERIFY(second.text().isSharedWith(first.text()));
+    QCOMPARE(store.count(), 1);
+    QCOMPARE(store.holderCount(QByteArrayLiteral("msg1")), 2);
+    QCOMPARE(updatedSpy.count(), 0);
+}
+
+void MessageStoreTest::shouldKeepNewestVersion()
+{
+    MessageStore store;
+    QSignalSpy updatedSpy(&store, &MessageStore::messageUpdated);
+    (void)store.acquire(createMessage(QStringLiteral("foo"), 5));
+
+    // Newer version acquired by another holder
+    QCOMPARE(store.acquire(createMessage(QStringLiteral("bla"), 6)).text(), QStringLiteral("bla"));
+    QCOMPARE(updatedSpy.count(), 1);
+    QCOMPARE(updatedSpy.at(0).at(0).value<Message>().text(), QStringLiteral("bla"));
+
+    // Older version: newest one is kept
+    QCOMPARE(store.acquire(createMessage(QStringLiteral("foo"), 5)).text(), QStringLiteral("bla"));
+    store.update(createMessage(QStringLiteral("foo"), 5));
+    QCOMPARE(updatedSpy.count(), 1);
+
+    store.update(createMessage(QStringLiteral("edited"), 7));
+    QCOMPARE(updatedSpy.count(), 2);
+    QCOMPARE(store.acquire(createMessage(QStringLiteral("foo"), 5)).text(), QStringLiteral("edited"));
+}
+
+void MessageStoreTest::shouldReleaseSnapshot()
+{
+    MessageStore store;
+    (void)store.acquire(createMessage(QStringLiteral("foo"), 5));
+    (void)store.acquire(createMessage(QStringLiteral("foo"), 5));
+    store.release(QByteArrayLiteral("msg1"));
+    QCOMPARE(store.count(), 1);
+    store.release(QByteArrayLiteral("msg1"));
+    QCOMPARE(store.count(), 0);
+    // Not held anymore: update is ignored
+    QSignalSpy updatedSpy(&store, &MessageStore::messageUpdated);
+    store.update(createMessage(QStringLiteral("bla"), 6));
+    QCOMPARE(updatedSpy.count(), 0);
+    QCOMPARE(store.count(), 0);
+    store.release(QByteArrayLiteral("unknown"));
+}
+
+#include "moc_messagestoretest.cpp"
@@ -0,0 +1,22 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class MessageStoreTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageStoreTest(QObject *parent = nullptr);
+    ~MessageStoreTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldShareSnapshot();
+    void shouldKeepNewestVersion();
+    void shouldReleaseSnapshot();
+};
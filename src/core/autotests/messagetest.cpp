@@ -8,6 +8,7 @@
 #include "messages/message.h"
 #include "ruqola_autotest_helper.h"
 #include <QCborValue>
+#include <QDateTime>
 #include <QJsonDocument>
 using namespace Qt::Literals::StringLiterals;
 QTEST_GUILESS_MAIN(MessageTest)
@@ -839,4 +840,61 @@ void MessageTest::shouldUpdateJsonMessage()
     QVERIFY(compareMessage);
 }
 
+void MessageTest::shouldParseSubObjectsOnFirstAccess()
+{
+    const QByteArray json = R"({"_id": "msg1", "rid": "room1", "msg": "https://www.kde.org", "ts": {"$date": 1}, "u": {"_id": "uid1", "username": "foo"},
+                                "urls": [{"url": "https://www.kde.org"}], "replies": ["uid2", "uid3"]})";
+    Message message;
+    message.parseMessage(QJsonDocument::fromJson(json).object(), false, nullptr);
+    const Message copy = message;
+    QVERIFY(message.urls());
+    QCOMPARE(message.urls()->messageUrls().count(), 1);
+    QCOMPARE(message.urls()->messageUrls().at(0).url(), QStringLiteral("https://www.kde.org"));
+    // Parsed once for all the copies
+    QCOMPARE(copy.urls(), message.urls());
+    QVERIFY(copy.replies());
+    QCOMPARE(copy.replies()->replies(), QList<QByteArray>({"uid2", "uid3"}));
+    QVERIFY(!message.blocks());
+    // Nothing to parse
+    QVERIFY(message.attachmentsParsed());
+    QVERIFY(!message.attachments());
+
+    // Setter replaces the value which is not parsed yet
+    Message other;
+    other.parseMessage(QJsonDocument::fromJson(json).object(), false, nullptr);
+    other.setUrls(MessageUrls());
+    QVERIFY(!other.urls());
+    QCOMPARE(other.replies()->replies().count(), 2);
+
+    const QByteArray attachmentJson = R"({"_id": "msg2", "rid": "room1", "ts": {"$date": 1}, "u": {"_id": "uid1", "username": "foo"},
+                                          "attachments": [{"title": "image.png", "image_preview": "/file-upload/foo/image.png"}]})";
+    Message withAttachment;
+    withAttachment.parseMessage(QJsonDocument::fromJson(attachmentJson).object(), false, nullptr);
+    const Message attachmentCopy = withAttachment;
+    QVERIFY(!withAttachment.attachmentsParsed());
+    QVERIFY(withAttachment.attachments());
+    QVERIFY(withAttachment.attachmentsParsed());
+    // Copy shares the parsed attachments
+    QVERIFY(attachmentCopy.attachmentsParsed());
+}
+
+void MessageTest::shouldShareDisplayTimeOfSameMinute()
+{
+    const QDateTime dateTime(QDate(2026, 3, 4), QTime(10, 42, 5));
+    Message first;
+    first.setTimeStamp(dateTime.toMSecsSinceEpoch());
+    Message second;
+    second.setTimeStamp(dateTime.addSecs(30).toMSecsSinceEpoch());
+    Message next;
+    next.setTimeStamp(dateTime.addSecs(60).toMSecsSinceEpoch());
+    QCOMPARE(first.displayTime(), QStringLiteral("10:42"));
+    QCOMPARE(second.displayTime(), QStringLiteral("10:42"));
+    // Formatted once
+    QVERIFY(first.displayTime().isSharedWith(second.displayTime()));
+    QCOMPARE(next.displayTime(), QStringLiteral("10:43"));
+
+    Message::clearDisplayTimeCache();
+    QCOMPARE(second.displayTime(), QStringLiteral("10:42"));
+}
+
 #include "moc_messagetest.cpp"
@@ -27,4 +27,7 @@ private Q_SLOTS:
 
     void shouldUpdateJsonMessage_data();
     void shouldUpdateJsonMessage();
+
+    void shouldParseSubObjectsOnFirstAccess();
+    void shouldShareDisplayTimeOfSameMinute();
 };
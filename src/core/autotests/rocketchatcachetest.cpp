@@ -5,14 +5,272 @@
 */
 
 #include "rocketchatcachetest.h"
+#include "connection.h"
+#include "localdatabase/localcacheindexdatabase.h"
+#include "managerdatapaths.h"
+#include "rocketchataccount.h"
 #include "rocketchatcache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(RocketChatCacheTest)
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+QString accountName()
+{
+    return u"rocketchatcachetest"_s;
+}
+
+bool createFile(const QString &filePath, qint64 size)
+{
+    if (!QDir().mkpath(QFileInfo(filePath).absolutePath())) {
+        return false;
+    }
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(QByteArray(size, 'a')) == size;
+}
+
+LocalCacheIndexDatabase::CacheFileInfo cacheFileInfo(qint64 size, qint64 lastAccess)
+{
+    LocalCacheIndexDatabase::CacheFileInfo info;
+    info.size = size;
+    info.lastAccess = lastAccess;
+    return info;
+}
+}
 
 RocketChatCacheTest::RocketChatCacheTest(QObject *parent)
     : QObject(parent)
 {
 }
 
+void RocketChatCacheTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void RocketChatCacheTest::init()
+{
+    LocalCacheIndexDatabase database;
+    QFile::remove(database.dbFileName(accountName()));
+}
+
+void RocketChatCacheTest::shouldIndexOnlyCacheDirectories_data()
+{
+    QTest::addColumn<QString>("filePath");
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("cache") << u"/cache/MainCache/file-upload/foo.png"_s << true;
+    QTest::newRow("preview") << u"/cache/PreviewUrl/foo.png"_s << true;
+    QTest::newRow("partial") << u"/cache/MainCache/file-upload/foo.png.part"_s << false;
+    QTest::newRow("partialvalidator") << u"/cache/MainCache/file-upload/foo.png.part.validator"_s << false;
+    QTest::newRow("directory-prefix") << u"/cache/MainCacheOther/foo.png"_s << false;
+    QTest::newRow("user-file") << u"/home/foo/Downloads/foo.png"_s << false;
+}
+
+void RocketChatCacheTest::shouldIndexOnlyCacheDirectories()
+{
+    QFETCH(QString, filePath);
+    QFETCH(bool, indexed);
+    const QStringList directories{u"/cache/MainCache"_s, u"/cache/PreviewUrl"_s};
+    QCOMPARE(RocketChatCache::isIndexedPath(filePath, directories), indexed);
+}
+
+void RocketChatCacheTest::shouldNotIndexPartialDownloads()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    QVERIFY(createFile(directory + u"/file-upload/foo.png"_s, 10));
+    QVERIFY(createFile(directory + u"/file-upload/bla.png.part"_s, 20));
+
+    const LocalCacheIndexDatabase::CacheFiles files = RocketChatCache::synchronizeCacheIndex(accountName(), {directory});
+    QCOMPARE(files.count(), 1);
+    QCOMPARE(files.value(directory + u"/file-upload/foo.png"_s).size, 10);
+    QCOMPARE(LocalCacheIndexDatabase().cacheFiles(accountName()).count(), 1);
+}
+
+void RocketChatCacheTest::shouldRemoveAbandonedPartialDownloads()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    const QString abandonedFile = directory + u"/file-upload/foo.png.part"_s;
+    const QString abandonedValidator = directory + u"/file-upload/foo.png.part.validator"_s;
+    const QString partialFile = directory + u"/file-upload/bla.png.part"_s;
+    QVERIFY(createFile(abandonedFile, 10));
+    QVERIFY(createFile(abandonedValidator, 10));
+    QVERIFY(createFile(partialFile, 10));
+    const QDateTime modificationTime = QDateTime::currentDateTime().addDays(-30);
+    for (const QString &filePath : {abandonedFile, abandonedValidator}) {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(modificationTime, QFileDevice::FileModificationTime));
+    }
+
+    QVERIFY(RocketChatCache::synchronizeCacheIndex(accountName(), {directory}).isEmpty());
+    QVERIFY(!QFileInfo::exists(abandonedFile));
+    QVERIFY(!QFileInfo::exists(abandonedValidator));
+    QVERIFY(QFileInfo::exists(partialFile));
+}
+
+void RocketChatCacheTest::shouldEvictLeastRecentlyUsedFirst()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    const QString oldFile = directory + u"/old.png"_s;
+    const QString recentFile = directory + u"/recent.png"_s;
+    const QString newFile = directory + u"/new.png"_s;
+    QVERIFY(createFile(oldFile, 10));
+    QVERIFY(createFile(recentFile, 10));
+    QVERIFY(createFile(newFile, 10));
+    LocalCacheIndexDatabase().updateCacheFiles(accountName(),
+                                               {{recentFile, cacheFileInfo(10, 200)}, {newFile, cacheFileInfo(10, 300)}, {oldFile, cacheFileInfo(10, 100)}});
+
+    const QStringList evictedFiles = RocketChatCache::evictCacheFiles(accountName(), {directory}, {}, {}, 1, 0);
+    QCOMPARE(evictedFiles, QStringList{oldFile});
+    QVERIFY(!QFile::exists(oldFile));
+    QVERIFY(QFile::exists(recentFile));
+    QVERIFY(QFile::exists(newFile));
+    QCOMPARE(LocalCacheIndexDatabase().cacheFiles(accountName()).count(), 2);
+
+    // Access time saved before eviction
+    const QStringList nextEvictedFiles = RocketChatCache::evictCacheFiles(accountName(), {directory}, {{recentFile, cacheFileInfo(10, 400)}}, {}, 1, 0);
+    QCOMPARE(nextEvictedFiles, QStringList{newFile});
+}
+
+void RocketChatCacheTest::shouldEvictUntilBudgetIsReached()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    LocalCacheIndexDatabase::CacheFiles files;
+    for (int i = 0; i < 5; ++i) {
+        const QString filePath = directory + u"/file%1.png"_s.arg(i);
+        QVERIFY(createFile(filePath, 100));
+        files.insert(filePath, cacheFileInfo(100, 100 + i));
+    }
+    LocalCacheIndexDatabase().updateCacheFiles(accountName(), files);
+
+    // Cache is not full
+    QVERIFY(RocketChatCache::evictCacheFiles(accountName(), {directory}, {}, {}, 0, 0).isEmpty());
+
+    const QStringList evictedFiles = RocketChatCache::evictCacheFiles(accountName(), {directory}, {}, {}, 150, 0);
+    QCOMPARE(evictedFiles, (QStringList{directory + u"/file0.png"_s, directory + u"/file1.png"_s}));
+    QCOMPARE(LocalCacheIndexDatabase().cacheFiles(accountName()).count(), 3);
+}
+
+void RocketChatCacheTest::shouldEvictExpiredFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    const QString expiredFile = directory + u"/expired.png"_s;
+    const QString usedFile = directory + u"/used.png"_s;
+    QVERIFY(createFile(expiredFile, 10));
+    QVERIFY(createFile(usedFile, 10));
+    LocalCacheIndexDatabase().updateCacheFiles(accountName(), {{expiredFile, cacheFileInfo(10, 100)}, {usedFile, cacheFileInfo(10, 300)}});
+
+    QCOMPARE(RocketChatCache::evictCacheFiles(accountName(), {directory}, {}, {}, 0, 200), QStringList{expiredFile});
+    QVERIFY(QFile::exists(usedFile));
+}
+
+void RocketChatCacheTest::shouldNotRemoveFilesOutsideCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QTemporaryDir userDir;
+    QVERIFY(userDir.isValid());
+    const QString directory = QDir::cleanPath(dir.path());
+    const QString userFile = QDir::cleanPath(userDir.path()) + u"/document.pdf"_s;
+    const QString cacheFile = directory + u"/foo.png"_s;
+    QVERIFY(createFile(userFile, 10));
+    QVERIFY(createFile(cacheFile, 10));
+    LocalCacheIndexDatabase().updateCacheFiles(accountName(), {{userFile, cacheFileInfo(10, 100)}, {cacheFile, cacheFileInfo(10, 200)}});
+
+    const QStringList evictedFiles = RocketChatCache::evictCacheFiles(accountName(), {directory}, {}, {}, 20, 0);
+    // Forgotten by the index, kept on disk
+    QCOMPARE(evictedFiles, (QStringList{userFile, cacheFile}));
+    QVERIFY(QFile::exists(userFile));
+    QVERIFY(!QFile::exists(cacheFile));
+    QVERIFY(LocalCacheIndexDatabase().cacheFiles(accountName()).isEmpty());
+}
+
+void RocketChatCacheTest::shouldNotIndexDownloadsOutsideCache()
+{
+    RocketChatAccount account;
+    RocketChatCache cache(&account);
+    Connection connection;
+    cache.setRestApiConnection(&connection);
+    QCOMPARE(cache.cacheSize(), 0);
+
+    QTemporaryDir userDir;
+    QVERIFY(userDir.isValid());
+    const QString userFile = QDir::cleanPath(userDir.path()) + u"/document.pdf"_s;
+    QVERIFY(createFile(userFile, 10));
+    Q_EMIT connection.downloadFileDone(QUrl(u"https://www.kde.org/file-upload/document.pdf"_s), QUrl::fromLocalFile(userFile));
+    QCOMPARE(cache.cacheSize(), 0);
+
+    const QString cacheFile = QDir::cleanPath(ManagerDataPaths::self()->path(ManagerDataPaths::Cache, QString())) + u"/file-upload/foo.png"_s;
+    QVERIFY(createFile(cacheFile, 10));
+    Q_EMIT connection.downloadFileDone(QUrl(u"https://www.kde.org/file-upload/foo.png"_s), QUrl::fromLocalFile(cacheFile));
+    QCOMPARE(cache.cacheSize(), 10);
+    QVERIFY(QFile::remove(cacheFile));
+}
+
+void RocketChatCacheTest::shouldLookUpDiskUntilIndexIsLoaded()
+{
+    // Index isn't loaded without account name
+    RocketChatAccount account;
+    RocketChatCache cache(&account);
+    QVERIFY(!cache.cacheIndexLoaded());
+
+    const QString cacheFile = QDir::cleanPath(ManagerDataPaths::self()->path(ManagerDataPaths::Cache, QString())) + u"/file-upload/bla.png"_s;
+    QVERIFY(!cache.isCached(cacheFile));
+    QVERIFY(createFile(cacheFile, 10));
+    QVERIFY(cache.isCached(cacheFile));
+    // Found file is indexed
+    QCOMPARE(cache.cacheSize(), 10);
+    QVERIFY(QFile::remove(cacheFile));
+}
+
+void RocketChatCacheTest::shouldLoadCacheIndex()
+{
+    RocketChatAccount account(accountName());
+    // Created after the account: first cache of an account removes old cache files
+    const QString directory = QDir::cleanPath(ManagerDataPaths::self()->path(ManagerDataPaths::Cache, accountName()));
+    QVERIFY(createFile(directory + u"/file-upload/foo.png"_s, 10));
+    QVERIFY(createFile(directory + u"/file-upload/bla.png"_s, 20));
+    QVERIFY(createFile(directory + u"/file-upload/bla.png.part"_s, 5));
+
+    RocketChatCache cache(&account);
+    QTRY_VERIFY(cache.cacheIndexLoaded());
+    QCOMPARE(cache.cacheSize(), 30);
+    QVERIFY(cache.isCached(directory + u"/file-upload/foo.png"_s));
+    QVERIFY(cache.isCached(directory + u"/file-upload/bla.png"_s));
+    QVERIFY(!cache.isCached(directory + u"/file-upload/bla.png.part"_s));
+
+    // Once loaded, only the index is used
+    QVERIFY(createFile(directory + u"/file-upload/new.png"_s, 10));
+    QVERIFY(!cache.isCached(directory + u"/file-upload/new.png"_s));
+    QCOMPARE(cache.cacheSize(), 30);
+
+    // Index is saved in the database
+    const LocalCacheIndexDatabase::CacheFiles indexedFiles = LocalCacheIndexDatabase().cacheFiles(accountName());
+    QVERIFY(indexedFiles.contains(directory + u"/file-upload/foo.png"_s));
+    QVERIFY(indexedFiles.contains(directory + u"/file-upload/bla.png"_s));
+    QVERIFY(!indexedFiles.contains(directory + u"/file-upload/bla.png.part"_s));
+
+    QVERIFY(QDir(directory + u"/file-upload"_s).removeRecursively());
+}
+
 #include "moc_rocketchatcachetest.cpp"
@@ -14,4 +14,18 @@ class RocketChatCacheTest : public QObject
 public:
     explicit RocketChatCacheTest(QObject *parent = nullptr);
     ~RocketChatCacheTest() override = default;
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void shouldIndexOnlyCacheDirectories_data();
+    void shouldIndexOnlyCacheDirectories();
+    void shouldNotIndexPartialDownloads();
+    void shouldRemoveAbandonedPartialDownloads();
+    void shouldEvictLeastRecentlyUsedFirst();
+    void shouldEvictUntilBudgetIsReached();
+    void shouldEvictExpiredFiles();
+    void shouldNotRemoveFilesOutsideCache();
+    void shouldNotIndexDownloadsOutsideCache();
+    void shouldLookUpDiskUntilIndexIsLoaded();
+    void shouldLoadCacheIndex();
 };
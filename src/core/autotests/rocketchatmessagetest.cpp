@@ -15,9 +15,9 @@ RocketChatMessageTest::RocketChatMessageTest(QObject *parent)
 {
 }
 
-void RocketChatMessageTest::compareFile(const QString &data, const QString &name)
+void RocketChatMessageTest::compareFile(const QByteArray &data, const QString &name)
 {
-    AutoTestHelper::compareFile(QStringLiteral("/method/"), data.toUtf8(), name);
+    AutoTestHelper::compareFile(QStringLiteral("/method/"), data, name);
 }
 
 void RocketChatMessageTest::shouldSetDefaultStatus()
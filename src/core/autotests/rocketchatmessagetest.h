@@ -64,5 +64,5 @@ private Q_SLOTS:
     void getRoomByTypeAndName();
 
 private:
-    void compareFile(const QString &data, const QString &name);
+    void compareFile(const QByteArray &data, const QString &name);
 };
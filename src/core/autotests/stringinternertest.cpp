@@ -0,0 +1,72 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "stringinternertest.h"
+#include "messages/message.h"
+#include "stringinterner.h"
+#include <QJsonObject>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(StringInternerTest)
+
+using namespace Qt::Literals::StringLiterals;
+
+StringInternerTest::StringInternerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void StringInternerTest::shouldShareStrings()
+{
+    auto &interner = StringInterner::self();
+    // Built at runtime, as when parsing
+    const QString first = interner.intern(u"user"_s + QString::number(1));
+    const QString second = interner.intern(u"user"_s + QString::number(1));
+    QCOMPARE(second, u"user1"_s);
+    QVERIFY(second.isSharedWith(first));
+
+    const QByteArray firstId = interner.intern(QByteArray("id") + QByteArray::number(1));
+    const QByteArray secondId = interner.intern(QByteArray("id") + QByteArray::number(1));
+    QCOMPARE(secondId, QByteArray("id1"));
+    QVERIFY(secondId.isSharedWith(firstId));
+
+    QVERIFY(interner.intern(QString()).isEmpty());
+}
+
+void StringInternerTest::shouldPurgeUnusedStrings()
+{
+    auto &interner = StringInterner::self();
+    interner.purge();
+    const qsizetype count = interner.count();
+    {
+        const QString str = interner.intern(u"foo"_s + QString::number(2));
+        QCOMPARE(interner.count(), count + 1);
+        interner.purge();
+        // Still used
+        QCOMPARE(interner.count(), count + 1);
+    }
+    interner.purge();
+    QCOMPARE(interner.count(), count);
+}
+
+void StringInternerTest::shouldShareMessageIdentityFields()
+{
+    auto createMessage = [](const QByteArray &messageId) {
+        const QJsonObject user{{"_id"_L1, QString::fromLatin1("uid" + QByteArray::number(42))}, {"username"_L1, u"foo"_s + QString::number(42)}};
+        const QJsonObject obj{{"_id"_L1, QString::fromLatin1(messageId)}, {"rid"_L1, u"room"_s + QString::number(42)}, {"msg"_L1, u"text"_s}, {"u"_L1, user}};
+        Message message;
+        message.parseMessage(obj, true, nullptr);
+        return message;
+    };
+    const Message first = createMessage("msg1");
+    const Message second = createMessage("msg2");
+    QCOMPARE(second.username(), u"foo42"_s);
+    QVERIFY(second.username().isSharedWith(first.username()));
+    QVERIFY(second.userId().isSharedWith(first.userId()));
+    QVERIFY(second.roomId().isSharedWith(first.roomId()));
+}
+
+#include "moc_stringinternertest.cpp"
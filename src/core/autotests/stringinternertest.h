@@ -0,0 +1,21 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class StringInternerTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StringInternerTest(QObject *parent = nullptr);
+    ~StringInternerTest() override = default;
+private Q_SLOTS:
+    void shouldShareStrings();
+    void shouldPurgeUnusedStrings();
+    void shouldShareMessageIdentityFields();
+};
@@ -396,6 +396,33 @@ void TextConverterTest::shouldConvertTextWithEmoji()
     QCOMPARE(actualOutput, output); // TODO add autotest for highlightwords
 }
 
+void TextConverterTest::shouldConvertTextWithEmojiReplacementTable_data()
+{
+    shouldConvertTextWithEmoji_data();
+}
+
+void TextConverterTest::shouldConvertTextWithEmojiReplacementTable()
+{
+    QFETCH(QString, input);
+    QFETCH(QString, serverUrl);
+
+    const QString originalJsonFile = QLatin1StringView(RUQOLA_DATA_DIR) + "/json/restapi/emojiparent.json"_L1;
+    const QJsonObject obj = AutoTestHelper::loadJsonObject(originalJsonFile);
+    EmojiManager manager(nullptr);
+    manager.loadCustomEmoji(obj);
+    manager.setServerUrl(serverUrl);
+
+    // Conversion done in worker threads must give the same result as the one using EmojiManager
+    QByteArray needUpdateMessageId;
+    int recursiveIndex = 0;
+    const TextConverter::ConvertMessageTextSettings settings(input, QString(), {}, {}, &manager, nullptr, {}, {});
+    const QString expectedOutput = TextConverter::convertMessageText(settings, needUpdateMessageId, recursiveIndex);
+
+    recursiveIndex = 0;
+    const TextConverter::ConvertMessageTextSettings tableSettings(input, QString(), {}, {}, nullptr, nullptr, {}, {}, {}, -1, manager.replacementTable());
+    QCOMPARE(TextConverter::convertMessageText(tableSettings, needUpdateMessageId, recursiveIndex), expectedOutput);
+}
+
 void TextConverterTest::shouldShowChannels_data()
 {
     QTest::addColumn<QString>("input");
@@ -584,4 +611,42 @@ void TextConverterTest::shouldShowSearchedText()
     QCOMPARE(TextConverter::convertMessageText(settings, needUpdateMessageId, recursiveIndex), output);
 }
 
+void TextConverterTest::shouldResolveQuotedMessageWithLookup()
+{
+    Message quotedMessage;
+    quotedMessage.setMessageId(QByteArrayLiteral("3BR34NSG5x7ZfBa22"));
+    quotedMessage.setUsername(QStringLiteral("foo"));
+    quotedMessage.setText(QStringLiteral("quoted *text*"));
+    quotedMessage.setTimeStamp(42);
+    const QList<Message> allMessages{quotedMessage};
+    const QString input = QStringLiteral("[ ](https://www.kde.org/channel/all?msg=3BR34NSG5x7ZfBa22) answer");
+
+    QByteArray needUpdateMessageId;
+    int recursiveIndex = 0;
+    const TextConverter::ConvertMessageTextSettings settings(input, QString(), allMessages, {}, nullptr, nullptr, {}, {});
+    const QString expectedOutput = TextConverter::convertMessageText(settings, needUpdateMessageId, recursiveIndex);
+    QVERIFY(needUpdateMessageId.isEmpty());
+    QVERIFY(expectedOutput.contains(QStringLiteral("<em>text</em>")));
+
+    int lookupCount = 0;
+    const TextConverter::MessageLookup lookup = [&](const QByteArray &messageId) -> const Message * {
+        ++lookupCount;
+        return messageId == quotedMessage.messageId() ? &quotedMessage : nullptr;
+    };
+    TextConverter::clearQuotedTextCache();
+    for (int i = 0; i < 2; ++i) {
+        // Second time quoted message comes from cache
+        recursiveIndex = 0;
+        const TextConverter::ConvertMessageTextSettings lookupSettings(input, QString(), {}, {}, nullptr, nullptr, {}, {}, {}, -1, {}, lookup);
+        QCOMPARE(TextConverter::convertMessageText(lookupSettings, needUpdateMessageId, recursiveIndex), expectedOutput);
+    }
+    QCOMPARE(lookupCount, 2);
+
+    // Quoted message not found and no message cache to load it
+    recursiveIndex = 0;
+    const TextConverter::ConvertMessageTextSettings notFoundSettings(input, QString(), {}, {}, nullptr, nullptr, {}, {});
+    (void)TextConverter::convertMessageText(notFoundSettings, needUpdateMessageId, recursiveIndex);
+    QCOMPARE(needUpdateMessageId, quotedMessage.messageId());
+}
+
 #include "moc_textconvertertest.cpp"
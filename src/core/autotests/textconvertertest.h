@@ -27,6 +27,9 @@ private Q_SLOTS:
     void shouldConvertTextWithEmoji_data();
     void shouldConvertTextWithEmoji();
 
+    void shouldConvertTextWithEmojiReplacementTable_data();
+    void shouldConvertTextWithEmojiReplacementTable();
+
     void shouldShowChannels_data();
     void shouldShowChannels();
 
@@ -35,4 +38,6 @@ private Q_SLOTS:
 
     void shouldShowSearchedText_data();
     void shouldShowSearchedText();
+
+    void shouldResolveQuotedMessageWithLookup();
 };
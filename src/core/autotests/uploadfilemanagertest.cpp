@@ -0,0 +1,245 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "uploadfilemanagertest.h"
+#include "rocketchataccount.h"
+#include "ruqolaglobalconfig.h"
+#include "uploadfilemanager.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(UploadFileManagerTest)
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Nothing is sent, the test emits the signals of the network reply
+class FakeUploadFileJob : public RocketChatRestApi::UploadFileJob
+{
+public:
+    explicit FakeUploadFileJob(QObject *parent)
+        : RocketChatRestApi::UploadFileJob(parent)
+    {
+    }
+    [[nodiscard]] bool start() override
+    {
+        return true;
+    }
+};
+
+class UploadEnvironment
+{
+public:
+    UploadEnvironment()
+        : manager(&account)
+    {
+        manager.setRetryDelay(0ms);
+        manager.setCreateJobFunction([this](QObject *parent) {
+            auto job = new FakeUploadFileJob(parent);
+            jobs.append(job);
+            return job;
+        });
+    }
+
+    [[nodiscard]] int addUpload(const QString &fileName, bool deleteTemporaryFile = false)
+    {
+        const QString filePath = dir.filePath(fileName);
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly) || file.write("data") != 4) {
+            return -1;
+        }
+        RocketChatRestApi::UploadFileJob::UploadFileInfo info;
+        info.roomId = "room1"_ba;
+        info.filenameUrl = QUrl::fromLocalFile(filePath);
+        info.deleteTemporaryFile = deleteTemporaryFile;
+        return manager.addUpload(info);
+    }
+
+    // Job is deleted like when its reply is finished
+    void finishJob(int index)
+    {
+        QPointer<RocketChatRestApi::UploadFileJob> job = jobs.at(index);
+        Q_EMIT job->uploadFinished();
+        delete job;
+    }
+
+    void interruptJob(int index)
+    {
+        QPointer<RocketChatRestApi::UploadFileJob> job = jobs.at(index);
+        Q_EMIT job->uploadInterrupted();
+        delete job;
+    }
+
+    [[nodiscard]] QString fileName(int index) const
+    {
+        return QFileInfo(jobs.at(index)->uploadFileInfo().filenameUrl.toLocalFile()).fileName();
+    }
+
+    QTemporaryDir dir;
+    RocketChatAccount account;
+    UploadFileManager manager;
+    QList<QPointer<RocketChatRestApi::UploadFileJob>> jobs;
+};
+
+// Uploads which are done, failed or cancelled
+QList<int> finishedUploads(const QSignalSpy &spy)
+{
+    QList<int> identifiers;
+    for (const QList<QVariant> &arguments : spy) {
+        const auto info = arguments.at(0).value<RocketChatRestApi::UploadFileJob::UploadStatusInfo>();
+        if (info.bytesTotal == 0) {
+            identifiers.append(arguments.at(1).toInt());
+        }
+    }
+    return identifiers;
+}
+}
+
+UploadFileManagerTest::UploadFileManagerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void UploadFileManagerTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    RuqolaGlobalConfig::self()->setRecompressUploadedImages(false);
+}
+
+void UploadFileManagerTest::shouldQueueUploads()
+{
+    UploadEnvironment environment;
+    QSignalSpy spy(&environment.manager, &UploadFileManager::uploadProgress);
+    const int first = environment.addUpload(u"file1"_s);
+    const int second = environment.addUpload(u"file2"_s);
+    const int third = environment.addUpload(u"file3"_s);
+    QVERIFY(first != -1);
+    QVERIFY(second != -1);
+    QVERIFY(third != -1);
+    QCOMPARE(environment.jobs.count(), UploadFileManager::maximumParallelUploads);
+    QCOMPARE(environment.fileName(0), u"file1"_s);
+    QCOMPARE(environment.fileName(1), u"file2"_s);
+
+    environment.finishJob(1);
+    QCOMPARE(finishedUploads(spy), QList<int>{second});
+    // Pending upload is started
+    QCOMPARE(environment.jobs.count(), 3);
+    QCOMPARE(environment.fileName(2), u"file3"_s);
+
+    environment.finishJob(0);
+    environment.finishJob(2);
+    QCOMPARE(finishedUploads(spy), (QList<int>{second, first, third}));
+    QCOMPARE(environment.jobs.count(), 3);
+}
+
+void UploadFileManagerTest::shouldRetryUploadNotSent()
+{
+    UploadEnvironment environment;
+    QSignalSpy spy(&environment.manager, &UploadFileManager::uploadProgress);
+    const int first = environment.addUpload(u"file1"_s);
+    QVERIFY(first != -1);
+    QCOMPARE(environment.jobs.count(), 1);
+    QVERIFY(environment.jobs.at(0)->retryOnNetworkError());
+
+    environment.interruptJob(0);
+    // Upload isn't finished, it's sent again after the delay
+    QVERIFY(finishedUploads(spy).isEmpty());
+    QTRY_COMPARE(environment.jobs.count(), 2);
+    QCOMPARE(environment.fileName(1), u"file1"_s);
+
+    environment.finishJob(1);
+    QCOMPARE(finishedUploads(spy), QList<int>{first});
+}
+
+void UploadFileManagerTest::shouldOnlyConfirmStoredFile()
+{
+    UploadEnvironment environment;
+    QSignalSpy spy(&environment.manager, &UploadFileManager::uploadProgress);
+    const int first = environment.addUpload(u"file1"_s);
+    QVERIFY(first != -1);
+    QVERIFY(environment.jobs.at(0)->uploadedFileId().isEmpty());
+
+    // File was stored, posting the message was interrupted
+    Q_EMIT environment.jobs.at(0)->mediaUploaded("file1id"_ba);
+    environment.interruptJob(0);
+    QTRY_COMPARE(environment.jobs.count(), 2);
+    QCOMPARE(environment.jobs.at(1)->uploadedFileId(), "file1id"_ba);
+
+    environment.finishJob(1);
+    QCOMPARE(finishedUploads(spy), QList<int>{first});
+}
+
+void UploadFileManagerTest::shouldGiveUpAfterMaximumAttempts()
+{
+    UploadEnvironment environment;
+    QSignalSpy spy(&environment.manager, &UploadFileManager::uploadProgress);
+    const int first = environment.addUpload(u"file1"_s);
+    QVERIFY(first != -1);
+    for (int attempt = 1; attempt < UploadFileManager::maximumAttempts; ++attempt) {
+        QTRY_COMPARE(environment.jobs.count(), attempt);
+        QVERIFY(environment.jobs.constLast()->retryOnNetworkError());
+        environment.interruptJob(attempt - 1);
+    }
+    QTRY_COMPARE(environment.jobs.count(), UploadFileManager::maximumAttempts);
+    // Last attempt reports the error instead of being interrupted
+    QVERIFY(!environment.jobs.constLast()->retryOnNetworkError());
+    environment.finishJob(UploadFileManager::maximumAttempts - 1);
+    QCOMPARE(finishedUploads(spy), QList<int>{first});
+}
+
+void UploadFileManagerTest::shouldCancelUploads()
+{
+    UploadEnvironment environment;
+    QSignalSpy spy(&environment.manager, &UploadFileManager::uploadProgress);
+    const int first = environment.addUpload(u"file1"_s);
+    const int second = environment.addUpload(u"file2"_s);
+    const int third = environment.addUpload(u"file3"_s);
+    const int fourth = environment.addUpload(u"file4"_s);
+    QCOMPARE(environment.jobs.count(), 2);
+
+    // Pending upload is never started
+    environment.manager.cancelJob(third);
+    QCOMPARE(finishedUploads(spy), QList<int>{third});
+    QCOMPARE(environment.jobs.count(), 2);
+
+    // Running upload is aborted, next pending upload is started
+    environment.manager.cancelJob(first);
+    QCOMPARE(finishedUploads(spy), (QList<int>{third, first}));
+    QCOMPARE(environment.jobs.count(), 3);
+    QCOMPARE(environment.fileName(2), u"file4"_s);
+    QTRY_VERIFY(!environment.jobs.at(0));
+
+    // Upload waiting for a retry isn't sent again
+    environment.interruptJob(1);
+    environment.manager.cancelJob(second);
+    QCOMPARE(finishedUploads(spy), (QList<int>{third, first, second}));
+    QTest::qWait(10);
+    QCOMPARE(environment.jobs.count(), 3);
+
+    environment.finishJob(2);
+    QCOMPARE(finishedUploads(spy), (QList<int>{third, first, second, fourth}));
+}
+
+void UploadFileManagerTest::shouldRemoveTemporaryFile()
+{
+    UploadEnvironment environment;
+    const int first = environment.addUpload(u"file1"_s, true);
+    const int second = environment.addUpload(u"file2"_s, false);
+    QVERIFY(first != -1);
+    QVERIFY(second != -1);
+    environment.finishJob(0);
+    environment.finishJob(1);
+    QVERIFY(!QFile::exists(environment.dir.filePath(u"file1"_s)));
+    QVERIFY(QFile::exists(environment.dir.filePath(u"file2"_s)));
+}
+
+#include "moc_uploadfilemanagertest.cpp"
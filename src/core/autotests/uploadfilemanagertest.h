@@ -0,0 +1,25 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class UploadFileManagerTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UploadFileManagerTest(QObject *parent = nullptr);
+    ~UploadFileManagerTest() override = default;
+private Q_SLOTS:
+    void initTestCase();
+    void shouldQueueUploads();
+    void shouldRetryUploadNotSent();
+    void shouldOnlyConfirmStoredFile();
+    void shouldGiveUpAfterMaximumAttempts();
+    void shouldCancelUploads();
+    void shouldRemoveTemporaryFile();
+};
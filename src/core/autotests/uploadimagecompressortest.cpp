@@ -0,0 +1,135 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "uploadimagecompressortest.h"
+#include "uploadimagecompressor.h"
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(UploadImageCompressorTest)
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+// Noise doesn't compress well in png
+QImage createNoiseImage(int width, int height, bool transparent)
+{
+    QImage image(width, height, transparent ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    QRandomGenerator generator(42);
+    for (int y = 0; y < height; ++y) {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const quint32 value = generator.generate();
+            line[x] = transparent ? qRgba(value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, 128) : (value | 0xff000000);
+        }
+    }
+    return image;
+}
+}
+
+UploadImageCompressorTest::UploadImageCompressorTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void UploadImageCompressorTest::shouldHaveDefaultValues()
+{
+    const UploadImageCompressor::Settings settings;
+    QCOMPARE(settings.maximumSize, 2048);
+    QCOMPARE(settings.quality, 85);
+}
+
+void UploadImageCompressorTest::shouldDownscaleOpaqueImage()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(u"screenshot.png"_s);
+    QImage image = createNoiseImage(600, 300, false);
+    image.setText(u"Author"_s, u"foo"_s);
+    QVERIFY(image.save(filePath));
+
+    UploadImageCompressor::Settings settings;
+    settings.maximumSize = 200;
+    const QString compressedFilePath = UploadImageCompressor::compressImage(filePath, settings);
+    QVERIFY(!compressedFilePath.isEmpty());
+    QVERIFY(compressedFilePath.endsWith(u".jpg"_s));
+
+    QImageReader reader(compressedFilePath);
+    QCOMPARE(reader.format(), QByteArrayLiteral("jpeg"));
+    QCOMPARE(reader.size(), QSize(200, 100));
+    QVERIFY(reader.text(u"Author"_s).isEmpty());
+    QVERIFY(QFile::size(compressedFilePath) < QFile::size(filePath));
+    QVERIFY(QFile::remove(compressedFilePath));
+}
+
+void UploadImageCompressorTest::shouldKeepTransparentImage()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(u"logo.png"_s);
+    QVERIFY(createNoiseImage(400, 400, true).save(filePath));
+
+    UploadImageCompressor::Settings settings;
+    settings.maximumSize = 100;
+    const QString compressedFilePath = UploadImageCompressor::compressImage(filePath, settings);
+    QVERIFY(compressedFilePath.endsWith(u".png"_s));
+
+    const QImage compressedImage(compressedFilePath);
+    QCOMPARE(compressedImage.size(), QSize(100, 100));
+    QVERIFY(compressedImage.hasAlphaChannel());
+    QVERIFY(QFile::remove(compressedFilePath));
+}
+
+void UploadImageCompressorTest::shouldIgnoreOtherFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(u"notes.txt"_s);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("foo");
+    file.close();
+    QVERIFY(UploadImageCompressor::compressImage(filePath, {}).isEmpty());
+    QVERIFY(UploadImageCompressor::compressImage(dir.filePath(u"missing.png"_s), {}).isEmpty());
+}
+
+void UploadImageCompressorTest::shouldNotReturnBiggerFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // A plain color png is smaller than any jpeg
+    const QString filePath = dir.filePath(u"plain.png"_s);
+    QImage image(100, 100, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QVERIFY(image.save(filePath));
+    QVERIFY(UploadImageCompressor::compressImage(filePath, {}).isEmpty());
+}
+
+void UploadImageCompressorTest::shouldChangeFileNameSuffix_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<QString>("compressedFilePath");
+    QTest::addColumn<QString>("result");
+    QTest::newRow("png-to-jpg") << u"screenshot.png"_s << u"/tmp/abcdef.jpg"_s << u"screenshot.jpg"_s;
+    QTest::newRow("same-suffix") << u"photo.jpg"_s << u"/tmp/abcdef.jpg"_s << u"photo.jpg"_s;
+    QTest::newRow("jpeg") << u"photo.JPEG"_s << u"/tmp/abcdef.jpg"_s << u"photo.JPEG"_s;
+    QTest::newRow("no-suffix") << u"image"_s << u"/tmp/abcdef.png"_s << u"image.png"_s;
+    QTest::newRow("dots") << u"my.screen.bmp"_s << u"/tmp/abcdef.png"_s << u"my.screen.png"_s;
+}
+
+void UploadImageCompressorTest::shouldChangeFileNameSuffix()
+{
+    QFETCH(QString, fileName);
+    QFETCH(QString, compressedFilePath);
+    QFETCH(QString, result);
+    QCOMPARE(UploadImageCompressor::compressedFileName(fileName, compressedFilePath), result);
+}
+
+#include "moc_uploadimagecompressortest.cpp"
@@ -0,0 +1,25 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class UploadImageCompressorTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UploadImageCompressorTest(QObject *parent = nullptr);
+    ~UploadImageCompressorTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldDownscaleOpaqueImage();
+    void shouldKeepTransparentImage();
+    void shouldIgnoreOtherFiles();
+    void shouldNotReturnBiggerFile();
+    void shouldChangeFileNameSuffix_data();
+    void shouldChangeFileNameSuffix();
+};
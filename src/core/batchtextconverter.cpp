@@ -0,0 +1,268 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "batchtextconverter.h"
+#include "emoticons/emojimanager.h"
+#include "highlightedcodecache.h"
+#include "textconverter.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QPointer>
+#include <QThreadPool>
+
+using namespace Qt::Literals::StringLiterals;
+
+QThreadPool *BatchTextConverter::threadPool()
+{
+    static QThreadPool *s_threadPool = []() {
+        auto pool = new QThreadPool(QCoreApplication::instance());
+        // Keep threads alive: each one has its own SyntaxHighlightingManager repository which is expensive to load
+        pool->setExpiryTimeout(-1);
+        pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return pool;
+    }();
+    return s_threadPool;
+}
+
+QList<BatchTextConverter::Result> BatchTextConverter::convertMessages(const Settings &settings, const QList<Message> &messages)
+{
+    QList<Result> results;
+    results.reserve(messages.count());
+    QHash<QByteArray, qsizetype> messageIndex;
+    messageIndex.reserve(settings.allMessages.count());
+    for (qsizetype i = 0, total = settings.allMessages.count(); i < total; ++i) {
+        messageIndex.insert(settings.allMessages.at(i).messageId(), i);
+    }
+    const TextConverter::MessageLookup messageLookup = [&settings, &messageIndex](const QByteArray &messageId) -> const Message * {
+        const qsizetype index = messageIndex.value(messageId, -1);
+        return index == -1 ? nullptr : &settings.allMessages.at(index);
+    };
+    for (const Message &message : messages) {
+        if (message.messageType() == Message::System || message.text().isEmpty()) {
+            continue;
+        }
+        if (settings.emojiReplacementTable) {
+            const QStringList &unresolvedCustomEmojis = settings.emojiReplacementTable->unresolvedCustomEmojis;
+            const bool hasUnresolvedEmoji = std::any_of(unresolvedCustomEmojis.cbegin(), unresolvedCustomEmojis.cend(), [&message](const QString &identifier) {
+                return message.text().contains(identifier);
+            });
+            if (hasUnresolvedEmoji) {
+                continue;
+            }
+        }
+        const TextConverter::ConvertMessageTextSettings convertSettings(message.text(),
+                                                                        settings.userName,
+                                                                        settings.allMessages,
+                                                                        settings.highlightWords,
+                                                                        nullptr,
+                                                                        nullptr,
+                                                                        message.mentions(),
+                                                                        message.channels(),
+                                                                        {},
+                                                                        settings.maximumRecursiveQuotedText,
+                                                                        settings.emojiReplacementTable,
+                                                                        messageLookup,
+                                                                        settings.colors);
+        QByteArray needUpdateMessageId;
+        int recursiveIndex = 0;
+        const QString convertedText = TextConverter::convertMessageText(convertSettings, needUpdateMessageId, recursiveIndex);
+        if (!needUpdateMessageId.isEmpty() || convertedText.contains(HighlightedCodeCache::pendingHighlightingMarker())) {
+            // Quoted message is not loaded or code not highlighted yet, main thread will do it.
+            continue;
+        }
+        Result result;
+        result.messageId = message.messageId();
+        result.convertedText = convertedText;
+        results.append(std::move(result));
+    }
+    return results;
+}
+
+BatchTextConverter::Settings BatchTextConverter::workerSettings(const Settings &settings)
+{
+    if (settings.colors) {
+        return settings;
+    }
+    // Color scheme can't be read in worker threads
+    Settings newSettings = settings;
+    newSettings.colors = std::make_shared<const TextConverter::TextColors>(TextConverter::TextColors::fromColorScheme());
+    return newSettings;
+}
+
+void BatchTextConverter::convert(const Settings &currentSettings, const QList<Message> &messages, QObject *context, const ResultCallback &callback)
+{
+    const Settings settings = workerSettings(currentSettings);
+    const QPointer<QObject> guard(context);
+    for (qsizetype i = 0, total = messages.count(); i < total; i += chunkSize) {
+        const QList<Message> chunk = messages.mid(i, chunkSize);
+        threadPool()->start([settings, chunk, guard, callback]() {
+            const QList<Result> results = convertMessages(settings, chunk);
+            if (results.isEmpty()) {
+                return;
+            }
+            // Deliver results in main thread, guard is only dereferenced there.
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [guard, callback, results]() {
+                    if (guard) {
+                        callback(results);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+    }
+}
+
+namespace
+{
+const auto codeBlockMarker = "```"_L1;
+
+// Returns the fence of the code block still open at @p end, @p openFence is the one open at @p startPosition
+QString codeBlockFenceAt(const QString &text, qsizetype startPosition, qsizetype end, QString openFence)
+{
+    qsizetype markerPosition = text.indexOf(codeBlockMarker, startPosition);
+    while (markerPosition != -1 && markerPosition < end) {
+        const qsizetype nextMarkerPosition = text.indexOf(codeBlockMarker, markerPosition + codeBlockMarker.size());
+        if (openFence.isEmpty()) {
+            // Marker and info string
+            qsizetype fenceEnd = text.indexOf(u'\n', markerPosition);
+            if (fenceEnd == -1 || fenceEnd > end) {
+                fenceEnd = end;
+            }
+            if (nextMarkerPosition != -1 && nextMarkerPosition < fenceEnd) {
+                fenceEnd = nextMarkerPosition;
+            }
+            openFence = text.mid(markerPosition, fenceEnd - markerPosition).trimmed();
+        } else {
+            openFence.clear();
+        }
+        markerPosition = nextMarkerPosition;
+    }
+    return openFence;
+}
+}
+
+qsizetype BatchTextConverter::chunkEnd(const QString &text, qsizetype startPosition, qsizetype chunkSize, bool insideCodeBlock)
+{
+    if (text.size() - startPosition <= chunkSize) {
+        return text.size();
+    }
+    const qsizetype minimumEnd = startPosition + chunkSize;
+    // One line or one code block can be the whole text: don't look too far
+    const qsizetype maximumEnd = qMin(text.size(), startPosition + maximumChunkSizeFactor * chunkSize);
+    // Paragraph first, otherwise a line
+    for (const auto separator : {"\n\n"_L1, "\n"_L1}) {
+        bool inCodeBlock = insideCodeBlock;
+        qsizetype codeBlockMarkerPosition = text.indexOf(codeBlockMarker, startPosition);
+        qsizetype position = text.indexOf(separator, minimumEnd);
+        while (position != -1 && position <= maximumEnd) {
+            while (codeBlockMarkerPosition != -1 && codeBlockMarkerPosition < position) {
+                inCodeBlock = !inCodeBlock;
+                codeBlockMarkerPosition = text.indexOf(codeBlockMarker, codeBlockMarkerPosition + codeBlockMarker.size());
+            }
+            if (!inCodeBlock) {
+                return position;
+            }
+            position = text.indexOf(separator, position + separator.size());
+        }
+    }
+    // Line in a code block: it's closed and opened again (see textChunk())
+    const qsizetype lineEnd = text.indexOf(u'\n', minimumEnd);
+    if (lineEnd != -1 && lineEnd <= maximumEnd) {
+        return lineEnd;
+    }
+    // One long line: between two words
+    for (qsizetype position = minimumEnd; position < maximumEnd; ++position) {
+        if (text.at(position).isSpace()) {
+            return position;
+        }
+    }
+    // Hard cut, without splitting a surrogate pair or a code block marker
+    qsizetype position = minimumEnd;
+    if (text.at(position - 1).isHighSurrogate()) {
+        --position;
+    }
+    const qsizetype markerPosition = text.indexOf(codeBlockMarker, qMax(startPosition, position - codeBlockMarker.size() + 1));
+    if (markerPosition > startPosition && markerPosition < position) {
+        position = markerPosition;
+    }
+    return position;
+}
+
+BatchTextConverter::TextChunk BatchTextConverter::textChunk(const QString &text, qsizetype startPosition, const QString &openCodeBlockFence, qsizetype chunkSize)
+{
+    TextChunk chunk;
+    chunk.end = chunkEnd(text, startPosition, chunkSize, !openCodeBlockFence.isEmpty());
+    chunk.openCodeBlockFence = codeBlockFenceAt(text, startPosition, chunk.end, openCodeBlockFence);
+    qsizetype contentStart = startPosition;
+    if (!openCodeBlockFence.isEmpty()) {
+        // Previous chunk ended before this line break
+        if (contentStart < chunk.end && text.at(contentStart) == u'\n') {
+            ++contentStart;
+        }
+        chunk.text = openCodeBlockFence + u'\n';
+    }
+    chunk.text += QStringView(text).mid(contentStart, chunk.end - contentStart);
+    if (!chunk.openCodeBlockFence.isEmpty()) {
+        chunk.text += u'\n' + codeBlockMarker;
+    }
+    return chunk;
+}
+
+QString BatchTextConverter::convertChunk(const Settings &currentSettings, const Message &message, const TextChunk &chunk)
+{
+    const Settings settings = workerSettings(currentSettings);
+    const TextConverter::ConvertMessageTextSettings convertSettings(chunk.text,
+                                                                    settings.userName,
+                                                                    settings.allMessages,
+                                                                    settings.highlightWords,
+                                                                    nullptr,
+                                                                    nullptr,
+                                                                    message.mentions(),
+                                                                    message.channels(),
+                                                                    {},
+                                                                    settings.maximumRecursiveQuotedText,
+                                                                    settings.emojiReplacementTable,
+                                                                    {},
+                                                                    settings.colors);
+    QByteArray needUpdateMessageId;
+    int recursiveIndex = 0;
+    return TextConverter::convertMessageTextFragment(convertSettings, needUpdateMessageId, recursiveIndex);
+}
+
+void BatchTextConverter::convertInChunks(const Settings &currentSettings,
+                                         const Message &message,
+                                         qsizetype startPosition,
+                                         const QString &openCodeBlockFence,
+                                         QObject *context,
+                                         const ChunkCallback &callback)
+{
+    const Settings settings = workerSettings(currentSettings);
+    const QPointer<QObject> guard(context);
+    threadPool()->start([settings, message, startPosition, openCodeBlockFence, guard, callback]() {
+        const QString text = message.text();
+        qsizetype position = startPosition;
+        QString fence = openCodeBlockFence;
+        while (position < text.size()) {
+            const TextChunk chunk = textChunk(text, position, fence);
+            const QString html = convertChunk(settings, message, chunk);
+            position = chunk.end;
+            fence = chunk.openCodeBlockFence;
+            const bool finished = position >= text.size();
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [guard, callback, html, finished]() {
+                    if (guard) {
+                        callback(html, finished);
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    });
+}
@@ -0,0 +1,108 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include "messages/message.h"
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+#include <memory>
+class QThreadPool;
+struct EmojiReplacementTable;
+namespace TextConverter
+{
+struct TextColors;
+}
+/**
+ * Converts a batch of messages (history pages) to rich text in parallel, outside of the main thread.
+ * Messages which can't be converted without main thread resources (quoted message not loaded,
+ * custom emoji still downloading) are skipped: they will be converted lazily when painted.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT BatchTextConverter
+{
+public:
+    struct LIBRUQOLACORE_TESTS_EXPORT Settings {
+        QString userName;
+        QStringList highlightWords;
+        // Messages used to resolve quoted messages
+        QList<Message> allMessages;
+        std::shared_ptr<const EmojiReplacementTable> emojiReplacementTable;
+        // Copied from the color scheme in main thread
+        std::shared_ptr<const TextConverter::TextColors> colors;
+        int maximumRecursiveQuotedText = -1;
+    };
+    struct LIBRUQOLACORE_TESTS_EXPORT Result {
+        QByteArray messageId;
+        QString convertedText;
+    };
+    /**
+     * Part of a large text converted on its own.
+     * A code block cut in the middle is closed at the end of the chunk and opened again in the next one.
+     */
+    struct LIBRUQOLACORE_TESTS_EXPORT TextChunk {
+        // Markdown to convert
+        QString text;
+        // Position in the whole text where next chunk starts
+        qsizetype end = 0;
+        // Opening fence (with its info string) of the code block which continues in next chunk, empty otherwise
+        QString openCodeBlockFence;
+    };
+    using ResultCallback = std::function<void(const QList<BatchTextConverter::Result> &)>;
+    // html of the converted chunk, without <qt> tags
+    using ChunkCallback = std::function<void(const QString &html, bool finished)>;
+
+    /**
+     * Starts conversion of @p messages, @p callback is called in main thread for each converted chunk,
+     * as long as @p context is alive.
+     */
+    static void convert(const Settings &settings, const QList<Message> &messages, QObject *context, const ResultCallback &callback);
+
+    // Synchronous version, it's what runs in worker threads
+    [[nodiscard]] static QList<BatchTextConverter::Result> convertMessages(const Settings &settings, const QList<Message> &messages);
+
+    /**
+     * Converts @p message text from @p startPosition chunk by chunk, @p callback is called in main thread
+     * after each chunk, as long as @p context is alive.
+     * @p openCodeBlockFence is the fence of the code block in which @p startPosition is (see TextChunk).
+     */
+    static void convertInChunks(const Settings &settings,
+                                const Message &message,
+                                qsizetype startPosition,
+                                const QString &openCodeBlockFence,
+                                QObject *context,
+                                const ChunkCallback &callback);
+
+    // Converts one chunk of @p message, html is returned without <qt> tags
+    [[nodiscard]] static QString convertChunk(const Settings &settings, const Message &message, const TextChunk &chunk);
+
+    /**
+     * Returns where a chunk of at least @p chunkSize characters starting at @p startPosition ends:
+     * after a paragraph or a line outside of code blocks when there is one close enough,
+     * otherwise after a line in a code block, between two words, or at @p chunkSize.
+     * @p insideCodeBlock is true when @p startPosition is in a code block.
+     */
+    [[nodiscard]] static qsizetype chunkEnd(const QString &text, qsizetype startPosition, qsizetype chunkSize, bool insideCodeBlock = false);
+
+    // Returns the chunk starting at @p startPosition, in the code block opened by @p openCodeBlockFence when it's not empty
+    [[nodiscard]] static BatchTextConverter::TextChunk
+    textChunk(const QString &text, qsizetype startPosition, const QString &openCodeBlockFence = {}, qsizetype chunkSize = textChunkSize);
+
+    [[nodiscard]] static QThreadPool *threadPool();
+
+    static constexpr int chunkSize = 16;
+    static constexpr qsizetype textChunkSize = 20000;
+    // A chunk is cut at a worse place rather than being longer than this factor times the chunk size
+    static constexpr qsizetype maximumChunkSizeFactor = 4;
+
+private:
+    // Settings with everything read from main thread
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT static BatchTextConverter::Settings workerSettings(const Settings &settings);
+};
+Q_DECLARE_TYPEINFO(BatchTextConverter::Result, Q_RELOCATABLE_TYPE);
+Q_DECLARE_TYPEINFO(BatchTextConverter::TextChunk, Q_RELOCATABLE_TYPE);
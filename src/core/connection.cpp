@@ -6,7 +6,10 @@
 
 #include "connection.h"
 #include "authenticationmanager/restauthenticationmanager.h"
+#include "downloadscheduler.h"
 #include "restapimethod.h"
+#include "restapipendingrequests.h"
+#include "restapiresponsecache.h"
 #include "rooms/roomsmembersorderedbyrolejob.h"
 #include "ruqola.h"
 #include "ruqola_debug.h"
@@ -91,7 +94,19 @@ Connection::Connection(QObject *parent)
     , mCookieJar(new QNetworkCookieJar(this))
     , mRestApiMethod(new RestApiMethod)
     , mRESTAuthenticationManager(new RESTAuthenticationManager(this, this))
-{
+    , mDownloadScheduler(new DownloadScheduler(this))
+    , mPendingRequests(new RocketChatRestApi::RestApiPendingRequests(this))
+{
+    mDownloadScheduler->setStartFunction([this](const DownloadScheduler::Request &request) {
+        auto job = downloadFile(request.url, request.localFileUrl, request.mimeType, request.requiredAuthentication);
+        connect(job, &DownloadFileJob::downloadFileDone, mDownloadScheduler, [scheduler = mDownloadScheduler, url = request.url]() {
+            scheduler->downloadFinished(url, true);
+        });
+        // Job deletes itself when download is done or failed, it's ignored when it's already finished
+        connect(job, &QObject::destroyed, mDownloadScheduler, [scheduler = mDownloadScheduler, url = request.url]() {
+            scheduler->downloadFinished(url, false);
+        });
+    });
     mNetworkAccessManager->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
     mNetworkAccessManager->setCookieJar(mCookieJar);
     connect(mNetworkAccessManager, &QNetworkAccessManager::finished, this, &Connection::slotResult);
@@ -116,6 +131,11 @@ void Connection::setRestApiLogger(RocketChatRestApi::AbstractLogger *logger)
     mRuqolaLogger = logger;
 }
 
+void Connection::setResponseCacheDirectory(const QString &path)
+{
+    mResponseCache = std::make_unique<RocketChatRestApi::RestApiResponseCache>(path);
+}
+
 void Connection::initializeCookies()
 {
     const QString url = serverUrl();
@@ -242,6 +262,8 @@ void Connection::initializeRestApiJob(RocketChatRestApi::RestApiAbstractJob *job
     job->setNetworkAccessManager(mNetworkAccessManager);
     job->setRestApiLogger(mRuqolaLogger);
     job->setRestApiMethod(mRestApiMethod);
+    job->setResponseCache(mResponseCache.get());
+    job->setPendingRequests(mPendingRequests);
     if (job->requireHttpAuthentication()) {
         job->setAuthToken(mAuthToken);
         job->setUserId(mUserId);
@@ -293,6 +315,11 @@ DownloadFileJob *Connection::downloadFile(const QUrl &url, const QUrl &localFile
     return job;
 }
 
+DownloadScheduler *Connection::downloadScheduler() const
+{
+    return mDownloadScheduler;
+}
+
 void Connection::serverInfo()
 {
     auto job = new ServerInfoJob(this);
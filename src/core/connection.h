@@ -22,16 +22,20 @@
 #include <QObject>
 #include <QSslError>
 #include <QUrl>
+#include <memory>
 
 class QNetworkAccessManager;
 class QNetworkReply;
 class QNetworkCookieJar;
 class RESTAuthenticationManager;
+class DownloadScheduler;
 namespace RocketChatRestApi
 {
 class RestApiAbstractJob;
 class DownloadFileJob;
 class AbstractLogger;
+class RestApiResponseCache;
+class RestApiPendingRequests;
 }
 
 class LIBRUQOLACORE_EXPORT Connection : public QObject
@@ -42,6 +46,8 @@ public:
     ~Connection() override;
 
     void setRestApiLogger(RocketChatRestApi::AbstractLogger *logger);
+    // Replies of the jobs using a response cache are stored there
+    void setResponseCacheDirectory(const QString &path);
     [[nodiscard]] RESTAuthenticationManager *authenticationManager() const;
 
     [[nodiscard]] QString userId() const;
@@ -65,6 +71,8 @@ public:
     void getOwnInfo();
     RocketChatRestApi::DownloadFileJob *
     downloadFile(const QUrl &url, const QUrl &localFileUrl, const QByteArray &mimeType = "text/plain", bool requiredAuthentication = true);
+    // Queue used for the files downloaded in cache, downloadFile() starts immediately
+    [[nodiscard]] DownloadScheduler *downloadScheduler() const;
     void postMessage(const QByteArray &roomId, const QString &text);
     void createChannels(const RocketChatRestApi::CreateChannelTeamInfo &info);
     void createGroups(const RocketChatRestApi::CreateChannelTeamInfo &info);
@@ -185,7 +193,10 @@ private:
     QNetworkCookieJar *const mCookieJar;
     RocketChatRestApi::RestApiMethod *const mRestApiMethod;
     RESTAuthenticationManager *const mRESTAuthenticationManager;
+    DownloadScheduler *const mDownloadScheduler;
+    RocketChatRestApi::RestApiPendingRequests *const mPendingRequests;
     RocketChatRestApi::AbstractLogger *mRuqolaLogger = nullptr;
+    std::unique_ptr<RocketChatRestApi::RestApiResponseCache> mResponseCache;
     QString mUserId;
     QString mAuthToken;
     QString mUserName;
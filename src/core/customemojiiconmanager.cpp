@@ -24,7 +24,7 @@ QIcon CustomEmojiIconManager::generateIcon(const QString &customIdentifier)
         //        qDebug() << " mCurrentRocketChatAccount " << mCurrentRocketChatAccount->accountName();
         //        qDebug() << " fileName " << fileName << "customIdentifier " << customIdentifier;
         if (!fileName.isEmpty()) {
-            const QUrl emojiUrl = mCurrentRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+            const QUrl emojiUrl = mCurrentRocketChatAccount->emojiUrlFromLocalCache(fileName);
             //            qDebug() << " emojiUrl " << emojiUrl;
             if (!emojiUrl.isEmpty()) {
                 const QIcon icon(emojiUrl.toLocalFile());
@@ -49,7 +49,7 @@ QString CustomEmojiIconManager::fileName(const QString &customIdentifier)
 {
     const QString fileName = mCurrentRocketChatAccount->emojiManager()->customEmojiFileName(customIdentifier);
     if (!fileName.isEmpty()) {
-        const QUrl emojiUrl = mCurrentRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+        const QUrl emojiUrl = mCurrentRocketChatAccount->emojiUrlFromLocalCache(fileName);
         return emojiUrl.toLocalFile();
     }
     return {};
@@ -317,7 +317,7 @@ quint64 DDPClient::videoConferenceCall(const QString &roomId, const QString &cal
 quint64 DDPClient::informTypingStatus(const QByteArray &roomId, bool typing, const QString &userName)
 {
     const RocketChatMessage::RocketChatMessageResult result = mRocketChatMessage->informTypingStatus(roomId, userName, typing, mUid);
-    const qint64 bytes = mWebSocket->sendTextMessage(result.result);
+    const qint64 bytes = mWebSocket->sendUtf8TextMessage(result.result);
     if (bytes < result.result.length()) {
         qCDebug(RUQOLA_DDPAPI_LOG) << "ERROR! I couldn't send all of my message. This is a bug! (try again)";
         qCDebug(RUQOLA_DDPAPI_LOG) << mWebSocket->isValid() << mWebSocket->error() << mWebSocket->requestUrl();
@@ -331,7 +331,7 @@ quint64 DDPClient::informTypingStatus(const QByteArray &roomId, bool typing, con
 
 quint64 DDPClient::method(const RocketChatMessage::RocketChatMessageResult &result, MethodRequestedType methodRequestedType, DDPClient::MessageType messageType)
 {
-    qint64 bytes = mWebSocket->sendTextMessage(result.result);
+    qint64 bytes = mWebSocket->sendUtf8TextMessage(result.result);
     if (bytes < result.result.length()) {
         qCDebug(RUQOLA_DDPAPI_COMMAND_LOG) << "ERROR! I couldn't send all of my message. This is a bug! (try again)";
         qCDebug(RUQOLA_DDPAPI_COMMAND_LOG) << mWebSocket->isValid() << mWebSocket->error() << mWebSocket->requestUrl();
@@ -369,7 +369,7 @@ QJsonObject DDPClient::generateJsonObject(const QString &method, const QJsonArra
 quint64
 DDPClient::storeInQueue(const RocketChatMessage::RocketChatMessageResult &result, MethodRequestedType methodRequestedType, DDPClient::MessageType messageType)
 {
-    qint64 bytes = mWebSocket->sendTextMessage(result.result);
+    qint64 bytes = mWebSocket->sendUtf8TextMessage(result.result);
     if (bytes < result.result.length()) {
         qCDebug(RUQOLA_DDPAPI_COMMAND_LOG) << "ERROR! I couldn't send all of my message. This is a bug! (try again)";
         qCDebug(RUQOLA_DDPAPI_COMMAND_LOG) << mWebSocket->isValid() << mWebSocket->error() << mWebSocket->requestUrl();
@@ -425,8 +425,9 @@ quint64 DDPClient::subscribe(const QString &collection, const QJsonArray &params
 
     json["params"_L1] = newParams;
     qCDebug(RUQOLA_DDPAPI_LOG) << "subscribe: json " << json << "m_uid " << mUid;
-    qint64 bytes = mWebSocket->sendTextMessage(QString::fromUtf8(QJsonDocument(json).toJson(QJsonDocument::Compact)));
-    if (bytes < json.length()) {
+    const QByteArray serialize = QJsonDocument(json).toJson(QJsonDocument::Compact);
+    qint64 bytes = mWebSocket->sendUtf8TextMessage(serialize);
+    if (bytes < serialize.length()) {
         qCWarning(RUQOLA_DDPAPI_LOG) << "ERROR! I couldn't send all of my message. This is a bug! (try again)";
         qCWarning(RUQOLA_DDPAPI_LOG) << mWebSocket->isValid() << mWebSocket->error() << mWebSocket->requestUrl();
     } else {
@@ -464,9 +465,9 @@ void DDPClient::deregisterFromMethodResponse(quint64 methodId, DDPManager *ddpMa
     mMethodResponseHash.remove(methodId);
 }
 
-void DDPClient::onTextMessageReceived(const QString &message)
+void DDPClient::onTextMessageReceived(const QByteArray &message)
 {
-    QJsonDocument response = QJsonDocument::fromJson(message.toUtf8());
+    QJsonDocument response = QJsonDocument::fromJson(message);
     if (!response.isNull() && response.isObject()) {
         QJsonObject root = response.object();
 
@@ -570,7 +571,7 @@ void DDPClient::onWSConnected()
     protocol["version"_L1] = QStringLiteral("1");
     protocol["support"_L1] = supportedVersions;
     const QByteArray serialize = QJsonDocument(protocol).toJson(QJsonDocument::Compact);
-    const qint64 bytes = mWebSocket->sendTextMessage(QString::fromUtf8(serialize));
+    const qint64 bytes = mWebSocket->sendUtf8TextMessage(serialize);
     if (bytes < serialize.length()) {
         qCWarning(RUQOLA_DDPAPI_COMMAND_LOG) << "onWSConnected: ERROR! I couldn't send all of my message. This is a bug! (try again)";
         qCWarning(RUQOLA_DDPAPI_COMMAND_LOG) << mWebSocket->isValid() << mWebSocket->error() << mWebSocket->requestUrl();
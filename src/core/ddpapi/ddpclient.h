@@ -218,7 +218,7 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void onWSConnected();
-    void onTextMessageReceived(const QString &message);
+    void onTextMessageReceived(const QByteArray &message);
     void onWSclosed();
     void onSslErrors(const QList<QSslError> &errors);
 
@@ -0,0 +1,200 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "downloadscheduler.h"
+#include "ruqola_debug.h"
+
+#include <algorithm>
+
+DownloadScheduler::DownloadScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DownloadScheduler::~DownloadScheduler() = default;
+
+void DownloadScheduler::setStartFunction(const StartFunction &function)
+{
+    mStartFunction = function;
+}
+
+int DownloadScheduler::maximumDownloadsPerHost() const
+{
+    return mMaximumDownloadsPerHost;
+}
+
+void DownloadScheduler::setMaximumDownloadsPerHost(int maximum)
+{
+    mMaximumDownloadsPerHost = qMax(1, maximum);
+    startNextDownloads();
+}
+
+void DownloadScheduler::enqueue(const Request &request)
+{
+    if (!request.url.isValid()) {
+        qCWarning(RUQOLA_LOG) << "DownloadScheduler: invalid url" << request.url;
+        return;
+    }
+    if (request.priority == Priority::Explicit) {
+        // User retries it
+        mFailedUrls.remove(request.url);
+    }
+    if (mRunningDownloads.contains(request.url) || hasFailed(request.url)) {
+        return;
+    }
+    // Nobody cancels explicit downloads
+    const QObject *requester = nullptr;
+    if (request.priority != Priority::Explicit) {
+        requester = request.requester ? request.requester : mCurrentRequester;
+    }
+    auto it = std::find_if(mPendingRequests.begin(), mPendingRequests.end(), [&request](const Request &pending) {
+        return pending.url == request.url;
+    });
+    if (it != mPendingRequests.end()) {
+        // Same file requested for something more important (e.g. an emoji which is also an attachment)
+        if (request.priority < it->priority) {
+            it->priority = request.priority;
+        }
+        // Still needed when one of them cancels it
+        if (it->requester != requester) {
+            it->requester = nullptr;
+        }
+        return;
+    }
+    Request pendingRequest = request;
+    pendingRequest.requester = requester;
+    mPendingRequests.append(pendingRequest);
+    startNextDownloads();
+}
+
+void DownloadScheduler::downloadFinished(const QUrl &url, bool success)
+{
+    const auto it = mRunningDownloads.constFind(url);
+    if (it == mRunningDownloads.cend()) {
+        return;
+    }
+    if (success) {
+        mFailedUrls.remove(url);
+    } else {
+        // Server or network may be back later
+        FailedUrl &failedUrl = mFailedUrls[url];
+        ++failedUrl.failureCount;
+        failedUrl.retryDeadline = QDeadlineTimer(retryDelay(mMinimumRetryDelay, failedUrl.failureCount));
+    }
+    const QString host = it.value();
+    mRunningDownloads.erase(it);
+    if (--mRunningDownloadsPerHost[host] <= 0) {
+        mRunningDownloadsPerHost.remove(host);
+    }
+    startNextDownloads();
+}
+
+const QObject *DownloadScheduler::currentRequester() const
+{
+    return mCurrentRequester;
+}
+
+void DownloadScheduler::setCurrentRequester(const QObject *requester)
+{
+    mCurrentRequester = requester;
+}
+
+void DownloadScheduler::cancel(const QUrl &url)
+{
+    mPendingRequests.removeIf([&url](const Request &request) {
+        return request.url == url;
+    });
+}
+
+void DownloadScheduler::cancelPending(const QObject *requester, Priority priority)
+{
+    if (!requester) {
+        return;
+    }
+    mPendingRequests.removeIf([requester, priority](const Request &request) {
+        return request.requester == requester && request.priority == priority;
+    });
+}
+
+void DownloadScheduler::clearFailedUrls()
+{
+    mFailedUrls.clear();
+}
+
+std::chrono::milliseconds DownloadScheduler::minimumRetryDelay() const
+{
+    return mMinimumRetryDelay;
+}
+
+void DownloadScheduler::setMinimumRetryDelay(std::chrono::milliseconds delay)
+{
+    mMinimumRetryDelay = delay;
+}
+
+std::chrono::milliseconds DownloadScheduler::retryDelay(std::chrono::milliseconds minimumDelay, int failureCount)
+{
+    // Doubled after each failure, the shift is bounded so that it doesn't overflow
+    const int shift = std::clamp(failureCount - 1, 0, 16);
+    return std::min<std::chrono::milliseconds>(minimumDelay * (1 << shift), maximumRetryDelay);
+}
+
+bool DownloadScheduler::isPending(const QUrl &url) const
+{
+    return std::any_of(mPendingRequests.cbegin(), mPendingRequests.cend(), [&url](const Request &request) {
+        return request.url == url;
+    });
+}
+
+bool DownloadScheduler::isRunning(const QUrl &url) const
+{
+    return mRunningDownloads.contains(url);
+}
+
+bool DownloadScheduler::hasFailed(const QUrl &url) const
+{
+    const auto it = mFailedUrls.constFind(url);
+    return it != mFailedUrls.cend() && !it->retryDeadline.hasExpired();
+}
+
+qsizetype DownloadScheduler::pendingCount() const
+{
+    return mPendingRequests.count();
+}
+
+int DownloadScheduler::runningCount(const QString &host) const
+{
+    return mRunningDownloadsPerHost.value(host);
+}
+
+void DownloadScheduler::startNextDownloads()
+{
+    if (!mStartFunction) {
+        return;
+    }
+    while (true) {
+        // First request of the highest priority whose host isn't busy
+        qsizetype nextIndex = -1;
+        for (qsizetype i = 0, total = mPendingRequests.count(); i < total; ++i) {
+            const Request &request = mPendingRequests.at(i);
+            if (nextIndex != -1 && request.priority >= mPendingRequests.at(nextIndex).priority) {
+                continue;
+            }
+            if (runningCount(request.url.host()) < mMaximumDownloadsPerHost) {
+                nextIndex = i;
+            }
+        }
+        if (nextIndex == -1) {
+            return;
+        }
+        const Request request = mPendingRequests.takeAt(nextIndex);
+        const QString host = request.url.host();
+        mRunningDownloads.insert(request.url, host);
+        ++mRunningDownloadsPerHost[host];
+        mStartFunction(request);
+    }
+}
+
+#include "moc_downloadscheduler.cpp"
@@ -0,0 +1,109 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QUrl>
+#include <chrono>
+#include <functional>
+
+/**
+ * Queue of the files downloaded to the local cache.
+ * Downloads are started by priority, with a limited number of downloads running in parallel for each host.
+ * A url is only downloaded once: requesting it again while it's pending or running does nothing,
+ * a url which failed is not requested again before a delay which doubles after each failure,
+ * unless it's explicitly requested or failures are cleared.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT DownloadScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    // Highest priority first
+    enum class Priority : uint8_t {
+        // Requested by the user (save as, show image), never cancelled
+        Explicit = 0,
+        Attachment,
+        Avatar,
+        // Custom emojis and sounds
+        Emoji,
+        // Url previews
+        Preview,
+    };
+    Q_ENUM(Priority)
+
+    struct LIBRUQOLACORE_TESTS_EXPORT Request {
+        QUrl url;
+        QUrl localFileUrl;
+        QByteArray mimeType = QByteArrayLiteral("text/plain");
+        bool requiredAuthentication = true;
+        Priority priority = Priority::Attachment;
+        // Object which displays the file, nullptr when several objects requested it
+        const QObject *requester = nullptr;
+    };
+    // Must start the download, downloadFinished() must be called when it's done or failed
+    using StartFunction = std::function<void(const DownloadScheduler::Request &)>;
+
+    explicit DownloadScheduler(QObject *parent = nullptr);
+    ~DownloadScheduler() override;
+
+    void setStartFunction(const StartFunction &function);
+
+    [[nodiscard]] int maximumDownloadsPerHost() const;
+    void setMaximumDownloadsPerHost(int maximum);
+
+    void enqueue(const Request &request);
+    void downloadFinished(const QUrl &url, bool success);
+
+    // Requests enqueued without requester are made by it, e.g. while a view paints its rows
+    [[nodiscard]] const QObject *currentRequester() const;
+    void setCurrentRequester(const QObject *requester);
+
+    // Only pending requests are cancelled, running downloads finish and stay in cache
+    void cancel(const QUrl &url);
+    void cancelPending(const QObject *requester, Priority priority);
+
+    // Failed urls are requested again, e.g. when network is back
+    void clearFailedUrls();
+
+    // Delay before a failed url can be requested again after its first failure
+    [[nodiscard]] std::chrono::milliseconds minimumRetryDelay() const;
+    void setMinimumRetryDelay(std::chrono::milliseconds delay);
+    [[nodiscard]] static std::chrono::milliseconds retryDelay(std::chrono::milliseconds minimumDelay, int failureCount);
+
+    [[nodiscard]] bool isPending(const QUrl &url) const;
+    [[nodiscard]] bool isRunning(const QUrl &url) const;
+    // True until the retry delay of a failed url expired
+    [[nodiscard]] bool hasFailed(const QUrl &url) const;
+    [[nodiscard]] qsizetype pendingCount() const;
+    [[nodiscard]] int runningCount(const QString &host) const;
+
+    // Same limit as the connections opened by QNetworkAccessManager for a host, minus one left for REST api calls
+    static constexpr int defaultMaximumDownloadsPerHost = 5;
+    static constexpr std::chrono::milliseconds defaultMinimumRetryDelay = std::chrono::seconds(30);
+    static constexpr std::chrono::milliseconds maximumRetryDelay = std::chrono::hours(1);
+
+private:
+    LIBRUQOLACORE_NO_EXPORT void startNextDownloads();
+
+    QList<Request> mPendingRequests;
+    QHash<QUrl, QString> mRunningDownloads;
+    QHash<QString, int> mRunningDownloadsPerHost;
+    struct FailedUrl {
+        QDeadlineTimer retryDeadline;
+        int failureCount = 0;
+    };
+    QHash<QUrl, FailedUrl> mFailedUrls;
+    StartFunction mStartFunction;
+    const QObject *mCurrentRequester = nullptr;
+    std::chrono::milliseconds mMinimumRetryDelay = defaultMinimumRetryDelay;
+    int mMaximumDownloadsPerHost = defaultMaximumDownloadsPerHost;
+};
+Q_DECLARE_TYPEINFO(DownloadScheduler::Request, Q_RELOCATABLE_TYPE);
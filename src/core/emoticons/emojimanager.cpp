@@ -14,11 +14,21 @@
 #include <QJsonObject>
 #include <QTextStream>
 
+#include <algorithm>
+
 using namespace Qt::Literals::StringLiterals;
 EmojiManager::EmojiManager(RocketChatAccount *account, QObject *parent)
     : QObject(parent)
     , mRocketChatAccount(account)
 {
+    if (mRocketChatAccount) {
+        connect(mRocketChatAccount, &RocketChatAccount::fileDownloaded, this, [this](const QString &filePath) {
+            // Emoji is displayed as an image from now on
+            if (isCustomEmojiFile(filePath)) {
+                invalidateReplacementTable();
+            }
+        });
+    }
 }
 
 EmojiManager::~EmojiManager() = default;
@@ -70,6 +80,7 @@ void EmojiManager::addUpdateEmojiCustomList(const QJsonArray &arrayEmojiCustomAr
         }
     }
 
+    invalidateReplacementTable();
     // New QJsonArray([{"emojiData":{"_id":"HdN28k4PQ6J9xLkZ8","_updatedAt":{"$date":1631885946222},"aliases":["roo"],"extension":"png","name":"ruqola"}}])
     // Update
     // QJsonArray([{"emojiData":{"_id":"vxE6eG5FrZCvbgM3t","aliases":["rooss"],"extension":"png","name":"xxx","newFile":true,"previousExtension":"png","previousName":"ruqolas"}}
@@ -93,6 +104,7 @@ void EmojiManager::deleteEmojiCustom(const QJsonArray &arrayEmojiCustomArray)
             }
         }
     }
+    invalidateReplacementTable();
     Q_EMIT customEmojiChanged(false);
 }
 
@@ -113,6 +125,7 @@ void EmojiManager::loadCustomEmoji(const QJsonObject &obj)
 
     // clear cache
     mReplacePatternDirty = true;
+    invalidateReplacementTable();
 }
 
 int EmojiManager::count() const
@@ -158,6 +171,17 @@ QString EmojiManager::customEmojiFileName(const QString &emojiIdentifier) const
     return {};
 }
 
+bool EmojiManager::isCustomEmojiFile(const QString &downloadPath) const
+{
+    if (!mRocketChatAccount || !downloadPath.contains("/emoji-custom/"_L1)) {
+        return false;
+    }
+    // Transform file name the way RocketChatCache::downloadFile does it
+    return std::any_of(mCustomEmojiList.cbegin(), mCustomEmojiList.cend(), [this, &downloadPath](const CustomEmoji &customEmoji) {
+        return mRocketChatAccount->urlForLink(customEmoji.emojiFileName()).path() == downloadPath;
+    });
+}
+
 QString EmojiManager::normalizedReactionEmoji(const QString &emojiIdentifier) const
 {
     for (const auto &customEmoji : mCustomEmojiList) {
@@ -194,7 +218,7 @@ QString EmojiManager::replaceEmojiIdentifier(const QString &emojiIdentifier, boo
                     } else {
                         const QString fileName = customEmojiFileName(emojiIdentifier);
                         if (!fileName.isEmpty() && mRocketChatAccount) {
-                            const QUrl emojiUrl = mRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+                            const QUrl emojiUrl = mRocketChatAccount->emojiUrlFromLocalCache(fileName);
                             if (emojiUrl.isEmpty()) {
                                 // The download is happening, this will all be updated again later
                             } else {
@@ -218,9 +242,8 @@ QString EmojiManager::replaceEmojiIdentifier(const QString &emojiIdentifier, boo
     return emojiIdentifier;
 }
 
-void EmojiManager::replaceEmojis(QString *str)
+void EmojiManager::updateReplacePattern()
 {
-    Q_ASSERT(str);
     if (mReplacePatternDirty) {
         // build a regexp pattern for all the possible emoticons we want to replace
         // i.e. this is going to build a pattern like this:
@@ -281,6 +304,12 @@ void EmojiManager::replaceEmojis(QString *str)
         mReplacePattern.optimize();
         mReplacePatternDirty = false;
     }
+}
+
+void EmojiManager::replaceEmojis(QString *str)
+{
+    Q_ASSERT(str);
+    updateReplacePattern();
 
     if (mReplacePattern.pattern().isEmpty() || !mReplacePattern.isValid()) {
         qCWarning(RUQOLA_LOG) << "invalid emoji replace pattern" << mReplacePattern.pattern() << mReplacePattern.errorString();
@@ -300,6 +329,77 @@ void EmojiManager::replaceEmojis(QString *str)
     }
 }
 
+std::shared_ptr<const EmojiReplacementTable> EmojiManager::replacementTable()
+{
+    // Rebuild it while some custom emojis are still downloading
+    if (mReplacementTable && mReplacementTable->unresolvedCustomEmojis.isEmpty() && !mReplacePatternDirty) {
+        return mReplacementTable;
+    }
+    updateReplacePattern();
+    auto table = std::make_shared<EmojiReplacementTable>();
+    table->replacePattern = mReplacePattern;
+    table->revision = mEmojiRevision;
+    table->replaceEmojis = !mServerUrl.isEmpty() && (!mRocketChatAccount || mRocketChatAccount->ownUserPreferences().convertAsciiEmoji());
+    if (table->replaceEmojis) {
+        for (const CustomEmoji &emoji : std::as_const(mCustomEmojiList)) {
+            QStringList identifiers = emoji.aliases();
+            identifiers.prepend(emoji.emojiIdentifier());
+            for (const QString &identifier : std::as_const(identifiers)) {
+                if (!identifier.startsWith(QLatin1Char(':')) || !identifier.endsWith(QLatin1Char(':')) || table->customEmojis.contains(identifier)) {
+                    continue;
+                }
+                const QString html = replaceEmojiIdentifier(identifier);
+                if (html.isEmpty()) {
+                    table->unresolvedCustomEmojis.append(identifier);
+                }
+                table->customEmojis.insert(identifier, html);
+            }
+        }
+        const auto unicodeEmojis = unicodeEmojiList();
+        for (const TextEmoticonsCore::UnicodeEmoticon &emoji : unicodeEmojis) {
+            const QString display = emoji.unicodeDisplay();
+            table->unicodeEmojis.insert(emoji.identifier(), display);
+            const auto aliases = emoji.aliases();
+            for (const auto &alias : aliases) {
+                if (!table->unicodeEmojis.contains(alias)) {
+                    table->unicodeEmojis.insert(alias, display);
+                }
+            }
+        }
+    }
+    mReplacementTable = std::move(table);
+    return mReplacementTable;
+}
+
+void EmojiManager::replaceEmojis(const EmojiReplacementTable &table, QString *str)
+{
+    Q_ASSERT(str);
+    if (!table.replaceEmojis || table.replacePattern.pattern().isEmpty() || !table.replacePattern.isValid()) {
+        return;
+    }
+
+    int offset = 0;
+    while (offset < str->size()) {
+        const auto match = table.replacePattern.matchView(QStringView(*str), offset);
+        if (!match.hasMatch()) {
+            break;
+        }
+        const auto word = match.captured();
+        QString replaceWord = word;
+        auto customIt = table.customEmojis.constFind(word);
+        if (customIt != table.customEmojis.constEnd()) {
+            replaceWord = *customIt;
+        } else {
+            auto unicodeIt = table.unicodeEmojis.constFind(word);
+            if (unicodeIt != table.unicodeEmojis.constEnd()) {
+                replaceWord = *unicodeIt;
+            }
+        }
+        str->replace(match.capturedStart(), word.size(), replaceWord);
+        offset = match.capturedStart() + replaceWord.size();
+    }
+}
+
 QString EmojiManager::serverUrl() const
 {
     return mServerUrl;
@@ -318,6 +418,18 @@ void EmojiManager::clearCustomEmojiCachedHtml()
     for (int i = 0, total = mCustomEmojiList.size(); i < total; ++i) {
         mCustomEmojiList[i].clearCachedHtml();
     }
+    invalidateReplacementTable();
+}
+
+void EmojiManager::invalidateReplacementTable()
+{
+    mReplacementTable.reset();
+    ++mEmojiRevision;
+}
+
+quint64 EmojiManager::emojiRevision() const
+{
+    return mEmojiRevision;
 }
 
 const QList<CustomEmoji> &EmojiManager::customEmojiList() const
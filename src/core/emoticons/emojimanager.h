@@ -8,11 +8,30 @@
 
 #include "customemoji.h"
 #include "libruqolacore_export.h"
+#include <QHash>
 #include <QObject>
 #include <QRegularExpression>
 #include <TextEmoticonsCore/EmoticonCategory>
 #include <TextEmoticonsCore/UnicodeEmoticon>
+#include <memory>
 class RocketChatAccount;
+
+/**
+ * Immutable snapshot of the emoji replacements, built in the main thread.
+ * It can be used to replace emojis from any thread (see EmojiManager::replaceEmojis(const EmojiReplacementTable &, QString *))
+ */
+struct LIBRUQOLACORE_EXPORT EmojiReplacementTable {
+    QRegularExpression replacePattern;
+    // custom emoji identifier/alias => html
+    QHash<QString, QString> customEmojis;
+    // unicode emoji identifier/alias => unicode display
+    QHash<QString, QString> unicodeEmojis;
+    // custom emojis which are not downloaded yet
+    QStringList unresolvedCustomEmojis;
+    // EmojiManager::emojiRevision() when it was built
+    quint64 revision = 0;
+    bool replaceEmojis = true;
+};
 class LIBRUQOLACORE_EXPORT EmojiManager : public QObject
 {
     Q_OBJECT
@@ -26,6 +45,10 @@ public:
 
     [[nodiscard]] QString replaceEmojiIdentifier(const QString &emojiIdentifier, bool isReaction = false);
     void replaceEmojis(QString *str);
+
+    [[nodiscard]] std::shared_ptr<const EmojiReplacementTable> replacementTable();
+    static void replaceEmojis(const EmojiReplacementTable &table, QString *str);
+
     [[nodiscard]] QString serverUrl() const;
     void setServerUrl(const QString &serverUrl);
 
@@ -46,16 +69,25 @@ public:
     void addUpdateEmojiCustomList(const QJsonArray &arrayEmojiCustomArray);
     void deleteEmojiCustom(const QJsonArray &obj);
     [[nodiscard]] QString customEmojiFileNameFromIdentifier(const QByteArray &emojiIdentifier) const;
+    // Returns true when @p downloadPath (see RocketChatAccount::fileDownloaded()) is the file of a custom emoji
+    [[nodiscard]] bool isCustomEmojiFile(const QString &downloadPath) const;
+    // Changes when the custom emojis or their html change (list updated, file downloaded...),
+    // so that texts converted with emojis can be cached with it
+    [[nodiscard]] quint64 emojiRevision() const;
 
 Q_SIGNALS:
     void customEmojiChanged(bool fetchListCustom);
 
 private:
     LIBRUQOLACORE_NO_EXPORT void clearCustomEmojiCachedHtml();
+    LIBRUQOLACORE_NO_EXPORT void invalidateReplacementTable();
+    LIBRUQOLACORE_NO_EXPORT void updateReplacePattern();
     // Use identifier in a QMap ???
     QList<CustomEmoji> mCustomEmojiList;
     QString mServerUrl;
     QRegularExpression mReplacePattern;
+    std::shared_ptr<const EmojiReplacementTable> mReplacementTable;
     RocketChatAccount *const mRocketChatAccount;
+    quint64 mEmojiRevision = 0;
     bool mReplacePatternDirty = true;
 };
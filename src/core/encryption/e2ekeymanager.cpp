@@ -47,7 +47,7 @@ void E2eKeyManager::setStatus(Status newStatus)
     mStatus = newStatus;
 }
 
-void E2eKeyManager::fetchMyKeys()
+RocketChatRestApi::RestApiAbstractJob *E2eKeyManager::fetchMyKeys()
 {
     auto job = new RocketChatRestApi::FetchMyKeysJob(this);
     mAccount->restApi()->initializeRestApiJob(job);
@@ -59,6 +59,7 @@ void E2eKeyManager::fetchMyKeys()
     if (!job->start()) {
         qCDebug(RUQOLA_ENCRYPTION_LOG) << "Impossible to start fetchmykeys job";
     }
+    return job;
 }
 
 void E2eKeyManager::verifyExistingKey(const QJsonObject &json)
@@ -9,6 +9,10 @@
 
 #include <QObject>
 class RocketChatAccount;
+namespace RocketChatRestApi
+{
+class RestApiAbstractJob;
+}
 class LIBRUQOLACORE_EXPORT E2eKeyManager : public QObject
 {
     Q_OBJECT
@@ -26,7 +30,8 @@ public:
 
     void decodeEncryptionKey();
 
-    void fetchMyKeys();
+    // Returns the job, deleted when keys are fetched
+    RocketChatRestApi::RestApiAbstractJob *fetchMyKeys();
 
     [[nodiscard]] E2eKeyManager::Status needToDecodeEncryptionKey() const;
 
@@ -0,0 +1,108 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "highlightedcodecache.h"
+#include "batchtextconverter.h"
+#include "syntaxhighlightingmanager.h"
+#include "texthighlighter.h"
+
+#include <KSyntaxHighlighting/Theme>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThreadPool>
+
+using namespace Qt::Literals::StringLiterals;
+
+HighlightedCodeCache::HighlightedCodeCache()
+    : QObject()
+{
+    // It can be created from a worker thread, signals must be emitted from main thread
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+    mCache.setMaxEntries(maximumEntries);
+}
+
+HighlightedCodeCache::~HighlightedCodeCache() = default;
+
+HighlightedCodeCache &HighlightedCodeCache::self()
+{
+    static HighlightedCodeCache c;
+    return c;
+}
+
+QByteArray HighlightedCodeCache::cacheKey(const QString &definitionName, const QString &themeName, const QString &code)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(definitionName.toUtf8());
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(themeName.toUtf8());
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(QByteArrayView(reinterpret_cast<const char *>(code.constData()), code.size() * sizeof(QChar)));
+    return hash.result();
+}
+
+QString HighlightedCodeCache::highlightedCode(const QByteArray &key)
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mCache.find(key);
+    if (it != mCache.end()) {
+        return it->value;
+    }
+    return {};
+}
+
+void HighlightedCodeCache::insert(const QByteArray &key, const QString &html)
+{
+    QMutexLocker locker(&mMutex);
+    mCache.remove(key);
+    mCache.insert(key, html);
+}
+
+void HighlightedCodeCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mCache.clear();
+}
+
+QString HighlightedCodeCache::pendingHighlightingMarker()
+{
+    return u"<!--pending-highlighting-->"_s;
+}
+
+void HighlightedCodeCache::highlightInBackground(const QByteArray &key, const QString &definitionName, const QString &themeName, const QString &code)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        if (mPendingKeys.contains(key)) {
+            return;
+        }
+        mPendingKeys.insert(key);
+    }
+    // Same pool as batch conversion: its threads keep their syntax highlighting repository loaded
+    BatchTextConverter::threadPool()->start([this, key, definitionName, themeName, code]() {
+        auto &repo = SyntaxHighlightingManager::self()->repo();
+        QString highlighted;
+        QTextStream stream(&highlighted);
+        TextHighlighter highlighter(&stream);
+        highlighter.setTheme(repo.theme(themeName));
+        highlighter.setDefinition(repo.definitionForName(definitionName));
+        highlighter.highlight(code);
+        stream.flush();
+        {
+            QMutexLocker locker(&mMutex);
+            mPendingKeys.remove(key);
+            mCache.remove(key);
+            mCache.insert(key, highlighted);
+        }
+        QMetaObject::invokeMethod(this, &HighlightedCodeCache::codeHighlighted, Qt::QueuedConnection);
+    });
+}
+
+#include "moc_highlightedcodecache.cpp"
@@ -0,0 +1,57 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include "lrucache.h"
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+/**
+ * Cache of code blocks highlighted by TextHighlighter, keyed by a hash of (definition, theme, code).
+ * It can be used from any thread.
+ * Very large blocks are highlighted in a worker thread, plain text is used until it's done.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT HighlightedCodeCache : public QObject
+{
+    Q_OBJECT
+public:
+    static HighlightedCodeCache &self();
+
+    HighlightedCodeCache();
+    ~HighlightedCodeCache() override;
+
+    [[nodiscard]] static QByteArray cacheKey(const QString &definitionName, const QString &themeName, const QString &code);
+
+    // Returns an empty string when not in cache
+    [[nodiscard]] QString highlightedCode(const QByteArray &key);
+    void insert(const QByteArray &key, const QString &html);
+    void clear();
+
+    /**
+     * Highlights @p code in a worker thread, codeHighlighted() is emitted when it's in cache.
+     */
+    void highlightInBackground(const QByteArray &key, const QString &definitionName, const QString &themeName, const QString &code);
+
+    // Added to the generated html while a code block is not highlighted yet
+    [[nodiscard]] static QString pendingHighlightingMarker();
+
+    // Code blocks longer than this are highlighted lazily
+    static constexpr int lazyHighlightingThreshold = 20000;
+    static constexpr int maximumEntries = 128;
+
+Q_SIGNALS:
+    void codeHighlighted();
+
+private:
+    QMutex mMutex;
+    LRUCache<QByteArray, QString> mCache;
+    QSet<QByteArray> mPendingKeys;
+};
@@ -0,0 +1,80 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "localcacheblobsdatabasetest.h"
+#include "localdatabase/localcacheblobsdatabase.h"
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+static QString accountName()
+{
+    return QStringLiteral("myAccount");
+}
+
+QTEST_MAIN(LocalCacheBlobsDatabaseTest)
+LocalCacheBlobsDatabaseTest::LocalCacheBlobsDatabaseTest(QObject *parent)
+    : QObject{parent}
+{
+}
+
+void LocalCacheBlobsDatabaseTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Clean up after previous runs
+    LocalCacheBlobsDatabase cacheBlobsDataBase;
+    QFile::remove(cacheBlobsDataBase.dbFileName(accountName()));
+}
+
+void LocalCacheBlobsDatabaseTest::shouldHaveDefaultValues()
+{
+    LocalCacheBlobsDatabase cacheBlobsDataBase;
+    QCOMPARE(cacheBlobsDataBase.schemaDatabaseStr(), QStringLiteral("CREATE TABLE CACHEBLOBS (path TEXT PRIMARY KEY NOT NULL, blob TEXT)"));
+}
+
+void LocalCacheBlobsDatabaseTest::shouldVerifyDbFileName()
+{
+    LocalCacheBlobsDatabase cacheBlobsDataBase;
+    QCOMPARE(cacheBlobsDataBase.dbFileName(accountName()),
+             QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/database/cacheblobs/myAccount/myAccount.sqlite"));
+}
+
+void LocalCacheBlobsDatabaseTest::shouldStoreCacheBlobs()
+{
+    LocalCacheBlobsDatabase cacheBlobsDataBase;
+    LocalCacheBlobsDatabase::CacheBlobs blobs;
+    blobs.insert(QStringLiteral("/cache/foo.png"), QStringLiteral("aaaa.png"));
+    blobs.insert(QStringLiteral("/cache/forwarded/foo.png"), QStringLiteral("aaaa.png"));
+    blobs.insert(QStringLiteral("/cache/bla.png"), QStringLiteral("bbbb.png"));
+    cacheBlobsDataBase.updateCacheBlobs(accountName(), blobs);
+
+    LocalCacheBlobsDatabase::CacheBlobs storedBlobs = cacheBlobsDataBase.cacheBlobs(accountName());
+    QCOMPARE(storedBlobs, blobs);
+
+    // Same url downloaded again with a new content
+    cacheBlobsDataBase.updateCacheBlobs(accountName(), {{QStringLiteral("/cache/bla.png"), QStringLiteral("cccc.png")}});
+    storedBlobs = cacheBlobsDataBase.cacheBlobs(accountName());
+    QCOMPARE(storedBlobs.count(), 3);
+    QCOMPARE(storedBlobs.value(QStringLiteral("/cache/bla.png")), QStringLiteral("cccc.png"));
+}
+
+void LocalCacheBlobsDatabaseTest::shouldRemoveCacheBlobs()
+{
+    LocalCacheBlobsDatabase cacheBlobsDataBase;
+    LocalCacheBlobsDatabase::CacheBlobs blobs;
+    blobs.insert(QStringLiteral("/cache/remove.png"), QStringLiteral("dddd.png"));
+    blobs.insert(QStringLiteral("/cache/forwarded/remove.png"), QStringLiteral("dddd.png"));
+    blobs.insert(QStringLiteral("/cache/keep.png"), QStringLiteral("eeee.png"));
+    cacheBlobsDataBase.updateCacheBlobs(accountName(), blobs);
+
+    cacheBlobsDataBase.removeCacheBlobs(accountName(), {QStringLiteral("dddd.png")});
+    const LocalCacheBlobsDatabase::CacheBlobs storedBlobs = cacheBlobsDataBase.cacheBlobs(accountName());
+    QVERIFY(!storedBlobs.contains(QStringLiteral("/cache/remove.png")));
+    QVERIFY(!storedBlobs.contains(QStringLiteral("/cache/forwarded/remove.png")));
+    QVERIFY(storedBlobs.contains(QStringLiteral("/cache/keep.png")));
+}
+
+#include "moc_localcacheblobsdatabasetest.cpp"
@@ -0,0 +1,23 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class LocalCacheBlobsDatabaseTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalCacheBlobsDatabaseTest(QObject *parent = nullptr);
+    ~LocalCacheBlobsDatabaseTest() override = default;
+private Q_SLOTS:
+    void initTestCase();
+    void shouldHaveDefaultValues();
+    void shouldVerifyDbFileName();
+    void shouldStoreCacheBlobs();
+    void shouldRemoveCacheBlobs();
+};
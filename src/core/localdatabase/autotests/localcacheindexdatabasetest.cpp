@@ -0,0 +1,105 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "localcacheindexdatabasetest.h"
+#include "localdatabase/localcacheindexdatabase.h"
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+static QString accountName()
+{
+    return QStringLiteral("myAccount");
+}
+
+static LocalCacheIndexDatabase::CacheFileInfo cacheFileInfo(qint64 size, qint64 lastAccess)
+{
+    LocalCacheIndexDatabase::CacheFileInfo info;
+    info.size = size;
+    info.lastAccess = lastAccess;
+    return info;
+}
+
+QTEST_MAIN(LocalCacheIndexDatabaseTest)
+LocalCacheIndexDatabaseTest::LocalCacheIndexDatabaseTest(QObject *parent)
+    : QObject{parent}
+{
+}
+
+void LocalCacheIndexDatabaseTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Clean up after previous runs
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    QFile::remove(cacheIndexDataBase.dbFileName(accountName()));
+}
+
+void LocalCacheIndexDatabaseTest::shouldHaveDefaultValues()
+{
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    QCOMPARE(cacheIndexDataBase.schemaDatabaseStr(),
+             QStringLiteral("CREATE TABLE CACHEFILES (path TEXT PRIMARY KEY NOT NULL, size INTEGER, lastAccess INTEGER)"));
+
+    const LocalCacheIndexDatabase::CacheFileInfo info;
+    QCOMPARE(info.size, 0);
+    QCOMPARE(info.lastAccess, 0);
+}
+
+void LocalCacheIndexDatabaseTest::shouldVerifyDbFileName()
+{
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    QCOMPARE(cacheIndexDataBase.dbFileName(accountName()),
+             QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/database/cacheindex/myAccount/myAccount.sqlite"));
+}
+
+void LocalCacheIndexDatabaseTest::shouldStoreCacheFiles()
+{
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    LocalCacheIndexDatabase::CacheFiles files;
+    files.insert(QStringLiteral("/cache/foo.png"), cacheFileInfo(100, 10));
+    files.insert(QStringLiteral("/cache/bla.png"), cacheFileInfo(200, 20));
+    cacheIndexDataBase.updateCacheFiles(accountName(), files);
+
+    LocalCacheIndexDatabase::CacheFiles storedFiles = cacheIndexDataBase.cacheFiles(accountName());
+    QCOMPARE(storedFiles.count(), 2);
+    QCOMPARE(storedFiles.value(QStringLiteral("/cache/foo.png")).size, 100);
+    QCOMPARE(storedFiles.value(QStringLiteral("/cache/bla.png")).lastAccess, 20);
+
+    // Update access time
+    cacheIndexDataBase.updateCacheFiles(accountName(), {{QStringLiteral("/cache/foo.png"), cacheFileInfo(100, 30)}});
+    storedFiles = cacheIndexDataBase.cacheFiles(accountName());
+    QCOMPARE(storedFiles.count(), 2);
+    QCOMPARE(storedFiles.value(QStringLiteral("/cache/foo.png")).lastAccess, 30);
+}
+
+void LocalCacheIndexDatabaseTest::shouldRemoveCacheFiles()
+{
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    cacheIndexDataBase.updateCacheFiles(accountName(), {{QStringLiteral("/cache/remove.png"), cacheFileInfo(100, 10)}});
+    QVERIFY(cacheIndexDataBase.cacheFiles(accountName()).contains(QStringLiteral("/cache/remove.png")));
+
+    cacheIndexDataBase.removeCacheFiles(accountName(), {QStringLiteral("/cache/remove.png")});
+    QVERIFY(!cacheIndexDataBase.cacheFiles(accountName()).contains(QStringLiteral("/cache/remove.png")));
+}
+
+void LocalCacheIndexDatabaseTest::shouldReturnLeastRecentlyUsedFiles()
+{
+    LocalCacheIndexDatabase cacheIndexDataBase;
+    cacheIndexDataBase.removeCacheFiles(accountName(), cacheIndexDataBase.cacheFiles(accountName()).keys());
+    LocalCacheIndexDatabase::CacheFiles files;
+    files.insert(QStringLiteral("/cache/recent.png"), cacheFileInfo(100, 300));
+    files.insert(QStringLiteral("/cache/old.png"), cacheFileInfo(200, 100));
+    files.insert(QStringLiteral("/cache/middle.png"), cacheFileInfo(300, 200));
+    cacheIndexDataBase.updateCacheFiles(accountName(), files);
+
+    const auto leastRecentlyUsedFiles = cacheIndexDataBase.leastRecentlyUsedCacheFiles(accountName(), 2);
+    QCOMPARE(leastRecentlyUsedFiles.count(), 2);
+    QCOMPARE(leastRecentlyUsedFiles.at(0).first, QStringLiteral("/cache/old.png"));
+    QCOMPARE(leastRecentlyUsedFiles.at(0).second.size, 200);
+    QCOMPARE(leastRecentlyUsedFiles.at(1).first, QStringLiteral("/cache/middle.png"));
+}
+
+#include "moc_localcacheindexdatabasetest.cpp"
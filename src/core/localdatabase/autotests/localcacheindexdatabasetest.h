@@ -0,0 +1,24 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class LocalCacheIndexDatabaseTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalCacheIndexDatabaseTest(QObject *parent = nullptr);
+    ~LocalCacheIndexDatabaseTest() override = default;
+private Q_SLOTS:
+    void initTestCase();
+    void shouldHaveDefaultValues();
+    void shouldVerifyDbFileName();
+    void shouldStoreCacheFiles();
+    void shouldRemoveCacheFiles();
+    void shouldReturnLeastRecentlyUsedFiles();
+};
@@ -50,5 +50,13 @@ void LocalDatabaseBaseTest::shouldHaveDefaultValues()
         TestLocalDatabaseBase w(QStringLiteral("foo/bla/"), LocalDatabaseBase::DatabaseType::Global);
         QCOMPARE(w.currentDatabaseName(QStringLiteral("kde")), QStringLiteral("global-kde"));
     }
+    {
+        TestLocalDatabaseBase w(QStringLiteral("foo/bla/"), LocalDatabaseBase::DatabaseType::CacheIndex);
+        QCOMPARE(w.currentDatabaseName(QStringLiteral("kde")), QStringLiteral("cacheindex-kde"));
+    }
+    {
+        TestLocalDatabaseBase w(QStringLiteral("foo/bla/"), LocalDatabaseBase::DatabaseType::CacheBlobs);
+        QCOMPARE(w.currentDatabaseName(QStringLiteral("kde")), QStringLiteral("cacheblobs-kde"));
+    }
 }
 #include "moc_localdatabasebasetest.cpp"
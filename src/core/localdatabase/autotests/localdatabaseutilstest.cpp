@@ -29,6 +29,8 @@ void LocalDatabaseUtilsTest::shouldCheckPath()
     QCOMPARE(LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::Rooms), QStringLiteral("rooms/"));
     QCOMPARE(LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::Account), QStringLiteral("account/"));
     QCOMPARE(LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::Global), QStringLiteral("global/"));
+    QCOMPARE(LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::CacheIndex), QStringLiteral("cacheindex/"));
+    QCOMPARE(LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::CacheBlobs), QStringLiteral("cacheblobs/"));
 }
 
 void LocalDatabaseUtilsTest::shouldCheckDataBase()
@@ -45,6 +47,14 @@ void LocalDatabaseUtilsTest::shouldCheckDataBase()
     QCOMPARE(LocalDatabaseUtils::deleteMessageFromLogs(), QStringLiteral("DELETE FROM LOGS WHERE messageId = ?"));
     QCOMPARE(LocalDatabaseUtils::insertReplaceMessageFromLogs(), QStringLiteral("INSERT OR REPLACE INTO LOGS VALUES (?, ?, ?, ?)"));
     QCOMPARE(LocalDatabaseUtils::jsonAccount(), QStringLiteral("SELECT json FROM ACCOUNT WHERE accountName = \"%1\""));
+    QCOMPARE(LocalDatabaseUtils::insertReplaceCacheFile(), QStringLiteral("INSERT OR REPLACE INTO CACHEFILES VALUES (?, ?, ?)"));
+    QCOMPARE(LocalDatabaseUtils::deleteCacheFile(), QStringLiteral("DELETE FROM CACHEFILES WHERE path = ?"));
+    QCOMPARE(LocalDatabaseUtils::cacheFiles(), QStringLiteral("SELECT path, size, lastAccess FROM CACHEFILES"));
+    QCOMPARE(LocalDatabaseUtils::leastRecentlyUsedCacheFiles(),
+             QStringLiteral("SELECT path, size, lastAccess FROM CACHEFILES ORDER BY lastAccess LIMIT %1"));
+    QCOMPARE(LocalDatabaseUtils::insertReplaceCacheBlob(), QStringLiteral("INSERT OR REPLACE INTO CACHEBLOBS VALUES (?, ?)"));
+    QCOMPARE(LocalDatabaseUtils::deleteCacheBlob(), QStringLiteral("DELETE FROM CACHEBLOBS WHERE path = ?"));
+    QCOMPARE(LocalDatabaseUtils::cacheBlobs(), QStringLiteral("SELECT path, blob FROM CACHEBLOBS"));
 }
 
 #include "moc_localdatabaseutilstest.cpp"
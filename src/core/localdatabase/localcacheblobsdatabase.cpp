@@ -0,0 +1,86 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "localcacheblobsdatabase.h"
+#include "localdatabaseutils.h"
+#include "ruqola_database_debug.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+static const char s_schemaCacheBlobsDataBase[] = "CREATE TABLE CACHEBLOBS (path TEXT PRIMARY KEY NOT NULL, blob TEXT)";
+enum class CacheBlobsFields {
+    Path,
+    Blob,
+}; // in the same order as the table
+
+LocalCacheBlobsDatabase::LocalCacheBlobsDatabase()
+    : LocalDatabaseBase(LocalDatabaseUtils::localCacheBlobsDatabasePath(), LocalDatabaseBase::DatabaseType::CacheBlobs)
+{
+}
+
+LocalCacheBlobsDatabase::~LocalCacheBlobsDatabase() = default;
+
+QString LocalCacheBlobsDatabase::schemaDataBase() const
+{
+    return QString::fromLatin1(s_schemaCacheBlobsDataBase);
+}
+
+void LocalCacheBlobsDatabase::updateCacheBlobs(const QString &accountName, const CacheBlobs &blobs)
+{
+    if (blobs.isEmpty()) {
+        return;
+    }
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return;
+    }
+    db.transaction();
+    QSqlQuery query(LocalDatabaseUtils::insertReplaceCacheBlob(), db);
+    for (auto it = blobs.cbegin(), end = blobs.cend(); it != end; ++it) {
+        query.addBindValue(it.key());
+        query.addBindValue(it.value());
+        if (!query.exec()) {
+            qCWarning(RUQOLA_DATABASE_LOG) << "Couldn't insert-or-replace in CACHEBLOBS table" << db.databaseName() << query.lastError();
+        }
+    }
+    db.commit();
+}
+
+void LocalCacheBlobsDatabase::removeCacheBlobs(const QString &accountName, const QStringList &paths)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return;
+    }
+    db.transaction();
+    QSqlQuery query(LocalDatabaseUtils::deleteCacheBlob(), db);
+    for (const QString &path : paths) {
+        query.addBindValue(path);
+        if (!query.exec()) {
+            qCWarning(RUQOLA_DATABASE_LOG) << "Couldn't delete from CACHEBLOBS table" << db.databaseName() << query.lastError();
+        }
+    }
+    db.commit();
+}
+
+LocalCacheBlobsDatabase::CacheBlobs LocalCacheBlobsDatabase::cacheBlobs(const QString &accountName)
+{
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return {};
+    }
+    CacheBlobs blobs;
+    QSqlQuery query(LocalDatabaseUtils::cacheBlobs(), db);
+    while (query.next()) {
+        blobs.insert(query.value(static_cast<int>(CacheBlobsFields::Path)).toString(), query.value(static_cast<int>(CacheBlobsFields::Blob)).toString());
+    }
+    return blobs;
+}
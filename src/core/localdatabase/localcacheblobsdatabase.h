@@ -0,0 +1,34 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolacore_export.h"
+#include "localdatabasebase.h"
+#include <QHash>
+#include <QStringList>
+
+/**
+ * Files of an account cache stored by content: keys are the paths where the files would be stored
+ * without deduplication, values are the names of the blobs (content hash and extension).
+ * Like other databases, it must always be used from the same thread.
+ */
+class LIBRUQOLACORE_EXPORT LocalCacheBlobsDatabase : public LocalDatabaseBase
+{
+public:
+    using CacheBlobs = QHash<QString, QString>;
+
+    LocalCacheBlobsDatabase();
+    ~LocalCacheBlobsDatabase() override;
+
+    void updateCacheBlobs(const QString &accountName, const CacheBlobs &blobs);
+    void removeCacheBlobs(const QString &accountName, const QStringList &paths);
+
+    [[nodiscard]] CacheBlobs cacheBlobs(const QString &accountName);
+
+protected:
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString schemaDataBase() const override;
+};
@@ -0,0 +1,109 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "localcacheindexdatabase.h"
+#include "localdatabaseutils.h"
+#include "ruqola_database_debug.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+static const char s_schemaCacheIndexDataBase[] = "CREATE TABLE CACHEFILES (path TEXT PRIMARY KEY NOT NULL, size INTEGER, lastAccess INTEGER)";
+enum class CacheFilesFields {
+    Path,
+    Size,
+    LastAccess,
+}; // in the same order as the table
+
+LocalCacheIndexDatabase::LocalCacheIndexDatabase()
+    : LocalDatabaseBase(LocalDatabaseUtils::localCacheIndexDatabasePath(), LocalDatabaseBase::DatabaseType::CacheIndex)
+{
+}
+
+LocalCacheIndexDatabase::~LocalCacheIndexDatabase() = default;
+
+QString LocalCacheIndexDatabase::schemaDataBase() const
+{
+    return QString::fromLatin1(s_schemaCacheIndexDataBase);
+}
+
+void LocalCacheIndexDatabase::updateCacheFiles(const QString &accountName, const CacheFiles &files)
+{
+    if (files.isEmpty()) {
+        return;
+    }
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return;
+    }
+    // One transaction: there are thousands of files at startup
+    db.transaction();
+    QSqlQuery query(LocalDatabaseUtils::insertReplaceCacheFile(), db);
+    for (auto it = files.cbegin(), end = files.cend(); it != end; ++it) {
+        query.addBindValue(it.key());
+        query.addBindValue(it->size);
+        query.addBindValue(it->lastAccess);
+        if (!query.exec()) {
+            qCWarning(RUQOLA_DATABASE_LOG) << "Couldn't insert-or-replace in CACHEFILES table" << db.databaseName() << query.lastError();
+        }
+    }
+    db.commit();
+}
+
+void LocalCacheIndexDatabase::removeCacheFiles(const QString &accountName, const QStringList &paths)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return;
+    }
+    db.transaction();
+    QSqlQuery query(LocalDatabaseUtils::deleteCacheFile(), db);
+    for (const QString &path : paths) {
+        query.addBindValue(path);
+        if (!query.exec()) {
+            qCWarning(RUQOLA_DATABASE_LOG) << "Couldn't delete from CACHEFILES table" << db.databaseName() << query.lastError();
+        }
+    }
+    db.commit();
+}
+
+LocalCacheIndexDatabase::CacheFiles LocalCacheIndexDatabase::cacheFiles(const QString &accountName)
+{
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return {};
+    }
+    CacheFiles files;
+    QSqlQuery query(LocalDatabaseUtils::cacheFiles(), db);
+    while (query.next()) {
+        CacheFileInfo info;
+        info.size = query.value(static_cast<int>(CacheFilesFields::Size)).toLongLong();
+        info.lastAccess = query.value(static_cast<int>(CacheFilesFields::LastAccess)).toLongLong();
+        files.insert(query.value(static_cast<int>(CacheFilesFields::Path)).toString(), info);
+    }
+    return files;
+}
+
+QList<std::pair<QString, LocalCacheIndexDatabase::CacheFileInfo>> LocalCacheIndexDatabase::leastRecentlyUsedCacheFiles(const QString &accountName, int count)
+{
+    QSqlDatabase db;
+    if (!initializeDataBase(accountName, db)) {
+        return {};
+    }
+    QList<std::pair<QString, CacheFileInfo>> files;
+    QSqlQuery query(LocalDatabaseUtils::leastRecentlyUsedCacheFiles().arg(count), db);
+    while (query.next()) {
+        CacheFileInfo info;
+        info.size = query.value(static_cast<int>(CacheFilesFields::Size)).toLongLong();
+        info.lastAccess = query.value(static_cast<int>(CacheFilesFields::LastAccess)).toLongLong();
+        files.append({query.value(static_cast<int>(CacheFilesFields::Path)).toString(), info});
+    }
+    return files;
+}
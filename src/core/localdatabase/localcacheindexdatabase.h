@@ -0,0 +1,43 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolacore_export.h"
+#include "localdatabasebase.h"
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <utility>
+
+/**
+ * Size and last access time of the files of an account cache, used to remove the least recently used ones.
+ * Like other databases, it must always be used from the same thread.
+ */
+class LIBRUQOLACORE_EXPORT LocalCacheIndexDatabase : public LocalDatabaseBase
+{
+public:
+    struct LIBRUQOLACORE_EXPORT CacheFileInfo {
+        qint64 size = 0;
+        // Seconds since epoch
+        qint64 lastAccess = 0;
+    };
+    using CacheFiles = QHash<QString, LocalCacheIndexDatabase::CacheFileInfo>;
+
+    LocalCacheIndexDatabase();
+    ~LocalCacheIndexDatabase() override;
+
+    void updateCacheFiles(const QString &accountName, const CacheFiles &files);
+    void removeCacheFiles(const QString &accountName, const QStringList &paths);
+
+    [[nodiscard]] CacheFiles cacheFiles(const QString &accountName);
+    // Least recently used first
+    [[nodiscard]] QList<std::pair<QString, CacheFileInfo>> leastRecentlyUsedCacheFiles(const QString &accountName, int count);
+
+protected:
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString schemaDataBase() const override;
+};
+Q_DECLARE_TYPEINFO(LocalCacheIndexDatabase::CacheFileInfo, Q_PRIMITIVE_TYPE);
@@ -64,6 +64,12 @@ QString LocalDatabaseBase::databaseName(const QString &name) const
     case DatabaseType::Global:
         prefix = QStringLiteral("global-");
         break;
+    case DatabaseType::CacheIndex:
+        prefix = QStringLiteral("cacheindex-");
+        break;
+    case DatabaseType::CacheBlobs:
+        prefix = QStringLiteral("cacheblobs-");
+        break;
     case DatabaseType::Logger:
         break;
     }
@@ -19,6 +19,8 @@ public:
         Message,
         Logger,
         Global,
+        CacheIndex,
+        CacheBlobs,
     };
     explicit LocalDatabaseBase(const QString &basePath, DatabaseType type);
     virtual ~LocalDatabaseBase();
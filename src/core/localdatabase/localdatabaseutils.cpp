@@ -46,6 +46,16 @@ QString LocalDatabaseUtils::localGlobalDatabasePath()
     return LocalDatabaseUtils::localDatabasePath() + LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::Global);
 }
 
+QString LocalDatabaseUtils::localCacheIndexDatabasePath()
+{
+    return LocalDatabaseUtils::localDatabasePath() + LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::CacheIndex);
+}
+
+QString LocalDatabaseUtils::localCacheBlobsDatabasePath()
+{
+    return LocalDatabaseUtils::localDatabasePath() + LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath::CacheBlobs);
+}
+
 QString LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath pathType)
 {
     switch (pathType) {
@@ -57,6 +67,10 @@ QString LocalDatabaseUtils::databasePath(LocalDatabaseUtils::DatabasePath pathTy
         return QStringLiteral("account/");
     case LocalDatabaseUtils::DatabasePath::Global:
         return QStringLiteral("global/");
+    case LocalDatabaseUtils::DatabasePath::CacheIndex:
+        return QStringLiteral("cacheindex/");
+    case LocalDatabaseUtils::DatabasePath::CacheBlobs:
+        return QStringLiteral("cacheblobs/");
     }
     Q_UNREACHABLE();
     return {};
@@ -131,3 +145,38 @@ QString LocalDatabaseUtils::jsonAccount()
 {
     return QStringLiteral("SELECT json FROM ACCOUNT WHERE accountName = \"%1\"");
 }
+
+QString LocalDatabaseUtils::insertReplaceCacheFile()
+{
+    return QStringLiteral("INSERT OR REPLACE INTO CACHEFILES VALUES (?, ?, ?)");
+}
+
+QString LocalDatabaseUtils::deleteCacheFile()
+{
+    return QStringLiteral("DELETE FROM CACHEFILES WHERE path = ?");
+}
+
+QString LocalDatabaseUtils::cacheFiles()
+{
+    return QStringLiteral("SELECT path, size, lastAccess FROM CACHEFILES");
+}
+
+QString LocalDatabaseUtils::leastRecentlyUsedCacheFiles()
+{
+    return QStringLiteral("SELECT path, size, lastAccess FROM CACHEFILES ORDER BY lastAccess LIMIT %1");
+}
+
+QString LocalDatabaseUtils::insertReplaceCacheBlob()
+{
+    return QStringLiteral("INSERT OR REPLACE INTO CACHEBLOBS VALUES (?, ?)");
+}
+
+QString LocalDatabaseUtils::deleteCacheBlob()
+{
+    return QStringLiteral("DELETE FROM CACHEBLOBS WHERE path = ?");
+}
+
+QString LocalDatabaseUtils::cacheBlobs()
+{
+    return QStringLiteral("SELECT path, blob FROM CACHEBLOBS");
+}
@@ -15,6 +15,8 @@ enum class DatabasePath : uint8_t {
     Rooms,
     Account,
     Global,
+    CacheIndex,
+    CacheBlobs,
 };
 
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString fixRoomName(QString roomName);
@@ -24,6 +26,8 @@ enum class DatabasePath : uint8_t {
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString localRoomsDatabasePath();
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString localAccountDatabasePath();
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString localGlobalDatabasePath();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString localCacheIndexDatabasePath();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString localCacheBlobsDatabasePath();
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString databasePath(LocalDatabaseUtils::DatabasePath pathType);
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString deleteMessage();
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString insertReplaceMessages();
@@ -39,4 +43,11 @@ enum class DatabasePath : uint8_t {
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString insertReplaceMessageFromLogs();
 [[nodiscard]] LIBRUQOLACORE_EXPORT qint64 currentTimeStamp();
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString jsonAccount();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString insertReplaceCacheFile();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString deleteCacheFile();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString cacheFiles();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString leastRecentlyUsedCacheFiles();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString insertReplaceCacheBlob();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString deleteCacheBlob();
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString cacheBlobs();
 };
@@ -0,0 +1,192 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "loginbootstrap.h"
+#include "ruqola_debug.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+LoginBootstrap::LoginBootstrap(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LoginBootstrap::~LoginBootstrap() = default;
+
+void LoginBootstrap::addTask(const QString &name, Stage stage, const StartFunction &start, const QStringList &dependencies)
+{
+    Task task;
+    task.name = name;
+    task.stage = stage;
+    task.start = start;
+    task.dependencies = dependencies;
+    mTasks.append(std::move(task));
+    if (mRunning) {
+        startReadyTasks();
+    }
+}
+
+void LoginBootstrap::start()
+{
+    mRunning = true;
+    mDeferredTasksScheduled = false;
+    mDeferredTasksStarted = false;
+    mElapsedTimer.start();
+    startReadyTasks();
+}
+
+void LoginBootstrap::clear()
+{
+    ++mGeneration;
+    mTasks.clear();
+    mRunning = false;
+    mDeferredTasksScheduled = false;
+    mDeferredTasksStarted = false;
+}
+
+bool LoginBootstrap::isRunning() const
+{
+    return mRunning;
+}
+
+bool LoginBootstrap::isFinished(const QString &name) const
+{
+    return std::any_of(mTasks.cbegin(), mTasks.cend(), [&name](const Task &task) {
+        return task.name == name && task.state == State::Finished;
+    });
+}
+
+bool LoginBootstrap::deferredTasksStarted() const
+{
+    return mDeferredTasksStarted;
+}
+
+QHash<QString, qint64> LoginBootstrap::taskDurations() const
+{
+    QHash<QString, qint64> durations;
+    for (const Task &task : mTasks) {
+        if (task.state == State::Finished && task.duration != -1) {
+            durations.insert(task.name, task.duration);
+        }
+    }
+    return durations;
+}
+
+bool LoginBootstrap::isReady(const Task &task) const
+{
+    if (task.stage == Stage::Deferred && !mDeferredTasksStarted) {
+        return false;
+    }
+    // Unknown dependencies are ignored
+    return std::all_of(task.dependencies.cbegin(), task.dependencies.cend(), [this](const QString &dependency) {
+        return std::none_of(mTasks.cbegin(), mTasks.cend(), [&dependency](const Task &task) {
+            return task.name == dependency && task.state != State::Finished;
+        });
+    });
+}
+
+bool LoginBootstrap::allFinished(Stage stage) const
+{
+    return std::all_of(mTasks.cbegin(), mTasks.cend(), [stage](const Task &task) {
+        return task.stage != stage || task.state == State::Finished;
+    });
+}
+
+void LoginBootstrap::startReadyTasks()
+{
+    bool taskStarted = true;
+    while (taskStarted) {
+        taskStarted = false;
+        for (qsizetype i = 0; i < mTasks.count(); ++i) {
+            if (mTasks.at(i).state != State::Pending || !isReady(mTasks.at(i))) {
+                continue;
+            }
+            mTasks[i].state = State::Running;
+            mTasks[i].startTime = mElapsedTimer.elapsed();
+            // Task can add other tasks while it starts
+            const QString name = mTasks.at(i).name;
+            const StartFunction startFunction = mTasks.at(i).start;
+            const int generation = mGeneration;
+            QObject *object = startFunction ? startFunction() : nullptr;
+            if (generation != mGeneration) {
+                // Cleared by the task
+                return;
+            }
+            if (object) {
+                connect(object, &QObject::destroyed, this, [this, name, generation]() {
+                    if (generation == mGeneration) {
+                        taskFinished(name);
+                    }
+                });
+            } else {
+                // Nothing to wait for, no duration
+                mTasks[i].state = State::Finished;
+            }
+            taskStarted = true;
+        }
+    }
+    checkStages();
+}
+
+void LoginBootstrap::startDeferredTasks()
+{
+    mDeferredTasksStarted = true;
+    startReadyTasks();
+}
+
+void LoginBootstrap::taskFinished(const QString &name)
+{
+    const auto it = std::find_if(mTasks.cbegin(), mTasks.cend(), [&name](const Task &task) {
+        return task.name == name;
+    });
+    if (it == mTasks.cend() || it->state != State::Running) {
+        return;
+    }
+    setTaskFinished(std::distance(mTasks.cbegin(), it));
+    startReadyTasks();
+}
+
+void LoginBootstrap::setTaskFinished(qsizetype index)
+{
+    Task &task = mTasks[index];
+    task.state = State::Finished;
+    task.duration = mElapsedTimer.elapsed() - task.startTime;
+}
+
+void LoginBootstrap::checkStages()
+{
+    if (!mRunning) {
+        return;
+    }
+    if (!mDeferredTasksStarted) {
+        if (!mDeferredTasksScheduled && allFinished(Stage::Critical)) {
+            mDeferredTasksScheduled = true;
+            // Let the event loop paint the views first
+            const int generation = mGeneration;
+            QTimer::singleShot(0, this, [this, generation]() {
+                if (generation == mGeneration) {
+                    startDeferredTasks();
+                }
+            });
+            Q_EMIT criticalTasksFinished();
+        }
+        return;
+    }
+    if (allFinished(Stage::Deferred)) {
+        mRunning = false;
+        for (const Task &task : std::as_const(mTasks)) {
+            if (task.duration != -1) {
+                qCDebug(RUQOLA_LOG) << "LoginBootstrap:" << task.name << task.stage << task.duration << "ms";
+            }
+        }
+        qCDebug(RUQOLA_LOG) << "LoginBootstrap: done in" << mElapsedTimer.elapsed() << "ms";
+        Q_EMIT finished();
+    }
+}
+
+#include "moc_loginbootstrap.cpp"
@@ -0,0 +1,88 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+
+/**
+ * Requests sent after login, as a dependency graph.
+ * Critical tasks are started at once, in parallel, when their dependencies are done.
+ * Deferred tasks (not needed to display the rooms) start when the critical ones are done,
+ * after the views had a chance to be painted.
+ * Time spent by each task which returned an object is recorded.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT LoginBootstrap : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Stage : uint8_t {
+        Critical = 0,
+        Deferred,
+    };
+    Q_ENUM(Stage)
+
+    // Starts the task, returns the object (usually the job) destroyed when it's done or failed,
+    // or nullptr when it's done once started (its reply isn't followed, it has no duration)
+    using StartFunction = std::function<QObject *()>;
+
+    explicit LoginBootstrap(QObject *parent = nullptr);
+    ~LoginBootstrap() override;
+
+    // Critical tasks can't depend on deferred ones
+    void addTask(const QString &name, Stage stage, const StartFunction &start, const QStringList &dependencies = {});
+    void start();
+    // Forgets all tasks, running ones are not followed anymore
+    void clear();
+
+    [[nodiscard]] bool isRunning() const;
+    [[nodiscard]] bool isFinished(const QString &name) const;
+    [[nodiscard]] bool deferredTasksStarted() const;
+    // Milliseconds from the start of the task to its end, for finished tasks which returned an object
+    [[nodiscard]] QHash<QString, qint64> taskDurations() const;
+
+Q_SIGNALS:
+    void criticalTasksFinished();
+    void finished();
+
+private:
+    enum class State : uint8_t {
+        Pending = 0,
+        Running,
+        Finished,
+    };
+    struct Task {
+        QString name;
+        QStringList dependencies;
+        StartFunction start;
+        Stage stage = Stage::Critical;
+        State state = State::Pending;
+        qint64 startTime = 0;
+        // -1 when the task didn't return an object
+        qint64 duration = -1;
+    };
+    LIBRUQOLACORE_NO_EXPORT void startReadyTasks();
+    LIBRUQOLACORE_NO_EXPORT void startDeferredTasks();
+    LIBRUQOLACORE_NO_EXPORT void taskFinished(const QString &name);
+    LIBRUQOLACORE_NO_EXPORT void setTaskFinished(qsizetype index);
+    LIBRUQOLACORE_NO_EXPORT void checkStages();
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool isReady(const Task &task) const;
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool allFinished(Stage stage) const;
+
+    QList<Task> mTasks;
+    QElapsedTimer mElapsedTimer;
+    // Tasks of a previous start() finishing after clear() are ignored
+    int mGeneration = 0;
+    bool mRunning = false;
+    bool mDeferredTasksScheduled = false;
+    bool mDeferredTasksStarted = false;
+};
@@ -58,6 +58,9 @@ QString ManagerDataPaths::path(ManagerDataPaths::PathType type, const QString &a
     case PathType::Cache:
         path += QStringLiteral("/MainCache");
         break;
+    case PathType::RestApiCache:
+        path += QStringLiteral("/RestApi");
+        break;
     case PathType::Config:
         break;
     }
@@ -75,5 +78,6 @@ void ManagerDataPaths::initializePaths()
     mPathTypeHash.insert(PathType::Picture, QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
     mPathTypeHash.insert(PathType::PreviewUrl, QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
     mPathTypeHash.insert(PathType::CustomSound, QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    mPathTypeHash.insert(PathType::RestApiCache, QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
     qCDebug(RUQOLA_LOG) << "mPathTypeHash:" << mPathTypeHash;
 }
@@ -20,6 +20,7 @@ public:
         Video = 3,
         PreviewUrl = 4,
         CustomSound = 5,
+        RestApiCache = 6,
     };
     static ManagerDataPaths *self();
 
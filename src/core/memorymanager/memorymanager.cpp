@@ -5,7 +5,9 @@
 */
 
 #include "memorymanager.h"
+#include "messages/message.h"
 #include "ruqola_memory_management_debug.h"
+#include "stringinterner.h"
 #include <QTimer>
 #include <chrono>
 using namespace std::chrono_literals;
@@ -24,6 +26,9 @@ MemoryManager::MemoryManager(QObject *parent)
     connect(mClearRoomsHistory, &QTimer::timeout, this, [this]() {
         qCDebug(RUQOLA_MEMORY_MANAGEMENT_LOG) << "Clean room history";
         Q_EMIT cleanRoomHistoryRequested();
+        // Strings of the removed messages
+        StringInterner::self().purge();
+        Message::clearDisplayTimeCache();
     });
     mClearRoomsHistory->start();
 }
@@ -61,7 +61,8 @@ void MessageCache::slotGetThreadMessagesDone(const QJsonObject &obj, const QByte
 {
     ThreadMessageModel *model = mThreadMessageModels.object(threadMessageId);
     if (!model) {
-        model = new ThreadMessageModel;
+        // Account gives access to the shared message store
+        model = new ThreadMessageModel(mRocketChatAccount);
         model->parseThreadMessages(obj);
         mThreadMessageModels.insert(threadMessageId, model);
     } else {
@@ -6,20 +6,40 @@
 
 #include "message.h"
 #include "ruqola_debug.h"
+#include "stringinterner.h"
 #include <KLocalizedString>
 #include <QCborValue>
 #include <QDateTime>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QMutex>
 using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+// displayTime() of each minute, shared by the messages sent during this minute
+struct DisplayTimeCache {
+    QMutex mutex;
+    QHash<qint64, QString> displayTimes;
+};
+
+DisplayTimeCache &displayTimeCache()
+{
+    static DisplayTimeCache cache;
+    return cache;
+}
+}
 Message::Message() = default;
 
 Message::~Message() = default;
 
 void Message::parseMessage(const QJsonObject &o, bool restApi, EmojiManager *emojiManager)
 {
+    // Identity fields repeat in every message of a room
+    auto &interner = StringInterner::self();
     mMessageId = o.value("_id"_L1).toString().toLatin1();
-    mRoomId = o.value("rid"_L1).toString().toLatin1();
+    mRoomId = interner.intern(o.value("rid"_L1).toString().toLatin1());
     mText = o.value("msg"_L1).toString();
     if (restApi) {
         mUpdatedAt = Utils::parseIsoDate(QStringLiteral("_updatedAt"), o);
@@ -46,17 +66,17 @@ void Message::parseMessage(const QJsonObject &o, bool restApi, EmojiManager *emo
     }
 
     const auto userObject = o.value("u"_L1).toObject();
-    mUsername = userObject.value("username"_L1).toString();
-    mName = userObject.value("name"_L1).toString();
-    mUserId = userObject.value("_id"_L1).toString().toLatin1();
-    mEditedByUsername = o.value("editedBy"_L1).toObject().value("username"_L1).toString();
-    mAlias = o.value("alias"_L1).toString();
-    mAvatar = o.value("avatar"_L1).toString();
+    mUsername = interner.intern(userObject.value("username"_L1).toString());
+    mName = interner.intern(userObject.value("name"_L1).toString());
+    mUserId = interner.intern(userObject.value("_id"_L1).toString().toLatin1());
+    mEditedByUsername = interner.intern(o.value("editedBy"_L1).toObject().value("username"_L1).toString());
+    mAlias = interner.intern(o.value("alias"_L1).toString());
+    mAvatar = interner.intern(o.value("avatar"_L1).toString());
 
     setUnread(o.value("unread"_L1).toBool());
     setGroupable(o.value("groupable"_L1).toBool(/*true*/ false)); // Laurent, disable for the moment groupable
     setParseUrls(o.value("parseUrls"_L1).toBool());
-    mRole = o.value("role"_L1).toString();
+    mRole = interner.intern(o.value("role"_L1).toString());
     if (o.contains("tcount"_L1)) {
         setThreadCount(o.value("tcount"_L1).toInt());
     }
@@ -69,7 +89,7 @@ void Message::parseMessage(const QJsonObject &o, bool restApi, EmojiManager *emo
     if (o.contains("tmid"_L1)) {
         setThreadMessageId(o.value("tmid"_L1).toString().toLatin1());
     }
-    mEmoji = o.value("emoji"_L1).toString();
+    mEmoji = interner.intern(o.value("emoji"_L1).toString());
     mMessageStarred.parse(o);
 
     if (o.contains("pinned"_L1)) {
@@ -107,14 +127,66 @@ void Message::parseMessage(const QJsonObject &o, bool restApi, EmojiManager *emo
             mMessageType = MessageType::System;
         }
     }
-    parseBlocks(o.value("blocks"_L1).toArray());
     parseMentions(o.value("mentions"_L1).toArray());
-
-    parseAttachment(o.value("attachments"_L1).toArray());
-    parseMessageUrls(o.value("urls"_L1).toArray());
     parseReactions(o.value("reactions"_L1).toObject(), emojiManager);
     parseChannels(o.value("channels"_L1).toArray());
-    parseReplies(o.value("replies"_L1).toArray());
+
+    // Most messages of a history page are never displayed: these ones are parsed on first access
+    auto lazySubObjects = std::make_shared<LazySubObjects>();
+    lazySubObjects->blocks = o.value("blocks"_L1).toArray();
+    lazySubObjects->attachments = o.value("attachments"_L1).toArray();
+    lazySubObjects->urls = o.value("urls"_L1).toArray();
+    lazySubObjects->replies = o.value("replies"_L1).toArray();
+    mLazySubObjectTypes = LazyBlocks | LazyAttachments | LazyUrls | LazyReplies;
+    mLazySubObjects = std::move(lazySubObjects);
+}
+
+void Message::parseLazySubObject(LazySubObject type) const
+{
+    if (!(mLazySubObjectTypes & type)) {
+        return;
+    }
+    mLazySubObjectTypes &= ~type;
+    const std::shared_ptr<LazySubObjects> lazySubObjects = mLazySubObjects;
+    if (!mLazySubObjectTypes) {
+        mLazySubObjects.reset();
+    }
+    const bool parsed = lazySubObjects->parsedTypes & type;
+    lazySubObjects->parsedTypes |= type;
+    switch (type) {
+    case LazyBlocks:
+        if (parsed) {
+            mBlocks = lazySubObjects->parsedBlocks;
+        } else {
+            parseBlocks(lazySubObjects->blocks);
+            lazySubObjects->parsedBlocks = mBlocks;
+        }
+        break;
+    case LazyAttachments:
+        if (parsed) {
+            mAttachments = lazySubObjects->parsedAttachments;
+        } else {
+            parseAttachment(lazySubObjects->attachments);
+            lazySubObjects->parsedAttachments = mAttachments;
+        }
+        break;
+    case LazyUrls:
+        if (parsed) {
+            mUrls = lazySubObjects->parsedUrls;
+        } else {
+            parseMessageUrls(lazySubObjects->urls);
+            lazySubObjects->parsedUrls = mUrls;
+        }
+        break;
+    case LazyReplies:
+        if (parsed) {
+            mReplies = lazySubObjects->parsedReplies;
+        } else {
+            parseReplies(lazySubObjects->replies);
+            lazySubObjects->parsedReplies = mReplies;
+        }
+        break;
+    }
 }
 
 void Message::parseReactions(const QJsonObject &reacts, EmojiManager *emojiManager)
@@ -166,19 +238,22 @@ QString Message::emoji() const
 
 void Message::setEmoji(const QString &emoji)
 {
-    mEmoji = emoji;
+    mEmoji = StringInterner::self().intern(emoji);
 }
 
 const Replies *Message::replies() const
 {
+    parseLazySubObject(LazyReplies);
     if (mReplies) {
-        return mReplies.data();
+        // constData(): don't detach the mutable member
+        return mReplies.constData();
     }
     return nullptr;
 }
 
 void Message::setReplies(const Replies &replies)
 {
+    mLazySubObjectTypes &= ~LazyReplies;
     if (!mReplies) {
         mReplies = new Replies(replies);
     } else {
@@ -193,7 +268,7 @@ QString Message::name() const
 
 void Message::setName(const QString &name)
 {
-    mName = name;
+    mName = StringInterner::self().intern(name);
 }
 
 bool Message::isAutoTranslated() const
@@ -233,7 +308,22 @@ void Message::setMessageTranslation(const MessageTranslation &messageTranslation
 
 QString Message::displayTime() const
 {
-    return mDisplayTime;
+    // Cached per minute rather than stored in each message
+    const qint64 minute = mTimeStamp / (60 * 1000);
+    DisplayTimeCache &cache = displayTimeCache();
+    const QMutexLocker locker(&cache.mutex);
+    auto it = cache.displayTimes.constFind(minute);
+    if (it == cache.displayTimes.cend()) {
+        it = cache.displayTimes.insert(minute, QDateTime::fromMSecsSinceEpoch(mTimeStamp).time().toString(QStringLiteral("hh:mm")));
+    }
+    return *it;
+}
+
+void Message::clearDisplayTimeCache()
+{
+    DisplayTimeCache &cache = displayTimeCache();
+    const QMutexLocker locker(&cache.mutex);
+    cache.displayTimes.clear();
 }
 
 QByteArray Message::threadMessageId() const
@@ -358,7 +448,7 @@ QString Message::role() const
 
 void Message::setRole(const QString &role)
 {
-    mRole = role;
+    mRole = StringInterner::self().intern(role);
 }
 
 void Message::parseChannels(const QJsonArray &channels)
@@ -377,14 +467,17 @@ void Message::parseChannels(const QJsonArray &channels)
 
 const Blocks *Message::blocks() const
 {
+    parseLazySubObject(LazyBlocks);
     if (mBlocks) {
-        return mBlocks.data();
+        // constData(): don't detach the mutable member
+        return mBlocks.constData();
     }
     return nullptr;
 }
 
 void Message::setBlocks(const Blocks &newBlocks)
 {
+    mLazySubObjectTypes &= ~LazyBlocks;
     if (!mBlocks) {
         mBlocks = new Blocks(newBlocks);
     } else {
@@ -434,6 +527,16 @@ void Message::setHoverHighlight(bool newShowReactionIcon)
     assignMessageStateValue(HoverHighlight, newShowReactionIcon);
 }
 
+bool Message::showFullMessage() const
+{
+    return messageStateValue(ShowFullMessage);
+}
+
+void Message::setShowFullMessage(bool showFullMessage)
+{
+    assignMessageStateValue(ShowFullMessage, showFullMessage);
+}
+
 const Channels *Message::channels() const
 {
     if (mChannels) {
@@ -451,7 +554,7 @@ void Message::setChannels(const Channels &channels)
     }
 }
 
-void Message::parseReplies(const QJsonArray &replies)
+void Message::parseReplies(const QJsonArray &replies) const
 {
     if (!replies.isEmpty()) {
         if (!mReplies) {
@@ -465,7 +568,7 @@ void Message::parseReplies(const QJsonArray &replies)
     }
 }
 
-void Message::parseBlocks(const QJsonArray &blocks)
+void Message::parseBlocks(const QJsonArray &blocks) const
 {
     if (!blocks.isEmpty()) {
         if (!mBlocks) {
@@ -508,6 +611,7 @@ void Message::setModerationMessage(const ModerationMessage &newModerationMessage
 
 void Message::setVideoConferenceInfo(const VideoConferenceInfo &info)
 {
+    parseLazySubObject(LazyBlocks);
     if (mBlocks) {
         mBlocks->setVideoConferenceInfo(info);
     }
@@ -518,11 +622,12 @@ void Message::parseMentions(const QJsonArray &mentions)
     mMentions.clear();
     for (int i = 0; i < mentions.size(); i++) {
         const QJsonObject mention = mentions.at(i).toObject();
-        mMentions.insert(mention.value("username"_L1).toString(), mention.value("_id"_L1).toString().toLatin1());
+        mMentions.insert(StringInterner::self().intern(mention.value("username"_L1).toString()),
+                         StringInterner::self().intern(mention.value("_id"_L1).toString().toLatin1()));
     }
 }
 
-void Message::parseMessageUrls(const QJsonArray &urls)
+void Message::parseMessageUrls(const QJsonArray &urls) const
 {
     if (!urls.isEmpty()) {
         if (!mUrls) {
@@ -581,7 +686,7 @@ void Message::setMentions(const QMap<QString, QByteArray> &mentions)
     mMentions = mentions;
 }
 
-void Message::parseAttachment(const QJsonArray &attachments)
+void Message::parseAttachment(const QJsonArray &attachments) const
 {
     if (!attachments.isEmpty()) {
         if (!mAttachments) {
@@ -604,7 +709,7 @@ bool Message::operator==(const Message &other) const
         && (discussionLastMessage() == other.discussionLastMessage()) && (discussionRoomId() == other.discussionRoomId())
         && (threadMessageId() == other.threadMessageId()) && (showTranslatedMessage() == other.showTranslatedMessage()) && (mEmoji == other.emoji())
         && (pendingMessage() == other.pendingMessage()) && (showIgnoredMessage() == other.showIgnoredMessage())
-        && (localTranslation() == other.localTranslation()) && (mDisplayTime == other.mDisplayTime) && (privateMessage() == other.privateMessage());
+        && (localTranslation() == other.localTranslation()) && (privateMessage() == other.privateMessage());
     if (!result) {
         return false;
     }
@@ -869,14 +974,25 @@ void Message::setMessageType(MessageType messageType)
 
 const MessageAttachments *Message::attachments() const
 {
+    parseLazySubObject(LazyAttachments);
     if (mAttachments) {
-        return mAttachments.data();
+        // constData(): don't detach the mutable member
+        return mAttachments.constData();
     }
     return nullptr;
 }
 
+bool Message::attachmentsParsed() const
+{
+    if (!(mLazySubObjectTypes & LazyAttachments)) {
+        return true;
+    }
+    return (mLazySubObjects->parsedTypes & LazyAttachments) || mLazySubObjects->attachments.isEmpty();
+}
+
 void Message::setAttachments(const MessageAttachments &attachment)
 {
+    mLazySubObjectTypes &= ~LazyAttachments;
     if (!mAttachments) {
         mAttachments = new MessageAttachments(attachment);
     } else {
@@ -886,14 +1002,17 @@ void Message::setAttachments(const MessageAttachments &attachment)
 
 const MessageUrls *Message::urls() const
 {
+    parseLazySubObject(LazyUrls);
     if (mUrls) {
-        return mUrls.data();
+        // constData(): don't detach the mutable member
+        return mUrls.constData();
     }
     return nullptr;
 }
 
 void Message::setUrls(const MessageUrls &urls)
 {
+    mLazySubObjectTypes &= ~LazyUrls;
     if (urls.isEmpty()) {
         mUrls.reset();
         return;
@@ -912,7 +1031,7 @@ QString Message::alias() const
 
 void Message::setAlias(const QString &alias)
 {
-    mAlias = alias;
+    mAlias = StringInterner::self().intern(alias);
 }
 
 QString Message::editedByUsername() const
@@ -922,7 +1041,7 @@ QString Message::editedByUsername() const
 
 void Message::setEditedByUsername(const QString &editedByUsername)
 {
-    mEditedByUsername = editedByUsername;
+    mEditedByUsername = StringInterner::self().intern(editedByUsername);
 }
 
 bool Message::wasEdited() const
@@ -959,7 +1078,7 @@ QByteArray Message::userId() const
 
 void Message::setUserId(const QByteArray &userId)
 {
-    mUserId = userId;
+    mUserId = StringInterner::self().intern(userId);
 }
 
 QString Message::username() const
@@ -969,7 +1088,7 @@ QString Message::username() const
 
 void Message::setUsername(const QString &username)
 {
-    mUsername = username;
+    mUsername = StringInterner::self().intern(username);
 }
 
 qint64 Message::timeStamp() const
@@ -979,10 +1098,7 @@ qint64 Message::timeStamp() const
 
 void Message::setTimeStamp(qint64 timeStamp)
 {
-    if (mTimeStamp != timeStamp) {
-        mTimeStamp = timeStamp;
-        mDisplayTime = QDateTime::fromMSecsSinceEpoch(mTimeStamp).time().toString(QStringLiteral("hh:mm"));
-    }
+    mTimeStamp = timeStamp;
 }
 
 QString Message::text() const
@@ -1012,7 +1128,7 @@ QByteArray Message::roomId() const
 
 void Message::setRoomId(const QByteArray &roomId)
 {
-    mRoomId = roomId;
+    mRoomId = StringInterner::self().intern(roomId);
 }
 
 QString Message::avatar() const
@@ -1022,7 +1138,7 @@ QString Message::avatar() const
 
 void Message::setAvatar(const QString &avatar)
 {
-    mAvatar = avatar;
+    mAvatar = StringInterner::self().intern(avatar);
 }
 
 bool Message::parseUrls() const
@@ -1079,17 +1195,18 @@ Message Message::deserialize(const QJsonObject &o, EmojiManager *emojiManager)
     }
 
     message.mMessageId = o["messageID"_L1].toString().toLatin1();
-    message.mRoomId = o["roomID"_L1].toString().toLatin1();
+    auto &interner = StringInterner::self();
+    message.mRoomId = interner.intern(o["roomID"_L1].toString().toLatin1());
     message.mText = o["message"_L1].toString();
     message.setTimeStamp(static_cast<qint64>(o["timestamp"_L1].toDouble()));
-    message.mUsername = o["username"_L1].toString();
-    message.mName = o["name"_L1].toString();
-    message.mUserId = o["userID"_L1].toString().toLatin1();
+    message.mUsername = interner.intern(o["username"_L1].toString());
+    message.mName = interner.intern(o["name"_L1].toString());
+    message.mUserId = interner.intern(o["userID"_L1].toString().toLatin1());
     message.mUpdatedAt = static_cast<qint64>(o["updatedAt"_L1].toDouble());
     message.setEditedAt(static_cast<qint64>(o["editedAt"_L1].toDouble()));
-    message.mEditedByUsername = o["editedByUsername"_L1].toString();
-    message.mAlias = o["alias"_L1].toString();
-    message.mAvatar = o["avatar"_L1].toString();
+    message.mEditedByUsername = interner.intern(o["editedByUsername"_L1].toString());
+    message.mAlias = interner.intern(o["alias"_L1].toString());
+    message.mAvatar = interner.intern(o["avatar"_L1].toString());
     message.setGroupable(o["groupable"_L1].toBool());
     message.setParseUrls(o["parseUrls"_L1].toBool());
     message.setUnread(o["unread"_L1].toBool());
@@ -1101,9 +1218,9 @@ Message Message::deserialize(const QJsonObject &o, EmojiManager *emojiManager)
         delete pinned;
     }
 
-    message.mRole = o["role"_L1].toString();
+    message.mRole = interner.intern(o["role"_L1].toString());
     message.mSystemMessageType = SystemMessageTypeUtil::systemMessageTypeFromString(o["type"_L1].toString());
-    message.mEmoji = o["emoji"_L1].toString();
+    message.mEmoji = interner.intern(o["emoji"_L1].toString());
     message.mMessageType = o["messageType"_L1].toVariant().value<MessageType>();
 
     if (o.contains("attachments"_L1)) {
@@ -1138,7 +1255,7 @@ Message Message::deserialize(const QJsonObject &o, EmojiManager *emojiManager)
     const QJsonArray mentionsArray = o.value("mentions"_L1).toArray();
     for (int i = 0, total = mentionsArray.count(); i < total; ++i) {
         const QJsonObject mention = mentionsArray.at(i).toObject();
-        mentions.insert(mention.value("username"_L1).toString(), mention.value("_id"_L1).toString().toLatin1());
+        mentions.insert(interner.intern(mention.value("username"_L1).toString()), interner.intern(mention.value("_id"_L1).toString().toLatin1()));
     }
     message.setMentions(std::move(mentions));
 
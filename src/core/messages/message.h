@@ -21,8 +21,10 @@
 #include "systemmessagetypeutil.h"
 #include "utils.h"
 #include <QColor>
+#include <QJsonArray>
 #include <QList>
 #include <QString>
+#include <memory>
 
 class EmojiManager;
 class LIBRUQOLACORE_EXPORT Message
@@ -53,6 +55,7 @@ public:
         Edited = 64,
         Translated = 128,
         ParsedUrl = 256,
+        ShowFullMessage = 512,
     };
     Q_FLAGS(MessageState MessageStates)
     Q_DECLARE_FLAGS(MessageStates, MessageState)
@@ -130,6 +133,8 @@ public:
     void setMessageType(Message::MessageType messageType);
 
     [[nodiscard]] const MessageAttachments *attachments() const;
+    // False while attachments() would have to parse the json attachments, i.e. the message was not displayed yet
+    [[nodiscard]] bool attachmentsParsed() const;
     void setAttachments(const MessageAttachments &attachments);
 
     [[nodiscard]] const MessageUrls *urls() const;
@@ -177,6 +182,8 @@ public:
     void setThreadMessageId(const QByteArray &threadMessageId);
 
     [[nodiscard]] QString displayTime() const;
+    // To call when the time zone or the locale changed. Can be called from any thread
+    static void clearDisplayTimeCache();
 
     [[nodiscard]] const MessageTranslation *messageTranslation() const;
     void setMessageTranslation(const MessageTranslation &messageTranslation);
@@ -212,6 +219,10 @@ public:
     [[nodiscard]] bool hoverHighlight() const;
     void setHoverHighlight(bool newShowReactionIcon);
 
+    // Large messages are only displayed partially until user asks to see all
+    [[nodiscard]] bool showFullMessage() const;
+    void setShowFullMessage(bool showFullMessage);
+
     [[nodiscard]] QString localTranslation() const;
     void setLocalTranslation(const QString &newLocalTranslation);
 
@@ -235,13 +246,33 @@ public:
 
 private:
     LIBRUQOLACORE_NO_EXPORT void parseMentions(const QJsonArray &mentions);
-    LIBRUQOLACORE_NO_EXPORT void parseAttachment(const QJsonArray &attachments);
-    LIBRUQOLACORE_NO_EXPORT void parseMessageUrls(const QJsonArray &urls);
+    // Sub-objects parsed on first access, the parse methods are const as they only fill mutable members
+    enum LazySubObject : uint8_t {
+        LazyBlocks = 1,
+        LazyAttachments = 2,
+        LazyUrls = 4,
+        LazyReplies = 8,
+    };
+    struct LazySubObjects {
+        QJsonArray blocks;
+        QJsonArray attachments;
+        QJsonArray urls;
+        QJsonArray replies;
+        // Shared by the copies of the message, so that each sub-object is parsed once
+        QSharedDataPointer<Blocks> parsedBlocks;
+        QSharedDataPointer<MessageAttachments> parsedAttachments;
+        QSharedDataPointer<MessageUrls> parsedUrls;
+        QSharedDataPointer<Replies> parsedReplies;
+        uint8_t parsedTypes = 0;
+    };
+    LIBRUQOLACORE_NO_EXPORT void parseLazySubObject(LazySubObject type) const;
+    LIBRUQOLACORE_NO_EXPORT void parseAttachment(const QJsonArray &attachments) const;
+    LIBRUQOLACORE_NO_EXPORT void parseMessageUrls(const QJsonArray &urls) const;
     LIBRUQOLACORE_NO_EXPORT void parseReactions(const QJsonObject &mentions, EmojiManager *emojiManager);
     LIBRUQOLACORE_NO_EXPORT void parseChannels(const QJsonArray &channels);
-    LIBRUQOLACORE_NO_EXPORT void parseBlocks(const QJsonArray &blocks);
+    LIBRUQOLACORE_NO_EXPORT void parseBlocks(const QJsonArray &blocks) const;
     LIBRUQOLACORE_NO_EXPORT void assignMessageStateValue(MessageState type, bool status);
-    LIBRUQOLACORE_NO_EXPORT void parseReplies(const QJsonArray &replies);
+    LIBRUQOLACORE_NO_EXPORT void parseReplies(const QJsonArray &replies) const;
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool messageStateValue(MessageState type) const;
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT MessageExtra *messageExtra();
 
@@ -252,20 +283,17 @@ private:
     // Message Pinned
     QSharedDataPointer<MessagePinned> mMessagePinned;
 
-    // Message Starred
-    MessageStarred mMessageStarred;
-
     // Message Translation
     QSharedDataPointer<MessageTranslation> mMessageTranslation;
 
     // Message Object Fields
-    QSharedDataPointer<MessageAttachments> mAttachments;
+    mutable QSharedDataPointer<MessageAttachments> mAttachments;
 
     // Message urls object
-    QSharedDataPointer<MessageUrls> mUrls;
+    mutable QSharedDataPointer<MessageUrls> mUrls;
 
     // Block
-    QSharedDataPointer<Blocks> mBlocks;
+    mutable QSharedDataPointer<Blocks> mBlocks;
 
     // Reactions
     QSharedDataPointer<Reactions> mReactions;
@@ -277,9 +305,10 @@ private:
     QSharedDataPointer<Channels> mChannels;
 
     // Users which replies to thread
-    QSharedDataPointer<Replies> mReplies;
+    mutable QSharedDataPointer<Replies> mReplies;
 
     // role used when we add/remove role. It will displaying in messagesystem
+    // Role, user, room, alias, avatar and emoji strings are shared through StringInterner
     QString mRole;
 
     // _id
@@ -309,7 +338,6 @@ private:
     QString mEmoji;
 
     // ts
-    QString mDisplayTime;
     qint64 mTimeStamp = -1;
     // _updatedAt
     qint64 mUpdatedAt = -1;
@@ -320,5 +348,13 @@ private:
     SystemMessageTypeUtil::SystemMessageType mSystemMessageType = SystemMessageTypeUtil::SystemMessageType::Unknown;
     MessageType mMessageType = MessageType::NormalText;
     MessageStates mMessageStates = MessageStates(MessageState::Groupable | MessageState::Translated);
+
+    // Message Starred, small members are kept together to avoid padding
+    MessageStarred mMessageStarred;
+
+    // Raw json of the sub-objects which are not parsed yet (LazySubObject flags).
+    // Not thread safe: a message must not be read from several threads while they are parsed.
+    mutable uint8_t mLazySubObjectTypes = 0;
+    mutable std::shared_ptr<LazySubObjects> mLazySubObjects;
 };
 LIBRUQOLACORE_EXPORT QDebug operator<<(QDebug d, const Message &t);
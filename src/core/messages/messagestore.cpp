@@ -0,0 +1,75 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagestore.h"
+
+MessageStore::MessageStore(QObject *parent)
+    : QObject(parent)
+{
+}
+
+MessageStore::~MessageStore() = default;
+
+bool MessageStore::isNewer(const Message &message, const Message &snapshot)
+{
+    // Edits, reactions, thread replies... all change updatedAt. A pending message is replaced by the real one.
+    return message.updatedAt() > snapshot.updatedAt() || (snapshot.pendingMessage() && !message.pendingMessage());
+}
+
+Message MessageStore::acquire(const Message &message)
+{
+    const QByteArray messageId = message.messageId();
+    if (messageId.isEmpty()) {
+        return message;
+    }
+    auto it = mEntries.find(messageId);
+    if (it == mEntries.end()) {
+        mEntries.insert(messageId, {message, 1});
+        return message;
+    }
+    ++it->holderCount;
+    if (isNewer(message, it->message)) {
+        it->message = message;
+        Q_EMIT messageUpdated(message);
+        return message;
+    }
+    return it->message;
+}
+
+void MessageStore::update(const Message &message)
+{
+    auto it = mEntries.find(message.messageId());
+    if (it == mEntries.end()) {
+        return;
+    }
+    if (isNewer(message, it->message)) {
+        it->message = message;
+        Q_EMIT messageUpdated(message);
+    }
+}
+
+void MessageStore::release(const QByteArray &messageId)
+{
+    auto it = mEntries.find(messageId);
+    if (it == mEntries.end()) {
+        return;
+    }
+    if (--it->holderCount <= 0) {
+        mEntries.erase(it);
+    }
+}
+
+int MessageStore::holderCount(const QByteArray &messageId) const
+{
+    return mEntries.value(messageId).holderCount;
+}
+
+qsizetype MessageStore::count() const
+{
+    return mEntries.count();
+}
+
+#include "moc_messagestore.cpp"
@@ -0,0 +1,52 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolacore_export.h"
+#include "messages/message.h"
+#include <QHash>
+#include <QObject>
+
+/**
+ * Per account store of the last known version of each message held by a model
+ * (room, thread, search, starred/pinned lists...).
+ * Models get the stored snapshot when they add a message: copies share their strings and sub-objects,
+ * so a message shown in several models is only in memory once.
+ * When a model receives a newer version of a message, the store replaces its snapshot and
+ * emits messageUpdated() so that the other models holding it are updated too.
+ */
+class LIBRUQOLACORE_EXPORT MessageStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageStore(QObject *parent = nullptr);
+    ~MessageStore() override;
+
+    /**
+     * Registers one more holder of @p message and returns the snapshot to keep:
+     * the stored one if it's not older than @p message.
+     */
+    [[nodiscard]] Message acquire(const Message &message);
+    // Stores @p message if it's newer than the snapshot, message must be already held
+    void update(const Message &message);
+    // Removes one holder of @p messageId, snapshot is dropped when nobody holds it anymore
+    void release(const QByteArray &messageId);
+
+    [[nodiscard]] int holderCount(const QByteArray &messageId) const;
+    [[nodiscard]] qsizetype count() const;
+
+Q_SIGNALS:
+    void messageUpdated(const Message &message);
+
+private:
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT static bool isNewer(const Message &message, const Message &snapshot);
+    struct Entry {
+        Message message;
+        int holderCount = 0;
+    };
+    QHash<QByteArray, Entry> mEntries;
+};
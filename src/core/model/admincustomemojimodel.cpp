@@ -166,7 +166,7 @@ QIcon AdminCustomEmojiModel::createCustomIcon(const QByteArray &identifier) cons
     if (mRocketChatAccount) {
         const QString fileName = mRocketChatAccount->emojiManager()->customEmojiFileNameFromIdentifier(identifier);
         if (!fileName.isEmpty()) {
-            const QUrl emojiUrl = mRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+            const QUrl emojiUrl = mRocketChatAccount->emojiUrlFromLocalCache(fileName);
             if (!emojiUrl.isEmpty()) {
                 const QIcon icon(emojiUrl.toLocalFile());
                 return icon;
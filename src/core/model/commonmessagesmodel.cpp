@@ -30,7 +30,7 @@ QList<Message> CommonMessagesModel::extractMessages(const QJsonObject &obj)
     return messages.listMessages();
 }
 
-bool CommonMessagesModel::parse(const QJsonObject &obj, bool clearMessages, bool insertListMessages)
+bool CommonMessagesModel::parse(const QJsonObject &obj, bool clearMessages)
 {
     if (clearMessages) {
         clear();
@@ -38,7 +38,7 @@ bool CommonMessagesModel::parse(const QJsonObject &obj, bool clearMessages, bool
     const QList<Message> messages = extractMessages(obj);
     const bool isEmpty = messages.isEmpty();
     if (!isEmpty) {
-        addMessages(messages, insertListMessages);
+        addMessages(messages);
     }
     setStringNotFound(rowCount() == 0);
     return isEmpty;
@@ -32,7 +32,7 @@ QIcon EmoticonModel::createCustomIcon(const QString &name) const
     if (mRocketChatAccount) {
         const QString fileName = mRocketChatAccount->emojiManager()->customEmojiFileName(name);
         if (!fileName.isEmpty()) {
-            const QUrl emojiUrl = mRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+            const QUrl emojiUrl = mRocketChatAccount->emojiUrlFromLocalCache(fileName);
             if (!emojiUrl.isEmpty()) {
                 const QIcon icon(emojiUrl.toLocalFile());
                 return icon;
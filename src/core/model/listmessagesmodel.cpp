@@ -34,7 +34,7 @@ void ListMessagesModel::parse(const QJsonObject &obj)
 
     messages.parseMessages(obj, parseMessageName);
     mTotal = messages.total();
-    addMessages(messages.listMessages(), true);
+    addMessages(messages.listMessages());
     setHasFullList(rowCount() == total());
 }
 
@@ -8,34 +8,79 @@
 
 #include <QModelIndex>
 #include <QTimeZone>
+#include <QTimer>
 
+#include "batchtextconverter.h"
+#include "colorsandmessageviewstyle.h"
 #include "emoticons/emojimanager.h"
+#include "highlightedcodecache.h"
 #include "loadrecenthistorymanager.h"
+#include "messages/messagestore.h"
 #include "messagesmodel.h"
 #include "rocketchataccount.h"
+#include "rocketchataccountsettings.h"
 #include "room.h"
+#include "ruqolaglobalconfig.h"
 #include "ruqola_debug.h"
 #include "textconverter.h"
 #include "utils.h"
 
 #include <KLocalizedString>
 
+#include <chrono>
+#include <utility>
+
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
 MessagesModel::MessagesModel(const QByteArray &roomID, RocketChatAccount *account, Room *room, QObject *parent)
     : QAbstractListModel(parent)
     , mRoomId(roomID)
     , mRocketChatAccount(account)
     , mRoom(room)
     , mLoadRecentHistoryManager(new LoadRecentHistoryManager)
+    , mDataChangedTimer(new QTimer(this))
+    , mLargeMessageTimer(new QTimer(this))
 {
     qCDebug(RUQOLA_LOG) << "Creating message Model";
+    mDataChangedTimer->setSingleShot(true);
+    // One frame: changes arriving in bursts (downloads, background conversion, edits) repaint once
+    mDataChangedTimer->setInterval(16ms);
+    connect(mDataChangedTimer, &QTimer::timeout, this, &MessagesModel::emitPendingDataChanged);
+    // data() is const: conversions are started from the event loop
+    mLargeMessageTimer->setSingleShot(true);
+    mLargeMessageTimer->setInterval(0);
+    connect(mLargeMessageTimer, &QTimer::timeout, this, &MessagesModel::convertPendingLargeMessages);
+    mConvertedTextCache.setMaxEntries(512);
     if (mRoom) {
         connect(mRoom, &Room::rolesChanged, this, &MessagesModel::refresh);
         connect(mRoom, &Room::ignoredUsersChanged, this, &MessagesModel::refresh);
         connect(mRoom, &Room::highlightsWordChanged, this, &MessagesModel::refresh);
     }
+    connect(&ColorsAndMessageViewStyle::self(), &ColorsAndMessageViewStyle::needToUpdateColors, this, [this]() {
+        // Quoted messages are rendered with the colors too
+        TextConverter::clearQuotedTextCache();
+        clearConvertedTextCache();
+    });
+    if (mRocketChatAccount) {
+        mMessageStore = mRocketChatAccount->messageStore();
+        connect(mMessageStore, &MessageStore::messageUpdated, this, &MessagesModel::slotMessageUpdated);
+        // Mentions and highlighted words depend on them
+        connect(mRocketChatAccount, &RocketChatAccount::highlightWordsChanged, this, &MessagesModel::refresh);
+        connect(mRocketChatAccount->settings(), &RocketChatAccountSettings::userNameChanged, this, &MessagesModel::refresh);
+        connect(mRocketChatAccount->emojiManager(), &EmojiManager::customEmojiChanged, this, [this]() {
+            // Quoted messages are cached with the emoji revision, they are converted again
+            clearConvertedTextCache();
+            // Custom emoji file names can change
+            rebuildDownloadIndex();
+        });
+    }
 }
 
-MessagesModel::~MessagesModel() = default;
+MessagesModel::~MessagesModel()
+{
+    releaseMessages(0, mAllMessages.count());
+}
 
 void MessagesModel::activate()
 {
@@ -101,6 +146,7 @@ QByteArray MessagesModel::messageIdFromIndex(int rowIndex)
 
 void MessagesModel::refresh()
 {
+    clearConvertedTextCache();
     beginResetModel();
     endResetModel();
 }
@@ -126,61 +172,298 @@ static bool compareTimeStamps(const Message &lhs, const Message &rhs)
     return lhs.timeStamp() < rhs.timeStamp();
 }
 
-void MessagesModel::addMessage(const Message &message)
+bool MessagesModel::updateExistingMessage(const Message &message)
 {
     auto it = std::upper_bound(mAllMessages.begin(), mAllMessages.end(), message, compareTimeStamps);
 
-    auto emitChanged = [this](int rowNumber, const QList<int> &roles = QList<int>()) {
-        const QModelIndex index = createIndex(rowNumber, 0);
-        Q_EMIT dataChanged(index, index, roles);
-    };
-
     // When we have 1 element.
     if (mAllMessages.count() == 1 && (*mAllMessages.begin()).messageId() == message.messageId()) {
         (*mAllMessages.begin()) = message;
+        if (mMessageStore) {
+            mMessageStore->update(message);
+        }
+        indexDownloads(message);
+        invalidateConvertedText(message.messageId());
         qCDebug(RUQOLA_LOG) << "Update first message";
-        emitChanged(0);
+        scheduleDataChanged(message.messageId());
+        return true;
     } else if (((it) != mAllMessages.begin() && (*(it - 1)).messageId() == message.messageId())) {
         qCDebug(RUQOLA_LOG) << "Update message: " << message.text();
         if (message.pendingMessage()) {
             // If we already have a message and we must add pending message it's that server
             // send quickly new message => replace not it by a pending message
-            return;
+            return true;
         }
         (*(it - 1)) = message;
-        emitChanged(std::distance(mAllMessages.begin(), it - 1), {OriginalMessageOrAttachmentDescription});
-    } else {
-        qCDebug(RUQOLA_LOG) << "Add message: " << message.text();
-        const int pos = it - mAllMessages.begin();
-        beginInsertRows(QModelIndex(), pos, pos);
-        mAllMessages.insert(it, message);
-        endInsertRows();
+        invalidateConvertedText(message.messageId());
+        if (mMessageStore) {
+            mMessageStore->update(message);
+        }
+        indexDownloads(message);
+        scheduleDataChanged(message.messageId(), {OriginalMessageOrAttachmentDescription});
+        return true;
+    }
+    return false;
+}
+
+void MessagesModel::addMessage(const Message &message)
+{
+    if (updateExistingMessage(message)) {
+        return;
     }
+    qCDebug(RUQOLA_LOG) << "Add message: " << message.text();
+    const Message sharedMessage = mMessageStore ? mMessageStore->acquire(message) : message;
+    auto it = std::upper_bound(mAllMessages.begin(), mAllMessages.end(), sharedMessage, compareTimeStamps);
+    const int pos = it - mAllMessages.begin();
+    beginInsertRows(QModelIndex(), pos, pos);
+    mAllMessages.insert(it, sharedMessage);
+    invalidateMessageIndex();
+    indexDownloads(sharedMessage);
+    endInsertRows();
 }
 
-void MessagesModel::addMessages(const QList<Message> &messages, bool insertListMessages)
+void MessagesModel::addMessages(const QList<Message> &messages)
 {
     if (messages.isEmpty()) {
         return;
     }
-    if (mAllMessages.isEmpty()) {
-        beginInsertRows(QModelIndex(), 0, messages.count() - 1);
-        mAllMessages = messages;
-        std::sort(mAllMessages.begin(), mAllMessages.end(), compareTimeStamps);
+    QList<Message> sortedMessages = messages;
+    std::stable_sort(sortedMessages.begin(), sortedMessages.end(), compareTimeStamps);
+
+    // Update messages we already have, keep the new ones (last version if a message is in the list twice)
+    QList<Message> newMessages;
+    newMessages.reserve(sortedMessages.count());
+    for (const Message &message : std::as_const(sortedMessages)) {
+        if (updateExistingMessage(message)) {
+            continue;
+        }
+        if (!newMessages.isEmpty() && newMessages.constLast().messageId() == message.messageId()) {
+            if (!message.pendingMessage()) {
+                newMessages.last() = message;
+            }
+            continue;
+        }
+        newMessages.append(message);
+    }
+    if (mMessageStore) {
+        // Share the messages already held by other models
+        for (Message &message : newMessages) {
+            message = mMessageStore->acquire(message);
+        }
+    }
+
+    // Merge them: one insertion per run of new messages which are between the same two existing messages.
+    // Views keep their state and caches, as opposed to a model reset.
+    QList<qsizetype> insertionPositions;
+    insertionPositions.reserve(newMessages.count());
+    for (const Message &message : std::as_const(newMessages)) {
+        const auto it = std::upper_bound(mAllMessages.cbegin(), mAllMessages.cend(), message, compareTimeStamps);
+        insertionPositions.append(std::distance(mAllMessages.cbegin(), it));
+    }
+    qsizetype insertedCount = 0;
+    for (qsizetype runStart = 0, total = newMessages.count(); runStart < total;) {
+        qsizetype runEnd = runStart + 1;
+        while (runEnd < total && insertionPositions.at(runEnd) == insertionPositions.at(runStart)) {
+            ++runEnd;
+        }
+        const qsizetype firstRow = insertionPositions.at(runStart) + insertedCount;
+        const qsizetype runLength = runEnd - runStart;
+        beginInsertRows(QModelIndex(), firstRow, firstRow + runLength - 1);
+        mAllMessages.insert(firstRow, runLength, Message());
+        std::copy(newMessages.cbegin() + runStart, newMessages.cbegin() + runEnd, mAllMessages.begin() + firstRow);
+        invalidateMessageIndex();
+        for (qsizetype i = runStart; i < runEnd; ++i) {
+            indexDownloads(newMessages.at(i));
+        }
         endInsertRows();
-    } else if (insertListMessages) {
-        beginResetModel();
-        mAllMessages += messages;
-        std::sort(mAllMessages.begin(), mAllMessages.end(), compareTimeStamps);
-        endResetModel();
-    } else {
-        // TODO optimize this case as well?
-        for (const Message &message : messages) {
-            addMessage(message);
+        insertedCount += runLength;
+        runStart = runEnd;
+    }
+    // History pages: convert them in worker threads before they are painted
+    if (messages.count() >= 20) {
+        convertMessagesInBackground(messages);
+    }
+}
+
+void MessagesModel::convertMessagesInBackground(const QList<Message> &messages)
+{
+    if (!mRocketChatAccount) {
+        return;
+    }
+    QList<Message> messagesToConvert;
+    messagesToConvert.reserve(messages.count());
+    const bool checkIgnoredUsers = mRoom && mRoom->channelType() != Room::RoomType::Direct;
+    for (const Message &message : messages) {
+        // Translated and ignored messages depend on state which can change, they are converted when painted
+        if (message.messageType() == Message::System || message.showTranslatedMessage() || isLargeMessage(message)
+            || mConvertedTextCache.find(message.messageId()) != mConvertedTextCache.end()) {
+            continue;
+        }
+        if (checkIgnoredUsers && mRoom->userIsIgnored(message.userId())) {
+            continue;
+        }
+        messagesToConvert.append(message);
+    }
+    if (messagesToConvert.isEmpty()) {
+        return;
+    }
+    // Messages edited while they are converted must not get their previous text
+    QHash<QByteArray, qint64> convertedRevisions;
+    convertedRevisions.reserve(messagesToConvert.count());
+    for (const Message &message : std::as_const(messagesToConvert)) {
+        convertedRevisions.insert(message.messageId(), message.updatedAt());
+    }
+    const quint64 generation = mConvertedTextCacheGeneration;
+    BatchTextConverter::convert(batchTextConverterSettings(),
+                                messagesToConvert,
+                                this,
+                                [this, generation, convertedRevisions](const QList<BatchTextConverter::Result> &results) {
+                                    if (generation != mConvertedTextCacheGeneration) {
+                                        return;
+                                    }
+                                    for (const BatchTextConverter::Result &result : results) {
+                                        const qsizetype row = messageRow(result.messageId);
+                                        if (row == -1 || mAllMessages.at(row).updatedAt() != convertedRevisions.value(result.messageId)) {
+                                            continue;
+                                        }
+                                        if (mConvertedTextCache.find(result.messageId) == mConvertedTextCache.end()) {
+                                            mConvertedTextCache.insert(result.messageId, result.convertedText);
+                                        }
+                                    }
+                                });
+}
+
+BatchTextConverter::Settings MessagesModel::batchTextConverterSettings() const
+{
+    BatchTextConverter::Settings settings;
+    settings.allMessages = mAllMessages;
+    settings.colors = std::make_shared<const TextConverter::TextColors>(TextConverter::TextColors::fromColorScheme());
+    if (mRocketChatAccount) {
+        settings.userName = mRocketChatAccount->userName();
+        settings.highlightWords = mRocketChatAccount->highlightWords();
+        settings.emojiReplacementTable = mRocketChatAccount->emojiManager()->replacementTable();
+        settings.maximumRecursiveQuotedText = mRocketChatAccount->ruqolaServerConfig()->messageQuoteChainLimit();
+    }
+    return settings;
+}
+
+void MessagesModel::clearConvertedTextCache()
+{
+    mConvertedTextCache.clear();
+    // Full messages being converted are converted again, otherwise they would stay "Loading…"
+    for (auto it = mLargeMessageConversions.cbegin(), end = mLargeMessageConversions.cend(); it != end; ++it) {
+        if (it->showFullMessage && !it->finished) {
+            mPendingLargeMessages.insert(it.key());
+        }
+    }
+    if (!mPendingLargeMessages.isEmpty()) {
+        mLargeMessageTimer->start();
+    }
+    mLargeMessageConversions.clear();
+    ++mConvertedTextCacheGeneration;
+}
+
+void MessagesModel::invalidateConvertedText(const QByteArray &messageId)
+{
+    // Quotes are rendered with the quoted message: drop the messages quoting it, and the ones quoting them
+    QList<QByteArray> pendingIds{messageId};
+    QSet<QByteArray> invalidatedIds{messageId};
+    while (!pendingIds.isEmpty()) {
+        const QByteArray id = pendingIds.takeLast();
+        mConvertedTextCache.remove(id);
+        mLargeMessageConversions.remove(id);
+        const QLatin1StringView quotedId(id);
+        for (const Message &message : std::as_const(mAllMessages)) {
+            const QByteArray quotingId = message.messageId();
+            if (!invalidatedIds.contains(quotingId) && message.text().contains(quotedId)) {
+                invalidatedIds.insert(quotingId);
+                pendingIds.append(quotingId);
+                scheduleDataChanged(quotingId, {MessageConvertedText});
+            }
         }
     }
 }
 
+bool MessagesModel::isLargeMessage(const Message &message) const
+{
+    const int threshold = RuqolaGlobalConfig::self()->largeMessageThreshold();
+    return threshold > 0 && message.text().size() > threshold;
+}
+
+QString MessagesModel::largeMessageText(const Message &message) const
+{
+    const QByteArray messageId = message.messageId();
+    auto it = mLargeMessageConversions.find(messageId);
+    if (it == mLargeMessageConversions.end() || it->showFullMessage != message.showFullMessage()) {
+        // Only the beginning is converted here, it's enough to render the preview
+        const BatchTextConverter::TextChunk chunk = BatchTextConverter::textChunk(message.text(), 0);
+        LargeMessageConversion conversion;
+        conversion.html = BatchTextConverter::convertChunk(batchTextConverterSettings(), message, chunk);
+        conversion.showFullMessage = message.showFullMessage();
+        conversion.nextPosition = chunk.end;
+        conversion.openCodeBlockFence = chunk.openCodeBlockFence;
+        conversion.finished = !conversion.showFullMessage || conversion.nextPosition >= message.text().size();
+        it = mLargeMessageConversions.insert(messageId, conversion);
+        if (!conversion.finished) {
+            mPendingLargeMessages.insert(messageId);
+            mLargeMessageTimer->start();
+        }
+    }
+    QString html = it->html;
+    if (!it->showFullMessage) {
+        html += QStringLiteral("<p><a href=\"ruqola:/showfullmessage/%1\">%2</a></p>")
+                    .arg(QString::fromLatin1(messageId), i18n("Show full message (%1 characters)", message.text().size()));
+    } else if (!it->finished) {
+        html += QStringLiteral("<p><i>%1</i></p>").arg(i18n("Loading…"));
+    }
+    return "<qt>"_L1 + html + "</qt>"_L1;
+}
+
+void MessagesModel::convertPendingLargeMessages()
+{
+    const QSet<QByteArray> messageIds = std::exchange(mPendingLargeMessages, {});
+    for (const QByteArray &messageId : messageIds) {
+        const qsizetype row = messageRow(messageId);
+        if (row == -1) {
+            continue;
+        }
+        const Message message = mAllMessages.at(row);
+        if (!isLargeMessage(message) || !message.showFullMessage()) {
+            continue;
+        }
+        auto it = mLargeMessageConversions.find(messageId);
+        if (it == mLargeMessageConversions.end() || !it->showFullMessage) {
+            // Cache was cleared: convert the preview again, it re-queues the message
+            (void)largeMessageText(message);
+            continue;
+        }
+        if (it->finished || it->conversionId != 0) {
+            continue;
+        }
+        const quint64 conversionId = ++mLargeMessageConversionId;
+        it->conversionId = conversionId;
+        BatchTextConverter::convertInChunks(batchTextConverterSettings(),
+                                            message,
+                                            it->nextPosition,
+                                            it->openCodeBlockFence,
+                                            this,
+                                            [this, conversionId, messageId](const QString &html, bool finished) {
+                                                auto it = mLargeMessageConversions.find(messageId);
+                                                // Message changed, was collapsed or cache cleared (it's converted again then)
+                                                if (it == mLargeMessageConversions.end() || it->conversionId != conversionId) {
+                                                    return;
+                                                }
+                                                it->html += html;
+                                                it->finished = finished;
+                                                // Each update rebuilds the whole document in the view: update it once
+                                                if (finished) {
+                                                    it->conversionId = 0;
+                                                    scheduleDataChanged(messageId, {MessagesModel::ShowFullMessage});
+                                                }
+                                            });
+    }
+}
+
 QVariant MessagesModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid()) {
@@ -357,6 +640,8 @@ QVariant MessagesModel::data(const QModelIndex &index, int role) const
         return messageReplies(message);
     case MessagesModel::Unread:
         return message.unread();
+    case MessagesModel::ShowFullMessage:
+        return message.showFullMessage();
     }
 
     return {};
@@ -376,9 +661,25 @@ QString MessagesModel::convertedText(const Message &message, const QString &sear
             }
             highlightWords = mRoom->highlightsWord();
         }
-        const QString userName = mRocketChatAccount ? mRocketChatAccount->userName() : QString();
-        const QStringList highlightWordsLst = mRocketChatAccount ? mRocketChatAccount->highlightWords() : highlightWords;
-        const QString convertedMessage{convertMessageText(message, userName, highlightWordsLst, searchedText)};
+        // Search highlighting and translations are not cached
+        const bool useCache = searchedText.isEmpty() && !message.showTranslatedMessage();
+        QString convertedMessage;
+        auto cacheIt = useCache ? mConvertedTextCache.find(message.messageId()) : mConvertedTextCache.end();
+        if (useCache && isLargeMessage(message)) {
+            // Don't convert and lay out megabytes of text before user asks for it
+            convertedMessage = largeMessageText(message);
+        } else if (cacheIt != mConvertedTextCache.end()) {
+            convertedMessage = cacheIt->value;
+        } else {
+            const QString userName = mRocketChatAccount ? mRocketChatAccount->userName() : QString();
+            const QStringList highlightWordsLst = mRocketChatAccount ? mRocketChatAccount->highlightWords() : highlightWords;
+            QByteArray needUpdateMessageId;
+            convertedMessage = convertMessageText(message, userName, highlightWordsLst, searchedText, &needUpdateMessageId);
+            // Quoted message not loaded or code block not highlighted yet: conversion will be done again
+            if (useCache && needUpdateMessageId.isEmpty() && !convertedMessage.contains(HighlightedCodeCache::pendingHighlightingMarker())) {
+                mConvertedTextCache.insert(message.messageId(), convertedMessage);
+            }
+        }
         if (message.privateMessage()) {
             return i18n("Only you can see this message") + convertedMessage;
         }
@@ -412,7 +713,7 @@ bool MessagesModel::setData(const QModelIndex &index, const QVariant &value, int
             MessageAttachments d;
             d.setMessageAttachments(attachments);
             message.setAttachments(d);
-            Q_EMIT dataChanged(index, index, {MessagesModel::DisplayAttachment});
+            scheduleDataChanged(message.messageId(), {MessagesModel::DisplayAttachment});
             return true;
         } else {
             return false;
@@ -434,7 +735,7 @@ bool MessagesModel::setData(const QModelIndex &index, const QVariant &value, int
             MessageUrls d;
             d.setMessageUrls(urls);
             message.setUrls(d);
-            Q_EMIT dataChanged(index, index, {MessagesModel::DisplayUrlPreview});
+            scheduleDataChanged(message.messageId(), {MessagesModel::DisplayUrlPreview});
             return true;
         } else {
             return false;
@@ -442,23 +743,27 @@ bool MessagesModel::setData(const QModelIndex &index, const QVariant &value, int
     }
     case MessagesModel::ShowTranslatedMessage:
         message.setShowTranslatedMessage(value.toBool());
-        Q_EMIT dataChanged(index, index, {MessagesModel::ShowTranslatedMessage});
+        scheduleDataChanged(message.messageId(), {MessagesModel::ShowTranslatedMessage});
         return true;
     case MessagesModel::ShowIgnoredMessage:
         message.setShowIgnoredMessage(value.toBool());
-        Q_EMIT dataChanged(index, index, {MessagesModel::ShowIgnoredMessage});
+        scheduleDataChanged(message.messageId(), {MessagesModel::ShowIgnoredMessage});
         return true;
     case MessagesModel::MessageInEditMode:
         message.setIsEditingMode(value.toBool());
-        Q_EMIT dataChanged(index, index, {MessagesModel::MessageInEditMode});
+        scheduleDataChanged(message.messageId(), {MessagesModel::MessageInEditMode});
         return true;
     case MessagesModel::HoverHighLight:
         message.setHoverHighlight(value.toBool());
-        Q_EMIT dataChanged(index, index, {MessagesModel::HoverHighLight});
+        scheduleDataChanged(message.messageId(), {MessagesModel::HoverHighLight});
         return true;
     case MessagesModel::LocalTranslation:
         message.setLocalTranslation(value.toString());
-        Q_EMIT dataChanged(index, index, {MessagesModel::LocalTranslation});
+        scheduleDataChanged(message.messageId(), {MessagesModel::LocalTranslation});
+        return true;
+    case MessagesModel::ShowFullMessage:
+        message.setShowFullMessage(value.toBool());
+        scheduleDataChanged(message.messageId(), {MessagesModel::ShowFullMessage});
         return true;
     }
     return false;
@@ -472,7 +777,11 @@ QStringList MessagesModel::roomRoles(const QByteArray &userId) const
     return {};
 }
 
-QString MessagesModel::convertMessageText(const Message &message, const QString &userName, const QStringList &highlightWords, const QString &searchedText) const
+QString MessagesModel::convertMessageText(const Message &message,
+                                          const QString &userName,
+                                          const QStringList &highlightWords,
+                                          const QString &searchedText,
+                                          QByteArray *needUpdateMessageId) const
 {
     QString messageStr = message.text();
     EmojiManager *emojiManager = nullptr;
@@ -501,7 +810,7 @@ QString MessagesModel::convertMessageText(const Message &message, const QString
         }
     }
 
-    QByteArray needUpdateMessageId;
+    QByteArray updateMessageId;
     const TextConverter::ConvertMessageTextSettings settings(messageStr,
                                                              userName,
                                                              mAllMessages,
@@ -511,10 +820,19 @@ QString MessagesModel::convertMessageText(const Message &message, const QString
                                                              message.mentions(),
                                                              message.channels(),
                                                              searchedText,
-                                                             maximumRecursiveQuotedText);
+                                                             maximumRecursiveQuotedText,
+                                                             {},
+                                                             [this](const QByteArray &messageId) -> const Message * {
+                                                                 const auto it = findMessage(messageId);
+                                                                 return it == mAllMessages.cend() ? nullptr : &(*it);
+                                                             });
 
     int recursiveIndex = 0;
-    return TextConverter::convertMessageText(settings, needUpdateMessageId, recursiveIndex);
+    const QString result = TextConverter::convertMessageText(settings, updateMessageId, recursiveIndex);
+    if (needUpdateMessageId) {
+        *needUpdateMessageId = updateMessageId;
+    }
+    return result;
 }
 
 void MessagesModel::setRoomId(const QByteArray &roomId)
@@ -530,53 +848,148 @@ bool MessagesModel::isEmpty() const
 void MessagesModel::clear()
 {
     mSearchText.clear();
+    clearConvertedTextCache();
     if (rowCount() != 0) {
         beginResetModel();
+        releaseMessages(0, mAllMessages.count());
         mAllMessages.clear();
+        invalidateMessageIndex();
+        rebuildDownloadIndex();
         endResetModel();
     }
 }
 
-void MessagesModel::slotFileDownloaded(const QString &filePath, const QUrl &cacheImageUrl)
+void MessagesModel::slotFileDownloaded(const QString &filePath)
 {
-    auto matchesFilePath = [&](const QList<MessageAttachment> &msgAttachments) {
-        return std::find_if(msgAttachments.begin(),
-                            msgAttachments.end(),
-                            [&](const MessageAttachment &attach) {
-                                // Transform link() the way RocketChatCache::downloadFile does it
-                                return mRocketChatAccount->urlForLink(attach.imageUrlPreview()).path() == filePath;
-                            })
-            != msgAttachments.end();
-    };
-    auto it = std::find_if(mAllMessages.begin(), mAllMessages.end(), [&](const Message &msg) {
-        if (msg.attachments() && !msg.attachments()->messageAttachments().isEmpty()) {
-            return matchesFilePath(msg.attachments()->messageAttachments());
+    indexPendingDownloads();
+    QList<QByteArray> messageIds = mDownloadPathIndex.values(filePath);
+    const QStringList avatarIdentifiers = mRocketChatAccount->avatarIdentifiers(filePath);
+    for (const QString &avatarIdentifier : avatarIdentifiers) {
+        messageIds += mAvatarIndex.values(avatarIdentifier);
+    }
+    if (!messageIds.isEmpty()) {
+        for (const QByteArray &messageId : std::as_const(messageIds)) {
+            scheduleDataChanged(messageId);
         }
+    } else if (mRocketChatAccount->emojiManager()->isCustomEmojiFile(filePath)) {
+        // A custom emoji used in a message text, converted before it was downloaded
+        clearConvertedTextCache();
+    } else {
+        // Not necessarily a problem. The signal is emitted for CustomSounds or avatars, not just for attachments.
+        // qCDebug(RUQOLA_LOG) << "Attachment not found:" << filePath << "in" << mRoom->name() << "which has" << mAllMessages.count() << "messages";
+    }
+}
+
+void MessagesModel::slotMessageUpdated(const Message &message)
+{
+    const qsizetype row = messageRow(message.messageId());
+    if (row == -1) {
+        return;
+    }
+    // Nothing to do when we sent this update
+    const Message &current = mAllMessages.at(row);
+    if (current.updatedAt() >= message.updatedAt() && (!current.pendingMessage() || message.pendingMessage())) {
+        return;
+    }
+    updateExistingMessage(message);
+}
+
+void MessagesModel::releaseMessages(qsizetype first, qsizetype count)
+{
+    if (!mMessageStore) {
+        return;
+    }
+    for (qsizetype i = first; i < first + count; ++i) {
+        mMessageStore->release(mAllMessages.at(i).messageId());
+    }
+}
+
+void MessagesModel::indexDownloads(const Message &message)
+{
+    // Attachments are parsed on first access: don't parse them when messages are loaded
+    const QByteArray messageId = message.messageId();
+    unindexDownloads(messageId);
+    mMessagesToIndex.insert(messageId);
+}
+
+void MessagesModel::indexPendingDownloads()
+{
+    // Only displayed messages request downloads: the ones which weren't displayed stay pending,
+    // so that their attachments are not parsed here
+    for (auto it = mMessagesToIndex.begin(); it != mMessagesToIndex.end();) {
+        const qsizetype row = messageRow(*it);
+        if (row == -1) {
+            it = mMessagesToIndex.erase(it);
+        } else if (mAllMessages.at(row).attachmentsParsed()) {
+            indexMessageDownloads(mAllMessages.at(row));
+            it = mMessagesToIndex.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MessagesModel::indexMessageDownloads(const Message &message)
+{
+    if (!mRocketChatAccount) {
+        return;
+    }
+    const QByteArray messageId = message.messageId();
+    DownloadIndexKeys keys;
+    if (message.attachments() && !message.attachments()->messageAttachments().isEmpty()) {
+        const auto messageAttachments = message.attachments()->messageAttachments();
+        for (const MessageAttachment &attach : messageAttachments) {
+            // Transform link() the way RocketChatCache::downloadFile does it
+            keys.filePaths.append(mRocketChatAccount->urlForLink(attach.imageUrlPreview()).path());
+        }
+    } else {
         auto *emojiManager = mRocketChatAccount->emojiManager();
-        if (auto reactionsMessages = msg.reactions()) {
+        if (auto reactionsMessages = message.reactions()) {
             const auto reactions = reactionsMessages->reactions();
             for (const Reaction &reaction : reactions) {
                 const QString fileName = emojiManager->customEmojiFileName(reaction.reactionName());
-                if (!fileName.isEmpty() && mRocketChatAccount->urlForLink(fileName).path() == filePath) {
-                    return true;
+                if (!fileName.isEmpty()) {
+                    keys.filePaths.append(mRocketChatAccount->urlForLink(fileName).path());
                 }
             }
         }
-        const Utils::AvatarInfo info = msg.avatarInfo();
-        const QUrl iconUrlStr = QUrl(mRocketChatAccount->avatarUrl(info));
-        if (!iconUrlStr.isEmpty()) {
-            if (iconUrlStr == cacheImageUrl) {
-                return true;
-            }
+        const Utils::AvatarInfo info = message.avatarInfo();
+        if (info.isValid()) {
+            keys.avatarIdentifier = info.generateAvatarIdentifier();
         }
-        return false;
-    });
-    if (it != mAllMessages.end()) {
-        const QModelIndex idx = createIndex(std::distance(mAllMessages.begin(), it), 0);
-        Q_EMIT dataChanged(idx, idx);
-    } else {
-        // Not necessarily a problem. The signal is emitted for CustomSounds or avatars, not just for attachments.
-        // qCDebug(RUQOLA_LOG) << "Attachment not found:" << filePath << "in" << mRoom->name() << "which has" << mAllMessages.count() << "messages";
+    }
+    keys.filePaths.removeDuplicates();
+    for (const QString &filePath : std::as_const(keys.filePaths)) {
+        mDownloadPathIndex.insert(filePath, messageId);
+    }
+    if (!keys.avatarIdentifier.isEmpty()) {
+        mAvatarIndex.insert(keys.avatarIdentifier, messageId);
+    }
+    if (!keys.filePaths.isEmpty() || !keys.avatarIdentifier.isEmpty()) {
+        mDownloadIndexKeys.insert(messageId, keys);
+    }
+}
+
+void MessagesModel::unindexDownloads(const QByteArray &messageId)
+{
+    mMessagesToIndex.remove(messageId);
+    const DownloadIndexKeys keys = mDownloadIndexKeys.take(messageId);
+    for (const QString &filePath : keys.filePaths) {
+        mDownloadPathIndex.remove(filePath, messageId);
+    }
+    if (!keys.avatarIdentifier.isEmpty()) {
+        mAvatarIndex.remove(keys.avatarIdentifier, messageId);
+    }
+}
+
+void MessagesModel::rebuildDownloadIndex()
+{
+    mDownloadPathIndex.clear();
+    mAvatarIndex.clear();
+    mDownloadIndexKeys.clear();
+    mMessagesToIndex.clear();
+    for (const Message &message : std::as_const(mAllMessages)) {
+        mMessagesToIndex.insert(message.messageId());
     }
 }
 
@@ -585,8 +998,12 @@ void MessagesModel::deleteMessage(const QByteArray &messageId)
     auto it = findMessage(messageId);
     if (it != mAllMessages.end()) {
         const int i = std::distance(mAllMessages.begin(), it);
+        mConvertedTextCache.remove(messageId);
         beginRemoveRows(QModelIndex(), i, i);
+        releaseMessages(i, 1);
         mAllMessages.erase(it);
+        invalidateMessageIndex();
+        unindexDownloads(messageId);
         endRemoveRows();
     }
 }
@@ -653,18 +1070,86 @@ bool MessagesModel::threadMessageFollowed(const QByteArray &threadMessageId) con
     return false;
 }
 
-QList<Message>::iterator MessagesModel::findMessage(const QByteArray &messageId)
+void MessagesModel::invalidateMessageIndex()
 {
-    return std::find_if(mAllMessages.begin(), mAllMessages.end(), [&](const Message &msg) {
-        return msg.messageId() == messageId;
+    mMessageIndexDirty = true;
+}
+
+qsizetype MessagesModel::messageRow(const QByteArray &messageId) const
+{
+    if (mMessageIndexDirty) {
+        mMessageIndex.clear();
+        mMessageIndex.reserve(mAllMessages.count());
+        for (qsizetype i = 0, total = mAllMessages.count(); i < total; ++i) {
+            mMessageIndex.insert(mAllMessages.at(i).messageId(), i);
+        }
+        mMessageIndexDirty = false;
+    }
+    return mMessageIndex.value(messageId, -1);
+}
+
+void MessagesModel::scheduleDataChanged(const QByteArray &messageId, const QList<int> &roles)
+{
+    auto it = mPendingDataChanged.find(messageId);
+    if (it == mPendingDataChanged.end()) {
+        mPendingDataChanged.insert(messageId, roles);
+    } else if (!it->isEmpty()) {
+        if (roles.isEmpty()) {
+            it->clear();
+        } else {
+            for (int role : roles) {
+                if (!it->contains(role)) {
+                    it->append(role);
+                }
+            }
+        }
+    }
+    if (!mDataChangedTimer->isActive()) {
+        mDataChangedTimer->start();
+    }
+}
+
+void MessagesModel::emitPendingDataChanged()
+{
+    struct PendingRow {
+        qsizetype row;
+        QList<int> roles;
+    };
+    QList<PendingRow> pendingRows;
+    pendingRows.reserve(mPendingDataChanged.count());
+    for (auto it = mPendingDataChanged.begin(), end = mPendingDataChanged.end(); it != end; ++it) {
+        // Message may have been removed in the meantime
+        const qsizetype row = messageRow(it.key());
+        if (row != -1) {
+            std::sort(it->begin(), it->end());
+            pendingRows.append({row, *it});
+        }
+    }
+    mPendingDataChanged.clear();
+    std::sort(pendingRows.begin(), pendingRows.end(), [](const PendingRow &lhs, const PendingRow &rhs) {
+        return lhs.row < rhs.row;
     });
+    // Merge adjacent rows with same roles in one range
+    for (qsizetype i = 0, total = pendingRows.count(); i < total;) {
+        qsizetype last = i;
+        while (last + 1 < total && pendingRows.at(last + 1).row == pendingRows.at(last).row + 1 && pendingRows.at(last + 1).roles == pendingRows.at(i).roles) {
+            ++last;
+        }
+        Q_EMIT dataChanged(createIndex(pendingRows.at(i).row, 0), createIndex(pendingRows.at(last).row, 0), pendingRows.at(i).roles);
+        i = last + 1;
+    }
+}
+
+QList<Message>::iterator MessagesModel::findMessage(const QByteArray &messageId)
+{
+    const qsizetype row = messageRow(messageId);
+    return row == -1 ? mAllMessages.end() : std::next(mAllMessages.begin(), row);
 }
 
 QList<Message>::const_iterator MessagesModel::findMessage(const QByteArray &messageId) const
 {
-    return std::find_if(mAllMessages.cbegin(), mAllMessages.cend(), [&](const Message &msg) {
-        return msg.messageId() == messageId;
-    });
+    const qsizetype row = messageRow(messageId);
+    return row == -1 ? mAllMessages.cend() : std::next(mAllMessages.cbegin(), row);
 }
 
 QByteArray MessagesModel::roomId() const
@@ -687,8 +1172,14 @@ void MessagesModel::clearHistory()
     if (rowCount() != 0) {
         const auto elementSize = (mAllMessages.size() - 50);
         if (elementSize > 0) {
+            clearConvertedTextCache();
             beginResetModel();
+            for (qsizetype i = 0; i < elementSize; ++i) {
+                unindexDownloads(mAllMessages.at(i).messageId());
+            }
+            releaseMessages(0, elementSize);
             mAllMessages.remove(0, elementSize);
+            invalidateMessageIndex();
             endResetModel();
         }
     }
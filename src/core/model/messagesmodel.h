@@ -8,11 +8,17 @@
 
 #pragma once
 
+#include "batchtextconverter.h"
 #include "libruqolacore_export.h"
+#include "lrucache.h"
 #include "messages/message.h"
 #include <QAbstractListModel>
+#include <QHash>
 #include <QPointer>
+#include <QSet>
 
+class QTimer;
+class MessageStore;
 class RocketChatAccount;
 class LoadRecentHistoryManager;
 class Room;
@@ -79,7 +85,8 @@ public:
         MessageReplies,
         Unread,
         PrivateMessage,
-        LastMessageRoles = PrivateMessage,
+        ShowFullMessage,
+        LastMessageRoles = ShowFullMessage,
     };
     Q_ENUM(MessageRoles)
 
@@ -94,7 +101,7 @@ public:
      *
      * @param messages The messages to be added
      */
-    void addMessages(const QList<Message> &messages, bool insertListMessages = false);
+    void addMessages(const QList<Message> &messages);
 
     /**
      * @brief returns number of messages in the model
@@ -143,13 +150,16 @@ public:
     void clearHistory();
 
 private:
-    LIBRUQOLACORE_NO_EXPORT void slotFileDownloaded(const QString &filePath, const QUrl &cacheImageUrl);
+    LIBRUQOLACORE_NO_EXPORT void slotFileDownloaded(const QString &filePath);
+    LIBRUQOLACORE_NO_EXPORT void slotMessageUpdated(const Message &message);
+    LIBRUQOLACORE_NO_EXPORT void releaseMessages(qsizetype first, qsizetype count);
     /**
      * @brief Adds a message to the model
      *
      * @param message The message to be added
      */
     LIBRUQOLACORE_NO_EXPORT void addMessage(const Message &message);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool updateExistingMessage(const Message &message);
 
     LIBRUQOLACORE_NO_EXPORT void refresh();
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool threadMessageFollowed(const QByteArray &threadMessageId) const;
@@ -157,19 +167,81 @@ private:
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString convertMessageText(const Message &message,
                                                                      const QString &userName,
                                                                      const QStringList &highlightWords,
-                                                                     const QString &searchedText) const;
+                                                                     const QString &searchedText,
+                                                                     QByteArray *needUpdateMessageId = nullptr) const;
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString threadMessagePreview(const QByteArray &threadMessageId) const;
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QList<Message>::iterator findMessage(const QByteArray &messageId);
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QList<Message>::const_iterator findMessage(const QByteArray &messageId) const;
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString convertedText(const Message &message, const QString &searchedText) const;
     [[nodiscard]] bool messageReplies(const Message &message) const;
+    LIBRUQOLACORE_NO_EXPORT void convertMessagesInBackground(const QList<Message> &messages);
+    LIBRUQOLACORE_NO_EXPORT void clearConvertedTextCache();
+    // Drops converted text of @p messageId and of the messages quoting it
+    LIBRUQOLACORE_NO_EXPORT void invalidateConvertedText(const QByteArray &messageId);
+    LIBRUQOLACORE_NO_EXPORT void invalidateMessageIndex();
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool isLargeMessage(const Message &message) const;
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString largeMessageText(const Message &message) const;
+    LIBRUQOLACORE_NO_EXPORT void convertPendingLargeMessages();
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT BatchTextConverter::Settings batchTextConverterSettings() const;
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT qsizetype messageRow(const QByteArray &messageId) const;
+    LIBRUQOLACORE_NO_EXPORT void scheduleDataChanged(const QByteArray &messageId, const QList<int> &roles = {});
+    LIBRUQOLACORE_NO_EXPORT void emitPendingDataChanged();
+    LIBRUQOLACORE_NO_EXPORT void indexDownloads(const Message &message);
+    LIBRUQOLACORE_NO_EXPORT void indexPendingDownloads();
+    LIBRUQOLACORE_NO_EXPORT void indexMessageDownloads(const Message &message);
+    LIBRUQOLACORE_NO_EXPORT void unindexDownloads(const QByteArray &messageId);
+    LIBRUQOLACORE_NO_EXPORT void rebuildDownloadIndex();
 
     QString mSearchText;
     QByteArray mRoomId;
     QList<Message> mAllMessages;
     RocketChatAccount *mRocketChatAccount = nullptr;
     QPointer<Room> mRoom;
+    // Shared by the models of the account, can be destroyed before us
+    QPointer<MessageStore> mMessageStore;
     std::unique_ptr<LoadRecentHistoryManager> mLoadRecentHistoryManager;
+    // messageId => converted text (without search highlighting and translation), most recently painted ones
+    mutable LRUCache<QByteArray, QString> mConvertedTextCache;
+    // Incremented when cache is cleared, background conversion results from an older generation are dropped
+    quint64 mConvertedTextCacheGeneration = 0;
+    // Identifies the background conversion of a large message, results of a replaced one are dropped
+    quint64 mLargeMessageConversionId = 0;
+    // messageId => row in mAllMessages, rebuilt on demand after rows changed
+    mutable QHash<QByteArray, qsizetype> mMessageIndex;
+    mutable bool mMessageIndexDirty = true;
+    struct LargeMessageConversion {
+        // Converted text without <qt> tags
+        QString html;
+        bool showFullMessage = false;
+        bool finished = false;
+        // Where conversion continues in message text
+        qsizetype nextPosition = 0;
+        // Fence of the code block in which nextPosition is
+        QString openCodeBlockFence;
+        // Background conversion appending to html, 0 when none is running
+        quint64 conversionId = 0;
+    };
+    // messageId => large message partially converted
+    mutable QHash<QByteArray, LargeMessageConversion> mLargeMessageConversions;
+    // Large messages to convert in background, requested while painting
+    mutable QSet<QByteArray> mPendingLargeMessages;
+    // messageId => changed roles (empty: all roles), emitted as dataChanged ranges once per frame.
+    // Rows are resolved when emitting, so insertions and removals in between don't matter.
+    QHash<QByteArray, QList<int>> mPendingDataChanged;
+    QTimer *const mDataChangedTimer;
+    QTimer *const mLargeMessageTimer;
+    // Downloaded file path (attachment preview, custom emoji of a reaction) => ids of the messages showing it
+    QMultiHash<QString, QByteArray> mDownloadPathIndex;
+    // Avatar identifier => ids of the messages showing it
+    QMultiHash<QString, QByteArray> mAvatarIndex;
+    struct DownloadIndexKeys {
+        QStringList filePaths;
+        QString avatarIdentifier;
+    };
+    // messageId => its keys in the indexes above, to remove them when message is updated or removed
+    QHash<QByteArray, DownloadIndexKeys> mDownloadIndexKeys;
+    // Messages added or updated since the last download, indexed when a download finishes once they were displayed
+    QSet<QByteArray> mMessagesToIndex;
 };
 Q_DECLARE_METATYPE(MessagesModel::AttachmentAndUrlPreviewVisibility)
 Q_DECLARE_TYPEINFO(MessagesModel::AttachmentAndUrlPreviewVisibility, Q_RELOCATABLE_TYPE);
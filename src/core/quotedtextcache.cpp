@@ -0,0 +1,45 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "quotedtextcache.h"
+
+#include <QMutexLocker>
+
+QuotedTextCache::QuotedTextCache()
+{
+    mCache.setMaxEntries(maximumEntries);
+}
+
+QuotedTextCache::~QuotedTextCache() = default;
+
+QuotedTextCache &QuotedTextCache::self()
+{
+    static QuotedTextCache c;
+    return c;
+}
+
+QString QuotedTextCache::quotedText(const QByteArray &key)
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mCache.find(key);
+    if (it != mCache.end()) {
+        return it->value;
+    }
+    return {};
+}
+
+void QuotedTextCache::insert(const QByteArray &key, const QString &html)
+{
+    QMutexLocker locker(&mMutex);
+    mCache.remove(key);
+    mCache.insert(key, html);
+}
+
+void QuotedTextCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mCache.clear();
+}
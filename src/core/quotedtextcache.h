@@ -0,0 +1,37 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include "lrucache.h"
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+/**
+ * Cache of quoted messages rendered by TextConverter (including their own nested quotes).
+ * It can be used from any thread.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT QuotedTextCache
+{
+public:
+    static QuotedTextCache &self();
+
+    QuotedTextCache();
+    ~QuotedTextCache();
+
+    // Returns an empty string when not in cache
+    [[nodiscard]] QString quotedText(const QByteArray &key);
+    void insert(const QByteArray &key, const QString &html);
+    void clear();
+
+    static constexpr int maximumEntries = 256;
+
+private:
+    QMutex mMutex;
+    LRUCache<QByteArray, QString> mCache;
+};
@@ -26,8 +26,10 @@
 #include "commands/listcommandsjob.h"
 #include "customemojiiconmanager.h"
 #include "downloadappslanguages/downloadappslanguagesmanager.h"
+#include "downloadscheduler.h"
 #include "emoticons/emojimanager.h"
 #include "encryption/e2ekeymanager.h"
+#include "loginbootstrap.h"
 #include "managerdatapaths.h"
 #include "messagequeue.h"
 #include "previewurlcachemanager.h"
@@ -80,6 +82,7 @@
 #include "managechannels.h"
 #include "managelocaldatabase.h"
 #include "messagecache.h"
+#include "messages/messagestore.h"
 #include "misc/roleslistjob.h"
 #include "receivetypingnotificationmanager.h"
 #include "ruqola_thread_message_debug.h"
@@ -125,6 +128,7 @@ RocketChatAccount::RocketChatAccount(const QString &accountFileName, QObject *pa
     , mAutoTranslateLanguagesModel(new AutotranslateLanguagesModel(this))
     , mDownloadAppsLanguagesManager(new DownloadAppsLanguagesManager(this))
     , mMessageCache(new MessageCache(this, this))
+    , mMessageStore(new MessageStore(this))
     , mManageChannels(new ManageChannels(this, this))
     , mCustomSoundManager(new CustomSoundsManager(this))
     , mAwayManager(new AwayManager(this, this))
@@ -141,6 +145,7 @@ RocketChatAccount::RocketChatAccount(const QString &accountFileName, QObject *pa
     , mAppsMarketPlaceModel(new AppsMarketPlaceModel(this))
     , mAppsCategoriesModel(new AppsCategoriesModel(this))
     , mMemoryManager(new MemoryManager(this))
+    , mLoginBootstrap(new LoginBootstrap(this))
 {
     qCDebug(RUQOLA_LOG) << " RocketChatAccount::RocketChatAccount(const QString &accountFileName, QObject *parent)" << accountFileName;
     // create an unique file for each account
@@ -250,9 +255,8 @@ RocketChatAccount::RocketChatAccount(const QString &accountFileName, QObject *pa
     connect(&mRolesManager, &RolesManager::rolesChanged, this, &RocketChatAccount::rolesUpdated);
     connect(mCustomSoundManager, &CustomSoundsManager::customSoundRemoved, this, [this](const QByteArray &identifier, const QString &soundFilePath) {
         const QUrl url = soundUrlFromLocalCache(soundFilePath);
-        QFile f(url.toLocalFile());
-        if (!f.remove()) {
-            qCWarning(RUQOLA_SOUND_LOG) << "Impossible to remove " << soundFilePath;
+        if (url.isLocalFile()) {
+            mCache->removeFileFromCache(url.toLocalFile());
         }
         Q_EMIT customSoundRemoved(identifier);
     });
@@ -514,6 +518,11 @@ QString RocketChatAccount::avatarUrl(const Utils::AvatarInfo &info)
     return mCache->avatarUrl(info);
 }
 
+QStringList RocketChatAccount::avatarIdentifiers(const QString &downloadPath) const
+{
+    return mCache->avatarIdentifiers(downloadPath);
+}
+
 void RocketChatAccount::insertAvatarUrl(const QString &userId, const QUrl &url)
 {
     mCache->insertAvatarUrl(userId, url);
@@ -571,6 +580,9 @@ Connection *RocketChatAccount::restApi()
 
         mRestApi->setServerUrl(mSettings->serverUrl());
         mRestApi->setRestApiLogger(mRuqolaLogger);
+        if (!accountName().isEmpty()) {
+            mRestApi->setResponseCacheDirectory(ManagerDataPaths::self()->path(ManagerDataPaths::RestApiCache, accountName()));
+        }
         mCache->setRestApiConnection(mRestApi.get());
     }
     return mRestApi.get();
@@ -903,7 +915,7 @@ void RocketChatAccount::joinRoom(const QString &roomId, const QString &joinCode)
     mManageChannels->channelJoin(info, joinCode);
 }
 
-void RocketChatAccount::listEmojiCustom()
+RocketChatRestApi::RestApiAbstractJob *RocketChatAccount::listEmojiCustom()
 {
     auto job = new RocketChatRestApi::LoadEmojiCustomJob(this);
     restApi()->initializeRestApiJob(job);
@@ -911,6 +923,7 @@ void RocketChatAccount::listEmojiCustom()
     if (!job->start()) {
         qCWarning(RUQOLA_LOG) << "Impossible to start listEmojiCustom job";
     }
+    return job;
 }
 
 void RocketChatAccount::setDefaultStatus(User::PresenceStatus status, const QString &messageStatus)
@@ -1748,6 +1761,34 @@ QUrl RocketChatAccount::attachmentUrlFromLocalCache(const QString &url)
     return mCache->attachmentUrlFromLocalCache(url);
 }
 
+QUrl RocketChatAccount::requestedAttachmentUrlFromLocalCache(const QString &url)
+{
+    return mCache->requestedAttachmentUrlFromLocalCache(url);
+}
+
+QUrl RocketChatAccount::emojiUrlFromLocalCache(const QString &url)
+{
+    return mCache->emojiUrlFromLocalCache(url);
+}
+
+void RocketChatAccount::setDownloadRequester(const QObject *requester)
+{
+    if (!mRestApi) {
+        return;
+    }
+    mRestApi->downloadScheduler()->setCurrentRequester(requester);
+}
+
+void RocketChatAccount::cancelPendingMessageDownloads(const QObject *requester)
+{
+    if (!mRestApi) {
+        return;
+    }
+    DownloadScheduler *scheduler = mRestApi->downloadScheduler();
+    scheduler->cancelPending(requester, DownloadScheduler::Priority::Attachment);
+    scheduler->cancelPending(requester, DownloadScheduler::Priority::Preview);
+}
+
 bool RocketChatAccount::attachmentIsInLocalCache(const QString &url)
 {
     return mCache->attachmentIsInLocalCache(url);
@@ -2306,25 +2347,53 @@ void RocketChatAccount::autoReconnectDelayed()
 
 void RocketChatAccount::initializeAccount()
 {
-    listEmojiCustom();
-
-    // load when necessary
-    restApi()->usersPresence();
+    // Rooms are displayed now: what is needed to display messages first, the rest after
+    mLoginBootstrap->clear();
+    mLoginBootstrap->addTask(u"emojiCustom"_s, LoginBootstrap::Stage::Critical, [this]() {
+        return listEmojiCustom();
+    });
+    mLoginBootstrap->addTask(u"usersPresence"_s, LoginBootstrap::Stage::Critical, [this]() {
+        // load when necessary
+        restApi()->usersPresence();
+        return nullptr;
+    });
+    qDebug() << "initializeAccount: encryptionEnabled =" << mRuqolaServerConfig->encryptionEnabled() << "account name" << accountName();
+    if (mRuqolaServerConfig->encryptionEnabled()) {
+        // Encrypted messages of the opened room can't be displayed without them
+        mLoginBootstrap->addTask(u"e2eKeys"_s, LoginBootstrap::Stage::Critical, [this]() {
+            return mE2eKeyManager->fetchMyKeys();
+        });
+    }
     // Force set online.
     // TODO don't reset message status !
     if (RuqolaGlobalConfig::self()->setOnlineAccounts()) {
         ddp()->setDefaultStatus(User::PresenceStatus::Online);
     }
-    // Initialize sounds
-    mCustomSoundManager->initializeDefaultSounds();
-    ddp()->listCustomSounds();
-    restApi()->customUserStatus();
-    slotLoadRoles();
-    checkLicenses();
-    qDebug() << "initializeAccount: encryptionEnabled =" << mRuqolaServerConfig->encryptionEnabled() << "account name" << accountName();
-    if (mRuqolaServerConfig->encryptionEnabled()) {
-        mE2eKeyManager->fetchMyKeys();
-    }
+    mLoginBootstrap->addTask(u"customSounds"_s, LoginBootstrap::Stage::Deferred, [this]() {
+        // Initialize sounds
+        mCustomSoundManager->initializeDefaultSounds();
+        ddp()->listCustomSounds();
+        return nullptr;
+    });
+    mLoginBootstrap->addTask(u"customUserStatus"_s, LoginBootstrap::Stage::Deferred, [this]() {
+        restApi()->customUserStatus();
+        return nullptr;
+    });
+    mLoginBootstrap->addTask(u"roles"_s, LoginBootstrap::Stage::Deferred, [this]() {
+        return slotLoadRoles();
+    });
+    mLoginBootstrap->addTask(u"licenses"_s, LoginBootstrap::Stage::Deferred, [this]() {
+        return checkLicenses();
+    });
+    // Modules are only listed by enterprise servers, known when licenses are loaded
+    mLoginBootstrap->addTask(
+        u"licenseModules"_s,
+        LoginBootstrap::Stage::Deferred,
+        [this]() {
+            return mRuqolaServerConfig->hasEnterpriseSupport() ? licenseGetModules() : nullptr;
+        },
+        {u"licenses"_s});
+    mLoginBootstrap->start();
 
     Q_EMIT accountInitialized();
 }
@@ -2334,7 +2403,7 @@ bool RocketChatAccount::hasAtLeastVersion(int major, int minor, int patch) const
     return ruqolaServerConfig()->hasAtLeastVersion(major, minor, patch);
 }
 
-void RocketChatAccount::checkLicenses()
+RocketChatRestApi::RestApiAbstractJob *RocketChatAccount::checkLicenses()
 {
     auto job = new RocketChatRestApi::LicensesInfoJob(this);
     restApi()->initializeRestApiJob(job);
@@ -2343,17 +2412,15 @@ void RocketChatAccount::checkLicenses()
         if (!license.isEmpty()) {
             const bool isEnterprise = !license["activeModules"_L1].toArray().isEmpty();
             mRuqolaServerConfig->setHasEnterpriseSupport(isEnterprise);
-            if (isEnterprise) {
-                licenseGetModules();
-            }
         }
     });
     if (!job->start()) {
         qCWarning(RUQOLA_LOG) << "Impossible to start LicensesInfoJob job";
     }
+    return job;
 }
 
-void RocketChatAccount::licenseGetModules()
+RocketChatRestApi::RestApiAbstractJob *RocketChatAccount::licenseGetModules()
 {
     auto job = new RocketChatRestApi::LicensesInfoJob(this);
     restApi()->initializeRestApiJob(job);
@@ -2363,6 +2430,7 @@ void RocketChatAccount::licenseGetModules()
     if (!job->start()) {
         qCWarning(RUQOLA_LOG) << "Impossible to start LicensesInfoJob job";
     }
+    return job;
 }
 
 NotificationPreferences *RocketChatAccount::notificationPreferences() const
@@ -2446,6 +2514,8 @@ void RocketChatAccount::slotRESTLoginStatusChanged()
     } else if (loginStatus == AuthenticationManager::LoggedIn) {
         // Reset it.
         mDelayReconnect = 100;
+        // Downloads which failed while network was down
+        mRestApi->downloadScheduler()->clearFailedUrls();
     } else if (loginStatus == AuthenticationManager::GenericError) {
         // Clear authToken it can be changed
         // If we don't clear it ruqola will want to login with resume method => it will failed all the time.
@@ -2497,6 +2567,9 @@ void RocketChatAccount::slotLoginStatusChanged() // only used in DDP-only mode (
     if (loginStatus() == AuthenticationManager::LoggedIn) {
         // Reset it.
         mDelayReconnect = 100;
+        if (mRestApi) {
+            mRestApi->downloadScheduler()->clearFailedUrls();
+        }
         qCDebug(RUQOLA_RECONNECT_LOG) << "Successfully logged in!";
     } else if (loginStatus() == AuthenticationManager::LoginFailedInvalidUserOrPassword) {
         // clear auth token to refresh it with the next login
@@ -2517,7 +2590,11 @@ void RocketChatAccount::slotRegisterUserDone()
 
 void RocketChatAccount::parseOwnInfoDone(const QJsonObject &replyObject)
 {
+    const QStringList previousHighlightWords = highlightWords();
     mOwnUser.parseOwnUserInfo(replyObject);
+    if (highlightWords() != previousHighlightWords) {
+        Q_EMIT highlightWordsChanged();
+    }
     mAwayManager->updateSettings();
     mBannerInfos.parseBannerInfos(replyObject);
     const User user = mOwnUser.user();
@@ -2612,6 +2689,7 @@ void RocketChatAccount::updateUserData(const QJsonArray &contents)
                 const QJsonArray highlightsArray = updateJson.value(key).toArray();
                 ownUserPreferences.updateHighlightWords(highlightsArray);
                 mOwnUser.setOwnUserPreferences(ownUserPreferences);
+                Q_EMIT highlightWordsChanged();
                 Q_EMIT needUpdateMessageView();
             } else if (key == "settings.preferences.enableAutoAway"_L1) {
                 ownUserPreferences.setEnableAutoAway(updateJson.value(key).toBool());
@@ -2849,6 +2927,11 @@ MessageCache *RocketChatAccount::messageCache() const
     return mMessageCache;
 }
 
+MessageStore *RocketChatAccount::messageStore() const
+{
+    return mMessageStore;
+}
+
 void RocketChatAccount::slotUpdateCustomUserStatus()
 {
     mStatusModel->updateCustomStatus(mCustomUserStatuses.customUserses());
@@ -2865,7 +2948,7 @@ bool RocketChatAccount::displayAvatars() const
     return mOwnUser.ownUserPreferences().displayAvatars();
 }
 
-void RocketChatAccount::slotLoadRoles()
+RocketChatRestApi::RestApiAbstractJob *RocketChatAccount::slotLoadRoles()
 {
     // First load list of roles.
     auto job = new RocketChatRestApi::RolesListJob(this);
@@ -2874,6 +2957,7 @@ void RocketChatAccount::slotLoadRoles()
     if (!job->start()) {
         qCWarning(RUQOLA_LOG) << "Impossible to start RolesListJob job";
     }
+    return job;
 }
 
 CustomSoundsManager *RocketChatAccount::customSoundManager() const
@@ -64,6 +64,7 @@ class CommandsModel;
 class DownloadAppsLanguagesManager;
 class UsersForRoomModel;
 class MessageCache;
+class MessageStore;
 class ManageChannels;
 class CustomSoundsManager;
 class AwayManager;
@@ -83,6 +84,7 @@ class SoundManager;
 class AppsMarketPlaceModel;
 class AppsCategoriesModel;
 class MemoryManager;
+class LoginBootstrap;
 class ServerConfigInfo;
 
 class LIBRUQOLACORE_EXPORT RocketChatAccount : public QObject
@@ -163,7 +165,16 @@ public:
     void changeNotificationsSettings(const QByteArray &QByteArray, RocketChatAccount::NotificationOptionsType notificationsType, const QVariant &newValue);
     void downloadFile(const QString &downloadFileUrl, const QUrl &localFile);
     [[nodiscard]] QString avatarUrl(const Utils::AvatarInfo &info);
+    // Identifiers of the avatars downloaded from this url path (see fileDownloaded())
+    [[nodiscard]] QStringList avatarIdentifiers(const QString &downloadPath) const;
     [[nodiscard]] QUrl attachmentUrlFromLocalCache(const QString &url);
+    // Requested by the user (save as, show image): downloaded first and never cancelled
+    [[nodiscard]] QUrl requestedAttachmentUrlFromLocalCache(const QString &url);
+    [[nodiscard]] QUrl emojiUrlFromLocalCache(const QString &url);
+    // Files requested while it's set are displayed by requester
+    void setDownloadRequester(const QObject *requester);
+    // Drops the attachments and url previews which requester is waiting for, it requests again the ones it still shows
+    void cancelPendingMessageDownloads(const QObject *requester);
     void loadHistory(const QByteArray &roomID, bool initial = false, qint64 timeStamp = 0);
 
     void roomFiles(const QByteArray &roomId, Room::RoomType channelType = Room::RoomType::Unknown);
@@ -303,6 +314,7 @@ public:
 
     void deleteUser(const QJsonArray &replyArray);
     MessageCache *messageCache() const;
+    [[nodiscard]] MessageStore *messageStore() const;
 
     [[nodiscard]] bool hideRoles() const;
     [[nodiscard]] bool displayAvatars() const;
@@ -472,6 +484,7 @@ Q_SIGNALS:
                                  ParseRocketChatUrlUtils::ChannelType channelType);
 
     void needUpdateMessageView();
+    void highlightWordsChanged();
     void publicSettingLoaded(const QJsonObject &obj);
     void bannerInfoChanged();
     void privateSettingsChanged();
@@ -527,7 +540,7 @@ private:
     LIBRUQOLACORE_NO_EXPORT void forceDisconnect();
     LIBRUQOLACORE_NO_EXPORT void logoutCompleted();
     LIBRUQOLACORE_NO_EXPORT void getSupportedLanguages();
-    LIBRUQOLACORE_NO_EXPORT void listEmojiCustom();
+    LIBRUQOLACORE_NO_EXPORT RocketChatRestApi::RestApiAbstractJob *listEmojiCustom();
 
     LIBRUQOLACORE_NO_EXPORT void checkInitializedRoom(const QByteArray &roomId);
     LIBRUQOLACORE_NO_EXPORT void clearTypingNotification();
@@ -548,12 +561,12 @@ private:
     LIBRUQOLACORE_NO_EXPORT void slotUsersSetPreferencesDone(const QJsonObject &replyObject);
     LIBRUQOLACORE_NO_EXPORT void slotUpdateCustomUserStatus();
     LIBRUQOLACORE_NO_EXPORT void updateCustomEmojiList(bool fetchListCustom);
-    LIBRUQOLACORE_NO_EXPORT void slotLoadRoles();
+    LIBRUQOLACORE_NO_EXPORT RocketChatRestApi::RestApiAbstractJob *slotLoadRoles();
     LIBRUQOLACORE_NO_EXPORT void slotAwayStatusChanged(bool away);
     LIBRUQOLACORE_NO_EXPORT void slotJobFailed(const QString &str);
-    LIBRUQOLACORE_NO_EXPORT void checkLicenses();
+    LIBRUQOLACORE_NO_EXPORT RocketChatRestApi::RestApiAbstractJob *checkLicenses();
     LIBRUQOLACORE_NO_EXPORT void parsePublicSettings();
-    LIBRUQOLACORE_NO_EXPORT void licenseGetModules();
+    LIBRUQOLACORE_NO_EXPORT RocketChatRestApi::RestApiAbstractJob *licenseGetModules();
     LIBRUQOLACORE_NO_EXPORT void loadSoundFiles();
     LIBRUQOLACORE_NO_EXPORT void slotReconnectToDdpServer();
     LIBRUQOLACORE_NO_EXPORT void slotVerifyKeysDone();
@@ -633,6 +646,7 @@ private:
     User::PresenceStatus mPresenceStatus = User::PresenceStatus::Unknown;
     DownloadAppsLanguagesManager *const mDownloadAppsLanguagesManager;
     MessageCache *const mMessageCache;
+    MessageStore *const mMessageStore;
     ManageChannels *const mManageChannels;
     CustomSoundsManager *const mCustomSoundManager;
     AwayManager *const mAwayManager;
@@ -656,6 +670,7 @@ private:
     AppsMarketPlaceModel *const mAppsMarketPlaceModel;
     AppsCategoriesModel *const mAppsCategoriesModel;
     MemoryManager *const mMemoryManager;
+    LoginBootstrap *const mLoginBootstrap;
     int mDelayReconnect = 100;
     bool mMarkUnreadThreadsAsReadOnNextReply = false;
     bool mE2EPasswordMustBeSave = false;
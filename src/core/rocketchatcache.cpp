@@ -10,30 +10,137 @@
 #include "rocketchataccount.h"
 #include "rocketchataccountsettings.h"
 #include "ruqola_debug.h"
+#include "ruqolaglobalconfig.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QPointer>
 #include <QSettings>
 #include <QStandardPaths>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrlQuery>
 
+#include <algorithm>
+
 using namespace std::chrono_literals;
 using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+// Urls seen in a session, paths are computed again when it's full
+constexpr qsizetype maximumCachedFilePaths = 20000;
+constexpr std::array<ManagerDataPaths::PathType, 3> indexedPathTypes{ManagerDataPaths::Cache, ManagerDataPaths::PreviewUrl, ManagerDataPaths::CustomSound};
+// Access time is saved with this precision, files are looked up when painting
+constexpr qint64 accessTimeResolution = 60;
+// Files removed by each background task
+constexpr int evictionBatchSize = 200;
+// Files unused for a year are removed even when the cache is not full
+constexpr qint64 maximumUnusedTime = 365 * 24 * 3600;
+// Partial downloads not resumed for a week are removed
+constexpr qint64 maximumPartialDownloadAge = 7 * 24 * 3600;
+
+// See DownloadFileJob::partialFilePath()
+bool isPartialDownload(const QString &filePath)
+{
+    return filePath.endsWith(".part"_L1) || filePath.endsWith(".part.validator"_L1);
+}
+
+// Index database is only used from this thread
+QThreadPool *cacheThreadPool()
+{
+    static QThreadPool *s_threadPool = []() {
+        auto pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(1);
+        pool->setExpiryTimeout(-1);
+        return pool;
+    }();
+    return s_threadPool;
+}
+
+QStringList indexedDirectories(const QString &accountName)
+{
+    QStringList directories;
+    for (const auto type : indexedPathTypes) {
+        directories.append(QDir::cleanPath(ManagerDataPaths::self()->path(type, accountName)));
+    }
+    return directories;
+}
+
+// Blobs are spread in subdirectories, there are thousands of them
+QString cacheBlobPath(const QString &blobsPath, const QString &blobName)
+{
+    return blobsPath + QLatin1Char('/') + blobName.left(2) + QLatin1Char('/') + blobName;
+}
+
+// Runs in cache thread: moves a downloaded file to the blob named after its content.
+// Returns the blob name, or an empty string when the file stays where it was downloaded
+QString storeCacheBlob(const QString &accountName, const QString &blobsPath, const QString &filePath, qint64 &blobSize)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to open" << filePath;
+        return {};
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to read" << filePath;
+        return {};
+    }
+    file.close();
+    QString blobName = QString::fromLatin1(hash.result().toHex());
+    const QString suffix = QFileInfo(filePath).suffix();
+    if (!suffix.isEmpty()) {
+        // Files are opened by external applications too
+        blobName += QLatin1Char('.') + suffix;
+    }
+    const QString blobPath = cacheBlobPath(blobsPath, blobName);
+    if (QFileInfo::exists(blobPath)) {
+        // Same content was downloaded from another url
+        if (!file.remove()) {
+            qCWarning(RUQOLA_LOG) << "Impossible to remove" << filePath;
+        }
+    } else if (!QDir().mkpath(QFileInfo(blobPath).absolutePath()) || !file.rename(blobPath)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to move" << filePath << "to" << blobPath;
+        return {};
+    }
+    // Only removed when it's empty
+    QDir().rmdir(QFileInfo(filePath).absolutePath());
+
+    LocalCacheIndexDatabase::CacheFileInfo info;
+    info.size = QFileInfo(blobPath).size();
+    info.lastAccess = QDateTime::currentSecsSinceEpoch();
+    blobSize = info.size;
+    // Saved now so that the blob isn't evicted before next maintenance
+    LocalCacheIndexDatabase().updateCacheFiles(accountName, {{blobPath, info}});
+    LocalCacheBlobsDatabase().updateCacheBlobs(accountName, {{filePath, blobName}});
+    return blobName;
+}
+}
+
 RocketChatCache::RocketChatCache(RocketChatAccount *account, QObject *parent)
     : QObject(parent)
+    , mMaximumCacheSize(RuqolaGlobalConfig::self()->maximumCacheSize() * 1024LL * 1024LL)
+    , mBlobsPath(QDir::cleanPath(ManagerDataPaths::self()->path(ManagerDataPaths::Cache, account->accountName()) + "/blobs"_L1))
+    , mIndexedDirectories(indexedDirectories(account->accountName()))
+    , mDeduplicateFiles(RuqolaGlobalConfig::self()->deduplicateCachedFiles())
     , mAccount(account)
     , mAvatarManager(new AvatarManager(mAccount, this))
+    , mCacheMaintenanceTimer(new QTimer(this))
     , mAccountServerHost(Utils::generateServerUrl(account->serverUrl()).host())
 {
     connect(mAvatarManager, &AvatarManager::insertAvatarUrl, this, &RocketChatCache::insertAvatarUrl);
+    connect(this, &RocketChatCache::fileDownloaded, this, &RocketChatCache::copyDownloadedFile);
     loadAvatarCache();
 
-    auto cleanupTimer = new QTimer(this);
-    cleanupTimer->setInterval(1h);
-    connect(cleanupTimer, &QTimer::timeout, this, &RocketChatCache::cleanupCache);
+    mCacheMaintenanceTimer->setSingleShot(true);
+    mCacheMaintenanceTimer->setInterval(1min);
+    connect(mCacheMaintenanceTimer, &QTimer::timeout, this, &RocketChatCache::runCacheMaintenance);
 
     handleMigration();
+    loadCacheIndex();
 }
 
 RocketChatCache::~RocketChatCache()
@@ -49,6 +156,120 @@ RocketChatCache::~RocketChatCache()
         ++i;
     }
     settings.endGroup();
+
+    // Save access times, eviction waits for next start
+    if (mCacheIndexLoaded && QCoreApplication::instance() && (!mAccessedFiles.isEmpty() || !mRemovedFiles.isEmpty() || !mRemovedBlobPaths.isEmpty())) {
+        LocalCacheIndexDatabase::CacheFiles accessedFiles;
+        for (const QString &path : std::as_const(mAccessedFiles)) {
+            accessedFiles.insert(path, mCachedFiles.value(path));
+        }
+        cacheThreadPool()->start(
+            [accountName = mAccount->accountName(),
+             directories = mIndexedDirectories,
+             accessedFiles,
+             removedFiles = mRemovedFiles,
+             removedBlobPaths = mRemovedBlobPaths]() {
+                LocalCacheBlobsDatabase().removeCacheBlobs(accountName, removedBlobPaths);
+                (void)evictCacheFiles(accountName, directories, accessedFiles, removedFiles, 0, 0);
+            });
+    }
+}
+
+bool RocketChatCache::isIndexedPath(const QString &filePath, const QStringList &directories)
+{
+    // Partial downloads are indexed once they are complete, synchronizeCacheIndex() removes the abandoned ones
+    if (isPartialDownload(filePath)) {
+        return false;
+    }
+    return std::any_of(directories.cbegin(), directories.cend(), [&filePath](const QString &directory) {
+        return filePath.startsWith(directory + QLatin1Char('/'));
+    });
+}
+
+// Lists files, with access time from the index database
+LocalCacheIndexDatabase::CacheFiles RocketChatCache::synchronizeCacheIndex(const QString &accountName, const QStringList &directories)
+{
+    LocalCacheIndexDatabase database;
+    const LocalCacheIndexDatabase::CacheFiles indexedFiles = database.cacheFiles(accountName);
+    LocalCacheIndexDatabase::CacheFiles files;
+    LocalCacheIndexDatabase::CacheFiles newFiles;
+    const qint64 partialDownloadExpiryTime = QDateTime::currentSecsSinceEpoch() - maximumPartialDownloadAge;
+    for (const QString &directory : directories) {
+        QDirIterator it(directory, {}, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString path = it.next();
+            const QFileInfo fileInfo = it.fileInfo();
+            if (isPartialDownload(path)) {
+                // Download was abandoned (cancelled, failed, file not displayed anymore): it won't be resumed
+                if (fileInfo.lastModified().toSecsSinceEpoch() < partialDownloadExpiryTime && !QFile::remove(path)) {
+                    qCWarning(RUQOLA_LOG) << "Impossible to remove" << path;
+                }
+                continue;
+            }
+            if (!isIndexedPath(path, directories)) {
+                continue;
+            }
+            LocalCacheIndexDatabase::CacheFileInfo info;
+            info.size = fileInfo.size();
+            const auto indexedFile = indexedFiles.constFind(path);
+            if (indexedFile != indexedFiles.cend()) {
+                info.lastAccess = indexedFile->lastAccess;
+            } else {
+                info.lastAccess = fileInfo.lastModified().toSecsSinceEpoch();
+            }
+            if (indexedFile == indexedFiles.cend() || indexedFile->size != info.size) {
+                newFiles.insert(path, info);
+            }
+            files.insert(path, info);
+        }
+    }
+    // Removed outside of ruqola
+    QStringList removedFiles;
+    for (auto it = indexedFiles.cbegin(), end = indexedFiles.cend(); it != end; ++it) {
+        if (!files.contains(it.key())) {
+            removedFiles.append(it.key());
+        }
+    }
+    database.updateCacheFiles(accountName, newFiles);
+    database.removeCacheFiles(accountName, removedFiles);
+    return files;
+}
+
+// Saves changes then removes least recently used files
+QStringList RocketChatCache::evictCacheFiles(const QString &accountName,
+                                             const QStringList &directories,
+                                             const LocalCacheIndexDatabase::CacheFiles &accessedFiles,
+                                             const QStringList &removedFiles,
+                                             qint64 bytesToFree,
+                                             qint64 expiryTime)
+{
+    LocalCacheIndexDatabase database;
+    database.updateCacheFiles(accountName, accessedFiles);
+    database.removeCacheFiles(accountName, removedFiles);
+    QStringList evictedFiles;
+    qint64 freedBytes = 0;
+    const auto leastRecentlyUsedFiles = database.leastRecentlyUsedCacheFiles(accountName, evictionBatchSize);
+    for (const auto &[path, info] : leastRecentlyUsedFiles) {
+        if (freedBytes >= bytesToFree && info.lastAccess >= expiryTime) {
+            break;
+        }
+        if (!isIndexedPath(path, directories)) {
+            // Indexed by mistake (files saved by the user), forgotten but never removed
+            freedBytes += info.size;
+            evictedFiles.append(path);
+            continue;
+        }
+        if (QFileInfo::exists(path) && !QFile::remove(path)) {
+            qCWarning(RUQOLA_LOG) << "Impossible to remove" << path;
+            continue;
+        }
+        // Only removed when it's empty
+        QDir().rmdir(QFileInfo(path).absolutePath());
+        freedBytes += info.size;
+        evictedFiles.append(path);
+    }
+    database.removeCacheFiles(accountName, evictedFiles);
+    return evictedFiles;
 }
 
 void RocketChatCache::setRestApiConnection(Connection *restApi)
@@ -58,8 +279,268 @@ void RocketChatCache::setRestApiConnection(Connection *restApi)
 
 bool RocketChatCache::fileInCache(const QUrl &url)
 {
-    const QFileInfo f(fileCachePath(url));
-    return f.exists();
+    return isCached(localFilePath(url.toString()));
+}
+
+void RocketChatCache::loadCacheIndex()
+{
+    const QString accountName = mAccount->accountName();
+    if (accountName.isEmpty()) {
+        return;
+    }
+    const QPointer<RocketChatCache> guard(this);
+    cacheThreadPool()->start([accountName, directories = mIndexedDirectories, deduplicateFiles = mDeduplicateFiles, guard]() {
+        LocalCacheIndexDatabase::CacheFiles files = synchronizeCacheIndex(accountName, directories);
+        LocalCacheBlobsDatabase::CacheBlobs blobs;
+        if (deduplicateFiles) {
+            blobs = LocalCacheBlobsDatabase().cacheBlobs(accountName);
+        }
+        // guard is only dereferenced in main thread
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, files = std::move(files), blobs = std::move(blobs)]() mutable {
+                if (guard) {
+                    guard->setCacheIndex(std::move(files), std::move(blobs));
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void RocketChatCache::setCacheIndex(LocalCacheIndexDatabase::CacheFiles &&files, LocalCacheBlobsDatabase::CacheBlobs &&blobs)
+{
+    // Keep files found or downloaded while the directories were listed
+    files.insert(mCachedFiles);
+    mCachedFiles = std::move(files);
+    blobs.insert(mCacheBlobs);
+    mCacheBlobs = std::move(blobs);
+    mCacheSize = 0;
+    for (const auto &info : std::as_const(mCachedFiles)) {
+        mCacheSize += info.size;
+    }
+    mCacheIndexLoaded = true;
+    qCDebug(RUQOLA_LOG) << "Cache of" << mAccount->accountName() << "uses" << mCacheSize << "bytes in" << mCachedFiles.count() << "files";
+    scheduleCacheMaintenance();
+}
+
+void RocketChatCache::addToCacheIndex(const QString &filePath, qint64 size)
+{
+    if (!isIndexedPath(filePath, mIndexedDirectories)) {
+        // Saved somewhere else by the user, not managed by the cache
+        return;
+    }
+    LocalCacheIndexDatabase::CacheFileInfo &info = mCachedFiles[filePath];
+    mCacheSize += size - info.size;
+    info.size = size;
+    info.lastAccess = QDateTime::currentSecsSinceEpoch();
+    mAccessedFiles.insert(filePath);
+    if (mCacheSize > mMaximumCacheSize) {
+        scheduleCacheMaintenance();
+    }
+}
+
+void RocketChatCache::removeFromCacheIndex(const QString &filePath)
+{
+    const auto it = mCachedFiles.constFind(filePath);
+    if (it == mCachedFiles.cend()) {
+        return;
+    }
+    mCacheSize -= it->size;
+    mCachedFiles.erase(it);
+    mAccessedFiles.remove(filePath);
+    mRemovedFiles.append(filePath);
+}
+
+bool RocketChatCache::isCached(const QString &filePath)
+{
+    auto it = mCachedFiles.find(filePath);
+    if (it != mCachedFiles.end()) {
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        if (now - it->lastAccess >= accessTimeResolution) {
+            it->lastAccess = now;
+            mAccessedFiles.insert(filePath);
+            scheduleCacheMaintenance();
+        }
+        return true;
+    }
+    if (mCacheIndexLoaded) {
+        return false;
+    }
+    // Index is not loaded yet
+    const QFileInfo fileInfo(filePath);
+    if (fileInfo.exists()) {
+        addToCacheIndex(filePath, fileInfo.size());
+        return true;
+    }
+    return false;
+}
+
+bool RocketChatCache::cacheIndexLoaded() const
+{
+    return mCacheIndexLoaded;
+}
+
+void RocketChatCache::scheduleCacheMaintenance()
+{
+    if (!mCacheMaintenanceTimer->isActive()) {
+        mCacheMaintenanceTimer->start();
+    }
+}
+
+void RocketChatCache::runCacheMaintenance()
+{
+    if (!mCacheIndexLoaded || mCacheMaintenanceRunning) {
+        // Scheduled again when it's loaded or done
+        return;
+    }
+    LocalCacheIndexDatabase::CacheFiles accessedFiles;
+    for (const QString &path : std::as_const(mAccessedFiles)) {
+        accessedFiles.insert(path, mCachedFiles.value(path));
+    }
+    mAccessedFiles.clear();
+    const QStringList removedFiles = std::exchange(mRemovedFiles, {});
+    const QStringList removedBlobPaths = std::exchange(mRemovedBlobPaths, {});
+    const qint64 bytesToFree = mCacheSize - mMaximumCacheSize;
+    const qint64 expiryTime = QDateTime::currentSecsSinceEpoch() - maximumUnusedTime;
+    mCacheMaintenanceRunning = true;
+    const QPointer<RocketChatCache> guard(this);
+    cacheThreadPool()->start([accountName = mAccount->accountName(),
+                              directories = mIndexedDirectories,
+                              accessedFiles,
+                              removedFiles,
+                              removedBlobPaths,
+                              bytesToFree,
+                              expiryTime,
+                              guard]() {
+        LocalCacheBlobsDatabase().removeCacheBlobs(accountName, removedBlobPaths);
+        const QStringList evictedFiles = evictCacheFiles(accountName, directories, accessedFiles, removedFiles, bytesToFree, expiryTime);
+        const bool evictionFinished = evictedFiles.count() < evictionBatchSize;
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, evictedFiles, evictionFinished]() {
+                if (guard) {
+                    guard->slotCacheFilesEvicted(evictedFiles, evictionFinished);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void RocketChatCache::slotCacheFilesEvicted(const QStringList &filePaths, bool evictionFinished)
+{
+    mCacheMaintenanceRunning = false;
+    QSet<QString> evictedBlobs;
+    for (const QString &path : filePaths) {
+        // Already removed from database
+        const auto it = mCachedFiles.constFind(path);
+        if (it != mCachedFiles.cend()) {
+            mCacheSize -= it->size;
+            mCachedFiles.erase(it);
+            mAccessedFiles.remove(path);
+        }
+        if (path.startsWith(mBlobsPath + QLatin1Char('/'))) {
+            evictedBlobs.insert(QFileInfo(path).fileName());
+        }
+    }
+    if (!evictedBlobs.isEmpty()) {
+        // Urls of the removed contents are downloaded again when needed
+        for (auto it = mCacheBlobs.begin(); it != mCacheBlobs.end();) {
+            if (evictedBlobs.contains(it.value())) {
+                mRemovedBlobPaths.append(it.key());
+                it = mCacheBlobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!filePaths.isEmpty()) {
+        qCDebug(RUQOLA_LOG) << "Removed" << filePaths.count() << "files from cache, it uses" << mCacheSize << "bytes";
+    }
+    if (!evictionFinished && mCacheSize > mMaximumCacheSize) {
+        // Next batch
+        runCacheMaintenance();
+    } else if (!mAccessedFiles.isEmpty() || !mRemovedFiles.isEmpty() || !mRemovedBlobPaths.isEmpty()) {
+        scheduleCacheMaintenance();
+    }
+}
+
+qint64 RocketChatCache::maximumCacheSize() const
+{
+    return mMaximumCacheSize;
+}
+
+void RocketChatCache::setMaximumCacheSize(qint64 size)
+{
+    mMaximumCacheSize = size;
+    if (mCacheSize > mMaximumCacheSize) {
+        scheduleCacheMaintenance();
+    }
+}
+
+qint64 RocketChatCache::cacheSize() const
+{
+    return mCacheSize;
+}
+
+bool RocketChatCache::deduplicateFiles() const
+{
+    return mDeduplicateFiles;
+}
+
+void RocketChatCache::setDeduplicateFiles(bool deduplicate)
+{
+    // Blobs already stored are still used
+    mDeduplicateFiles = deduplicate;
+}
+
+QString RocketChatCache::cachedFilePath(const QString &url, ManagerDataPaths::PathType type)
+{
+    QHash<QString, QString> &filePaths = mCachedFilePaths[type];
+    auto it = filePaths.constFind(url);
+    if (it != filePaths.cend()) {
+        return it.value();
+    }
+    if (filePaths.size() >= maximumCachedFilePaths) {
+        filePaths.clear();
+    }
+    const QString path = fileCachePath(QUrl(url), type);
+    filePaths.insert(url, path);
+    return path;
+}
+
+QString RocketChatCache::localFilePath(const QString &url, ManagerDataPaths::PathType type)
+{
+    const QString path = cachedFilePath(url, type);
+    if (type == ManagerDataPaths::Cache && !mCacheBlobs.isEmpty()) {
+        const auto it = mCacheBlobs.constFind(path);
+        if (it != mCacheBlobs.cend()) {
+            return blobFilePath(it.value());
+        }
+    }
+    return path;
+}
+
+QString RocketChatCache::blobFilePath(const QString &blobName) const
+{
+    return cacheBlobPath(mBlobsPath, blobName);
+}
+
+void RocketChatCache::removeBlobPath(const QString &filePath)
+{
+    // Blob itself can be used by other urls, it's evicted when unused
+    if (mCacheBlobs.remove(filePath)) {
+        mRemovedBlobPaths.append(filePath);
+        scheduleCacheMaintenance();
+    }
+}
+
+void RocketChatCache::removeFileFromCache(const QString &filePath)
+{
+    const QString path = QDir::cleanPath(filePath);
+    removeFromCacheIndex(path);
+    if (QFileInfo::exists(path) && !QFile::remove(path)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to remove" << path;
+    }
 }
 
 QString RocketChatCache::fileCachePath(const QUrl &url, ManagerDataPaths::PathType type)
@@ -78,56 +559,90 @@ QString RocketChatCache::fileCachePath(const QUrl &url, ManagerDataPaths::PathTy
         const QUrlQuery query(url);
         cachePath += query.queryItemValue(QStringLiteral("etag"));
     }
-    return cachePath;
+    // Same path as the cache index
+    return QDir::cleanPath(cachePath);
 }
 
 void RocketChatCache::slotDataDownloaded(const QUrl &url, const QUrl &localFileUrl)
 {
-    mFileInDownload.remove(url);
+    const QString filePath = QDir::cleanPath(localFileUrl.toLocalFile());
+    // Files saved outside of the main cache are kept as is
+    if (mDeduplicateFiles && filePath.startsWith(QFileInfo(mBlobsPath).path() + QLatin1Char('/'))) {
+        storeBlob(url, filePath);
+        return;
+    }
+    addToCacheIndex(filePath, QFileInfo(filePath).size());
     // TODO emit the complete QUrl rather than just the path
     Q_EMIT fileDownloaded(url.path(), localFileUrl);
 }
 
+void RocketChatCache::storeBlob(const QUrl &url, const QString &filePath)
+{
+    mStoringBlobs.insert(filePath);
+    const QPointer<RocketChatCache> guard(this);
+    cacheThreadPool()->start([accountName = mAccount->accountName(), blobsPath = mBlobsPath, url, filePath, guard]() {
+        qint64 blobSize = 0;
+        const QString blobName = storeCacheBlob(accountName, blobsPath, filePath, blobSize);
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, url, filePath, blobName, blobSize]() {
+                if (guard) {
+                    guard->slotBlobStored(url, filePath, blobName, blobSize);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void RocketChatCache::slotBlobStored(const QUrl &url, const QString &filePath, const QString &blobName, qint64 size)
+{
+    mStoringBlobs.remove(filePath);
+    if (blobName.isEmpty()) {
+        addToCacheIndex(filePath, QFileInfo(filePath).size());
+        Q_EMIT fileDownloaded(url.path(), QUrl::fromLocalFile(filePath));
+        return;
+    }
+    // Found by the stat fallback while the file was moved
+    removeFromCacheIndex(filePath);
+    mCacheBlobs.insert(filePath, blobName);
+    const QString blobPath = blobFilePath(blobName);
+    addToCacheIndex(blobPath, size);
+    Q_EMIT fileDownloaded(url.path(), QUrl::fromLocalFile(blobPath));
+}
+
 void RocketChatCache::loadAvatarCache()
 {
     QSettings settings(ManagerDataPaths::self()->accountAvatarConfigPath(mAccount->accountName()), QSettings::IniFormat);
     settings.beginGroup(QStringLiteral("Avatar"));
     const QStringList keys = settings.childKeys();
     for (const QString &key : keys) {
-        mAvatarUrl[key] = QUrl(settings.value(key).toString());
+        setAvatarUrl(key, QUrl(settings.value(key).toString()));
     }
     settings.endGroup();
 }
 
-void RocketChatCache::cleanupCache()
+void RocketChatCache::setAvatarUrl(const QString &avatarIdentifier, const QUrl &url)
 {
-    const QString cachePath = ManagerDataPaths::self()->path(ManagerDataPaths::Cache, mAccount->accountName());
-    cleanupCacheDirectory(cachePath + "/file-upload"_L1);
-    cleanupCacheDirectory(cachePath + "/media"_L1);
+    removeAvatarUrl(avatarIdentifier);
+    mAvatarUrl.insert(avatarIdentifier, url);
+    if (!url.isEmpty()) {
+        mAvatarIdentifiers.insert(url.path(), avatarIdentifier);
+    }
 }
 
-void RocketChatCache::cleanupCacheDirectory(const QString &directory)
+void RocketChatCache::removeAvatarUrl(const QString &avatarIdentifier)
 {
-    qCDebug(RUQOLA_LOG) << "Checking cache directory" << directory;
-    const QDate today = QDate::currentDate();
-    QDirIterator it(directory, {}, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        QFileInfo fileInfo(it.next());
-        if (fileInfo.lastModified().date().daysTo(today) > 365) { // at least one year old
-            qCInfo(RUQOLA_LOG) << "Deleting" << fileInfo.absoluteFilePath();
-            QFile::remove(fileInfo.absoluteFilePath());
-        }
-    }
-    // Clean up empty directories
-    QDirIterator dirit(directory, {}, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    while (dirit.hasNext()) {
-        const QString path = dirit.next();
-        QDir dir(path);
-        if (dir.isEmpty()) {
-            qCInfo(RUQOLA_LOG) << "Deleting empty dir" << path;
-            QDir().rmdir(path);
-        }
+    const auto it = mAvatarUrl.constFind(avatarIdentifier);
+    if (it == mAvatarUrl.cend()) {
+        return;
     }
+    mAvatarIdentifiers.remove(it->path(), avatarIdentifier);
+    mAvatarUrl.erase(it);
+}
+
+QStringList RocketChatCache::avatarIdentifiers(const QString &downloadPath) const
+{
+    return mAvatarIdentifiers.values(downloadPath);
 }
 
 void RocketChatCache::handleMigration()
@@ -141,57 +656,75 @@ void RocketChatCache::handleMigration()
 
 void RocketChatCache::downloadFile(const QString &url, const QUrl &localFile)
 {
-    QFile f(fileCachePath(QUrl(url)));
-    if (f.exists()) {
-        if (!f.copy(localFile.toLocalFile())) {
-            qCWarning(RUQOLA_LOG) << "Impossible to copy" << f.fileName() << "to" << localFile;
-        }
-        // emit fileDownloaded?
+    const QString cacheFilePath = localFilePath(url);
+    if (isCached(cacheFilePath)) {
+        copyCachedFile(cacheFilePath, localFile);
     } else {
-        // Not in cache. We need to download it (e.g. file attachment).
-        const QUrl downloadUrl = mAccount->urlForLink(url);
-        // const QUrl destUrl = storeInCache ? QUrl::fromLocalFile(fileCachePath(downloadUrl)) : localFile;
-        mAccount->restApi()->downloadFile(downloadUrl, localFile, QByteArray("text/plain"));
-        // this will call slotDataDownloaded
+        // Not in cache (e.g. file attachment): it's downloaded in cache before the files displayed in views,
+        // and it's retried when a previous attempt failed
+        mPendingCopies.insert(mAccount->urlForLink(url).path(), localFile);
+        downloadFileFromServer(url, true, ManagerDataPaths::Cache, DownloadScheduler::Priority::Explicit);
+        // this will call copyDownloadedFile
     }
 }
 
-bool RocketChatCache::attachmentIsInLocalCache(const QString &url)
+void RocketChatCache::copyDownloadedFile(const QString &downloadPath, const QUrl &cacheFileUrl)
 {
-    const QString cachePath = fileCachePath(QUrl(url));
-    if (QFileInfo::exists(cachePath)) {
-        return true;
+    const QList<QUrl> localFiles = mPendingCopies.values(downloadPath);
+    if (localFiles.isEmpty()) {
+        return;
+    }
+    mPendingCopies.remove(downloadPath);
+    for (const QUrl &localFile : localFiles) {
+        copyCachedFile(cacheFileUrl.toLocalFile(), localFile);
+    }
+}
+
+void RocketChatCache::copyCachedFile(const QString &cacheFilePath, const QUrl &localFile)
+{
+    const QString filePath = localFile.toLocalFile();
+    // User confirmed that it replaces an existing file
+    if (QFileInfo::exists(filePath) && !QFile::remove(filePath)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to remove" << filePath;
+        return;
+    }
+    if (!QFile::copy(cacheFilePath, filePath)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to copy" << cacheFilePath << "to" << localFile;
     }
-    return false;
+}
+
+bool RocketChatCache::attachmentIsInLocalCache(const QString &url)
+{
+    return isCached(localFilePath(url));
 }
 
 QUrl RocketChatCache::faviconLogoUrlFromLocalCache(const QString &url)
 {
-    return urlFromLocalCache(url, false);
+    return urlFromLocalCache(url, false, ManagerDataPaths::Cache, DownloadScheduler::Priority::Avatar);
 }
 
 QUrl RocketChatCache::avatarUrlFromLocalCache(const QString &url)
 {
-    return urlFromLocalCache(url, false);
+    return urlFromLocalCache(url, false, ManagerDataPaths::Cache, DownloadScheduler::Priority::Avatar);
 }
 
-QUrl RocketChatCache::urlFromLocalCache(const QString &url, bool needAuthentication, ManagerDataPaths::PathType type)
+QUrl RocketChatCache::urlFromLocalCache(const QString &url, bool needAuthentication, ManagerDataPaths::PathType type, DownloadScheduler::Priority priority)
 {
     if (url.isEmpty())
         return {};
-    const QString cachePath = fileCachePath(QUrl(url), type);
-    if (QFileInfo::exists(cachePath)) {
+    const QString cachePath = localFilePath(url, type);
+    if (isCached(cachePath)) {
         // QML wants a QUrl here. The widgets code would be simpler with just a QString path.
         return QUrl::fromLocalFile(cachePath);
     } else {
-        downloadFileFromServer(url, needAuthentication, type);
+        downloadFileFromServer(url, needAuthentication, type, priority);
     }
     return {};
 }
 
 QUrl RocketChatCache::soundUrlFromLocalCache(const QString &url)
 {
-    const QUrl soundUrl = urlFromLocalCache(url, false, ManagerDataPaths::CustomSound);
+    const QUrl soundUrl = urlFromLocalCache(url, false, ManagerDataPaths::CustomSound, DownloadScheduler::Priority::Emoji);
     // qDebug() << "soundUrlFromLocalCache  " << previewUrl;
     return soundUrl;
 }
@@ -205,6 +738,10 @@ void RocketChatCache::removeCache()
     const QString storeCachePath =
         QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1Char('/') + mAccount->accountName() + QLatin1Char('/');
     QDir dir(storeCachePath);
+    mCachedFiles.clear();
+    mAccessedFiles.clear();
+    mCacheSize = 0;
+    mCacheBlobs.clear();
     if (dir.exists()) {
         qDebug() << "Deleting old cache dir" << storeCachePath;
         if (!dir.removeRecursively()) {
@@ -215,7 +752,7 @@ void RocketChatCache::removeCache()
 
 QUrl RocketChatCache::previewUrlFromLocalCache(const QString &url)
 {
-    const QUrl previewUrl = urlFromLocalCache(url, false, ManagerDataPaths::PreviewUrl);
+    const QUrl previewUrl = urlFromLocalCache(url, false, ManagerDataPaths::PreviewUrl, DownloadScheduler::Priority::Preview);
     // qDebug() << "previewUrl  " << previewUrl;
     return previewUrl;
 }
@@ -225,27 +762,43 @@ QUrl RocketChatCache::attachmentUrlFromLocalCache(const QString &url)
     return urlFromLocalCache(url, true);
 }
 
+QUrl RocketChatCache::requestedAttachmentUrlFromLocalCache(const QString &url)
+{
+    return urlFromLocalCache(url, true, ManagerDataPaths::Cache, DownloadScheduler::Priority::Explicit);
+}
+
+QUrl RocketChatCache::emojiUrlFromLocalCache(const QString &url)
+{
+    return urlFromLocalCache(url, true, ManagerDataPaths::Cache, DownloadScheduler::Priority::Emoji);
+}
+
 void RocketChatCache::downloadAvatarFromServer(const Utils::AvatarInfo &info)
 {
     mAvatarManager->insertInDownloadQueue(info);
 }
 
-void RocketChatCache::downloadFileFromServer(const QString &filename, bool needAuthentication, ManagerDataPaths::PathType type)
+void RocketChatCache::downloadFileFromServer(const QString &filename, bool needAuthentication, ManagerDataPaths::PathType type, DownloadScheduler::Priority priority)
 {
-    const QUrl downloadUrl = mAccount->urlForLink(filename);
-    if (!mFileInDownload.contains(downloadUrl)) {
-        mFileInDownload.insert(downloadUrl);
-        const QUrl destFileUrl = QUrl::fromLocalFile(fileCachePath(downloadUrl, type));
-        mAccount->restApi()->downloadFile(downloadUrl, destFileUrl, "text/plain", needAuthentication);
-        // this will call slotDataDownloaded
+    // Scheduler ignores urls which are already downloading
+    DownloadScheduler::Request request;
+    request.url = mAccount->urlForLink(filename);
+    const QString filePath = fileCachePath(request.url, type);
+    if (mStoringBlobs.contains(filePath)) {
+        // Already downloaded
+        return;
     }
+    request.localFileUrl = QUrl::fromLocalFile(filePath);
+    request.requiredAuthentication = needAuthentication;
+    request.priority = priority;
+    mAccount->restApi()->downloadScheduler()->enqueue(request);
+    // this will call slotDataDownloaded
 }
 
 QString RocketChatCache::avatarUrlFromCacheOnly(const QString &userId)
 {
     const QUrl avatarUrl = mAvatarUrl.value(userId);
     if (!avatarUrl.isEmpty() && fileInCache(avatarUrl)) {
-        const QString url = QUrl::fromLocalFile(fileCachePath(avatarUrl)).toString();
+        const QString url = QUrl::fromLocalFile(localFilePath(avatarUrl.toString())).toString();
         qCDebug(RUQOLA_LOG) << " Use image in cache" << url << " userId " << userId << " mUserAvatarUrl.value(userId) " << mAvatarUrl.value(userId);
         return url;
     }
@@ -258,7 +811,13 @@ void RocketChatCache::removeAvatar(const QString &avatarIdentifier)
     if (avatarUrl.isEmpty()) {
         return;
     }
-    QFile f(fileCachePath(avatarUrl));
+    const QString filePath = cachedFilePath(avatarUrl.toString());
+    if (mCacheBlobs.contains(filePath)) {
+        removeBlobPath(filePath);
+        return;
+    }
+    QFile f(filePath);
+    removeFromCacheIndex(f.fileName());
     if (f.exists()) {
         if (!f.remove()) {
             qCWarning(RUQOLA_LOG) << "Impossible to remove f" << f.fileName() << " avartarUrl " << avatarUrl << " userIdentifier  " << avatarIdentifier;
@@ -271,7 +830,6 @@ void RocketChatCache::updateAvatar(const Utils::AvatarInfo &info)
     const QString avatarIdentifier = info.generateAvatarIdentifier();
     // qDebug() << " updateAvatar" << info;
     removeAvatar(avatarIdentifier);
-    mAvatarUrl.remove(avatarIdentifier);
     insertAvatarUrl(avatarIdentifier, QUrl());
     downloadAvatarFromServer(info);
 }
@@ -308,7 +866,7 @@ QString RocketChatCache::avatarUrl(const Utils::AvatarInfo &info)
 #endif
 
         if (!valueUrl.isEmpty() && fileInCache(valueUrl)) {
-            const QString url = QUrl::fromLocalFile(fileCachePath(valueUrl)).toString();
+            const QString url = QUrl::fromLocalFile(localFilePath(valueUrl.toString())).toString();
             // qDebug() << " Use image in cache" << url << " userId " << userId << " mUserAvatarUrl.value(userId) "<< mUserAvatarUrl.value(userId);
             // qDebug() << "Use image in cache  " << url;
 
@@ -322,9 +880,14 @@ QString RocketChatCache::avatarUrl(const Utils::AvatarInfo &info)
 
 void RocketChatCache::insertAvatarUrl(const QString &userIdentifier, const QUrl &url)
 {
-    mAvatarUrl.insert(userIdentifier, url);
+    setAvatarUrl(userIdentifier, url);
     if (!url.isEmpty() && !fileInCache(url)) {
-        mAccount->restApi()->downloadFile(url, QUrl::fromLocalFile(fileCachePath(url)), "image/png"_ba);
+        DownloadScheduler::Request request;
+        request.url = url;
+        request.localFileUrl = QUrl::fromLocalFile(fileCachePath(url));
+        request.mimeType = "image/png"_ba;
+        request.priority = DownloadScheduler::Priority::Avatar;
+        mAccount->restApi()->downloadScheduler()->enqueue(request);
         // this will call slotDataDownloaded
     }
 }
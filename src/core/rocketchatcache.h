@@ -6,16 +6,21 @@
 
 #pragma once
 
+#include "downloadscheduler.h"
 #include "libruqola_private_export.h"
+#include "localdatabase/localcacheblobsdatabase.h"
+#include "localdatabase/localcacheindexdatabase.h"
 #include "managerdatapaths.h"
 #include "utils.h"
 #include <QHash>
 #include <QObject>
 #include <QSet>
+#include <array>
 
 class Connection;
 class RocketChatAccount;
 class AvatarManager;
+class QTimer;
 class LIBRUQOLACORE_TESTS_EXPORT RocketChatCache : public QObject
 {
     Q_OBJECT
@@ -30,19 +35,56 @@ public:
     [[nodiscard]] QString avatarUrl(const Utils::AvatarInfo &info);
     void insertAvatarUrl(const QString &userId, const QUrl &url);
 
-    void downloadFileFromServer(const QString &filename, bool needAuthentication, ManagerDataPaths::PathType type = ManagerDataPaths::Cache);
+    void downloadFileFromServer(const QString &filename,
+                                bool needAuthentication,
+                                ManagerDataPaths::PathType type = ManagerDataPaths::Cache,
+                                DownloadScheduler::Priority priority = DownloadScheduler::Priority::Attachment);
+    // Copies the file to localFile, it's downloaded in cache first (with the other downloads, see DownloadScheduler)
     void downloadFile(const QString &url, const QUrl &localFile);
     void updateAvatar(const Utils::AvatarInfo &info);
 
     [[nodiscard]] QString avatarUrlFromCacheOnly(const QString &userId);
+    // Identifiers of the avatars downloaded from this url path (see fileDownloaded())
+    [[nodiscard]] QStringList avatarIdentifiers(const QString &downloadPath) const;
     [[nodiscard]] bool attachmentIsInLocalCache(const QString &url);
 
     [[nodiscard]] QUrl attachmentUrlFromLocalCache(const QString &url);
+    // Downloaded before the files displayed in views
+    [[nodiscard]] QUrl requestedAttachmentUrlFromLocalCache(const QString &url);
+    [[nodiscard]] QUrl emojiUrlFromLocalCache(const QString &url);
     [[nodiscard]] QUrl faviconLogoUrlFromLocalCache(const QString &url);
     [[nodiscard]] QUrl previewUrlFromLocalCache(const QString &url);
     [[nodiscard]] QUrl avatarUrlFromLocalCache(const QString &url);
     [[nodiscard]] QUrl soundUrlFromLocalCache(const QString &url);
     void removeCache();
+    void removeFileFromCache(const QString &filePath);
+
+    [[nodiscard]] qint64 maximumCacheSize() const;
+    void setMaximumCacheSize(qint64 size);
+    [[nodiscard]] qint64 cacheSize() const;
+
+    // Looks up the in-memory index, files are only looked up on disk until it's loaded
+    [[nodiscard]] bool isCached(const QString &filePath);
+    // Index is loaded in the cache thread at startup
+    [[nodiscard]] bool cacheIndexLoaded() const;
+
+    // Files with the same content are stored once, in blobs named after their hash
+    [[nodiscard]] bool deduplicateFiles() const;
+    void setDeduplicateFiles(bool deduplicate);
+
+    // Only files of the cache directories are indexed, and evicted
+    [[nodiscard]] static bool isIndexedPath(const QString &filePath, const QStringList &directories);
+    // Run in cache thread: lists files of directories, with access time from the index database.
+    // Partial downloads not modified for a week are removed
+    [[nodiscard]] static LocalCacheIndexDatabase::CacheFiles synchronizeCacheIndex(const QString &accountName, const QStringList &directories);
+    // Run in cache thread: saves changes then removes least recently used files until bytesToFree are freed,
+    // and files unused since expiryTime. Returns the removed files
+    [[nodiscard]] static QStringList evictCacheFiles(const QString &accountName,
+                                                     const QStringList &directories,
+                                                     const LocalCacheIndexDatabase::CacheFiles &accessedFiles,
+                                                     const QStringList &removedFiles,
+                                                     qint64 bytesToFree,
+                                                     qint64 expiryTime);
 
 Q_SIGNALS:
     void fileDownloaded(const QString &filePath, const QUrl &cacheImageUrl);
@@ -50,20 +92,61 @@ Q_SIGNALS:
 private:
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QUrl urlFromLocalCache(const QString &url,
                                                                  bool needAuthentication,
-                                                                 ManagerDataPaths::PathType type = ManagerDataPaths::Cache);
+                                                                 ManagerDataPaths::PathType type = ManagerDataPaths::Cache,
+                                                                 DownloadScheduler::Priority priority = DownloadScheduler::Priority::Attachment);
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool fileInCache(const QUrl &url);
     [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString fileCachePath(const QUrl &url, ManagerDataPaths::PathType type = ManagerDataPaths::Cache);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString cachedFilePath(const QString &url, ManagerDataPaths::PathType type = ManagerDataPaths::Cache);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString localFilePath(const QString &url, ManagerDataPaths::PathType type = ManagerDataPaths::Cache);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT QString blobFilePath(const QString &blobName) const;
+    LIBRUQOLACORE_NO_EXPORT void loadCacheIndex();
+    LIBRUQOLACORE_NO_EXPORT void setCacheIndex(LocalCacheIndexDatabase::CacheFiles &&files, LocalCacheBlobsDatabase::CacheBlobs &&blobs);
+    LIBRUQOLACORE_NO_EXPORT void addToCacheIndex(const QString &filePath, qint64 size);
+    LIBRUQOLACORE_NO_EXPORT void removeFromCacheIndex(const QString &filePath);
+    LIBRUQOLACORE_NO_EXPORT void scheduleCacheMaintenance();
+    LIBRUQOLACORE_NO_EXPORT void runCacheMaintenance();
+    LIBRUQOLACORE_NO_EXPORT void slotCacheFilesEvicted(const QStringList &filePaths, bool evictionFinished);
     LIBRUQOLACORE_NO_EXPORT void downloadAvatarFromServer(const Utils::AvatarInfo &info);
     LIBRUQOLACORE_NO_EXPORT void slotDataDownloaded(const QUrl &url, const QUrl &localFileUrl);
+    LIBRUQOLACORE_NO_EXPORT void copyDownloadedFile(const QString &downloadPath, const QUrl &cacheFileUrl);
+    LIBRUQOLACORE_NO_EXPORT static void copyCachedFile(const QString &cacheFilePath, const QUrl &localFile);
+    LIBRUQOLACORE_NO_EXPORT void storeBlob(const QUrl &url, const QString &filePath);
+    LIBRUQOLACORE_NO_EXPORT void slotBlobStored(const QUrl &url, const QString &filePath, const QString &blobName, qint64 size);
+    LIBRUQOLACORE_NO_EXPORT void removeBlobPath(const QString &filePath);
     LIBRUQOLACORE_NO_EXPORT void removeAvatar(const QString &avatarIdentifier);
     LIBRUQOLACORE_NO_EXPORT void loadAvatarCache();
-    LIBRUQOLACORE_NO_EXPORT void cleanupCache();
-    LIBRUQOLACORE_NO_EXPORT void cleanupCacheDirectory(const QString &directory);
+    LIBRUQOLACORE_NO_EXPORT void setAvatarUrl(const QString &avatarIdentifier, const QUrl &url);
+    LIBRUQOLACORE_NO_EXPORT void removeAvatarUrl(const QString &avatarIdentifier);
     LIBRUQOLACORE_NO_EXPORT void handleMigration();
 
     QHash<QString, QUrl> mAvatarUrl;
-    QSet<QUrl> mFileInDownload;
+    // Url path => files to copy the download to (see downloadFile())
+    QMultiHash<QString, QUrl> mPendingCopies;
+    // Url path => avatar identifiers, reverse of mAvatarUrl
+    QMultiHash<QString, QString> mAvatarIdentifiers;
+    // Files in the cache directories, they are listed in a thread at startup then kept up to date
+    LocalCacheIndexDatabase::CacheFiles mCachedFiles;
+    // Changes not saved in the index database yet
+    QSet<QString> mAccessedFiles;
+    QStringList mRemovedFiles;
+    qint64 mCacheSize = 0;
+    // Per account, least recently used files are removed above it (MaximumCacheSize setting)
+    qint64 mMaximumCacheSize = 0;
+    // fileCachePath() of the urls per path type, cache is looked up when painting
+    std::array<QHash<QString, QString>, ManagerDataPaths::CustomSound + 1> mCachedFilePaths;
+    // Blob of the files of the main cache when they are deduplicated
+    LocalCacheBlobsDatabase::CacheBlobs mCacheBlobs;
+    QStringList mRemovedBlobPaths;
+    // Downloaded files which are moved to their blob
+    QSet<QString> mStoringBlobs;
+    const QString mBlobsPath;
+    // MainCache, PreviewUrl and CustomSound
+    const QStringList mIndexedDirectories;
+    bool mCacheIndexLoaded = false;
+    bool mCacheMaintenanceRunning = false;
+    bool mDeduplicateFiles = false;
     RocketChatAccount *const mAccount;
     AvatarManager *const mAvatarManager;
+    QTimer *const mCacheMaintenanceTimer;
     QString mAccountServerHost;
 };
@@ -210,7 +210,7 @@ RocketChatMessage::RocketChatMessageResult RocketChatMessage::unsubscribe(quint6
     QJsonObject json;
     json["msg"_L1] = QStringLiteral("unsub");
     json["id"_L1] = QString::number(id);
-    const QString generatedJsonDoc = QString::fromUtf8(QJsonDocument(json).toJson(mJsonFormat));
+    const QByteArray generatedJsonDoc = QJsonDocument(json).toJson(mJsonFormat);
     RocketChatMessageResult result;
     result.result = generatedJsonDoc;
     return result;
@@ -238,7 +238,7 @@ QJsonObject RocketChatMessage::generateJsonObject(const QString &method, const Q
 RocketChatMessage::RocketChatMessageResult RocketChatMessage::generateMethod(const QString &method, const QJsonArray &params, quint64 id)
 {
     const QJsonObject json = RocketChatMessage::generateJsonObject(method, params, id);
-    const QString generatedJsonDoc = QString::fromUtf8(QJsonDocument(json).toJson(mJsonFormat));
+    const QByteArray generatedJsonDoc = QJsonDocument(json).toJson(mJsonFormat);
     RocketChatMessageResult result;
     result.jsonDocument = QJsonDocument(params);
     result.method = method;
@@ -249,7 +249,7 @@ RocketChatMessage::RocketChatMessageResult RocketChatMessage::generateMethod(con
 RocketChatMessage::RocketChatMessageResult RocketChatMessage::generateMethod(const QString &method, const QJsonObject &params, quint64 id)
 {
     const QJsonObject json = RocketChatMessage::generateJsonObject(method, params, id);
-    const QString generatedJsonDoc = QString::fromUtf8(QJsonDocument(json).toJson(mJsonFormat));
+    const QByteArray generatedJsonDoc = QJsonDocument(json).toJson(mJsonFormat);
     RocketChatMessageResult result;
     result.jsonDocument = QJsonDocument(params);
     result.method = method;
@@ -20,7 +20,8 @@ public:
 
     struct RocketChatMessageResult {
         QString method;
-        QString result;
+        // UTF-8 json, sent as is to the websocket
+        QByteArray result;
         QJsonDocument jsonDocument;
     };
 
@@ -54,6 +54,16 @@ qint64 RuqolaWebSocket::sendTextMessage(const QString &message)
     return mWebSocket->sendTextMessage(message);
 }
 
+qint64 RuqolaWebSocket::sendUtf8TextMessage(const QByteArray &message)
+{
+    qCDebug(RUQOLA_LOG) << "RuqolaWebSocket::sendUtf8TextMessage" << message;
+    if (mLogger) {
+        mLogger->dataSent(message);
+    }
+    // QWebSocket only takes text frames as QString, it's the only conversion left
+    return mWebSocket->sendTextMessage(QString::fromUtf8(message));
+}
+
 bool RuqolaWebSocket::isValid() const
 {
     return mWebSocket->isValid();
@@ -111,10 +121,12 @@ QWebSocketProtocol::Version RuqolaWebSocket::version() const
 
 void RuqolaWebSocket::slotTextMessageReceived(const QString &msg)
 {
+    // QWebSocket decodes text frames to QString, convert back once for both logger and json parser
+    const QByteArray utf8Message = msg.toUtf8();
     if (mLogger) {
-        mLogger->dataReceived(msg.toUtf8());
+        mLogger->dataReceived(utf8Message);
     }
-    Q_EMIT textMessageReceived(msg);
+    Q_EMIT textMessageReceived(utf8Message);
 }
 
 void RuqolaWebSocket::slotError(QAbstractSocket::SocketError error)
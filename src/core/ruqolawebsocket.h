@@ -19,6 +19,7 @@ public:
 
     void openUrl(const QUrl &url) override;
     qint64 sendTextMessage(const QString &message) override;
+    qint64 sendUtf8TextMessage(const QByteArray &message) override;
     [[nodiscard]] bool isValid() const override;
     void flush() override;
     void close() override;
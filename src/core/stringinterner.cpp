@@ -0,0 +1,61 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "stringinterner.h"
+
+#include <QMutexLocker>
+
+StringInterner &StringInterner::self()
+{
+    static StringInterner s;
+    return s;
+}
+
+QString StringInterner::intern(const QString &str)
+{
+    if (str.isEmpty()) {
+        return str;
+    }
+    QMutexLocker locker(&mMutex);
+    auto it = mStrings.constFind(str);
+    if (it != mStrings.cend()) {
+        return *it;
+    }
+    mStrings.insert(str);
+    return str;
+}
+
+QByteArray StringInterner::intern(const QByteArray &str)
+{
+    if (str.isEmpty()) {
+        return str;
+    }
+    QMutexLocker locker(&mMutex);
+    auto it = mByteArrays.constFind(str);
+    if (it != mByteArrays.cend()) {
+        return *it;
+    }
+    mByteArrays.insert(str);
+    return str;
+}
+
+void StringInterner::purge()
+{
+    QMutexLocker locker(&mMutex);
+    // Only referenced by the pool
+    mStrings.removeIf([](const QString &str) {
+        return str.isDetached();
+    });
+    mByteArrays.removeIf([](const QByteArray &str) {
+        return str.isDetached();
+    });
+}
+
+qsizetype StringInterner::count() const
+{
+    QMutexLocker locker(&mMutex);
+    return mStrings.count() + mByteArrays.count();
+}
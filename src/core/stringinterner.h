@@ -0,0 +1,37 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include <QByteArray>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+/**
+ * Pool of strings which are repeated in a lot of objects (user names and identifiers, room identifiers...).
+ * intern() returns the pooled copy of a string, so that all the objects share its data.
+ * It can be used from any thread.
+ */
+class LIBRUQOLACORE_TESTS_EXPORT StringInterner
+{
+public:
+    static StringInterner &self();
+
+    [[nodiscard]] QString intern(const QString &str);
+    [[nodiscard]] QByteArray intern(const QByteArray &str);
+
+    // Drops the strings which are not used outside of the pool anymore
+    void purge();
+
+    [[nodiscard]] qsizetype count() const;
+
+private:
+    mutable QMutex mMutex;
+    QSet<QString> mStrings;
+    QSet<QByteArray> mByteArrays;
+};
@@ -65,7 +65,8 @@ bool SyntaxHighlightingManager::syntaxHighlightingInitialized() const
 
 SyntaxHighlightingManager *SyntaxHighlightingManager::self()
 {
-    static SyntaxHighlightingManager s_self;
+    // KSyntaxHighlighting::Repository is not thread-safe: each thread which converts text gets its own one.
+    static thread_local SyntaxHighlightingManager s_self;
     return &s_self;
 }
 
@@ -8,7 +8,9 @@
 #include "cmark-rc.h"
 #include "colorsandmessageviewstyle.h"
 #include "emoticons/emojimanager.h"
+#include "highlightedcodecache.h"
 #include "messagecache.h"
+#include "quotedtextcache.h"
 #include "ruqola_texttohtml_cmark_debug.h"
 #include "ruqola_texttohtml_debug.h"
 #include "utils.h"
@@ -21,6 +23,10 @@
 #include <KSyntaxHighlighting/Theme>
 
 #include <KColorScheme>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QThread>
 using namespace Qt::Literals::StringLiterals;
 namespace
 {
@@ -135,7 +141,8 @@ QString generateRichTextCMark(const QString &str,
                               const QStringList &highlightWords,
                               const QMap<QString, QByteArray> &mentions,
                               const Channels *const channels,
-                              const QString &searchedText)
+                              const QString &searchedText,
+                              const TextConverter::TextColors &colors)
 {
     QString newStr = markdownToRichTextCMark(str);
     static const QRegularExpression regularExpressionAHref(QStringLiteral("(<a href=\'.*\'>|<a href=\".*\">)"));
@@ -194,8 +201,8 @@ QString generateRichTextCMark(const QString &str,
     }
 
     if (!highlightWords.isEmpty()) {
-        const auto userHighlightForegroundColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::PositiveText).color().name();
-        const auto userHighlightBackgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::PositiveBackground).color().name();
+        const auto userHighlightForegroundColor = colors.positiveText.name();
+        const auto userHighlightBackgroundColor = colors.positiveBackground.name();
         lstPos.clear();
         QRegularExpressionMatchIterator userIteratorHref = regularExpressionAHref.globalMatch(newStr);
         while (userIteratorHref.hasNext()) {
@@ -234,8 +241,8 @@ QString generateRichTextCMark(const QString &str,
     }
 
     if (!searchedText.isEmpty()) {
-        const auto userHighlightForegroundColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::NeutralText).color().name();
-        const auto userHighlightBackgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::NeutralBackground).color().name();
+        const auto userHighlightForegroundColor = colors.neutralText.name();
+        const auto userHighlightBackgroundColor = colors.neutralBackground.name();
         lstPos.clear();
         QRegularExpressionMatchIterator userIteratorHref = regularExpressionAHref.globalMatch(newStr);
         while (userIteratorHref.hasNext()) {
@@ -273,10 +280,10 @@ QString generateRichTextCMark(const QString &str,
     static const QRegularExpression regularExpressionUser(QStringLiteral("(^|\\s+)@([\\w._-]+)"), QRegularExpression::UseUnicodePropertiesOption);
     QRegularExpressionMatchIterator userIterator = regularExpressionUser.globalMatch(newStr);
 
-    const auto userMentionForegroundColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::NegativeText).color().name();
-    const auto userMentionBackgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::NegativeBackground).color().name();
-    const auto hereAllMentionBackgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::NeutralBackground).color().name();
-    const auto hereAllMentionForegroundColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::NeutralText).color().name();
+    const auto userMentionForegroundColor = colors.negativeText.name();
+    const auto userMentionBackgroundColor = colors.negativeBackground.name();
+    const auto hereAllMentionBackgroundColor = colors.neutralBackground.name();
+    const auto hereAllMentionForegroundColor = colors.neutralText.name();
     while (userIterator.hasNext()) {
         const QRegularExpressionMatch match = userIterator.next();
         const QStringView word = match.capturedView(2);
@@ -334,33 +341,91 @@ void iterateOverRegionsCmark(const QString &str, const QString &regionMarker, In
 }
 }
 
+QByteArray quotedTextCacheKey(const TextConverter::ConvertMessageTextSettings &settings,
+                              const Message &quotedMessage,
+                              const QString &quotedText,
+                              const QString &url,
+                              int recursiveIndex)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto addString = [&hash](const QString &str) {
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(str.constData()), str.size() * sizeof(QChar)));
+        hash.addData(QByteArrayView("\0", 1));
+    };
+    hash.addData(quotedMessage.messageId());
+    hash.addData(QByteArrayView("\0", 1));
+    addString(quotedText);
+    addString(url);
+    addString(quotedMessage.dateTime());
+    addString(settings.userName);
+    addString(settings.highlightWords.join(QLatin1Char('\n')));
+    addString(settings.searchedText);
+    addString(settings.colors->alternateBackground.name());
+    addString(settings.colors->linkText.name());
+    // Custom emojis rendered in the quoted text
+    if (settings.emojiReplacementTable) {
+        addString(QString::number(settings.emojiReplacementTable->revision));
+        addString(QString::number(settings.emojiReplacementTable->unresolvedCustomEmojis.count()));
+    } else if (settings.emojiManager) {
+        addString(QString::number(settings.emojiManager->emojiRevision()));
+    }
+    // Depth of nested quotes which can still be rendered
+    const int remainingQuotes = settings.maximumRecursiveQuotedText == -1 ? -1 : settings.maximumRecursiveQuotedText - recursiveIndex;
+    addString(QString::number(remainingQuotes));
+    addString(QString::number(quotedMessage.editedAt()));
+    return hash.result();
+}
+
+void replaceEmojis(const TextConverter::ConvertMessageTextSettings &settings, QString *str)
+{
+    if (settings.emojiReplacementTable) {
+        EmojiManager::replaceEmojis(*settings.emojiReplacementTable, str);
+    } else if (settings.emojiManager) {
+        settings.emojiManager->replaceEmojis(str);
+    }
+}
+
 QString addHighlighter(const QString &str, const TextConverter::ConvertMessageTextSettings &settings)
 {
     QString richText;
     QTextStream richTextStream(&richText);
-    const QColor codeBackgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::AlternateBackground).color();
-    const auto codeBorderColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::InactiveText).color().name();
+    const QColor codeBackgroundColor = settings.colors->alternateBackground;
+    const auto codeBorderColor = settings.colors->inactiveText.name();
 
     QString highlighted;
     QTextStream stream(&highlighted);
     TextHighlighter highlighter(&stream);
     const auto useHighlighter = SyntaxHighlightingManager::self()->syntaxHighlightingInitialized();
 
+    QString themeName;
     if (useHighlighter) {
         auto &repo = SyntaxHighlightingManager::self()->repo();
         const auto theme = (codeBackgroundColor.lightness() < 128) ? repo.defaultTheme(KSyntaxHighlighting::Repository::DarkTheme)
                                                                    : repo.defaultTheme(KSyntaxHighlighting::Repository::LightTheme);
         // qDebug() << " theme .n am" << theme.name();
+        themeName = theme.name();
         highlighter.setTheme(theme);
     }
     auto highlight = [&](const QString &codeBlock) {
         if (!useHighlighter) {
             return codeBlock;
         }
+        auto &cache = HighlightedCodeCache::self();
+        const QByteArray key = HighlightedCodeCache::cacheKey(highlighter.definition().name(), themeName, codeBlock);
+        QString html = cache.highlightedCode(key);
+        if (!html.isEmpty()) {
+            return html;
+        }
+        // Don't block main thread with huge blocks (logs...): show plain text until it's highlighted
+        if (codeBlock.size() >= HighlightedCodeCache::lazyHighlightingThreshold && qApp && QThread::currentThread() == qApp->thread()) {
+            cache.highlightInBackground(key, highlighter.definition().name(), themeName, codeBlock);
+            return TextHighlighter::plainCode(codeBlock) + HighlightedCodeCache::pendingHighlightingMarker();
+        }
         stream.reset();
         stream.seek(0);
         highlighted.clear();
         highlighter.highlight(codeBlock);
+        cache.insert(key, highlighted);
         return highlighted;
     };
 
@@ -391,17 +456,13 @@ QString addHighlighter(const QString &str, const TextConverter::ConvertMessageTe
     };
 
     auto addTextChunk = [&](const QString &chunk) {
-        auto htmlChunk = generateRichTextCMark(chunk, settings.userName, settings.highlightWords, settings.mentions, settings.channels, settings.searchedText);
-        if (settings.emojiManager) {
-            settings.emojiManager->replaceEmojis(&htmlChunk);
-        }
+        auto htmlChunk = generateRichTextCMark(chunk, settings.userName, settings.highlightWords, settings.mentions, settings.channels, settings.searchedText, *settings.colors);
+        replaceEmojis(settings, &htmlChunk);
         richTextStream << htmlChunk;
     };
     auto addInlineQuoteCodeChunk = [&](const QString &chunk) {
-        auto htmlChunk = generateRichTextCMark(chunk, settings.userName, settings.highlightWords, settings.mentions, settings.channels, settings.searchedText);
-        if (settings.emojiManager) {
-            settings.emojiManager->replaceEmojis(&htmlChunk);
-        }
+        auto htmlChunk = generateRichTextCMark(chunk, settings.userName, settings.highlightWords, settings.mentions, settings.channels, settings.searchedText, *settings.colors);
+        replaceEmojis(settings, &htmlChunk);
         richTextStream << "<code style='background-color:"_L1 << codeBackgroundColor.name() << "'>"_L1 << htmlChunk << "</code>"_L1;
     };
 
@@ -450,6 +511,9 @@ QString convertMessageText(const TextConverter::ConvertMessageTextSettings &newS
         newSettings.channels,
         newSettings.searchedText,
         newSettings.maximumRecursiveQuotedText,
+        newSettings.emojiReplacementTable,
+        newSettings.messageLookup,
+        newSettings.colors,
     };
     const QByteArray ba = settings.str.toUtf8();
     cmark_node *doc = cmark_parse_document(ba.constData(), ba.length(), CMARK_OPT_DEFAULT);
@@ -535,9 +599,54 @@ QString convertMessageText(const TextConverter::ConvertMessageTextSettings &newS
     return result;
 }
 
+TextConverter::TextColors TextConverter::TextColors::fromColorScheme()
+{
+    const KColorScheme scheme = ColorsAndMessageViewStyle::self().schemeView();
+    TextColors colors;
+    colors.positiveText = scheme.foreground(KColorScheme::PositiveText).color();
+    colors.positiveBackground = scheme.background(KColorScheme::PositiveBackground).color();
+    colors.neutralText = scheme.foreground(KColorScheme::NeutralText).color();
+    colors.neutralBackground = scheme.background(KColorScheme::NeutralBackground).color();
+    colors.negativeText = scheme.foreground(KColorScheme::NegativeText).color();
+    colors.negativeBackground = scheme.background(KColorScheme::NegativeBackground).color();
+    colors.alternateBackground = scheme.background(KColorScheme::AlternateBackground).color();
+    colors.inactiveText = scheme.foreground(KColorScheme::InactiveText).color();
+    colors.linkText = scheme.foreground(KColorScheme::LinkText).color();
+    return colors;
+}
+
+void TextConverter::clearQuotedTextCache()
+{
+    QuotedTextCache::self().clear();
+}
+
 QString TextConverter::convertMessageText(const TextConverter::ConvertMessageTextSettings &settings, QByteArray &needUpdateMessageId, int &recusiveIndex)
 {
-    if (!settings.emojiManager) {
+    return "<qt>"_L1 + convertMessageTextFragment(settings, needUpdateMessageId, recusiveIndex) + "</qt>"_L1;
+}
+
+QString TextConverter::convertMessageTextFragment(const TextConverter::ConvertMessageTextSettings &settings, QByteArray &needUpdateMessageId, int &recusiveIndex)
+{
+    if (!settings.colors) {
+        Q_ASSERT(!qApp || QThread::currentThread() == qApp->thread());
+        const TextConverter::ConvertMessageTextSettings colorSettings{
+            settings.str,
+            settings.userName,
+            settings.allMessages,
+            settings.highlightWords,
+            settings.emojiManager,
+            settings.messageCache,
+            settings.mentions,
+            settings.channels,
+            settings.searchedText,
+            settings.maximumRecursiveQuotedText,
+            settings.emojiReplacementTable,
+            settings.messageLookup,
+            std::make_shared<const TextColors>(TextColors::fromColorScheme()),
+        };
+        return convertMessageTextFragment(colorSettings, needUpdateMessageId, recusiveIndex);
+    }
+    if (!settings.emojiManager && !settings.emojiReplacementTable) {
         qCWarning(RUQOLA_TEXTTOHTML_LOG) << "Emojimanager is null";
     }
 
@@ -553,28 +662,72 @@ QString TextConverter::convertMessageText(const TextConverter::ConvertMessageTex
         // URL example https://HOSTNAME/channel/all?msg=3BR34NSG5x7ZfBa22
         const QByteArray messageId = url.mid(url.indexOf("msg="_L1) + 4).toLatin1();
         // qCDebug(RUQOLA_TEXTTOHTML_LOG) << "Extracted messageId" << messageId;
-        auto it = std::find_if(settings.allMessages.cbegin(), settings.allMessages.cend(), [messageId](const Message &msg) {
-            return msg.messageId() == messageId;
-        });
-        if (it != settings.allMessages.cend()) {
-            const TextConverter::ConvertMessageTextSettings newSetting(QLatin1Char('@') + (*it).username() + QStringLiteral(": ") + (*it).text(),
-                                                                       settings.userName,
-                                                                       settings.allMessages,
-                                                                       settings.highlightWords,
-                                                                       settings.emojiManager,
-                                                                       settings.messageCache,
-                                                                       (*it).mentions(),
-                                                                       (*it).channels(),
-                                                                       settings.searchedText,
-                                                                       settings.maximumRecursiveQuotedText);
+        const Message *quotedMsg = nullptr;
+        // Message from the room: show who wrote it
+        bool foundInRoom = true;
+        if (settings.messageLookup) {
+            quotedMsg = settings.messageLookup(messageId);
+        } else {
+            auto it = std::find_if(settings.allMessages.cbegin(), settings.allMessages.cend(), [messageId](const Message &msg) {
+                return msg.messageId() == messageId;
+            });
+            if (it != settings.allMessages.cend()) {
+                quotedMsg = &(*it);
+            }
+        }
+        if (!quotedMsg) {
+            foundInRoom = false;
+            if (settings.messageCache) {
+                // TODO allow to reload index when we loaded message
+                quotedMsg = settings.messageCache->messageForId(messageId);
+                if (!quotedMsg) {
+                    qCDebug(RUQOLA_TEXTTOHTML_LOG) << "Quoted message" << messageId << "not found"; // could be a very old one
+                    needUpdateMessageId = messageId;
+                }
+            } else {
+                // Without message cache (conversion outside main thread) we can't load it: let caller know that it's incomplete
+                needUpdateMessageId = messageId;
+            }
+        }
+        if (quotedMsg) {
+            const QString quotedText = foundInRoom ? QLatin1Char('@') + quotedMsg->username() + QStringLiteral(": ") + quotedMsg->text() : quotedMsg->text();
+            const QByteArray cacheKey = quotedTextCacheKey(settings, *quotedMsg, quotedText, url, recusiveIndex);
             recusiveIndex++;
-            const QString text = TextConverter::convertMessageText(newSetting, needUpdateMessageId, recusiveIndex);
-            Utils::QuotedRichTextInfo info;
-            info.url = url;
-            info.richText = text;
-            info.displayTime = (*it).dateTime();
+            QString quotedFragment = QuotedTextCache::self().quotedText(cacheKey);
+            if (quotedFragment.isEmpty()) {
+                const TextConverter::ConvertMessageTextSettings newSetting(quotedText,
+                                                                           settings.userName,
+                                                                           settings.allMessages,
+                                                                           settings.highlightWords,
+                                                                           settings.emojiManager,
+                                                                           settings.messageCache,
+                                                                           quotedMsg->mentions(),
+                                                                           quotedMsg->channels(),
+                                                                           settings.searchedText,
+                                                                           settings.maximumRecursiveQuotedText,
+                                                                           settings.emojiReplacementTable,
+                                                                           settings.messageLookup,
+                                                                           settings.colors);
+                QByteArray nestedNeedUpdateMessageId;
+                const QString text = TextConverter::convertMessageText(newSetting, nestedNeedUpdateMessageId, recusiveIndex);
+                Utils::QuotedRichTextInfo info;
+                info.url = url;
+                info.richText = text;
+                info.displayTime = quotedMsg->dateTime();
+                info.backgroundColor = settings.colors->alternateBackground.name();
+                info.borderColor = settings.colors->linkText.name();
+                quotedFragment = Utils::formatQuotedRichText(std::move(info));
+                // Don't keep incomplete fragments
+                if (nestedNeedUpdateMessageId.isEmpty() && !text.contains(HighlightedCodeCache::pendingHighlightingMarker())) {
+                    QuotedTextCache::self().insert(cacheKey, quotedFragment);
+                } else {
+                    needUpdateMessageId = nestedNeedUpdateMessageId;
+                }
+            }
 
-            str = str.left(startPos - 3) + str.mid(endPos + 1);
+            if (foundInRoom) {
+                str = str.left(startPos - 3) + str.mid(endPos + 1);
+            }
             const TextConverter::ConvertMessageTextSettings newsettings{
                 str,
                 settings.userName,
@@ -586,53 +739,14 @@ QString TextConverter::convertMessageText(const TextConverter::ConvertMessageTex
                 settings.channels,
                 settings.searchedText,
                 settings.maximumRecursiveQuotedText,
+                settings.emojiReplacementTable,
+                settings.messageLookup,
+                settings.colors,
             };
             str = convertMessageText(newsettings, QString());
 
-            quotedMessage = Utils::formatQuotedRichText(std::move(info)) + str;
+            quotedMessage = quotedFragment + str;
             str.clear();
-        } else {
-            if (settings.messageCache) {
-                // TODO allow to reload index when we loaded message
-                Message *msg = settings.messageCache->messageForId(messageId);
-                if (msg) {
-                    const TextConverter::ConvertMessageTextSettings newSetting(msg->text(),
-                                                                               settings.userName,
-                                                                               settings.allMessages,
-                                                                               settings.highlightWords,
-                                                                               settings.emojiManager,
-                                                                               settings.messageCache,
-                                                                               msg->mentions(),
-                                                                               msg->channels(),
-                                                                               settings.searchedText,
-                                                                               settings.maximumRecursiveQuotedText);
-                    recusiveIndex++;
-                    const QString text = TextConverter::convertMessageText(newSetting, needUpdateMessageId, recusiveIndex);
-                    Utils::QuotedRichTextInfo info;
-                    info.url = url;
-                    info.richText = text;
-                    info.displayTime = msg->dateTime();
-                    const TextConverter::ConvertMessageTextSettings newsettings{
-                        str,
-                        settings.userName,
-                        settings.allMessages,
-                        settings.highlightWords,
-                        settings.emojiManager,
-                        settings.messageCache,
-                        settings.mentions,
-                        settings.channels,
-                        settings.searchedText,
-                        settings.maximumRecursiveQuotedText,
-                    };
-                    str = convertMessageText(newsettings, QString());
-
-                    quotedMessage = Utils::formatQuotedRichText(std::move(info)) + str;
-                    str.clear();
-                } else {
-                    qCDebug(RUQOLA_TEXTTOHTML_LOG) << "Quoted message" << messageId << "not found"; // could be a very old one
-                    needUpdateMessageId = messageId;
-                }
-            }
         }
     }
 
@@ -648,9 +762,12 @@ QString TextConverter::convertMessageText(const TextConverter::ConvertMessageTex
         settings.channels,
         settings.searchedText,
         settings.maximumRecursiveQuotedText,
+        settings.emojiReplacementTable,
+        settings.messageLookup,
+        settings.colors,
     };
     // qDebug() << "settings.str  " << settings.str;
     const QString result = convertMessageText(newsettings, quotedMessage);
     // qDebug() << " RESULT ************ " << result;
-    return "<qt>"_L1 + result + "</qt>"_L1;
+    return result;
 }
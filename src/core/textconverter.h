@@ -9,17 +9,41 @@
 #include "config-ruqola.h"
 #include "libruqolacore_export.h"
 #include "messages/message.h"
+#include <QColor>
 #include <QList>
 #include <QMap>
 #include <QString>
 #include <QStringList>
+#include <functional>
+#include <memory>
 
 class EmojiManager;
+struct EmojiReplacementTable;
 class Message;
 class MessageCache;
 
 namespace TextConverter
 {
+// Returns the message with this identifier, or nullptr
+using MessageLookup = std::function<const Message *(const QByteArray &messageId)>;
+
+// Colors used in generated html. ColorsAndMessageViewStyle is only read in main thread,
+// conversions running in other threads use a copy made there.
+struct LIBRUQOLACORE_EXPORT TextColors {
+    QColor positiveText;
+    QColor positiveBackground;
+    QColor neutralText;
+    QColor neutralBackground;
+    QColor negativeText;
+    QColor negativeBackground;
+    QColor alternateBackground;
+    QColor inactiveText;
+    QColor linkText;
+
+    // Main thread only
+    [[nodiscard]] static TextConverter::TextColors fromColorScheme();
+};
+
 struct LIBRUQOLACORE_EXPORT ConvertMessageTextSettings {
     ConvertMessageTextSettings(const QString &_str,
                                const QString &_userName,
@@ -30,7 +54,10 @@ struct LIBRUQOLACORE_EXPORT ConvertMessageTextSettings {
                                const QMap<QString, QByteArray> &_mentions,
                                const Channels *_channels,
                                const QString &_searchedText = {},
-                               int _maximumRecursiveQuotedText = -1)
+                               int _maximumRecursiveQuotedText = -1,
+                               const std::shared_ptr<const EmojiReplacementTable> &_emojiReplacementTable = {},
+                               const MessageLookup &_messageLookup = {},
+                               const std::shared_ptr<const TextColors> &_colors = {})
         : str(_str)
         , userName(_userName)
         , allMessages(_allMessages)
@@ -41,6 +68,9 @@ struct LIBRUQOLACORE_EXPORT ConvertMessageTextSettings {
         , channels(_channels)
         , searchedText(_searchedText)
         , maximumRecursiveQuotedText(_maximumRecursiveQuotedText)
+        , emojiReplacementTable(_emojiReplacementTable)
+        , messageLookup(_messageLookup)
+        , colors(_colors)
     {
     }
     const QString str;
@@ -53,10 +83,23 @@ struct LIBRUQOLACORE_EXPORT ConvertMessageTextSettings {
     const Channels *const channels;
     const QString searchedText;
     int maximumRecursiveQuotedText = -1;
+    // When set it's used instead of emojiManager: conversion can then run outside of main thread.
+    const std::shared_ptr<const EmojiReplacementTable> emojiReplacementTable;
+    // Used to find quoted messages instead of searching in allMessages
+    const MessageLookup messageLookup;
+    // Current color scheme when it's not set, it must be set outside of main thread
+    const std::shared_ptr<const TextColors> colors;
 };
 
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString convertMessageText(const ConvertMessageTextSettings &settings, QByteArray &needUpdateMessageId, int &recusiveIndex);
 [[nodiscard]] LIBRUQOLACORE_EXPORT QString convertMessageText(const TextConverter::ConvertMessageTextSettings &settings,
                                                               QByteArray &needUpdateMessageId,
                                                               int &recusiveIndex);
+// Same as convertMessageText() without <qt> tags around the html: fragments of a text converted separately can be concatenated
+[[nodiscard]] LIBRUQOLACORE_EXPORT QString convertMessageTextFragment(const TextConverter::ConvertMessageTextSettings &settings,
+                                                                      QByteArray &needUpdateMessageId,
+                                                                      int &recusiveIndex);
+// Rendered quoted messages are cached, call it when their rendering changes (colors...).
+// Emoji changes are part of the cache key (see EmojiManager::emojiRevision())
+LIBRUQOLACORE_EXPORT void clearQuotedTextCache();
 }
@@ -39,6 +39,14 @@ void TextHighlighter::highlight(const QString &str)
     *mStream << "</code>"_L1;
 }
 
+QString TextHighlighter::plainCode(const QString &str)
+{
+    QString escaped = str.toHtmlEscaped();
+    escaped.replace(QLatin1Char(' '), "&nbsp;"_L1);
+    escaped.replace(QLatin1Char('\n'), "<br>"_L1);
+    return "<code>"_L1 + escaped + "</code>"_L1;
+}
+
 void TextHighlighter::applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format)
 {
     if (!format.isDefaultTextStyle(theme())) {
@@ -5,11 +5,12 @@
 */
 #pragma once
 
+#include "libruqola_private_export.h"
 #include <KSyntaxHighlighting/AbstractHighlighter>
 
 class QTextStream;
 
-class TextHighlighter : public KSyntaxHighlighting::AbstractHighlighter
+class LIBRUQOLACORE_TESTS_EXPORT TextHighlighter : public KSyntaxHighlighting::AbstractHighlighter
 {
 public:
     explicit TextHighlighter(QTextStream *stream);
@@ -17,6 +18,9 @@ public:
 
     void highlight(const QString &str);
 
+    // Same markup as highlight() without any format
+    [[nodiscard]] static QString plainCode(const QString &str);
+
 protected:
     void applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format) override;
 
@@ -8,55 +8,215 @@
 #include "connection.h"
 #include "rocketchataccount.h"
 #include "ruqola_debug.h"
+#include "ruqolaglobalconfig.h"
+#include "uploadimagecompressor.h"
 
+#include <QCoreApplication>
 #include <QFile>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
 
 int UploadFileManager::uploadIdentifier = 0;
 UploadFileManager::UploadFileManager(RocketChatAccount *account, QObject *parent)
     : QObject{parent}
     , mRocketChatAccount(account)
 {
+    mCreateJobFunction = [this](QObject *parent) {
+        auto job = new RocketChatRestApi::UploadFileJob(parent);
+        mRocketChatAccount->restApi()->initializeRestApiJob(job);
+        return job;
+    };
 }
 
 UploadFileManager::~UploadFileManager() = default;
 
+void UploadFileManager::setCreateJobFunction(const CreateJobFunction &function)
+{
+    mCreateJobFunction = function;
+}
+
+std::chrono::milliseconds UploadFileManager::retryDelay() const
+{
+    return mRetryDelay;
+}
+
+void UploadFileManager::setRetryDelay(std::chrono::milliseconds delay)
+{
+    mRetryDelay = delay;
+}
+
 int UploadFileManager::addUpload(const RocketChatRestApi::UploadFileJob::UploadFileInfo &info)
 {
-    QPointer<RocketChatRestApi::UploadFileJob> job = new RocketChatRestApi::UploadFileJob(this);
-    mRocketChatAccount->restApi()->initializeRestApiJob(job);
-    job->setUploadFileInfo(info);
     uploadIdentifier++;
     const int jobIdentifier = uploadIdentifier;
+    Upload upload;
+    upload.info = info;
+    mUploads.insert(jobIdentifier, upload);
+    if (RuqolaGlobalConfig::self()->recompressUploadedImages()) {
+        // Queued when the image is compressed
+        compressImage(jobIdentifier);
+        return jobIdentifier;
+    }
+    if (runningUploadCount() < maximumParallelUploads) {
+        if (!startUpload(jobIdentifier)) {
+            qCWarning(RUQOLA_LOG) << "Impossible to start UploadFileJob job";
+            mUploads.remove(jobIdentifier);
+            return -1;
+        }
+    } else {
+        mPendingUploads.append(jobIdentifier);
+    }
+    return jobIdentifier;
+}
+
+void UploadFileManager::compressImage(int identifier)
+{
+    UploadImageCompressor::Settings settings;
+    settings.maximumSize = RuqolaGlobalConfig::self()->uploadedImageMaximumSize();
+    settings.quality = RuqolaGlobalConfig::self()->uploadedImageQuality();
+    const QString filePath = mUploads.value(identifier).info.filenameUrl.toLocalFile();
+    QPointer<UploadFileManager> guard(this);
+    QThreadPool::globalInstance()->start([guard, identifier, filePath, settings]() {
+        const QString compressedFilePath = UploadImageCompressor::compressImage(filePath, settings);
+        // guard is only dereferenced in main thread
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [guard, identifier, compressedFilePath]() {
+                if (guard) {
+                    guard->slotImageCompressed(identifier, compressedFilePath);
+                } else if (!compressedFilePath.isEmpty()) {
+                    QFile::remove(compressedFilePath);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void UploadFileManager::slotImageCompressed(int identifier, const QString &compressedFilePath)
+{
+    auto it = mUploads.find(identifier);
+    if (it == mUploads.end()) {
+        // Cancelled in between
+        if (!compressedFilePath.isEmpty()) {
+            QFile::remove(compressedFilePath);
+        }
+        return;
+    }
+    if (!compressedFilePath.isEmpty()) {
+        removeFile(it->info);
+        const QString fileName = it->info.fileName.isEmpty() ? it->info.filenameUrl.fileName() : it->info.fileName;
+        it->info.fileName = UploadImageCompressor::compressedFileName(fileName, compressedFilePath);
+        it->info.filenameUrl = QUrl::fromLocalFile(compressedFilePath);
+        it->info.deleteTemporaryFile = true;
+    }
+    mPendingUploads.append(identifier);
+    startNextUploads();
+}
+
+bool UploadFileManager::startUpload(int identifier)
+{
+    Upload &upload = mUploads[identifier];
+    auto job = mCreateJobFunction(this);
+    job->setUploadFileInfo(upload.info);
+    // rooms.media and rooms.mediaConfirm exist since RC 6.8
+    job->setUseMediaUpload(mRocketChatAccount->hasAtLeastVersion(6, 8, 0));
+    job->setUploadedFileId(upload.uploadedFileId);
+    upload.attempts++;
+    job->setRetryOnNetworkError(upload.attempts < maximumAttempts);
+    connect(job, &RocketChatRestApi::UploadFileJob::mediaUploaded, this, [this, identifier](const QByteArray &fileId) {
+        auto it = mUploads.find(identifier);
+        if (it != mUploads.end()) {
+            it->uploadedFileId = fileId;
+        }
+    });
     connect(job,
             &RocketChatRestApi::UploadFileJob::uploadProgress,
             this,
-            [this, jobIdentifier](const RocketChatRestApi::UploadFileJob::UploadStatusInfo &info) {
-                Q_EMIT uploadProgress(info, jobIdentifier, mRocketChatAccount->accountName());
+            [this, identifier](const RocketChatRestApi::UploadFileJob::UploadStatusInfo &info) {
+                // Empty progress is emitted by finishUpload(), not when an attempt is interrupted
+                if (info.bytesSent > 0 && info.bytesTotal > 0) {
+                    Q_EMIT uploadProgress(info, identifier, mRocketChatAccount->accountName());
+                }
             });
-    // Need to delete temporary file.
-    connect(job, &RocketChatRestApi::UploadFileJob::uploadFinished, this, [info, jobIdentifier, this]() {
-        if (info.deleteTemporaryFile) {
-            QFile f(info.filenameUrl.toLocalFile());
-            if (f.remove()) {
-                qCWarning(RUQOLA_LOG) << "Impossible to delete file" << f.fileName();
-            }
-        }
-        mUploadMap.remove(jobIdentifier);
+    connect(job, &RocketChatRestApi::UploadFileJob::uploadInterrupted, this, [this, identifier]() {
+        retryUpload(identifier);
     });
     if (!job->start()) {
-        qCWarning(RUQOLA_LOG) << "Impossible to start UploadFileJob job";
-        return -1;
-    } else {
-        mUploadMap.insert(uploadIdentifier, job);
-        return uploadIdentifier;
+        delete job;
+        return false;
+    }
+    // Job deletes itself when it's done, failed or aborted
+    connect(job, &QObject::destroyed, this, [this, identifier]() {
+        const auto it = mUploads.constFind(identifier);
+        if (it == mUploads.cend()) {
+            // Cancelled
+            return;
+        }
+        if (it->retryPending) {
+            startNextUploads();
+        } else {
+            finishUpload(identifier);
+        }
+    });
+    upload.job = job;
+    return true;
+}
+
+void UploadFileManager::startNextUploads()
+{
+    while (!mPendingUploads.isEmpty() && runningUploadCount() < maximumParallelUploads) {
+        const int identifier = mPendingUploads.takeFirst();
+        if (!startUpload(identifier)) {
+            qCWarning(RUQOLA_LOG) << "Impossible to start UploadFileJob job";
+            removeFile(mUploads.take(identifier).info);
+            Q_EMIT uploadProgress({}, identifier, mRocketChatAccount->accountName());
+        }
     }
 }
 
+void UploadFileManager::retryUpload(int identifier)
+{
+    auto it = mUploads.find(identifier);
+    if (it == mUploads.end()) {
+        return;
+    }
+    it->retryPending = true;
+    // Leave some time to the network to come back
+    const std::chrono::milliseconds delay = mRetryDelay * it->attempts;
+    qCWarning(RUQOLA_LOG) << "Upload not sent, it will be sent again in" << delay.count() << "ms" << it->info.filenameUrl;
+    QTimer::singleShot(delay, this, [this, identifier]() {
+        auto it = mUploads.find(identifier);
+        if (it == mUploads.end()) {
+            // Cancelled in between
+            return;
+        }
+        it->retryPending = false;
+        mPendingUploads.prepend(identifier);
+        startNextUploads();
+    });
+}
+
+void UploadFileManager::finishUpload(int identifier)
+{
+    removeFile(mUploads.take(identifier).info);
+    Q_EMIT uploadProgress({}, identifier, mRocketChatAccount->accountName());
+    startNextUploads();
+}
+
+int UploadFileManager::runningUploadCount() const
+{
+    return static_cast<int>(std::count_if(mUploads.cbegin(), mUploads.cend(), [](const Upload &upload) {
+        return !upload.job.isNull();
+    }));
+}
+
 void UploadFileManager::removeFile(const RocketChatRestApi::UploadFileJob::UploadFileInfo &info)
 {
     if (info.deleteTemporaryFile) {
         QFile f(info.filenameUrl.toLocalFile());
-        if (f.remove()) {
+        if (!f.remove()) {
             qCWarning(RUQOLA_LOG) << "Impossible to delete file" << f.fileName();
         }
     }
@@ -64,12 +224,18 @@ void UploadFileManager::removeFile(const RocketChatRestApi::UploadFileJob::Uploa
 
 void UploadFileManager::cancelJob(int identifier)
 {
-    auto job = mUploadMap.take(identifier);
+    if (!mUploads.contains(identifier)) {
+        return;
+    }
+    const Upload upload = mUploads.take(identifier);
+    mPendingUploads.removeAll(identifier);
+    removeFile(upload.info);
     // Abort will remove job too.
-    if (job) {
-        removeFile(job->uploadFileInfo());
-        job->abort();
+    if (upload.job) {
+        upload.job->abort();
     }
+    Q_EMIT uploadProgress({}, identifier, mRocketChatAccount->accountName());
+    startNextUploads();
 }
 
 #include "moc_uploadfilemanager.cpp"
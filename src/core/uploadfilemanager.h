@@ -7,26 +7,71 @@
 #pragma once
 #include "libruqolacore_export.h"
 #include "uploadfilejob.h"
+#include <QList>
 #include <QMap>
 #include <QObject>
 #include <QPointer>
+#include <chrono>
+#include <functional>
 class RocketChatAccount;
+/**
+ * Uploads are queued: a few run in parallel, the others start when one is done.
+ * An upload interrupted before its message was posted is sent again after a delay: with rooms.media
+ * the transfer of the file can be interrupted at any time, the file is then sent again from the start.
+ * When the file was stored, only rooms.mediaConfirm is sent again.
+ * When enabled, images are compressed in a thread before they are queued.
+ */
 class LIBRUQOLACORE_EXPORT UploadFileManager : public QObject
 {
     Q_OBJECT
 public:
+    // Creates the job of an upload attempt, it's started by the manager
+    using CreateJobFunction = std::function<RocketChatRestApi::UploadFileJob *(QObject *parent)>;
+
     explicit UploadFileManager(RocketChatAccount *account, QObject *parent = nullptr);
     ~UploadFileManager() override;
 
+    void setCreateJobFunction(const CreateJobFunction &function);
+
+    // Delay before sending an upload again, multiplied by the number of attempts
+    [[nodiscard]] std::chrono::milliseconds retryDelay() const;
+    void setRetryDelay(std::chrono::milliseconds delay);
+
+    // Returns -1 when the upload can't be started
     [[nodiscard]] int addUpload(const RocketChatRestApi::UploadFileJob::UploadFileInfo &info);
 
     void cancelJob(int identifier);
+
+    static constexpr int maximumParallelUploads = 2;
+    // Number of times a file is sent before giving up
+    static constexpr int maximumAttempts = 3;
+
 Q_SIGNALS:
+    // Progress with empty values when the upload is done, failed or was cancelled
     void uploadProgress(const RocketChatRestApi::UploadFileJob::UploadStatusInfo &info, int identifier, const QString &accountName);
 
 private:
+    struct Upload {
+        RocketChatRestApi::UploadFileJob::UploadFileInfo info;
+        QPointer<RocketChatRestApi::UploadFileJob> job;
+        // Stored by rooms.media, message not posted yet
+        QByteArray uploadedFileId;
+        int attempts = 0;
+        bool retryPending = false;
+    };
+    LIBRUQOLACORE_NO_EXPORT void compressImage(int identifier);
+    LIBRUQOLACORE_NO_EXPORT void slotImageCompressed(int identifier, const QString &compressedFilePath);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT bool startUpload(int identifier);
+    LIBRUQOLACORE_NO_EXPORT void startNextUploads();
+    LIBRUQOLACORE_NO_EXPORT void retryUpload(int identifier);
+    LIBRUQOLACORE_NO_EXPORT void finishUpload(int identifier);
+    [[nodiscard]] LIBRUQOLACORE_NO_EXPORT int runningUploadCount() const;
     LIBRUQOLACORE_NO_EXPORT void removeFile(const RocketChatRestApi::UploadFileJob::UploadFileInfo &info);
     RocketChatAccount *const mRocketChatAccount;
-    QMap<int, QPointer<RocketChatRestApi::UploadFileJob>> mUploadMap;
+    CreateJobFunction mCreateJobFunction;
+    std::chrono::milliseconds mRetryDelay = std::chrono::seconds(5);
+    QMap<int, Upload> mUploads;
+    // Started in this order when an upload is done
+    QList<int> mPendingUploads;
     static int uploadIdentifier;
 };
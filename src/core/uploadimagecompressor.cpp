@@ -0,0 +1,103 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "uploadimagecompressor.h"
+#include "ruqola_debug.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QTemporaryFile>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+// Other formats (gif, svg...) are sent as they are
+bool isCompressibleFormat(const QByteArray &format)
+{
+    return format == "png" || format == "jpeg" || format == "bmp" || format == "tiff" || format == "webp";
+}
+
+// Screenshots often have an alpha channel without using it
+bool hasTransparentPixels(const QImage &image)
+{
+    if (image.format() != QImage::Format_ARGB32) {
+        return false;
+    }
+    for (int y = 0; y < image.height(); ++y) {
+        const auto line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(line[x]) != 255) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+}
+
+QString UploadImageCompressor::compressImage(const QString &filePath, const Settings &settings)
+{
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+    if (!reader.canRead() || !isCompressibleFormat(reader.format()) || (reader.supportsAnimation() && reader.imageCount() > 1)) {
+        return {};
+    }
+    const QSize size = reader.size();
+    if (size.isValid() && (size.width() > settings.maximumSize || size.height() > settings.maximumSize)) {
+        reader.setScaledSize(size.scaled(settings.maximumSize, settings.maximumSize, Qt::KeepAspectRatio));
+    }
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        qCWarning(RUQOLA_LOG) << "Impossible to read image" << filePath << reader.errorString();
+        return {};
+    }
+    QImage pixels = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const bool transparent = hasTransparentPixels(pixels);
+    if (!transparent) {
+        pixels = pixels.convertToFormat(QImage::Format_RGB32);
+    }
+    // Image created from the pixels only, text keys (exif comments, png chunks) are not written again
+    QImage strippedImage(pixels.constBits(), pixels.width(), pixels.height(), pixels.bytesPerLine(), pixels.format());
+    strippedImage.setColorSpace(image.colorSpace());
+
+    QTemporaryFile tempFile(QDir::tempPath() + (transparent ? "/XXXXXX.png"_L1 : "/XXXXXX.jpg"_L1));
+    tempFile.setAutoRemove(false);
+    if (!tempFile.open()) {
+        qCWarning(RUQOLA_LOG) << "Impossible to create temporary file" << tempFile.fileName();
+        return {};
+    }
+    QImageWriter writer(&tempFile, transparent ? QByteArrayLiteral("png") : QByteArrayLiteral("jpeg"));
+    if (!transparent) {
+        writer.setQuality(settings.quality);
+        writer.setOptimizedWrite(true);
+    }
+    if (!writer.write(strippedImage)) {
+        qCWarning(RUQOLA_LOG) << "Impossible to compress image" << filePath << writer.errorString();
+        tempFile.remove();
+        return {};
+    }
+    tempFile.close();
+    if (tempFile.size() >= QFileInfo(filePath).size()) {
+        tempFile.remove();
+        return {};
+    }
+    return tempFile.fileName();
+}
+
+QString UploadImageCompressor::compressedFileName(const QString &fileName, const QString &compressedFilePath)
+{
+    const QFileInfo fileInfo(fileName);
+    const QString suffix = QFileInfo(compressedFilePath).suffix();
+    const QString originalSuffix = fileInfo.suffix().toLower();
+    if (originalSuffix == suffix || (suffix == "jpg"_L1 && originalSuffix == "jpeg"_L1)) {
+        return fileName;
+    }
+    return fileInfo.completeBaseName() + u'.' + suffix;
+}
@@ -0,0 +1,34 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqola_private_export.h"
+#include <QString>
+
+/**
+ * Makes images smaller before they are uploaded: they are downscaled to a maximum size
+ * and encoded again (JPEG when opaque, PNG otherwise), without their metadata.
+ * Can be used from any thread.
+ */
+namespace UploadImageCompressor
+{
+struct LIBRUQOLACORE_TESTS_EXPORT Settings {
+    // Maximum width and height, in pixels
+    int maximumSize = 2048;
+    // JPEG quality
+    int quality = 85;
+};
+
+/**
+ * Returns the path of a new temporary file, or an empty string when @p filePath is kept:
+ * not an image, animated, or the compressed file isn't smaller.
+ */
+[[nodiscard]] LIBRUQOLACORE_TESTS_EXPORT QString compressImage(const QString &filePath, const Settings &settings);
+
+// File name to send for the compressed file, with the suffix of @p compressedFilePath
+[[nodiscard]] LIBRUQOLACORE_TESTS_EXPORT QString compressedFileName(const QString &fileName, const QString &compressedFilePath);
+}
@@ -46,8 +46,11 @@ QString Utils::extractRoomUserFromUrl(QString url)
 QString Utils::formatQuotedRichText(const QuotedRichTextInfo &info)
 {
     // Qt's support for borders is limited to tables, so we have to jump through some hoops...
-    const auto backgroundColor = ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::AlternateBackground).color().name();
-    const auto borderColor = ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::LinkText).color().name();
+    const auto backgroundColor = info.backgroundColor.isEmpty()
+        ? ColorsAndMessageViewStyle::self().schemeView().background(KColorScheme::AlternateBackground).color().name()
+        : info.backgroundColor;
+    const auto borderColor =
+        info.borderColor.isEmpty() ? ColorsAndMessageViewStyle::self().schemeView().foreground(KColorScheme::LinkText).color().name() : info.borderColor;
     QString dateTimeInfo;
     if (!info.displayTime.isEmpty()) {
         if (!info.url.isEmpty()) {
@@ -30,6 +30,9 @@ struct LIBRUQOLACORE_EXPORT QuotedRichTextInfo {
     QString richText;
     QString url;
     QString displayTime;
+    // Colors of the current scheme when they are empty
+    QString backgroundColor;
+    QString borderColor;
 };
 
 [[nodiscard]] LIBRUQOLACORE_TESTS_EXPORT QUrl generateServerUrl(const QString &url);
@@ -20,6 +20,7 @@ void DirectoryJobTest::shouldHaveDefaultValue()
     DirectoryJob job;
     verifyDefaultValue(&job);
     QVERIFY(job.requireHttpAuthentication());
+    QVERIFY(job.useResponseCache());
     QVERIFY(job.hasQueryParameterSupport());
     QVERIFY(!job.requireTwoFactorAuthentication());
 }
@@ -6,9 +6,149 @@
 
 #include "downloadfilejobtest.h"
 #include "downloadfilejob.h"
+#include "restapimethod.h"
+#include <QDir>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
+
+#include <cstring>
 QTEST_GUILESS_MAIN(DownloadFileJobTest)
 using namespace RocketChatRestApi;
+
+namespace
+{
+// Data is received when the test calls receive()
+class FakeReply : public QNetworkReply
+{
+public:
+    explicit FakeReply(const QNetworkRequest &request, QObject *parent)
+        : QNetworkReply(parent)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(QNetworkAccessManager::GetOperation);
+        open(QIODevice::ReadOnly);
+    }
+    void abort() override
+    {
+        if (isFinished()) {
+            return;
+        }
+        setError(QNetworkReply::OperationCanceledError, QStringLiteral("Canceled"));
+        finish();
+    }
+    void setStatus(int statusCode, const QList<std::pair<QByteArray, QByteArray>> &headers = {})
+    {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, statusCode);
+        for (const auto &header : headers) {
+            setRawHeader(header.first, header.second);
+        }
+        if (statusCode >= 400) {
+            setError(QNetworkReply::ContentNotFoundError, QStringLiteral("Error"));
+        }
+        Q_EMIT metaDataChanged();
+    }
+    void receive(const QByteArray &data)
+    {
+        mData += data;
+        Q_EMIT readyRead();
+    }
+    void finish()
+    {
+        setFinished(true);
+        Q_EMIT finished();
+    }
+    void interrupt()
+    {
+        setError(QNetworkReply::RemoteHostClosedError, QStringLiteral("Closed"));
+        finish();
+    }
+    [[nodiscard]] qint64 bytesAvailable() const override
+    {
+        return mData.size() - mOffset + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (mOffset >= mData.size()) {
+            return isFinished() ? -1 : 0;
+        }
+        const qint64 size = qMin<qint64>(maxSize, mData.size() - mOffset);
+        std::memcpy(data, mData.constData() + mOffset, size);
+        mOffset += size;
+        return size;
+    }
+
+private:
+    QByteArray mData;
+    qint64 mOffset = 0;
+};
+
+class FakeNetworkAccessManager : public QNetworkAccessManager
+{
+public:
+    QList<FakeReply *> replies;
+
+protected:
+    QNetworkReply *createRequest(Operation, const QNetworkRequest &request, QIODevice *) override
+    {
+        auto reply = new FakeReply(request, this);
+        replies.append(reply);
+        return reply;
+    }
+};
+
+class DownloadEnvironment
+{
+public:
+    DownloadEnvironment()
+    {
+        method.setServerUrl(QStringLiteral("http://www.kde.org"));
+        filePath = dir.filePath(QStringLiteral("cache/foo.png"));
+    }
+    DownloadFileJob *createJob()
+    {
+        auto job = new DownloadFileJob;
+        job->setNetworkAccessManager(&networkAccessManager);
+        job->setRestApiMethod(&method);
+        job->setRequiredAuthentication(false);
+        job->setUrl(QUrl(QStringLiteral("http://www.kde.org/file-upload/foo.png")));
+        job->setLocalFileUrl(QUrl::fromLocalFile(filePath));
+        return job;
+    }
+    // Left by a previous attempt
+    [[nodiscard]] bool createPartialFile(const QByteArray &data, const QByteArray &validator)
+    {
+        if (!QDir().mkpath(dir.filePath(QStringLiteral("cache")))) {
+            return false;
+        }
+        QFile partialFile(DownloadFileJob::partialFilePath(filePath));
+        if (!partialFile.open(QIODevice::WriteOnly) || partialFile.write(data) != data.size()) {
+            return false;
+        }
+        if (validator.isEmpty()) {
+            return true;
+        }
+        QFile validatorFile(DownloadFileJob::partialValidatorFilePath(filePath));
+        return validatorFile.open(QIODevice::WriteOnly) && validatorFile.write(validator) == validator.size();
+    }
+    [[nodiscard]] static QByteArray fileContent(const QString &path)
+    {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    QTemporaryDir dir;
+    QString filePath;
+    FakeNetworkAccessManager networkAccessManager;
+    RestApiMethod method;
+};
+}
 DownloadFileJobTest::DownloadFileJobTest(QObject *parent)
     : QObject(parent)
 {
@@ -16,8 +156,220 @@ DownloadFileJobTest::DownloadFileJobTest(QObject *parent)
 
 void DownloadFileJobTest::shouldHaveDefaultValue()
 {
+    DownloadFileJob job;
+    QVERIFY(job.url().isEmpty());
+    QVERIFY(job.localFileUrl().isEmpty());
+    QVERIFY(job.mimeType().isEmpty());
+    QVERIFY(job.requiredAuthentication());
     // TODO
     // QVERIFY(!job.hasQueryParameterSupport());
 }
 
+void DownloadFileJobTest::shouldGeneratePartialFilePath()
+{
+    QCOMPARE(DownloadFileJob::partialFilePath(QStringLiteral("/tmp/cache/foo.png")), QStringLiteral("/tmp/cache/foo.png.part"));
+    QCOMPARE(DownloadFileJob::partialValidatorFilePath(QStringLiteral("/tmp/cache/foo.png")), QStringLiteral("/tmp/cache/foo.png.part.validator"));
+}
+
+void DownloadFileJobTest::shouldParseContentRange_data()
+{
+    QTest::addColumn<QByteArray>("contentRange");
+    QTest::addColumn<qint64>("start");
+    QTest::newRow("range") << QByteArrayLiteral("bytes 100-199/200") << qint64(100);
+    QTest::newRow("unknown-length") << QByteArrayLiteral("bytes 0-99/*") << qint64(0);
+    QTest::newRow("empty") << QByteArray() << qint64(-1);
+    QTest::newRow("unsatisfied") << QByteArrayLiteral("bytes */200") << qint64(-1);
+    QTest::newRow("other-unit") << QByteArrayLiteral("items 1-2/3") << qint64(-1);
+}
+
+void DownloadFileJobTest::shouldParseContentRange()
+{
+    QFETCH(QByteArray, contentRange);
+    QFETCH(qint64, start);
+    QCOMPARE(DownloadFileJob::contentRangeStart(contentRange), start);
+}
+
+void DownloadFileJobTest::shouldRenameCompleteDownload()
+{
+    DownloadEnvironment environment;
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    QCOMPARE(environment.networkAccessManager.replies.count(), 1);
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    QVERIFY(reply->request().rawHeader(QByteArrayLiteral("Range")).isEmpty());
+
+    reply->setStatus(200, {{QByteArrayLiteral("ETag"), QByteArrayLiteral("\"abc\"")}});
+    reply->receive(QByteArrayLiteral("hel"));
+    // Not complete yet
+    QVERIFY(!QFile::exists(environment.filePath));
+    QCOMPARE(DownloadEnvironment::fileContent(DownloadFileJob::partialValidatorFilePath(environment.filePath)), QByteArrayLiteral("\"abc\""));
+
+    reply->receive(QByteArrayLiteral("lo"));
+    reply->finish();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialValidatorFilePath(environment.filePath)));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldKeepPartialFileOfInterruptedDownload()
+{
+    DownloadEnvironment environment;
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    reply->setStatus(200, {{QByteArrayLiteral("ETag"), QByteArrayLiteral("W/\"weak\"")}, {QByteArrayLiteral("Last-Modified"), QByteArrayLiteral("Wed, 21 Oct 2015 07:28:00 GMT")}});
+    reply->receive(QByteArrayLiteral("hel"));
+    reply->interrupt();
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!QFile::exists(environment.filePath));
+    QCOMPARE(DownloadEnvironment::fileContent(DownloadFileJob::partialFilePath(environment.filePath)), QByteArrayLiteral("hel"));
+    // Weak ETag can't be used in If-Range
+    QCOMPARE(DownloadEnvironment::fileContent(DownloadFileJob::partialValidatorFilePath(environment.filePath)),
+             QByteArrayLiteral("Wed, 21 Oct 2015 07:28:00 GMT"));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldRemoveUnresumablePartialFile()
+{
+    DownloadEnvironment environment;
+    DownloadFileJob *job = environment.createJob();
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    // Neither ETag nor Last-Modified: download can't be resumed
+    reply->setStatus(200);
+    reply->receive(QByteArrayLiteral("hel"));
+    QVERIFY(QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    reply->interrupt();
+    QVERIFY(!QFile::exists(environment.filePath));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialValidatorFilePath(environment.filePath)));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldReplaceExistingFile()
+{
+    DownloadEnvironment environment;
+    QVERIFY(QDir().mkpath(environment.dir.filePath(QStringLiteral("cache"))));
+    {
+        QFile file(environment.filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(QByteArrayLiteral("old")), 3);
+    }
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    reply->setStatus(200);
+    reply->receive(QByteArrayLiteral("hello"));
+    reply->finish();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldResumeDownload()
+{
+    DownloadEnvironment environment;
+    QVERIFY(environment.createPartialFile(QByteArrayLiteral("hel"), QByteArrayLiteral("\"abc\"")));
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    QCOMPARE(reply->request().rawHeader(QByteArrayLiteral("Range")), QByteArrayLiteral("bytes=3-"));
+    QCOMPARE(reply->request().rawHeader(QByteArrayLiteral("If-Range")), QByteArrayLiteral("\"abc\""));
+
+    reply->setStatus(206, {{QByteArrayLiteral("Content-Range"), QByteArrayLiteral("bytes 3-4/5")}});
+    reply->receive(QByteArrayLiteral("lo"));
+    reply->finish();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialValidatorFilePath(environment.filePath)));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldNotResumeWithoutValidator()
+{
+    DownloadEnvironment environment;
+    QVERIFY(environment.createPartialFile(QByteArrayLiteral("hel"), QByteArray()));
+    DownloadFileJob *job = environment.createJob();
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    QVERIFY(reply->request().rawHeader(QByteArrayLiteral("Range")).isEmpty());
+    QVERIFY(reply->request().rawHeader(QByteArrayLiteral("If-Range")).isEmpty());
+
+    reply->setStatus(200);
+    reply->receive(QByteArrayLiteral("hello"));
+    reply->finish();
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldDownloadWholeChangedFile()
+{
+    DownloadEnvironment environment;
+    QVERIFY(environment.createPartialFile(QByteArrayLiteral("old"), QByteArrayLiteral("\"old\"")));
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+
+    // If-Range doesn't match: whole file is sent
+    reply->setStatus(200, {{QByteArrayLiteral("ETag"), QByteArrayLiteral("\"new\"")}});
+    reply->receive(QByteArrayLiteral("hello"));
+    QCOMPARE(DownloadEnvironment::fileContent(DownloadFileJob::partialValidatorFilePath(environment.filePath)), QByteArrayLiteral("\"new\""));
+    reply->finish();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldRestartOnUnexpectedRange()
+{
+    DownloadEnvironment environment;
+    QVERIFY(environment.createPartialFile(QByteArrayLiteral("hel"), QByteArrayLiteral("\"abc\"")));
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+
+    reply->setStatus(206, {{QByteArrayLiteral("Content-Range"), QByteArrayLiteral("bytes 1-4/5")}});
+    reply->receive(QByteArrayLiteral("ello"));
+    // Sent again without range
+    QCOMPARE(environment.networkAccessManager.replies.count(), 2);
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    FakeReply *newReply = environment.networkAccessManager.replies.constLast();
+    QVERIFY(newReply->request().rawHeader(QByteArrayLiteral("Range")).isEmpty());
+    QVERIFY(newReply->request().rawHeader(QByteArrayLiteral("If-Range")).isEmpty());
+
+    newReply->setStatus(200);
+    newReply->receive(QByteArrayLiteral("hello"));
+    newReply->finish();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(DownloadEnvironment::fileContent(environment.filePath), QByteArrayLiteral("hello"));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void DownloadFileJobTest::shouldRemovePartialFileWhenRangeNotSatisfiable()
+{
+    DownloadEnvironment environment;
+    QVERIFY(environment.createPartialFile(QByteArrayLiteral("hello!"), QByteArrayLiteral("\"abc\"")));
+    DownloadFileJob *job = environment.createJob();
+    QSignalSpy spy(job, &DownloadFileJob::downloadFileDone);
+    QVERIFY(job->start());
+    FakeReply *reply = environment.networkAccessManager.replies.constFirst();
+    reply->setStatus(416);
+    reply->finish();
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!QFile::exists(environment.filePath));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialFilePath(environment.filePath)));
+    QVERIFY(!QFile::exists(DownloadFileJob::partialValidatorFilePath(environment.filePath)));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
 #include "moc_downloadfilejobtest.cpp"
@@ -16,4 +16,16 @@ public:
     ~DownloadFileJobTest() override = default;
 private Q_SLOTS:
     void shouldHaveDefaultValue();
+    void shouldGeneratePartialFilePath();
+    void shouldParseContentRange_data();
+    void shouldParseContentRange();
+    void shouldRenameCompleteDownload();
+    void shouldKeepPartialFileOfInterruptedDownload();
+    void shouldRemoveUnresumablePartialFile();
+    void shouldReplaceExistingFile();
+    void shouldResumeDownload();
+    void shouldNotResumeWithoutValidator();
+    void shouldDownloadWholeChangedFile();
+    void shouldRestartOnUnexpectedRange();
+    void shouldRemovePartialFileWhenRangeNotSatisfiable();
 };
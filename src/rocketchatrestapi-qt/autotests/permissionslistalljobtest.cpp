@@ -20,6 +20,7 @@ void PermissionsListAllJobTest::shouldHaveDefaultValue()
     PermissionsListAllJob job;
     verifyDefaultValue(&job);
     QVERIFY(job.requireHttpAuthentication());
+    QVERIFY(job.useResponseCache());
     QVERIFY(!job.hasQueryParameterSupport());
 }
 
@@ -22,6 +22,7 @@ void PrivateInfoJobTest::shouldHaveDefaultValue()
     QVERIFY(!job.networkAccessManager());
     QVERIFY(!job.start());
     QVERIFY(job.requireHttpAuthentication());
+    QVERIFY(job.useResponseCache());
     QVERIFY(job.authToken().isEmpty());
     QVERIFY(job.authCode().isEmpty());
     QVERIFY(job.authMethod().isEmpty());
@@ -21,6 +21,7 @@ void PublicSettingsJobTest::shouldHaveDefaultValue()
     QVERIFY(!job.networkAccessManager());
     QVERIFY(!job.start());
     QVERIFY(!job.requireHttpAuthentication());
+    QVERIFY(job.useResponseCache());
     QVERIFY(job.authToken().isEmpty());
     QVERIFY(job.authCode().isEmpty());
     QVERIFY(job.authMethod().isEmpty());
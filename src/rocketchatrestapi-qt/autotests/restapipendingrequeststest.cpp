@@ -0,0 +1,299 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "restapipendingrequeststest.h"
+#include "misc/roleslistjob.h"
+#include "restapimethod.h"
+#include "restapipendingrequests.h"
+#include "restapiresponsecache.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+QTEST_GUILESS_MAIN(RestApiPendingRequestsTest)
+using namespace RocketChatRestApi;
+
+namespace
+{
+QNetworkRequest createRequest(const QString &url, const QByteArray &userId)
+{
+    QNetworkRequest request{QUrl(url)};
+    request.setRawHeader(QByteArrayLiteral("X-User-Id"), userId);
+    return request;
+}
+
+QByteArray requestKey(const QString &url, const QByteArray &userId)
+{
+    return RestApiPendingRequests::key(QByteArrayLiteral("RocketChatRestApi::UsersInfoJob"), nullptr, createRequest(url, userId));
+}
+
+class FakeReply : public QNetworkReply
+{
+public:
+    explicit FakeReply(const QNetworkRequest &request, QObject *parent = nullptr)
+        : QNetworkReply(parent)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(QNetworkAccessManager::GetOperation);
+        open(QIODevice::ReadOnly);
+    }
+    void abort() override
+    {
+    }
+    void finish(int statusCode = 200, const QByteArray &data = {}, const QByteArray &etag = {})
+    {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, statusCode);
+        if (!etag.isEmpty()) {
+            setRawHeader(QByteArrayLiteral("ETag"), etag);
+        }
+        if (statusCode >= 400) {
+            setError(QNetworkReply::ContentAccessDenied, QStringLiteral("Forbidden"));
+        }
+        mData = data;
+        setFinished(true);
+        Q_EMIT finished();
+    }
+    [[nodiscard]] qint64 bytesAvailable() const override
+    {
+        return mData.size() - mOffset + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (mOffset >= mData.size()) {
+            return isFinished() ? -1 : 0;
+        }
+        const qint64 size = qMin<qint64>(maxSize, mData.size() - mOffset);
+        std::memcpy(data, mData.constData() + mOffset, size);
+        mOffset += size;
+        return size;
+    }
+
+private:
+    QByteArray mData;
+    qint64 mOffset = 0;
+};
+
+class FakeNetworkAccessManager : public QNetworkAccessManager
+{
+public:
+    QList<FakeReply *> replies;
+
+protected:
+    QNetworkReply *createRequest(Operation, const QNetworkRequest &request, QIODevice *) override
+    {
+        auto reply = new FakeReply(request, this);
+        replies.append(reply);
+        return reply;
+    }
+};
+
+class SharedRequestEnvironment
+{
+public:
+    SharedRequestEnvironment()
+        : responseCache(cacheDir.path())
+    {
+        method.setServerUrl(QStringLiteral("http://www.kde.org"));
+    }
+    RolesListJob *createJob()
+    {
+        auto job = new RolesListJob;
+        job->setNetworkAccessManager(&networkAccessManager);
+        job->setRestApiMethod(&method);
+        job->setAuthToken(QStringLiteral("token"));
+        job->setUserId(QStringLiteral("user1"));
+        job->setResponseCache(&responseCache);
+        job->setPendingRequests(&pendingRequests);
+        return job;
+    }
+
+    QTemporaryDir cacheDir;
+    FakeNetworkAccessManager networkAccessManager;
+    RestApiMethod method;
+    RestApiResponseCache responseCache;
+    RestApiPendingRequests pendingRequests;
+};
+}
+
+RestApiPendingRequestsTest::RestApiPendingRequestsTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void RestApiPendingRequestsTest::shouldHaveDefaultValues()
+{
+    const RestApiPendingRequests pendingRequests;
+    QCOMPARE(pendingRequests.count(), 0);
+    QVERIFY(!pendingRequests.reply(requestKey(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user1")));
+}
+
+void RestApiPendingRequestsTest::shouldShareRunningRequest()
+{
+    RestApiPendingRequests pendingRequests;
+    const QNetworkRequest request = createRequest(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user1");
+    FakeReply reply(request);
+    pendingRequests.insert(requestKey(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user1"), &reply);
+    QCOMPARE(pendingRequests.count(), 1);
+
+    QCOMPARE(pendingRequests.reply(requestKey(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user1")), &reply);
+    // Other query
+    QVERIFY(!pendingRequests.reply(requestKey(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=bla"), "user1")));
+    // Other user
+    QVERIFY(!pendingRequests.reply(requestKey(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user2")));
+}
+
+void RestApiPendingRequestsTest::shouldDependOnJobAndHeaders()
+{
+    const QByteArray className = QByteArrayLiteral("RocketChatRestApi::UsersInfoJob");
+    const QNetworkRequest request = createRequest(QStringLiteral("http://www.kde.org/api/v1/users.info?userId=foo"), "user1");
+    QCOMPARE(RestApiPendingRequests::key(className, nullptr, request), RestApiPendingRequests::key(className, nullptr, request));
+
+    // Other job class
+    QVERIFY(RestApiPendingRequests::key(className, nullptr, request)
+            != RestApiPendingRequests::key(QByteArrayLiteral("RocketChatRestApi::GetAvatarJob"), nullptr, request));
+
+    // Other response cache
+    QTemporaryDir dir;
+    const RestApiResponseCache cache(dir.path());
+    QVERIFY(RestApiPendingRequests::key(className, nullptr, request) != RestApiPendingRequests::key(className, &cache, request));
+
+    // Two factor authentication
+    QNetworkRequest twoFactorRequest = request;
+    twoFactorRequest.setRawHeader(QByteArrayLiteral("x-2fa-code"), QByteArrayLiteral("123456"));
+    twoFactorRequest.setRawHeader(QByteArrayLiteral("x-2fa-method"), QByteArrayLiteral("totp"));
+    QVERIFY(RestApiPendingRequests::key(className, nullptr, request) != RestApiPendingRequests::key(className, nullptr, twoFactorRequest));
+    QNetworkRequest otherCodeRequest = twoFactorRequest;
+    otherCodeRequest.setRawHeader(QByteArrayLiteral("x-2fa-code"), QByteArrayLiteral("654321"));
+    QVERIFY(RestApiPendingRequests::key(className, nullptr, twoFactorRequest) != RestApiPendingRequests::key(className, nullptr, otherCodeRequest));
+}
+
+void RestApiPendingRequestsTest::shouldRemoveFinishedRequest()
+{
+    RestApiPendingRequests pendingRequests;
+    const QNetworkRequest request = createRequest(QStringLiteral("http://www.kde.org/api/v1/rooms.info?roomId=foo"), "user1");
+    const QByteArray key = requestKey(QStringLiteral("http://www.kde.org/api/v1/rooms.info?roomId=foo"), "user1");
+    FakeReply reply(request);
+    pendingRequests.insert(key, &reply);
+    reply.finish();
+    QCOMPARE(pendingRequests.count(), 0);
+    QVERIFY(!pendingRequests.reply(key));
+
+    // Same request sent again
+    FakeReply newReply(request);
+    pendingRequests.insert(key, &newReply);
+    QCOMPARE(pendingRequests.reply(key), &newReply);
+}
+
+void RestApiPendingRequestsTest::shouldRemoveDeletedRequest()
+{
+    RestApiPendingRequests pendingRequests;
+    const QNetworkRequest request = createRequest(QStringLiteral("http://www.kde.org/api/v1/rooms.info?roomId=foo"), "user1");
+    const QByteArray key = requestKey(QStringLiteral("http://www.kde.org/api/v1/rooms.info?roomId=foo"), "user1");
+    auto reply = new FakeReply(request);
+    pendingRequests.insert(key, reply);
+    delete reply;
+    QCOMPARE(pendingRequests.count(), 0);
+    QVERIFY(!pendingRequests.reply(key));
+}
+
+void RestApiPendingRequestsTest::shouldShareReplyBetweenJobs()
+{
+    SharedRequestEnvironment environment;
+    RolesListJob *job1 = environment.createJob();
+    RolesListJob *job2 = environment.createJob();
+    QSignalSpy spy1(job1, &RolesListJob::rolesListDone);
+    QSignalSpy spy2(job2, &RolesListJob::rolesListDone);
+    QVERIFY(job1->start());
+    QVERIFY(job2->start());
+    QCOMPARE(environment.networkAccessManager.replies.count(), 1);
+
+    const QByteArray data = QByteArrayLiteral("{\"roles\":[{\"_id\":\"admin\"}],\"success\":true}");
+    environment.networkAccessManager.replies.constFirst()->finish(200, data, QByteArrayLiteral("\"1\""));
+    QCOMPARE(spy1.count(), 1);
+    QCOMPARE(spy2.count(), 1);
+    QCOMPARE(spy1.at(0).at(0).toJsonObject(), QJsonDocument::fromJson(data).object());
+    QCOMPARE(spy2.at(0).at(0).toJsonObject(), QJsonDocument::fromJson(data).object());
+    QCOMPARE(environment.pendingRequests.count(), 0);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    // Next request is revalidated
+    RolesListJob *job3 = environment.createJob();
+    QVERIFY(job3->start());
+    QCOMPARE(environment.networkAccessManager.replies.count(), 2);
+    QCOMPARE(environment.networkAccessManager.replies.constLast()->request().rawHeader(QByteArrayLiteral("If-None-Match")), QByteArrayLiteral("\"1\""));
+    environment.networkAccessManager.replies.constLast()->finish(304);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void RestApiPendingRequestsTest::shouldShareNotModifiedReply()
+{
+    SharedRequestEnvironment environment;
+    const QByteArray data = QByteArrayLiteral("{\"roles\":[{\"_id\":\"user\"}],\"success\":true}");
+    {
+        RolesListJob job;
+        job.setRestApiMethod(&environment.method);
+        job.setAuthToken(QStringLiteral("token"));
+        job.setUserId(QStringLiteral("user1"));
+        RestApiResponseCache::Response response;
+        response.etag = QByteArrayLiteral("\"2\"");
+        response.data = data;
+        environment.responseCache.insert(job.request(), response);
+    }
+
+    RolesListJob *job1 = environment.createJob();
+    RolesListJob *job2 = environment.createJob();
+    RolesListJob *job3 = environment.createJob();
+    QSignalSpy spy2(job2, &RolesListJob::rolesListDone);
+    QSignalSpy spy3(job3, &RolesListJob::rolesListDone);
+    QVERIFY(job1->start());
+    QVERIFY(job2->start());
+    QVERIFY(job3->start());
+    QCOMPARE(environment.networkAccessManager.replies.count(), 1);
+    // Job which sent the request is deleted before it's finished
+    delete job1;
+
+    environment.networkAccessManager.replies.constFirst()->finish(304);
+    QCOMPARE(spy2.count(), 1);
+    QCOMPARE(spy3.count(), 1);
+    QCOMPARE(spy2.at(0).at(0).toJsonObject(), QJsonDocument::fromJson(data).object());
+    QCOMPARE(spy3.at(0).at(0).toJsonObject(), QJsonDocument::fromJson(data).object());
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void RestApiPendingRequestsTest::shouldShareErrorReply()
+{
+    SharedRequestEnvironment environment;
+    RolesListJob *job1 = environment.createJob();
+    RolesListJob *job2 = environment.createJob();
+    QSignalSpy doneSpy1(job1, &RolesListJob::rolesListDone);
+    QSignalSpy doneSpy2(job2, &RolesListJob::rolesListDone);
+    QSignalSpy failedSpy1(job1, &RolesListJob::failed);
+    QSignalSpy failedSpy2(job2, &RolesListJob::failed);
+    QVERIFY(job1->start());
+    QVERIFY(job2->start());
+    QCOMPARE(environment.networkAccessManager.replies.count(), 1);
+
+    environment.networkAccessManager.replies.constFirst()->finish(403, QByteArrayLiteral("{\"success\":false,\"error\":\"forbidden\"}"));
+    QCOMPARE(doneSpy1.count(), 0);
+    QCOMPARE(doneSpy2.count(), 0);
+    QCOMPARE(failedSpy1.count(), 1);
+    QCOMPARE(failedSpy2.count(), 1);
+    QCOMPARE(failedSpy1.at(0).at(0).toString(), failedSpy2.at(0).at(0).toString());
+    // Error isn't cached
+    QVERIFY(!environment.responseCache.response(environment.networkAccessManager.replies.constFirst()->request()).isValid());
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+#include "moc_restapipendingrequeststest.cpp"
@@ -0,0 +1,26 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class RestApiPendingRequestsTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RestApiPendingRequestsTest(QObject *parent = nullptr);
+    ~RestApiPendingRequestsTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldShareRunningRequest();
+    void shouldDependOnJobAndHeaders();
+    void shouldRemoveFinishedRequest();
+    void shouldRemoveDeletedRequest();
+    void shouldShareReplyBetweenJobs();
+    void shouldShareNotModifiedReply();
+    void shouldShareErrorReply();
+};
@@ -0,0 +1,108 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "restapiresponsecachetest.h"
+#include "restapiresponsecache.h"
+#include <QNetworkRequest>
+#include <QTemporaryDir>
+#include <QTest>
+QTEST_GUILESS_MAIN(RestApiResponseCacheTest)
+using namespace RocketChatRestApi;
+
+static QNetworkRequest cachedRequest(const QByteArray &userId)
+{
+    QNetworkRequest request(QUrl(QStringLiteral("http://www.kde.org/api/v1/permissions.listAll")));
+    request.setRawHeader(QByteArrayLiteral("X-User-Id"), userId);
+    return request;
+}
+
+RestApiResponseCacheTest::RestApiResponseCacheTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void RestApiResponseCacheTest::shouldHaveDefaultValues()
+{
+    const RestApiResponseCache::Response response;
+    QVERIFY(response.etag.isEmpty());
+    QVERIFY(response.lastModified.isEmpty());
+    QVERIFY(response.data.isEmpty());
+    QVERIFY(!response.isValid());
+
+    QTemporaryDir dir;
+    RestApiResponseCache cache(dir.path());
+    QCOMPARE(cache.cacheDirectory(), dir.path());
+    QVERIFY(!cache.response(cachedRequest("user")).isValid());
+}
+
+void RestApiResponseCacheTest::shouldStoreResponse()
+{
+    QTemporaryDir dir;
+    RestApiResponseCache cache(dir.path());
+    RestApiResponseCache::Response response;
+    response.etag = QByteArrayLiteral("W/\"1234\"");
+    response.data = QByteArrayLiteral("{\"success\":true}");
+    cache.insert(cachedRequest("user"), response);
+
+    RestApiResponseCache::Response storedResponse = cache.response(cachedRequest("user"));
+    QVERIFY(storedResponse.isValid());
+    QCOMPARE(storedResponse.etag, response.etag);
+    QVERIFY(storedResponse.lastModified.isEmpty());
+    QCOMPARE(storedResponse.data, response.data);
+
+    // Still stored after restart
+    RestApiResponseCache newCache(dir.path());
+    QCOMPARE(newCache.response(cachedRequest("user")).data, response.data);
+
+    newCache.remove(cachedRequest("user"));
+    QVERIFY(!newCache.response(cachedRequest("user")).isValid());
+}
+
+void RestApiResponseCacheTest::shouldNotStoreResponseWithoutValidators()
+{
+    QTemporaryDir dir;
+    RestApiResponseCache cache(dir.path());
+    RestApiResponseCache::Response response;
+    response.lastModified = QByteArrayLiteral("Wed, 21 Oct 2015 07:28:00 GMT");
+    response.data = QByteArrayLiteral("{\"success\":true}");
+    cache.insert(cachedRequest("user"), response);
+    QVERIFY(cache.response(cachedRequest("user")).isValid());
+
+    // Content changed and can't be revalidated anymore
+    response.lastModified.clear();
+    cache.insert(cachedRequest("user"), response);
+    QVERIFY(!cache.response(cachedRequest("user")).isValid());
+}
+
+void RestApiResponseCacheTest::shouldStoreResponsePerUser()
+{
+    QTemporaryDir dir;
+    RestApiResponseCache cache(dir.path());
+    RestApiResponseCache::Response response;
+    response.etag = QByteArrayLiteral("\"1\"");
+    response.data = QByteArrayLiteral("foo");
+    cache.insert(cachedRequest("user"), response);
+
+    QVERIFY(cache.response(cachedRequest("user")).isValid());
+    QVERIFY(!cache.response(cachedRequest("otheruser")).isValid());
+}
+
+void RestApiResponseCacheTest::shouldAddValidators()
+{
+    QNetworkRequest request = cachedRequest("user");
+    RestApiResponseCache::addValidators(request, {});
+    QVERIFY(!request.hasRawHeader(QByteArrayLiteral("If-None-Match")));
+    QVERIFY(!request.hasRawHeader(QByteArrayLiteral("If-Modified-Since")));
+
+    RestApiResponseCache::Response response;
+    response.etag = QByteArrayLiteral("\"1\"");
+    response.lastModified = QByteArrayLiteral("Wed, 21 Oct 2015 07:28:00 GMT");
+    RestApiResponseCache::addValidators(request, response);
+    QCOMPARE(request.rawHeader(QByteArrayLiteral("If-None-Match")), response.etag);
+    QCOMPARE(request.rawHeader(QByteArrayLiteral("If-Modified-Since")), response.lastModified);
+}
+
+#include "moc_restapiresponsecachetest.cpp"
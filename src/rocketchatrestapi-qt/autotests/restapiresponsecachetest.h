@@ -0,0 +1,23 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class RestApiResponseCacheTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RestApiResponseCacheTest(QObject *parent = nullptr);
+    ~RestApiResponseCacheTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldStoreResponse();
+    void shouldNotStoreResponseWithoutValidators();
+    void shouldStoreResponsePerUser();
+    void shouldAddValidators();
+};
@@ -36,4 +36,6 @@ void verifyDefaultValue(RestApiAbstractJob *job)
     QVERIFY(job->authToken().isEmpty());
     QVERIFY(job->userId().isEmpty());
     QVERIFY(!job->restApiLogger());
+    QVERIFY(!job->responseCache());
+    QVERIFY(!job->pendingRequests());
 }
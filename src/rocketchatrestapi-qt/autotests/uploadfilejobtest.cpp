@@ -31,6 +31,9 @@ void UploadFileJobTest::shouldHaveDefaultValue()
     QVERIFY(job.userId().isEmpty());
     QVERIFY(!job.hasQueryParameterSupport());
     QVERIFY(!job.requireTwoFactorAuthentication());
+    QVERIFY(!job.retryOnNetworkError());
+    QVERIFY(!job.useMediaUpload());
+    QVERIFY(job.uploadedFileId().isEmpty());
 
     UploadFileJob::UploadFileInfo info;
     QVERIFY(info.filenameUrl.isEmpty());
@@ -50,6 +53,23 @@ void UploadFileJobTest::shouldGenerateRequest()
     QCOMPARE(request.url(), QUrl(QStringLiteral("http://www.kde.org/api/v1/rooms.upload")));
 }
 
+void UploadFileJobTest::shouldGenerateMediaRequest()
+{
+    UploadFileJob job;
+    UploadFileJob::UploadFileInfo info;
+    info.roomId = QByteArrayLiteral("room1");
+    job.setUploadFileInfo(info);
+    job.setUseMediaUpload(true);
+    QNetworkRequest request = QNetworkRequest(QUrl());
+    verifyAuthentication(&job, request);
+    QCOMPARE(request.url(), QUrl(QStringLiteral("http://www.kde.org/api/v1/rooms.media/room1")));
+
+    job.setUploadedFileId(QByteArrayLiteral("file1"));
+    verifyAuthentication(&job, request);
+    QCOMPARE(request.url(), QUrl(QStringLiteral("http://www.kde.org/api/v1/rooms.mediaConfirm/room1/file1")));
+    QCOMPARE(request.header(QNetworkRequest::ContentTypeHeader).toString(), QStringLiteral("application/json"));
+}
+
 void UploadFileJobTest::shouldStart()
 {
     UploadFileJob job;
@@ -74,4 +94,50 @@ void UploadFileJobTest::shouldStart()
     QVERIFY(job.canStart());
 }
 
+void UploadFileJobTest::shouldRetryOnlyRequestsNotSent_data()
+{
+    QTest::addColumn<QNetworkReply::NetworkError>("error");
+    QTest::addColumn<bool>("notSent");
+    QTest::newRow("connectionrefused") << QNetworkReply::ConnectionRefusedError << true;
+    QTest::newRow("hostnotfound") << QNetworkReply::HostNotFoundError << true;
+    QTest::newRow("proxyconnectionrefused") << QNetworkReply::ProxyConnectionRefusedError << true;
+    QTest::newRow("proxynotfound") << QNetworkReply::ProxyNotFoundError << true;
+    // Server can have received the message
+    QTest::newRow("remotehostclosed") << QNetworkReply::RemoteHostClosedError << false;
+    QTest::newRow("timeout") << QNetworkReply::TimeoutError << false;
+    QTest::newRow("temporarynetworkfailure") << QNetworkReply::TemporaryNetworkFailureError << false;
+    QTest::newRow("networksessionfailed") << QNetworkReply::NetworkSessionFailedError << false;
+    QTest::newRow("serviceunavailable") << QNetworkReply::ServiceUnavailableError << false;
+    QTest::newRow("noerror") << QNetworkReply::NoError << false;
+}
+
+void UploadFileJobTest::shouldRetryOnlyRequestsNotSent()
+{
+    QFETCH(QNetworkReply::NetworkError, error);
+    QFETCH(bool, notSent);
+    QCOMPARE(UploadFileJob::isRequestNotSent(error), notSent);
+}
+
+void UploadFileJobTest::shouldRetryInterruptedMediaUpload_data()
+{
+    QTest::addColumn<QNetworkReply::NetworkError>("error");
+    QTest::addColumn<bool>("interrupted");
+    QTest::newRow("connectionrefused") << QNetworkReply::ConnectionRefusedError << true;
+    // rooms.media doesn't post a message
+    QTest::newRow("remotehostclosed") << QNetworkReply::RemoteHostClosedError << true;
+    QTest::newRow("timeout") << QNetworkReply::TimeoutError << true;
+    QTest::newRow("temporarynetworkfailure") << QNetworkReply::TemporaryNetworkFailureError << true;
+    QTest::newRow("serviceunavailable") << QNetworkReply::ServiceUnavailableError << true;
+    QTest::newRow("operationcanceled") << QNetworkReply::OperationCanceledError << false;
+    QTest::newRow("contentaccessdenied") << QNetworkReply::ContentAccessDenied << false;
+    QTest::newRow("noerror") << QNetworkReply::NoError << false;
+}
+
+void UploadFileJobTest::shouldRetryInterruptedMediaUpload()
+{
+    QFETCH(QNetworkReply::NetworkError, error);
+    QFETCH(bool, interrupted);
+    QCOMPARE(UploadFileJob::isMediaUploadInterrupted(error), interrupted);
+}
+
 #include "moc_uploadfilejobtest.cpp"
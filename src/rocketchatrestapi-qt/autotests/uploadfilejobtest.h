@@ -17,5 +17,10 @@ public:
 private Q_SLOTS:
     void shouldHaveDefaultValue();
     void shouldGenerateRequest();
+    void shouldGenerateMediaRequest();
     void shouldStart();
+    void shouldRetryOnlyRequestsNotSent_data();
+    void shouldRetryOnlyRequestsNotSent();
+    void shouldRetryInterruptedMediaUpload_data();
+    void shouldRetryInterruptedMediaUpload();
 };
@@ -11,6 +11,8 @@
 #include <QFileInfo>
 #include <QNetworkReply>
 
+#include <filesystem>
+
 using namespace RocketChatRestApi;
 
 DownloadFileJob::DownloadFileJob(QObject *parent)
@@ -27,36 +29,189 @@ bool DownloadFileJob::start()
         return false;
     }
 
-    mReply = networkAccessManager()->get(request());
-    addStartRestApiInfo("DownloadFileJob: url:" + mUrl.toEncoded() + " mimetype " + mMimeType + " saveAs " + mLocalFileUrl.toEncoded());
+    // Resume the partial file of a previous attempt, if it's still the same file on the server
+    const QString filePath = mLocalFileUrl.toLocalFile();
+    mResumeOffset = 0;
+    QFile validatorFile(partialValidatorFilePath(filePath));
+    if (validatorFile.open(QIODevice::ReadOnly)) {
+        mResumeValidator = validatorFile.readAll().trimmed();
+        if (!mResumeValidator.isEmpty()) {
+            mResumeOffset = QFileInfo(partialFilePath(filePath)).size();
+        }
+    }
+    sendRequest();
+    return true;
+}
+
+void DownloadFileJob::sendRequest()
+{
+    QNetworkRequest req = request();
+    if (mResumeOffset > 0) {
+        req.setRawHeader(QByteArrayLiteral("Range"), "bytes=" + QByteArray::number(mResumeOffset) + '-');
+        // Whole file is sent when it changed
+        req.setRawHeader(QByteArrayLiteral("If-Range"), mResumeValidator);
+    }
+    mReply = networkAccessManager()->get(req);
+    addStartRestApiInfo("DownloadFileJob: url:" + mUrl.toEncoded() + " mimetype " + mMimeType + " saveAs " + mLocalFileUrl.toEncoded()
+                        + " resume at " + QByteArray::number(mResumeOffset));
+    connect(mReply.data(), &QNetworkReply::readyRead, this, &DownloadFileJob::slotReadyRead);
     connect(mReply.data(), &QNetworkReply::finished, this, &DownloadFileJob::slotDownloadDone);
+}
+
+void DownloadFileJob::restartDownload()
+{
+    addLoggerWarning("DownloadFileJob: unexpected range " + mReply->rawHeader(QByteArrayLiteral("Content-Range")) + ", download from the start");
+    QNetworkReply *reply = mReply;
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+    removePartialFiles(mLocalFileUrl.toLocalFile());
+    mResumeOffset = 0;
+    mResumeValidator.clear();
+    sendRequest();
+}
+
+QString DownloadFileJob::partialFilePath(const QString &filePath)
+{
+    return filePath + QStringLiteral(".part");
+}
+
+QString DownloadFileJob::partialValidatorFilePath(const QString &filePath)
+{
+    return partialFilePath(filePath) + QStringLiteral(".validator");
+}
+
+void DownloadFileJob::removePartialFiles(const QString &filePath)
+{
+    QFile::remove(partialFilePath(filePath));
+    QFile::remove(partialValidatorFilePath(filePath));
+}
+
+qint64 DownloadFileJob::contentRangeStart(const QByteArray &contentRange)
+{
+    // "bytes 100-199/200"
+    if (!contentRange.startsWith("bytes ")) {
+        return -1;
+    }
+    const qsizetype dashIndex = contentRange.indexOf('-');
+    if (dashIndex == -1) {
+        return -1;
+    }
+    bool ok = false;
+    const qint64 start = contentRange.mid(6, dashIndex - 6).trimmed().toLongLong(&ok);
+    return ok ? start : -1;
+}
+
+QByteArray DownloadFileJob::resumeValidator(QNetworkReply *reply)
+{
+    // Weak ETags can't be used in If-Range
+    const QByteArray etag = reply->rawHeader(QByteArrayLiteral("ETag"));
+    if (!etag.isEmpty() && !etag.startsWith("W/")) {
+        return etag;
+    }
+    return reply->rawHeader(QByteArrayLiteral("Last-Modified"));
+}
+
+bool DownloadFileJob::openPartialFile()
+{
+    if (mPartialFile) {
+        return mPartialFile->isOpen();
+    }
+    const int status = mReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200 && status != 206) {
+        // Error page, it's logged when reply is finished
+        return false;
+    }
+    if (status == 206 && contentRangeStart(mReply->rawHeader(QByteArrayLiteral("Content-Range"))) != mResumeOffset) {
+        // Not the requested range, it can't be appended to the partial file
+        if (mResumeOffset > 0) {
+            restartDownload();
+        }
+        return false;
+    }
+    const QString newFilePath = mLocalFileUrl.toLocalFile();
+    QFileInfo(newFilePath).absoluteDir().mkpath(QStringLiteral("."));
+    mPartialFile = std::make_unique<QFile>(partialFilePath(newFilePath));
+    // 200: server ignored the Range header or the file changed, download from the start
+    const bool resume = (status == 206) && (mResumeOffset > 0);
+    if (!resume) {
+        mResumeOffset = 0;
+        // Allows resuming this download if it's interrupted
+        QFile validatorFile(partialValidatorFilePath(newFilePath));
+        const QByteArray validator = resumeValidator(mReply);
+        if (validator.isEmpty()) {
+            validatorFile.remove();
+        } else if (!validatorFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || validatorFile.write(validator) != validator.size()) {
+            qCWarning(ROCKETCHATQTRESTAPI_LOG) << " Error !" << validatorFile.errorString();
+        }
+    }
+    if (!mPartialFile->open(resume ? QIODevice::Append : (QIODevice::WriteOnly | QIODevice::Truncate))) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << " Error !" << mPartialFile->errorString();
+        mWriteError = true;
+        return false;
+    }
     return true;
 }
 
+void DownloadFileJob::slotReadyRead()
+{
+    auto reply = mReply;
+    if (!reply || mWriteError || !openPartialFile()) {
+        return;
+    }
+    // Write chunks as they arrive, the whole file is never in memory
+    const QByteArray data = reply->readAll();
+    if (mPartialFile->write(data) != data.size()) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << " Error !" << mPartialFile->errorString();
+        mWriteError = true;
+        reply->abort();
+    }
+}
+
 void DownloadFileJob::slotDownloadDone()
 {
     auto reply = mReply;
     if (reply) {
-        const QByteArray data = reply->readAll();
         const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        if (status == 200) {
-            addLoggerInfo("DownloadFileJob::slotDownloadDone finished");
-
-            // Split between image/video/audio
+        const bool success = (status == 200 || status == 206) && reply->error() == QNetworkReply::NoError && !mWriteError;
+        const bool opened = success && openPartialFile();
+        if (mReply != reply) {
+            // Download restarted from the start
+            return;
+        }
+        if (opened) {
+            const QByteArray data = reply->readAll();
+            const bool written = mPartialFile->write(data) == data.size() && mPartialFile->flush();
+            mPartialFile->close();
             const QString newFilePath = mLocalFileUrl.toLocalFile();
-            QFileInfo(newFilePath).absoluteDir().mkpath(QStringLiteral("."));
-            QFile file(newFilePath);
-            if (file.open(QIODevice::WriteOnly)) {
-                file.write(data);
-                file.close();
+            // The file only appears under its final name once it's complete. Unlike QFile::rename(),
+            // it replaces an existing file atomically: readers never see it missing or incomplete
+            std::error_code error;
+            if (written) {
+                std::filesystem::rename(std::filesystem::path(mPartialFile->fileName().toStdU16String()),
+                                        std::filesystem::path(newFilePath.toStdU16String()),
+                                        error);
+            }
+            if (written && !error) {
+                QFile::remove(partialValidatorFilePath(newFilePath));
+                addLoggerInfo("DownloadFileJob::slotDownloadDone finished");
+                Q_EMIT downloadFileDone(reply->url(), mLocalFileUrl);
             } else {
-                qCWarning(ROCKETCHATQTRESTAPI_LOG) << " Error !" << file.errorString();
+                qCWarning(ROCKETCHATQTRESTAPI_LOG) << " Error !" << (written ? QString::fromStdString(error.message()) : mPartialFile->errorString());
             }
-            Q_EMIT downloadFileDone(reply->url(), mLocalFileUrl);
         } else {
+            // Keep the partial file, next download of this url resumes it
+            if (mPartialFile) {
+                mPartialFile->close();
+            }
+            const QString filePath = mLocalFileUrl.toLocalFile();
+            // Range Not Satisfiable, or server didn't send a validator: partial file can't be resumed
+            if (status == 416 || !QFileInfo::exists(partialValidatorFilePath(filePath))) {
+                removePartialFiles(filePath);
+            }
             // FIXME
             // emitFailedMessage(replyObject, reply);
-            addLoggerWarning(QByteArrayLiteral("DownloadFileJob problem data: [") + data + "] :END");
+            addLoggerWarning(QByteArrayLiteral("DownloadFileJob problem status: ") + QByteArray::number(status) + " data: [" + reply->readAll() + "] :END");
         }
         reply->deleteLater();
     }
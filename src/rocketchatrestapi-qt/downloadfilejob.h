@@ -9,8 +9,18 @@
 #include "restapiabstractjob.h"
 
 #include <QUrl>
+#include <memory>
+class QFile;
 namespace RocketChatRestApi
 {
+/**
+ * Downloads url to localFileUrl. Data is streamed to a "<file>.part" file which is renamed
+ * over the final file when download is complete, so that an interrupted download never looks like a valid file.
+ * A partial file which can't be resumed is removed when the download fails.
+ * A partial file left by a previous attempt is resumed with a Range request, guarded by the
+ * ETag or Last-Modified header of the first reply (If-Range). It's downloaded again from the start
+ * when the server sends another range or the whole file.
+ */
 class LIBROCKETCHATRESTAPI_QT_EXPORT DownloadFileJob : public RestApiAbstractJob
 {
     Q_OBJECT
@@ -36,14 +46,31 @@ public:
     [[nodiscard]] bool requiredAuthentication() const;
     void setRequiredAuthentication(bool newRequiredAuthentication);
 
+    [[nodiscard]] static QString partialFilePath(const QString &filePath);
+    // Validator sent in If-Range when the partial file is resumed
+    [[nodiscard]] static QString partialValidatorFilePath(const QString &filePath);
+    // Returns -1 when the Content-Range header is invalid
+    [[nodiscard]] static qint64 contentRangeStart(const QByteArray &contentRange);
+
 Q_SIGNALS:
     void downloadFileDone(const QUrl &url, const QUrl &localFileUrl);
 
 private:
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void slotReadyRead();
     LIBROCKETCHATRESTAPI_QT_NO_EXPORT void slotDownloadDone();
+    [[nodiscard]] LIBROCKETCHATRESTAPI_QT_NO_EXPORT bool openPartialFile();
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void sendRequest();
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void restartDownload();
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT static void removePartialFiles(const QString &filePath);
+    [[nodiscard]] LIBROCKETCHATRESTAPI_QT_NO_EXPORT static QByteArray resumeValidator(QNetworkReply *reply);
     QUrl mUrl;
     QByteArray mMimeType;
     QUrl mLocalFileUrl;
+    std::unique_ptr<QFile> mPartialFile;
+    // Size of the partial file when download started, requested with a Range header
+    qint64 mResumeOffset = 0;
+    QByteArray mResumeValidator;
     bool mRequiredAuthentication = true;
+    bool mWriteError = false;
 };
 }
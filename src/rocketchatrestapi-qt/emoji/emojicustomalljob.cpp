@@ -51,6 +51,11 @@ bool EmojiCustomAllJob::requireHttpAuthentication() const
     return true;
 }
 
+bool EmojiCustomAllJob::useResponseCache() const
+{
+    return true;
+}
+
 bool EmojiCustomAllJob::hasQueryParameterSupport() const
 {
     return true;
@@ -51,6 +51,11 @@ bool LoadEmojiCustomJob::requireHttpAuthentication() const
     return true;
 }
 
+bool LoadEmojiCustomJob::useResponseCache() const
+{
+    return true;
+}
+
 bool LoadEmojiCustomJob::hasQueryParameterSupport() const
 {
     // Since 0.71
@@ -25,6 +25,11 @@ bool DirectoryJob::requireHttpAuthentication() const
     return true;
 }
 
+bool DirectoryJob::useResponseCache() const
+{
+    return true;
+}
+
 bool DirectoryJob::start()
 {
     if (!canStart()) {
@@ -31,6 +31,7 @@ public:
     };
 
     [[nodiscard]] bool requireHttpAuthentication() const override;
+    [[nodiscard]] bool useResponseCache() const override;
 
     [[nodiscard]] bool start() override;
 
@@ -24,6 +24,11 @@ bool RolesListJob::requireHttpAuthentication() const
     return true;
 }
 
+bool RolesListJob::useResponseCache() const
+{
+    return true;
+}
+
 bool RolesListJob::start()
 {
     if (!canStart()) {
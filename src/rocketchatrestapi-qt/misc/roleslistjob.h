@@ -19,6 +19,7 @@ public:
     ~RolesListJob() override;
 
     [[nodiscard]] bool requireHttpAuthentication() const override;
+    [[nodiscard]] bool useResponseCache() const override;
 
     [[nodiscard]] bool start() override;
 
@@ -24,6 +24,11 @@ bool PermissionsListAllJob::requireHttpAuthentication() const
     return true;
 }
 
+bool PermissionsListAllJob::useResponseCache() const
+{
+    return true;
+}
+
 bool PermissionsListAllJob::start()
 {
     if (!canStart()) {
@@ -20,6 +20,7 @@ public:
     ~PermissionsListAllJob() override;
 
     [[nodiscard]] bool requireHttpAuthentication() const override;
+    [[nodiscard]] bool useResponseCache() const override;
 
     [[nodiscard]] bool start() override;
 
@@ -7,15 +7,21 @@
 #include "restapiabstractjob.h"
 
 #include "abstractlogger.h"
+#include "restapipendingrequests.h"
 #include "rocketchatqtrestapi_debug.h"
 #include <KLocalizedString>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QNetworkAccessManager>
 #include <QUrlQuery>
 
 using namespace RocketChatRestApi;
 using namespace Qt::Literals::StringLiterals;
 
+// Data and document of the first job which handles a shared reply
+static const char replyDataProperty[] = "replyData";
+static const char parsedDocumentProperty[] = "parsedJsonDocument";
+
 RestApiAbstractJob::RestApiAbstractJob(QObject *parent)
     : QObject(parent)
 {
@@ -165,6 +171,31 @@ void RestApiAbstractJob::setRestApiLogger(RocketChatRestApi::AbstractLogger *ruq
     mRestApiLogger = ruqolaLogger;
 }
 
+RocketChatRestApi::RestApiResponseCache *RestApiAbstractJob::responseCache() const
+{
+    return mResponseCache;
+}
+
+void RestApiAbstractJob::setResponseCache(RocketChatRestApi::RestApiResponseCache *responseCache)
+{
+    mResponseCache = responseCache;
+}
+
+bool RestApiAbstractJob::useResponseCache() const
+{
+    return false;
+}
+
+RocketChatRestApi::RestApiPendingRequests *RestApiAbstractJob::pendingRequests() const
+{
+    return mPendingRequests;
+}
+
+void RestApiAbstractJob::setPendingRequests(RocketChatRestApi::RestApiPendingRequests *pendingRequests)
+{
+    mPendingRequests = pendingRequests;
+}
+
 void RestApiAbstractJob::addLoggerInfo(const QByteArray &str)
 {
     if (mRestApiLogger) { // when $RUQOLA_LOGFILE is set
@@ -490,9 +521,11 @@ void RestApiAbstractJob::genericResponseHandler(void (RestApiAbstractJob::*respo
     if (error != QNetworkReply::NoError) {
         if (networkErrorsNeedingReconnect().contains(error)) {
             // Ignore errors that will be handled in Connection class.
-            // no deleting, we will be trying to destroy everything and relogin
-            // reply will be invalid at this point, deleting it will crash us
+            // no deleting the reply, we will be trying to destroy everything and relogin
+            // reply will be invalid at this point, deleting it will crash us.
+            // The job is deleted, so that the ones waiting for it (e.g. LoginBootstrap) see it's done
             qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Network error. Lost connection? Let's reconnect";
+            deleteLater();
             return;
         }
         // qDebug() << mReply->readAll();
@@ -540,9 +573,28 @@ void RestApiAbstractJob::submitDeleteRequest()
 
 void RestApiAbstractJob::submitGetRequest()
 {
-    mReply = mNetworkAccessManager->get(request());
+    QNetworkRequest req = request();
     const QByteArray className = metaObject()->className();
-    mReply->setProperty("jobClassName", className);
+    const bool cacheResponse = mResponseCache && useResponseCache();
+    const QByteArray requestKey = mPendingRequests ? RestApiPendingRequests::key(className, cacheResponse ? mResponseCache : nullptr, req) : QByteArray();
+    if (cacheResponse) {
+        // Also loaded when the reply is shared: the job which sent it can be deleted before it's finished
+        mCachedResponse = mResponseCache->response(req);
+    }
+    QNetworkReply *runningReply = mPendingRequests ? mPendingRequests->reply(requestKey) : nullptr;
+    if (runningReply) {
+        addLoggerInfo(className + QByteArrayLiteral(": same request is running, share its reply"));
+        mReply = runningReply;
+    } else {
+        if (cacheResponse) {
+            RestApiResponseCache::addValidators(req, mCachedResponse);
+        }
+        mReply = mNetworkAccessManager->get(req);
+        mReply->setProperty("jobClassName", className);
+        if (mPendingRequests) {
+            mPendingRequests->insert(requestKey, mReply);
+        }
+    }
 
     connect(mReply.data(), &QNetworkReply::finished, this, [this] {
         genericResponseHandler(&RestApiAbstractJob::onGetRequestResponse);
@@ -563,13 +615,61 @@ void RestApiAbstractJob::submitPostRequest(const QJsonDocument &doc)
     });
 }
 
-QJsonDocument RestApiAbstractJob::convertToJsonDocument(QNetworkReply *reply, bool canBeNull)
+QByteArray RestApiAbstractJob::replyData(QNetworkReply *reply)
+{
+    if (reply->operation() != QNetworkAccessManager::GetOperation) {
+        return readReplyData(reply);
+    }
+    // Reply can be shared with other jobs, its data was already read
+    const QVariant data = reply->property(replyDataProperty);
+    if (data.isValid()) {
+        return data.toByteArray();
+    }
+    const QByteArray newData = readReplyData(reply);
+    reply->setProperty(replyDataProperty, newData);
+    return newData;
+}
+
+QByteArray RestApiAbstractJob::readReplyData(QNetworkReply *reply)
 {
+    if (!mResponseCache || !useResponseCache() || reply->operation() != QNetworkAccessManager::GetOperation) {
+        return reply->readAll();
+    }
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 304 && mCachedResponse.isValid()) {
+        addLoggerInfo(metaObject()->className() + QByteArrayLiteral(": not modified, use cached response"));
+        mResponseCache->touch(reply->request());
+        return mCachedResponse.data;
+    }
     const QByteArray data = reply->readAll();
+    if (statusCode == 200) {
+        RestApiResponseCache::Response response;
+        response.etag = reply->rawHeader(QByteArrayLiteral("ETag"));
+        response.lastModified = reply->rawHeader(QByteArrayLiteral("Last-Modified"));
+        response.data = data;
+        mResponseCache->insert(reply->request(), response);
+    }
+    return data;
+}
+
+QJsonDocument RestApiAbstractJob::convertToJsonDocument(QNetworkReply *reply, bool canBeNull)
+{
+    const bool getOperation = reply->operation() == QNetworkAccessManager::GetOperation;
+    if (getOperation) {
+        // Reply can be shared with other jobs, its data was already read
+        const QVariant parsedDocument = reply->property(parsedDocumentProperty);
+        if (parsedDocument.isValid()) {
+            return parsedDocument.value<QJsonDocument>();
+        }
+    }
+    const QByteArray data = replyData(reply);
     const QJsonDocument replyDocument = QJsonDocument::fromJson(data);
     if (replyDocument.isNull() && !canBeNull) {
         qCWarning(ROCKETCHATQTRESTAPI_LOG) << " convertToJsonObject return null jsondocument. It's a bug. Data:" << data;
     }
+    if (getOperation) {
+        reply->setProperty(parsedDocumentProperty, QVariant::fromValue(replyDocument));
+    }
     return replyDocument;
 }
 
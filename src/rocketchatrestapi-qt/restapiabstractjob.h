@@ -8,6 +8,7 @@
 
 #include "librocketchatrestapi-qt_export.h"
 #include "queryparameters.h"
+#include "restapiresponsecache.h"
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QObject>
@@ -19,6 +20,7 @@ namespace RocketChatRestApi
 {
 class RestApiMethod;
 class AbstractLogger;
+class RestApiPendingRequests;
 
 inline static const QList<QNetworkReply::NetworkError> &networkErrorsNeedingReconnect()
 {
@@ -63,6 +65,15 @@ public:
     RocketChatRestApi::AbstractLogger *restApiLogger() const;
     void setRestApiLogger(RocketChatRestApi::AbstractLogger *restApiLogger);
 
+    [[nodiscard]] RocketChatRestApi::RestApiResponseCache *responseCache() const;
+    void setResponseCache(RocketChatRestApi::RestApiResponseCache *responseCache);
+    // GET replies are stored in responseCache() and revalidated
+    [[nodiscard]] virtual bool useResponseCache() const;
+
+    // Identical GET requests running at the same time share one reply
+    [[nodiscard]] RocketChatRestApi::RestApiPendingRequests *pendingRequests() const;
+    void setPendingRequests(RocketChatRestApi::RestApiPendingRequests *pendingRequests);
+
     void addLoggerInfo(const QByteArray &str);
     void addLoggerWarning(const QByteArray &str);
     void addStartRestApiInfo(const QByteArray &str);
@@ -90,6 +101,9 @@ protected:
     [[nodiscard]] QString errorStr(const QJsonObject &replyObject);
 
     [[nodiscard]] QJsonDocument convertToJsonDocument(QNetworkReply *reply, bool canBeNull = false);
+    // Content of the reply, from the response cache when it's not modified.
+    // A GET reply can be shared with other jobs: don't read it directly.
+    [[nodiscard]] QByteArray replyData(QNetworkReply *reply);
     void emitFailedMessage(const QString &replyErrorString, const QJsonObject &replyObject);
     void addAuthRawHeader(QNetworkRequest &request) const;
     [[nodiscard]] virtual QString errorMessage(const QString &str, const QJsonObject &detail);
@@ -123,6 +137,7 @@ protected Q_SLOTS:
 
 private:
     LIBROCKETCHATRESTAPI_QT_NO_EXPORT void genericResponseHandler(void (RestApiAbstractJob::*func)(const QString &, const QJsonDocument &));
+    [[nodiscard]] LIBROCKETCHATRESTAPI_QT_NO_EXPORT QByteArray readReplyData(QNetworkReply *reply);
 
     QueryParameters mQueryParameters;
     QString mAuthToken;
@@ -132,5 +147,9 @@ private:
     bool mEnforcePasswordFallBack = true;
     QNetworkAccessManager *mNetworkAccessManager = nullptr;
     RocketChatRestApi::AbstractLogger *mRestApiLogger = nullptr;
+    RocketChatRestApi::RestApiResponseCache *mResponseCache = nullptr;
+    RocketChatRestApi::RestApiPendingRequests *mPendingRequests = nullptr;
+    // Revalidated by the GET request
+    RocketChatRestApi::RestApiResponseCache::Response mCachedResponse;
 };
 }
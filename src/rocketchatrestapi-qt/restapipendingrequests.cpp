@@ -0,0 +1,65 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "restapipendingrequests.h"
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include <algorithm>
+#include <utility>
+
+using namespace RocketChatRestApi;
+
+RestApiPendingRequests::RestApiPendingRequests(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RestApiPendingRequests::~RestApiPendingRequests() = default;
+
+QByteArray RestApiPendingRequests::key(const QByteArray &jobClassName, const RestApiResponseCache *responseCache, const QNetworkRequest &request)
+{
+    QByteArray requestKey = jobClassName + '\n' + QByteArray::number(reinterpret_cast<quintptr>(responseCache)) + '\n' + request.url().toEncoded();
+    // All headers: user, token, two factor authentication code...
+    QList<QByteArray> headers = request.rawHeaderList();
+    std::sort(headers.begin(), headers.end());
+    for (const QByteArray &header : std::as_const(headers)) {
+        requestKey += '\n' + header + ": " + request.rawHeader(header);
+    }
+    return requestKey;
+}
+
+QNetworkReply *RestApiPendingRequests::reply(const QByteArray &key) const
+{
+    return mReplies.value(key);
+}
+
+void RestApiPendingRequests::insert(const QByteArray &requestKey, QNetworkReply *reply)
+{
+    mReplies.insert(requestKey, reply);
+    connect(reply, &QNetworkReply::finished, this, [this, requestKey, reply]() {
+        remove(requestKey, reply);
+    });
+    connect(reply, &QObject::destroyed, this, [this, requestKey, reply]() {
+        remove(requestKey, reply);
+    });
+}
+
+void RestApiPendingRequests::remove(const QByteArray &key, QNetworkReply *reply)
+{
+    const auto it = mReplies.constFind(key);
+    if (it != mReplies.cend() && it.value() == reply) {
+        mReplies.erase(it);
+    }
+}
+
+qsizetype RestApiPendingRequests::count() const
+{
+    return mReplies.count();
+}
+
+#include "moc_restapipendingrequests.cpp"
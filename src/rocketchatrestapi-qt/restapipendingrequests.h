@@ -0,0 +1,46 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "librocketchatrestapi-qt_export.h"
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+
+class QNetworkReply;
+class QNetworkRequest;
+namespace RocketChatRestApi
+{
+class RestApiResponseCache;
+/**
+ * GET requests which are running, per job class, response cache, url and headers.
+ * A job sending the same request shares the running reply instead of sending it again,
+ * the reply is read and parsed once for all of them.
+ */
+class LIBROCKETCHATRESTAPI_QT_EXPORT RestApiPendingRequests : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RestApiPendingRequests(QObject *parent = nullptr);
+    ~RestApiPendingRequests() override;
+
+    // Only jobs of the same class, using the same response cache, share a reply: they handle it the same way.
+    // Request must not contain the validators of the response cache yet.
+    [[nodiscard]] static QByteArray key(const QByteArray &jobClassName, const RestApiResponseCache *responseCache, const QNetworkRequest &request);
+
+    // Returns nullptr when the same request isn't running
+    [[nodiscard]] QNetworkReply *reply(const QByteArray &key) const;
+    // Reply is removed when it's finished
+    void insert(const QByteArray &key, QNetworkReply *reply);
+    [[nodiscard]] qsizetype count() const;
+
+private:
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void remove(const QByteArray &key, QNetworkReply *reply);
+
+    QHash<QByteArray, QNetworkReply *> mReplies;
+};
+}
@@ -0,0 +1,130 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "restapiresponsecache.h"
+#include "rocketchatqtrestapi_debug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QNetworkRequest>
+#include <QSaveFile>
+
+using namespace RocketChatRestApi;
+
+namespace
+{
+// Increased when the file format changes, older files are ignored
+constexpr qint32 responseFileVersion = 1;
+}
+
+bool RestApiResponseCache::Response::isValid() const
+{
+    return !etag.isEmpty() || !lastModified.isEmpty();
+}
+
+RestApiResponseCache::RestApiResponseCache(const QString &cacheDirectory)
+    : mCacheDirectory(cacheDirectory)
+{
+    removeExpiredResponses();
+}
+
+RestApiResponseCache::~RestApiResponseCache() = default;
+
+QString RestApiResponseCache::cacheDirectory() const
+{
+    return mCacheDirectory;
+}
+
+QString RestApiResponseCache::filePath(const QNetworkRequest &request) const
+{
+    // Same url returns a different content for each user
+    const QByteArray key = request.url().toEncoded() + '\n' + request.rawHeader(QByteArrayLiteral("X-User-Id"));
+    return mCacheDirectory + QLatin1Char('/') + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+}
+
+RestApiResponseCache::Response RestApiResponseCache::response(const QNetworkRequest &request) const
+{
+    QFile file(filePath(request));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    QDataStream stream(&file);
+    qint32 version = 0;
+    stream >> version;
+    if (version != responseFileVersion) {
+        return {};
+    }
+    Response response;
+    stream >> response.etag >> response.lastModified >> response.data;
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Invalid cached response" << file.fileName();
+        return {};
+    }
+    return response;
+}
+
+void RestApiResponseCache::insert(const QNetworkRequest &request, const Response &response)
+{
+    if (!response.isValid()) {
+        // Can't be revalidated
+        remove(request);
+        return;
+    }
+    if (!QDir().mkpath(mCacheDirectory)) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to create" << mCacheDirectory;
+        return;
+    }
+    QSaveFile file(filePath(request));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to open" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << responseFileVersion << response.etag << response.lastModified << response.data;
+    if (!file.commit()) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to save" << file.fileName();
+    }
+}
+
+void RestApiResponseCache::remove(const QNetworkRequest &request)
+{
+    const QString path = filePath(request);
+    if (QFile::exists(path) && !QFile::remove(path)) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to remove" << path;
+    }
+}
+
+void RestApiResponseCache::touch(const QNetworkRequest &request)
+{
+    QFile file(filePath(request));
+    if (!file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly) || !file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime)) {
+        qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to update" << file.fileName();
+    }
+}
+
+void RestApiResponseCache::addValidators(QNetworkRequest &request, const Response &response)
+{
+    if (!response.etag.isEmpty()) {
+        request.setRawHeader(QByteArrayLiteral("If-None-Match"), response.etag);
+    }
+    if (!response.lastModified.isEmpty()) {
+        request.setRawHeader(QByteArrayLiteral("If-Modified-Since"), response.lastModified);
+    }
+}
+
+void RestApiResponseCache::removeExpiredResponses()
+{
+    const QDateTime expiryDate = QDateTime::currentDateTime().addDays(-maximumAge);
+    const QFileInfoList files = QDir(mCacheDirectory).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &fileInfo : files) {
+        if (fileInfo.lastModified() < expiryDate && !QFile::remove(fileInfo.absoluteFilePath())) {
+            qCWarning(ROCKETCHATQTRESTAPI_LOG) << "Impossible to remove" << fileInfo.absoluteFilePath();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "librocketchatrestapi-qt_export.h"
+#include <QByteArray>
+#include <QString>
+
+class QNetworkRequest;
+namespace RocketChatRestApi
+{
+/**
+ * Replies of the GET requests which have an ETag or a Last-Modified header, stored on disk.
+ * They are revalidated with If-None-Match / If-Modified-Since, the server answers 304 without
+ * content when they didn't change.
+ * Responses are stored per url and user.
+ */
+class LIBROCKETCHATRESTAPI_QT_EXPORT RestApiResponseCache
+{
+public:
+    struct LIBROCKETCHATRESTAPI_QT_EXPORT Response {
+        [[nodiscard]] bool isValid() const;
+
+        QByteArray etag;
+        QByteArray lastModified;
+        QByteArray data;
+    };
+
+    explicit RestApiResponseCache(const QString &cacheDirectory);
+    ~RestApiResponseCache();
+
+    [[nodiscard]] QString cacheDirectory() const;
+
+    [[nodiscard]] Response response(const QNetworkRequest &request) const;
+    // Response without ETag nor Last-Modified is not stored
+    void insert(const QNetworkRequest &request, const Response &response);
+    void remove(const QNetworkRequest &request);
+    // Response is still valid, it's not expired
+    void touch(const QNetworkRequest &request);
+
+    static void addValidators(QNetworkRequest &request, const Response &response);
+
+    // Responses unused for this number of days are removed
+    static constexpr int maximumAge = 30;
+
+private:
+    [[nodiscard]] LIBROCKETCHATRESTAPI_QT_NO_EXPORT QString filePath(const QNetworkRequest &request) const;
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void removeExpiredResponses();
+
+    const QString mCacheDirectory;
+};
+}
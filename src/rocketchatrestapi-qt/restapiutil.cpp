@@ -286,6 +286,10 @@ QString RestApiUtil::restUrl(RestApiUtil::RestApiUrlType type)
         return QStringLiteral("settings");
     case RestApiUtil::RestApiUrlType::RoomsUpload:
         return QStringLiteral("rooms.upload");
+    case RestApiUtil::RestApiUrlType::RoomsMedia:
+        return QStringLiteral("rooms.media");
+    case RestApiUtil::RestApiUrlType::RoomsMediaConfirm:
+        return QStringLiteral("rooms.mediaConfirm");
     case RestApiUtil::RestApiUrlType::RoomsSaveNotification:
         return QStringLiteral("rooms.saveNotification");
     case RestApiUtil::RestApiUrlType::RoomsSaveSettings:
@@ -177,6 +177,8 @@ enum class RestApiUrlType {
     EmojiCustomAll,
 
     RoomsUpload,
+    RoomsMedia,
+    RoomsMediaConfirm,
     RoomsSaveNotification,
     RoomsSaveSettings,
     RoomsAdminRooms,
@@ -50,6 +50,11 @@ bool PrivateInfoJob::requireHttpAuthentication() const
     return true;
 }
 
+bool PrivateInfoJob::useResponseCache() const
+{
+    return true;
+}
+
 QNetworkRequest PrivateInfoJob::request() const
 {
     const QUrl url = mRestApiMethod->generateUrl(RestApiUtil::RestApiUrlType::Settings);
@@ -50,6 +50,11 @@ bool PublicSettingsJob::requireHttpAuthentication() const
     return false;
 }
 
+bool PublicSettingsJob::useResponseCache() const
+{
+    return true;
+}
+
 QNetworkRequest PublicSettingsJob::request() const
 {
     const QUrl url = mRestApiMethod->generateUrl(RestApiUtil::RestApiUrlType::SettingsPublic);
@@ -21,6 +21,7 @@ public:
 
     [[nodiscard]] bool start() override;
     [[nodiscard]] bool requireHttpAuthentication() const override;
+    [[nodiscard]] bool useResponseCache() const override;
     [[nodiscard]] QNetworkRequest request() const override;
 Q_SIGNALS:
     void publicSettingsDone(const QJsonObject &data);
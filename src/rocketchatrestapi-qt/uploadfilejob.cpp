@@ -49,6 +49,11 @@ bool UploadFileJob::start()
         deleteLater();
         return false;
     }
+    if (mUseMediaUpload && !mUploadedFileId.isEmpty()) {
+        confirmMediaUpload();
+        addStartRestApiInfo("UploadFileJob::start confirm");
+        return true;
+    }
     const QString fileNameAsLocalFile = mUploadFileInfo.filenameUrl.toLocalFile();
     auto file = new QFile(fileNameAsLocalFile);
     if (!file->open(QIODevice::ReadOnly)) {
@@ -73,6 +78,16 @@ bool UploadFileJob::start()
     file->setParent(multiPart); // we cannot delete the file now, so delete it with the multiPart
     multiPart->append(filePart);
 
+    if (mUseMediaUpload) {
+        // Message is posted by rooms.mediaConfirm
+        mReply = networkAccessManager()->post(request(), multiPart);
+        connect(mReply, &QNetworkReply::uploadProgress, this, &UploadFileJob::slotUploadProgress);
+        connect(mReply, &QNetworkReply::finished, this, &UploadFileJob::slotMediaUploadFinished);
+        multiPart->setParent(mReply);
+        addStartRestApiInfo("UploadFileJob::start media");
+        return true;
+    }
+
     QHttpPart msgPart;
     msgPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"msg\""_L1));
     msgPart.setBody(mUploadFileInfo.messageText.toUtf8());
@@ -109,7 +124,16 @@ void UploadFileJob::slotUploadProgress(qint64 bytesSent, qint64 bytesTotal)
 
 QNetworkRequest UploadFileJob::request() const
 {
-    const QUrl url = mRestApiMethod->generateUrl(RestApiUtil::RestApiUrlType::RoomsUpload,
+    if (mUseMediaUpload && !mUploadedFileId.isEmpty()) {
+        const QUrl url = mRestApiMethod->generateUrl(RestApiUtil::RestApiUrlType::RoomsMediaConfirm,
+                                                     RestApiUtil::RestApiUrlExtensionType::V1,
+                                                     QString::fromLatin1(mUploadFileInfo.roomId + '/' + mUploadedFileId));
+        QNetworkRequest request(url);
+        addAuthRawHeader(request);
+        addRequestAttribute(request);
+        return request;
+    }
+    const QUrl url = mRestApiMethod->generateUrl(mUseMediaUpload ? RestApiUtil::RestApiUrlType::RoomsMedia : RestApiUtil::RestApiUrlType::RoomsUpload,
                                                  RestApiUtil::RestApiUrlExtensionType::V1,
                                                  QLatin1StringView(mUploadFileInfo.roomId));
     QNetworkRequest request(url);
@@ -119,6 +143,54 @@ QNetworkRequest UploadFileJob::request() const
     return request;
 }
 
+void UploadFileJob::slotMediaUploadFinished()
+{
+    auto reply = mReply;
+    if (!reply) {
+        deleteLater();
+        return;
+    }
+    if (mRetryOnNetworkError && isMediaUploadInterrupted(reply->error())) {
+        addLoggerWarning(QByteArrayLiteral("UploadFileJob: media upload interrupted: ") + reply->errorString().toUtf8());
+        reply->deleteLater();
+        Q_EMIT uploadInterrupted();
+        deleteLater();
+        return;
+    }
+    const QJsonDocument replyJson = convertToJsonDocument(reply);
+    const QJsonObject replyObject = replyJson.object();
+    reply->deleteLater();
+    const QByteArray fileId = replyObject.value("file"_L1).toObject().value("_id"_L1).toString().toLatin1();
+    if (!replyObject.value("success"_L1).toBool() || fileId.isEmpty()) {
+        if (reply->error() != QNetworkReply::NoError) {
+            Q_EMIT failed(reply->errorString() + QLatin1Char('\n') + errorStr(replyObject));
+        } else {
+            emitFailedMessage(reply->errorString(), replyObject);
+        }
+        addLoggerWarning(QByteArrayLiteral("UploadFileJob: media upload problem: ") + replyJson.toJson(QJsonDocument::Indented));
+        Q_EMIT uploadFinished();
+        deleteLater();
+        return;
+    }
+    addLoggerInfo(QByteArrayLiteral("UploadFileJob: media uploaded: ") + fileId);
+    mUploadedFileId = fileId;
+    Q_EMIT mediaUploaded(fileId);
+    confirmMediaUpload();
+}
+
+void UploadFileJob::confirmMediaUpload()
+{
+    QJsonObject jsonObj;
+    jsonObj["msg"_L1] = mUploadFileInfo.messageText;
+    jsonObj["description"_L1] = mUploadFileInfo.description;
+    if (!mUploadFileInfo.threadMessageId.isEmpty()) {
+        jsonObj["tmid"_L1] = QLatin1StringView(mUploadFileInfo.threadMessageId);
+    }
+    mReply = networkAccessManager()->post(request(), QJsonDocument(jsonObj).toJson(QJsonDocument::Compact));
+    // Posts the message: same handling as rooms.upload
+    connect(mReply, &QNetworkReply::finished, this, &UploadFileJob::slotUploadFinished);
+}
+
 void UploadFileJob::abort()
 {
     if (mReply) {
@@ -131,6 +203,13 @@ void UploadFileJob::slotUploadFinished()
 {
     auto reply = mReply;
     if (reply) {
+        if (mRetryOnNetworkError && isRequestNotSent(reply->error())) {
+            addLoggerWarning(QByteArrayLiteral("UploadFileJob: not sent: ") + reply->errorString().toUtf8());
+            reply->deleteLater();
+            Q_EMIT uploadInterrupted();
+            deleteLater();
+            return;
+        }
         const QJsonDocument replyJson = convertToJsonDocument(reply);
         const QJsonObject replyObject = replyJson.object();
         if (replyObject.value("success"_L1).toBool()) {
@@ -171,6 +250,74 @@ bool UploadFileJob::requireHttpAuthentication() const
     return true;
 }
 
+bool UploadFileJob::isRequestNotSent(QNetworkReply::NetworkError error)
+{
+    // rooms.upload posts a message: after any other error (connection closed, timeout...)
+    // the server can have received it, sending it again could post it twice
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyNotFoundError:
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+bool UploadFileJob::isMediaUploadInterrupted(QNetworkReply::NetworkError error)
+{
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyNotFoundError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::ServiceUnavailableError:
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+bool UploadFileJob::useMediaUpload() const
+{
+    return mUseMediaUpload;
+}
+
+void UploadFileJob::setUseMediaUpload(bool useMediaUpload)
+{
+    mUseMediaUpload = useMediaUpload;
+}
+
+QByteArray UploadFileJob::uploadedFileId() const
+{
+    return mUploadedFileId;
+}
+
+void UploadFileJob::setUploadedFileId(const QByteArray &fileId)
+{
+    mUploadedFileId = fileId;
+}
+
+bool UploadFileJob::retryOnNetworkError() const
+{
+    return mRetryOnNetworkError;
+}
+
+void UploadFileJob::setRetryOnNetworkError(bool retry)
+{
+    mRetryOnNetworkError = retry;
+}
+
 bool UploadFileJob::UploadFileInfo::isValid() const
 {
     return !roomId.isEmpty() && !filenameUrl.isEmpty();
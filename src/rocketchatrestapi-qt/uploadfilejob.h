@@ -46,14 +46,43 @@ public:
 
     void abort();
 
+    // When the upload can be sent again (see isRequestNotSent() and isMediaUploadInterrupted()),
+    // uploadInterrupted() is emitted instead of failed() and uploadFinished()
+    [[nodiscard]] bool retryOnNetworkError() const;
+    void setRetryOnNetworkError(bool retry);
+
+    /**
+     * File is sent with rooms.media, which stores it without posting a message, then the message is posted
+     * with rooms.mediaConfirm (RC 6.8). Otherwise both are done at once with rooms.upload.
+     */
+    [[nodiscard]] bool useMediaUpload() const;
+    void setUseMediaUpload(bool useMediaUpload);
+
+    // File already stored by rooms.media in a previous attempt: only rooms.mediaConfirm is sent
+    [[nodiscard]] QByteArray uploadedFileId() const;
+    void setUploadedFileId(const QByteArray &fileId);
+
+    // The server didn't receive anything, the upload can be sent again without posting it twice
+    [[nodiscard]] static bool isRequestNotSent(QNetworkReply::NetworkError error);
+    // rooms.media was interrupted by the network: it doesn't post anything, it can be sent again
+    [[nodiscard]] static bool isMediaUploadInterrupted(QNetworkReply::NetworkError error);
+
 Q_SIGNALS:
     void uploadProgress(const RocketChatRestApi::UploadFileJob::UploadStatusInfo &info);
     void uploadFinished();
+    void uploadInterrupted();
+    // rooms.media stored the file, rooms.mediaConfirm is sent
+    void mediaUploaded(const QByteArray &fileId);
 
 private:
     LIBROCKETCHATRESTAPI_QT_NO_EXPORT void slotUploadProgress(qint64 bytesSent, qint64 bytesTotal);
     LIBROCKETCHATRESTAPI_QT_NO_EXPORT void slotUploadFinished();
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void slotMediaUploadFinished();
+    LIBROCKETCHATRESTAPI_QT_NO_EXPORT void confirmMediaUpload();
     UploadFileInfo mUploadFileInfo;
+    QByteArray mUploadedFileId;
+    bool mRetryOnNetworkError = false;
+    bool mUseMediaUpload = false;
 };
 }
 Q_DECLARE_METATYPE(RocketChatRestApi::UploadFileJob::UploadFileInfo)
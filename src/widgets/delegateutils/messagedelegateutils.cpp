@@ -32,7 +32,11 @@ std::unique_ptr<QTextDocument> MessageDelegateUtils::createTextDocument(bool use
 
 bool MessageDelegateUtils::generateToolTip(const QTextDocument *doc, const QPoint &pos, QString &formattedTooltip)
 {
-    const auto format = doc->documentLayout()->formatAt(pos);
+    return generateToolTip(doc->documentLayout()->formatAt(pos), formattedTooltip);
+}
+
+bool MessageDelegateUtils::generateToolTip(const QTextCharFormat &format, QString &formattedTooltip)
+{
     const auto tooltip = format.property(QTextFormat::TextToolTip).toString();
     const auto href = format.property(QTextFormat::AnchorHref).toString();
     if (tooltip.isEmpty() && (href.isEmpty() || href.startsWith("ruqola:/"_L1))) {
@@ -22,6 +22,7 @@ namespace MessageDelegateUtils
 [[nodiscard]] std::unique_ptr<QTextDocument> createTextDocument(bool useItalic, const QString &text, int width);
 
 [[nodiscard]] bool generateToolTip(const QTextDocument *doc, const QPoint &pos, QString &formattedTooltip);
+[[nodiscard]] bool generateToolTip(const QTextCharFormat &format, QString &formattedTooltip);
 
 void generateToolTip(const QString &toolTip, const QString &href, QString &formattedTooltip);
 
@@ -153,6 +153,17 @@ bool TextSelection::contains(const QModelIndex &index, int charPos, const Messag
     }
 }
 
+bool TextSelection::containsRow(const QModelIndex &index) const
+{
+    if (!hasSelection()) {
+        return false;
+    }
+    Q_ASSERT(index.model() == mStartIndex.model());
+    const int row = index.row();
+    const OrderedPositions ordered = orderedPositions();
+    return row >= ordered.fromRow && row <= ordered.toRow;
+}
+
 QTextCursor TextSelection::selectionForIndex(const QModelIndex &index, QTextDocument *doc, const MessageAttachment &att, const MessageUrl &msgUrl) const
 {
     if (!hasSelection()) {
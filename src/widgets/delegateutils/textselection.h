@@ -66,6 +66,8 @@ public:
     };
     [[nodiscard]] QString selectedText(Format format) const;
     [[nodiscard]] bool contains(const QModelIndex &index, int charPos, const MessageAttachment &att = {}) const;
+    // Returns true when the row of @p index is between the first and the last selected rows
+    [[nodiscard]] bool containsRow(const QModelIndex &index) const;
     [[nodiscard]] QTextCursor
     selectionForIndex(const QModelIndex &index, QTextDocument *doc, const MessageAttachment &att = {}, const MessageUrl &msgUrl = {}) const;
 
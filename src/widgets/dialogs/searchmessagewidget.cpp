@@ -114,7 +114,7 @@ void SearchMessageWidget::messageSearch(const QString &pattern, const QByteArray
 void SearchMessageWidget::slotSearchMessagesDone(const QJsonObject &obj)
 {
     mSearchMessageModel->setLoadCommonMessagesInProgress(false);
-    mMessageIsEmpty = mSearchMessageModel->parse(obj, false, true);
+    mMessageIsEmpty = mSearchMessageModel->parse(obj, false);
 }
 
 void SearchMessageWidget::searchMessages(const QByteArray &roomId, const QString &pattern, bool useRegularExpression, int offset)
@@ -95,7 +95,7 @@ void ShowImageGraphicsView::setImageInfo(const ShowImageWidget::ImageInfo &info)
         qCDebug(RUQOLAWIDGETS_SHOWIMAGE_LOG) << " Download big image " << info.needToDownloadBigImage << " use same image";
         // We just need to download image not get url as it will be empty as we need to download it.
         if (mRocketChatAccount) {
-            (void)mRocketChatAccount->attachmentUrlFromLocalCache(info.bigImagePath);
+            (void)mRocketChatAccount->requestedAttachmentUrlFromLocalCache(info.bigImagePath);
         }
         updatePixmap(mImageInfo.pixmap, mImageInfo.bigImagePath);
     } else {
@@ -123,7 +123,7 @@ void MessageAttachmentDownloadAndSaveJob::start()
             mProgressDialogBox->setMinimumDuration(0);
             connect(mProgressDialogBox, &QProgressDialog::canceled, this, &MessageAttachmentDownloadAndSaveJob::slotDownloadCancel);
             connect(mRocketChatAccount, &RocketChatAccount::fileDownloaded, this, &MessageAttachmentDownloadAndSaveJob::slotFileDownloaded);
-            (void)mRocketChatAccount->attachmentUrlFromLocalCache(mInfo.attachmentPath);
+            (void)mRocketChatAccount->requestedAttachmentUrlFromLocalCache(mInfo.attachmentPath);
         }
     } else {
         Q_EMIT downloadDone(mRocketChatAccount->attachmentUrlFromLocalCache(mInfo.attachmentPath).toLocalFile());
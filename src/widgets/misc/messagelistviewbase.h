@@ -21,6 +21,7 @@ public:
     void updateVerticalPageStep();
     void maybeScrollToBottom();
     void copyMessageToClipboard(const QModelIndex &index = {});
+    [[nodiscard]] QStyleOptionViewItem listViewOptions() const;
 
 Q_SIGNALS:
     void errorMessage(const QString &message);
@@ -41,7 +42,6 @@ protected:
 
     virtual bool maybeStartDrag(QMouseEvent *event, const QStyleOptionViewItem &option, const QModelIndex &index);
     virtual bool mouseEvent(QMouseEvent *event, const QStyleOptionViewItem &option, const QModelIndex &index);
-    [[nodiscard]] QStyleOptionViewItem listViewOptions() const;
 
     void addTextPlugins(QMenu *menu, const QString &selectedText);
 
@@ -5,6 +5,7 @@
 */
 
 #include "messagelistdelegatetest.h"
+#include "config-ruqola.h"
 #include "messages/message.h"
 #include "messages/messageattachment.h"
 #include "rocketchataccount.h"
@@ -157,4 +158,99 @@ void MessageListDelegateTest::layoutChecks()
     }
 }
 
+void MessageListDelegateTest::shouldEstimateSizeHints()
+{
+#if !USE_SIZEHINT_CACHE_SUPPORT
+    QSKIP("Estimation needs sizehint cache");
+#endif
+    MessageListDelegate delegate(Ruqola::self()->rocketChatAccount(), nullptr);
+    delegate.setRocketChatAccount(Ruqola::self()->rocketChatAccount());
+    QVERIFY(!delegate.estimateSizeHints());
+    QStyleOptionViewItem option;
+    QWidget fakeWidget;
+    option.widget = &fakeWidget;
+    option.rect = QRect(0, 0, 500, 500);
+
+    Message message;
+    message.setMessageId(QByteArrayLiteral("someNonEmptyId"));
+    message.setUserId(QByteArrayLiteral("dfaureUserId"));
+    message.setUsername(QStringLiteral("dfaure"));
+    message.setTimeStamp(QDateTime(QDate(2020, 2, 1), QTime(4, 7, 15)).toMSecsSinceEpoch());
+    message.setMessageType(Message::NormalText);
+    message.setText(QStringLiteral("foo"));
+
+    QStandardItemModel model;
+    auto item = new QStandardItem;
+    item->setData(message.username(), MessagesModel::Username);
+    item->setData(message.userId(), MessagesModel::UserId);
+    item->setData(message.displayTime(), MessagesModel::Timestamp);
+    item->setData(QVariant::fromValue(&message), MessagesModel::MessagePointer);
+    item->setData(message.text(), MessagesModel::OriginalMessage);
+    item->setData(message.text(), MessagesModel::MessageConvertedText);
+    model.setItem(0, 0, item);
+    model.setItem(1, 0, new QStandardItem);
+    const QModelIndex index = model.index(0, 0);
+
+    delegate.setEstimateSizeHints(true);
+    QVERIFY(delegate.estimateSizeHints());
+    // Not measured yet
+    const int estimatedHeight = delegate.estimatedHeight(option);
+    QCOMPARE(estimatedHeight, option.fontMetrics.height() * 3);
+    QCOMPARE(delegate.sizeHint(option, index), QSize(500, estimatedHeight));
+
+    const QSize measuredSize = delegate.measuredSizeHint(option, index);
+    QVERIFY(measuredSize.isValid());
+    QCOMPARE(delegate.sizeHint(option, index), measuredSize);
+    // Estimation doesn't change with measured messages
+    QCOMPARE(delegate.estimatedHeight(option), estimatedHeight);
+
+    // Another width is not measured
+    option.rect = QRect(0, 0, 300, 500);
+    QCOMPARE(delegate.sizeHint(option, index), QSize(300, estimatedHeight));
+}
+
+void MessageListDelegateTest::shouldSkipPreRenderedMessages()
+{
+    MessageListDelegate delegate(Ruqola::self()->rocketChatAccount(), nullptr);
+    delegate.setRocketChatAccount(Ruqola::self()->rocketChatAccount());
+    QStyleOptionViewItem option;
+    QWidget fakeWidget;
+    option.widget = &fakeWidget;
+    option.rect = QRect(0, 0, 500, 500);
+
+    Message message;
+    message.setMessageId(QByteArrayLiteral("preRenderedId"));
+    message.setUserId(QByteArrayLiteral("dfaureUserId"));
+    message.setUsername(QStringLiteral("dfaure"));
+    message.setTimeStamp(QDateTime(QDate(2020, 2, 1), QTime(4, 7, 15)).toMSecsSinceEpoch());
+    message.setMessageType(Message::NormalText);
+    message.setText(QStringLiteral("foo"));
+
+    QStandardItemModel model;
+    auto item = new QStandardItem;
+    item->setData(message.username(), MessagesModel::Username);
+    item->setData(message.userId(), MessagesModel::UserId);
+    item->setData(message.displayTime(), MessagesModel::Timestamp);
+    item->setData(QVariant::fromValue(&message), MessagesModel::MessagePointer);
+    item->setData(message.text(), MessagesModel::OriginalMessage);
+    item->setData(message.text(), MessagesModel::MessageConvertedText);
+    model.setItem(0, 0, item);
+    const QModelIndex index = model.index(0, 0);
+
+    QVERIFY(delegate.preRender(option, index));
+    // Already done
+    QVERIFY(!delegate.preRender(option, index));
+
+    // Caches purged: done again
+    delegate.removeMessageCache(&message);
+    QVERIFY(delegate.preRender(option, index));
+    QVERIFY(!delegate.preRender(option, index));
+
+#if USE_SIZEHINT_CACHE_SUPPORT
+    delegate.clearSizeHintCache();
+    QVERIFY(delegate.preRender(option, index));
+    QVERIFY(!delegate.preRender(option, index));
+#endif
+}
+
 #include "moc_messagelistdelegatetest.cpp"
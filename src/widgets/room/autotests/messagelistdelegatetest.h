@@ -18,4 +18,6 @@ public:
 private Q_SLOTS:
     void layoutChecks_data();
     void layoutChecks();
+    void shouldEstimateSizeHints();
+    void shouldSkipPreRenderedMessages();
 };
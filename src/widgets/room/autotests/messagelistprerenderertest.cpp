@@ -0,0 +1,46 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagelistprerenderertest.h"
+#include "room/delegate/messagelistdelegate.h"
+#include "room/messagelistprerenderer.h"
+#include "room/messagelistview.h"
+#include <QTest>
+QTEST_MAIN(MessageListPreRendererTest)
+
+MessageListPreRendererTest::MessageListPreRendererTest(QObject *parent)
+    : QObject{parent}
+{
+}
+
+void MessageListPreRendererTest::shouldHaveDefaultValues()
+{
+    MessageListView view(nullptr, MessageListView::Mode::Editing);
+    MessageListDelegate delegate(nullptr, &view);
+    MessageListPreRenderer w(&view, &delegate);
+    QVERIFY(!w.isActive());
+    QCOMPARE(w.rowsAroundViewport(), 8);
+    QCOMPARE(w.timeBudget(), 5);
+    QCOMPARE(w.pendingRowsCount(), 0);
+}
+
+void MessageListPreRendererTest::shouldNotPreRenderWithoutModel()
+{
+    MessageListView view(nullptr, MessageListView::Mode::Editing);
+    MessageListDelegate delegate(nullptr, &view);
+    MessageListPreRenderer w(&view, &delegate);
+    w.schedule();
+    QVERIFY(w.isActive());
+    QTRY_VERIFY(!w.isActive());
+    QCOMPARE(w.pendingRowsCount(), 0);
+
+    w.schedule();
+    w.cancel();
+    QVERIFY(!w.isActive());
+    QCOMPARE(w.pendingRowsCount(), 0);
+}
+
+#include "moc_messagelistprerenderertest.cpp"
@@ -0,0 +1,19 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+
+class MessageListPreRendererTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageListPreRendererTest(QObject *parent = nullptr);
+    ~MessageListPreRendererTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldNotPreRenderWithoutModel();
+};
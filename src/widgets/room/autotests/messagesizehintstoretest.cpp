@@ -0,0 +1,152 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagesizehintstoretest.h"
+#include "room/delegate/messagesizehintstore.h"
+#include <QTest>
+QTEST_GUILESS_MAIN(MessageSizeHintStoreTest)
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+MessageSizeHintStore::Key key(const QByteArray &messageId, int width, qint64 revision = 1, int layoutMode = 0)
+{
+    MessageSizeHintStore::Key k;
+    k.messageId = messageId;
+    k.width = width;
+    k.revision = revision;
+    k.layoutMode = layoutMode;
+    return k;
+}
+}
+
+MessageSizeHintStoreTest::MessageSizeHintStoreTest(QObject *parent)
+    : QObject{parent}
+{
+}
+
+void MessageSizeHintStoreTest::shouldHaveDefaultValues()
+{
+    MessageSizeHintStore store;
+    QCOMPARE(store.messageCount(), 0);
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500)).isValid());
+}
+
+void MessageSizeHintStoreTest::shouldKeepSizePerWidth()
+{
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, 500), QSize(500, 40));
+    store.insert(key("foo"_ba, 300), QSize(300, 80));
+    QCOMPARE(store.messageCount(), 1);
+    QCOMPARE(store.sizeHint(key("foo"_ba, 500)), QSize(500, 40));
+    QCOMPARE(store.sizeHint(key("foo"_ba, 300)), QSize(300, 80));
+    QVERIFY(!store.sizeHint(key("foo"_ba, 400)).isValid());
+    // Another layout
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500, 1, 2)).isValid());
+
+    // Replace value
+    store.insert(key("foo"_ba, 500), QSize(500, 60));
+    QCOMPARE(store.sizeHint(key("foo"_ba, 500)), QSize(500, 60));
+    QCOMPARE(store.sizeHint(key("foo"_ba, 300)), QSize(300, 80));
+}
+
+void MessageSizeHintStoreTest::shouldInvalidateOnNewRevision()
+{
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, 500, 1), QSize(500, 40));
+    store.insert(key("foo"_ba, 300, 1), QSize(300, 80));
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500, 2)).isValid());
+
+    store.insert(key("foo"_ba, 500, 2), QSize(500, 100));
+    QCOMPARE(store.sizeHint(key("foo"_ba, 500, 2)), QSize(500, 100));
+    // Old sizes were dropped
+    QVERIFY(!store.sizeHint(key("foo"_ba, 300, 1)).isValid());
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500, 1)).isValid());
+}
+
+void MessageSizeHintStoreTest::shouldDependOnPreviousMessage()
+{
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, 500), QSize(500, 40));
+
+    // Previous message was removed: sender is displayed again
+    MessageSizeHintStore::Key grouped = key("foo"_ba, 500);
+    grouped.sameSenderAsPreviousMessage = true;
+    QVERIFY(!store.sizeHint(grouped).isValid());
+    store.insert(grouped, QSize(500, 20));
+    QCOMPARE(store.sizeHint(grouped), QSize(500, 20));
+
+    MessageSizeHintStore::Key newDate = key("foo"_ba, 500);
+    newDate.dateDiffersFromPrevious = true;
+    QVERIFY(!store.sizeHint(newDate).isValid());
+    store.insert(newDate, QSize(500, 60));
+    QCOMPARE(store.sizeHint(newDate), QSize(500, 60));
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500)).isValid());
+}
+
+void MessageSizeHintStoreTest::shouldLimitSizesPerMessage()
+{
+    MessageSizeHintStore store;
+    constexpr int bucketSize = MessageSizeHintStore::widthBucketSize;
+    for (int i = 0; i <= MessageSizeHintStore::maximumSizesPerMessage; ++i) {
+        store.insert(key("foo"_ba, 100 + i * bucketSize), QSize(100 + i * bucketSize, 10));
+    }
+    // Oldest width was removed
+    QVERIFY(!store.sizeHint(key("foo"_ba, 100)).isValid());
+    for (int i = 1; i <= MessageSizeHintStore::maximumSizesPerMessage; ++i) {
+        QCOMPARE(store.sizeHint(key("foo"_ba, 100 + i * bucketSize)), QSize(100 + i * bucketSize, 10));
+    }
+}
+
+void MessageSizeHintStoreTest::shouldApproximateSizeInWidthBucket()
+{
+    constexpr int bucketSize = MessageSizeHintStore::widthBucketSize;
+    const int width = 10 * bucketSize;
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, width), QSize(width, 40));
+    // Same bucket: approximation only when asked
+    QVERIFY(!store.sizeHint(key("foo"_ba, width + 1)).isValid());
+    QCOMPARE(store.sizeHint(key("foo"_ba, width + 1), MessageSizeHintStore::WidthMatch::Bucket), QSize(width + 1, 40));
+    // Another bucket
+    QVERIFY(!store.sizeHint(key("foo"_ba, width - 1), MessageSizeHintStore::WidthMatch::Bucket).isValid());
+
+    // Exact size replaces the one of the bucket
+    store.insert(key("foo"_ba, width + 1), QSize(width + 1, 60));
+    QCOMPARE(store.sizeHint(key("foo"_ba, width + 1)), QSize(width + 1, 60));
+    QVERIFY(!store.sizeHint(key("foo"_ba, width)).isValid());
+    QCOMPARE(store.messageCount(), 1);
+}
+
+void MessageSizeHintStoreTest::shouldInvalidateOnNewStyleRevision()
+{
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, 500), QSize(500, 40));
+    MessageSizeHintStore::Key newStyle = key("foo"_ba, 500);
+    newStyle.styleRevision = 1;
+    QVERIFY(!store.sizeHint(newStyle).isValid());
+    store.insert(newStyle, QSize(500, 60));
+    QCOMPARE(store.sizeHint(newStyle), QSize(500, 60));
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500)).isValid());
+}
+
+void MessageSizeHintStoreTest::shouldRemoveAndClear()
+{
+    MessageSizeHintStore store;
+    store.insert(key("foo"_ba, 500), QSize(500, 40));
+    store.insert(key("bla"_ba, 500), QSize(500, 20));
+    QCOMPARE(store.messageCount(), 2);
+
+    store.remove("foo"_ba);
+    QCOMPARE(store.messageCount(), 1);
+    QVERIFY(!store.sizeHint(key("foo"_ba, 500)).isValid());
+    QCOMPARE(store.sizeHint(key("bla"_ba, 500)), QSize(500, 20));
+
+    store.clear();
+    QCOMPARE(store.messageCount(), 0);
+    QVERIFY(!store.sizeHint(key("bla"_ba, 500)).isValid());
+}
+
+#include "moc_messagesizehintstoretest.cpp"
@@ -0,0 +1,26 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class MessageSizeHintStoreTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageSizeHintStoreTest(QObject *parent = nullptr);
+    ~MessageSizeHintStoreTest() override = default;
+private Q_SLOTS:
+    void shouldHaveDefaultValues();
+    void shouldKeepSizePerWidth();
+    void shouldInvalidateOnNewRevision();
+    void shouldDependOnPreviousMessage();
+    void shouldLimitSizesPerMessage();
+    void shouldApproximateSizeInWidthBucket();
+    void shouldInvalidateOnNewStyleRevision();
+    void shouldRemoveAndClear();
+};
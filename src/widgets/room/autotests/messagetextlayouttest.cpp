@@ -0,0 +1,166 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagetextlayouttest.h"
+#include "room/delegate/messagetextlayout.h"
+#include <QGuiApplication>
+#include <QTest>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QtMath>
+QTEST_MAIN(MessageTextLayoutTest)
+using namespace Qt::Literals::StringLiterals;
+
+MessageTextLayoutTest::MessageTextLayoutTest(QObject *parent)
+    : QObject{parent}
+{
+}
+
+void MessageTextLayoutTest::shouldRejectComplexHtml_data()
+{
+    QTest::addColumn<QString>("html");
+    QTest::newRow("table") << u"<qt><table><tr><td>foo</td></tr></table></qt>"_s;
+    QTest::newRow("list") << u"<qt><ul><li>foo</li></ul></qt>"_s;
+    QTest::newRow("image") << u"<qt><p><img height='22' width='22' src='foo.png' title=':foo:'/></p></qt>"_s;
+    QTest::newRow("comment") << u"<qt><p>foo</p><!--pending-highlighting--></qt>"_s;
+    QTest::newRow("unknown-style") << u"<qt><p><span style='text-decoration: overline'>foo</span></p></qt>"_s;
+    QTest::newRow("unknown-entity") << u"<qt><p>foo &euro;</p></qt>"_s;
+    QTest::newRow("not-closed-tag") << u"<qt><p>foo <b</p></qt>"_s;
+    QTest::newRow("empty") << QString();
+}
+
+void MessageTextLayoutTest::shouldRejectComplexHtml()
+{
+    QFETCH(QString, html);
+    QVERIFY(!MessageTextLayout::create(html, QGuiApplication::font()));
+}
+
+void MessageTextLayoutTest::shouldExtractPlainText_data()
+{
+    QTest::addColumn<QString>("html");
+    QTest::addColumn<QString>("plainText");
+    QTest::addColumn<int>("paragraphCount");
+    QTest::newRow("simpletext") << u"<qt><p>foo</p>\n</qt>"_s << u"foo"_s << 1;
+    QTest::newRow("without-paragraph") << u"<qt>foo bar</qt>"_s << u"foo bar"_s << 1;
+    QTest::newRow("paragraphs") << u"<qt><p>foo</p>\n<p>bar</p>\n</qt>"_s << u"foo\nbar"_s << 2;
+    QTest::newRow("line-break") << u"<qt><p>bla<br />\n<code style='background-color:#ff0000'>toto</code></p>\n</qt>"_s << u"bla\ntoto"_s << 1;
+    QTest::newRow("white-spaces") << u"<qt><p>  foo   \n bar</p></qt>"_s << u"foo bar"_s << 1;
+    QTest::newRow("entities") << u"<qt><p>bla &gt; toto &amp; &quot;a&quot; &#128578;</p></qt>"_s << u"bla > toto & \"a\" 🙂"_s << 1;
+    QTest::newRow("styles") << u"<qt><p><strong>foo</strong> <em>bar</em> <s>del</s></p></qt>"_s << u"foo bar del"_s << 1;
+    QTest::newRow("emoji") << u"<qt><p><span style=\"font: x-large Noto Color Emoji\" title=\":slight_smile:\">🙂</span></p></qt>"_s << u"🙂"_s << 1;
+    QTest::newRow("highlight") << u"<qt><p><a style=\"color:#ffffff;background-color:#ff0000;font-weight:bold\">foo</a></p></qt>"_s << u"foo"_s << 1;
+}
+
+void MessageTextLayoutTest::shouldExtractPlainText()
+{
+    QFETCH(QString, html);
+    QFETCH(QString, plainText);
+    QFETCH(int, paragraphCount);
+    const auto layout = MessageTextLayout::create(html, QGuiApplication::font());
+    QVERIFY(layout);
+    QCOMPARE(layout->toPlainText(), plainText);
+    QCOMPARE(layout->paragraphCount(), paragraphCount);
+
+    // Same as QTextDocument
+    QTextDocument document;
+    document.setHtml(html);
+    QCOMPARE(layout->toPlainText(), document.toPlainText());
+}
+
+void MessageTextLayoutTest::shouldFindAnchors()
+{
+    const auto layout =
+        MessageTextLayout::create(u"<qt><p><a href='ruqola:/user/foo'>@foo</a> bla <span title='tooltip'>bli</span></p></qt>"_s, QGuiApplication::font());
+    QVERIFY(layout);
+    const QPoint firstCharacter(1, qRound(layout->baseLine()) - 1);
+    QCOMPARE(layout->anchorAt(firstCharacter), u"ruqola:/user/foo"_s);
+    QVERIFY(layout->formatAt(firstCharacter).isAnchor());
+
+    const QPoint lastCharacter(layout->size().width() - 1, qRound(layout->baseLine()) - 1);
+    QVERIFY(layout->anchorAt(lastCharacter).isEmpty());
+    QCOMPARE(layout->formatAt(lastCharacter).toolTip(), u"tooltip"_s);
+
+    // Outside of text
+    QVERIFY(layout->anchorAt(QPoint(1, layout->size().height() + 10)).isEmpty());
+}
+
+void MessageTextLayoutTest::shouldWrapText()
+{
+    const auto layout = MessageTextLayout::create(u"<qt><p>foo bar foo bar foo bar foo bar</p>\n<p>bla</p></qt>"_s, QGuiApplication::font());
+    QVERIFY(layout);
+    const QSize size = layout->size();
+    QVERIFY(size.width() > 0);
+    QVERIFY(size.height() > MessageTextLayout::paragraphSpacing(QGuiApplication::font()));
+
+    layout->setTextWidth(size.width() / 3);
+    QCOMPARE(layout->textWidth(), size.width() / 3);
+    QVERIFY(layout->size().height() > size.height());
+    QVERIFY(layout->size().width() <= size.width() / 3);
+
+    layout->setTextWidth(-1);
+    QCOMPARE(layout->size(), size);
+}
+
+void MessageTextLayoutTest::shouldUseParagraphSpacingOfDocument()
+{
+    const QFont font = QGuiApplication::font();
+    const qreal spacing = MessageTextLayout::paragraphSpacing(font);
+    QVERIFY(spacing > 0);
+    // Cached per font
+    QCOMPARE(MessageTextLayout::paragraphSpacing(font), spacing);
+}
+
+void MessageTextLayoutTest::shouldHaveDocumentSize_data()
+{
+    QTest::addColumn<QString>("html");
+    QTest::addColumn<int>("width");
+    QTest::newRow("simpletext") << u"<qt><p>foo</p>\n</qt>"_s << -1;
+    QTest::newRow("without-paragraph") << u"<qt>foo bar</qt>"_s << -1;
+    QTest::newRow("paragraphs") << u"<qt><p>foo</p>\n<p>bar</p>\n</qt>"_s << -1;
+    QTest::newRow("three-paragraphs") << u"<qt><p>foo</p>\n<p>bar</p>\n<p>bla</p>\n</qt>"_s << -1;
+    QTest::newRow("line-break") << u"<qt><p>bla<br />\ntoto</p>\n</qt>"_s << -1;
+    QTest::newRow("styles") << u"<qt><p><strong>foo</strong> <em>bar</em> <s>del</s></p></qt>"_s << -1;
+    QTest::newRow("wrapped") << u"<qt><p>foo bar foo bar foo bar foo bar foo bar foo bar</p>\n<p>bla</p></qt>"_s << 60;
+    QTest::newRow("wrapped-without-paragraph") << u"<qt>foo bar foo bar foo bar foo bar foo bar foo bar</qt>"_s << 60;
+}
+
+void MessageTextLayoutTest::shouldHaveDocumentSize()
+{
+    QFETCH(QString, html);
+    QFETCH(int, width);
+    const QFont font = QGuiApplication::font();
+    const auto layout = MessageTextLayout::create(html, font);
+    QVERIFY(layout);
+    layout->setTextWidth(width);
+
+    // Configured as MessageDelegateUtils::createTextDocument()
+    QTextDocument document;
+    document.setHtml(html);
+    document.setTextWidth(width);
+    document.setDefaultFont(font);
+    QTextFrame *frame = document.rootFrame();
+    QTextFrameFormat frameFormat = frame->frameFormat();
+    frameFormat.setMargin(0);
+    frame->setFrameFormat(frameFormat);
+
+    const int documentWidth = qCeil(width < 0 ? document.idealWidth() : qMin<qreal>(document.idealWidth(), width));
+    const int documentHeight = qCeil(document.size().height());
+    QVERIFY2(qAbs(layout->size().width() - documentWidth) <= 1, qPrintable(u"%1 != %2"_s.arg(layout->size().width()).arg(documentWidth)));
+    QVERIFY2(qAbs(layout->size().height() - documentHeight) <= 1, qPrintable(u"%1 != %2"_s.arg(layout->size().height()).arg(documentHeight)));
+}
+
+void MessageTextLayoutTest::shouldUseDocumentPositions()
+{
+    const auto layout = MessageTextLayout::create(u"<qt><p>foo</p>\n<p>bar</p></qt>"_s, QGuiApplication::font());
+    QVERIFY(layout);
+    QCOMPARE(layout->hitTest(QPoint(0, 1), Qt::FuzzyHit), 0);
+    // Second paragraph starts after "foo" and the block separator
+    QCOMPARE(layout->hitTest(QPoint(0, layout->size().height() - 1), Qt::FuzzyHit), 4);
+    QCOMPARE(layout->hitTest(QPoint(layout->size().width() + 100, layout->size().height() - 1), Qt::FuzzyHit), 7);
+    QCOMPARE(layout->hitTest(QPoint(layout->size().width() + 100, layout->size().height() - 1), Qt::ExactHit), -1);
+}
+
+#include "moc_messagetextlayouttest.cpp"
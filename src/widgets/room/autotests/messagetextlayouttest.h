@@ -0,0 +1,28 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+class MessageTextLayoutTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageTextLayoutTest(QObject *parent = nullptr);
+    ~MessageTextLayoutTest() override = default;
+private Q_SLOTS:
+    void shouldRejectComplexHtml_data();
+    void shouldRejectComplexHtml();
+    void shouldExtractPlainText_data();
+    void shouldExtractPlainText();
+    void shouldFindAnchors();
+    void shouldWrapText();
+    void shouldUseParagraphSpacingOfDocument();
+    void shouldHaveDocumentSize_data();
+    void shouldHaveDocumentSize();
+    void shouldUseDocumentPositions();
+};
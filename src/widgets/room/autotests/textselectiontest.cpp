@@ -124,6 +124,10 @@ void TextSelectionTest::testChangingSelection()
     QVERIFY(selection.contains(index2, 2)); // (arguable, end of selection)
     QVERIFY(!selection.contains(index2, 3));
     QVERIFY(!selection.contains(index3, 0));
+    QVERIFY(!selection.containsRow(index0));
+    QVERIFY(selection.containsRow(index1));
+    QVERIFY(selection.containsRow(index2));
+    QVERIFY(!selection.containsRow(index3));
 
     // Now move up and reverse selection
     spy.clear();
@@ -144,6 +148,10 @@ void TextSelectionTest::testChangingSelection()
     QVERIFY(selection.contains(index1, 3)); // (arguable, end of selection)
     QVERIFY(!selection.contains(index2, 0));
     QVERIFY(!selection.contains(index3, 0));
+    QVERIFY(selection.containsRow(index0));
+    QVERIFY(selection.containsRow(index1));
+    QVERIFY(!selection.containsRow(index2));
+    QVERIFY(!selection.containsRow(index3));
 }
 
 void TextSelectionTest::testSingleLineReverseSelection()
@@ -232,8 +240,10 @@ void TextSelectionTest::textClear()
     QVERIFY(!selection.hasSelection());
     selection.selectMessage(index1);
     QVERIFY(selection.hasSelection());
+    QVERIFY(selection.containsRow(index1));
     selection.clear();
     QVERIFY(!selection.hasSelection());
+    QVERIFY(!selection.containsRow(index1));
 }
 
 #include "moc_textselectiontest.cpp"
@@ -40,7 +40,7 @@ void MessageDelegateHelperBase::removeMessageCache(const QByteArray &messageId)
 
 void MessageDelegateHelperBase::clearTextDocumentCache()
 {
-    TextUiBase::clearCache();
+    clearCache();
 }
 
 QSize MessageDelegateHelperBase::documentDescriptionForIndexSize(const DocumentDescriptionInfo &info) const
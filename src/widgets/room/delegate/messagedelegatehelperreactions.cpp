@@ -49,7 +49,7 @@ MessageDelegateHelperReactions::layoutReactions(const QList<Reaction> &reactions
         } else {
             const QString fileName = emojiManager->customEmojiFileName(reaction.reactionName());
             if (!fileName.isEmpty()) {
-                const QUrl emojiUrl = mRocketChatAccount->attachmentUrlFromLocalCache(fileName);
+                const QUrl emojiUrl = mRocketChatAccount->emojiUrlFromLocalCache(fileName);
                 if (emojiUrl.isEmpty()) {
                     // The download is happening, this will all be updated again later
                 } else {
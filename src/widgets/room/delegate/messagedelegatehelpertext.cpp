@@ -8,6 +8,7 @@
 
 #include "colorsandmessageviewstyle.h"
 #include "delegateutils/messagedelegateutils.h"
+#include "highlightedcodecache.h"
 #include "messagecache.h"
 #include "model/messagesmodel.h"
 #include "model/threadmessagemodel.h"
@@ -21,16 +22,25 @@
 #include <QAbstractItemView>
 #include <QAbstractTextDocumentLayout>
 #include <QDrag>
+#include <QGuiApplication>
 #include <QListView>
 #include <QMimeData>
 #include <QPainter>
 #include <QStyleOptionViewItem>
+#include <QTextCursor>
 #include <QToolTip>
 
 using namespace Qt::Literals::StringLiterals;
 MessageDelegateHelperText::MessageDelegateHelperText(RocketChatAccount *account, QListView *view, TextSelectionImpl *textSelectionImpl)
     : MessageDelegateHelperBase(account, view, textSelectionImpl)
 {
+    // Layouts are much smaller than documents, keep more of them
+    mTextLayoutCache.setMaxEntries(256);
+    // Colors are part of the converted text, one connection for all layouts
+    connect(&ColorsAndMessageViewStyle::self(), &ColorsAndMessageViewStyle::needToUpdateColors, this, [this]() {
+        mTextLayoutCache.clear();
+        mListView->viewport()->update();
+    });
 }
 
 MessageDelegateHelperText::~MessageDelegateHelperText() = default;
@@ -126,6 +136,9 @@ QString MessageDelegateHelperText::makeMessageText(const QPersistentModelIndex &
 
 QString MessageDelegateHelperText::urlAt(const QModelIndex &index, QPoint relativePos) const
 {
+    if (auto layout = textLayoutForIndex(index, -1, false)) {
+        return layout->anchorAt(relativePos);
+    }
     auto document = documentForIndex(index);
     if (!document) {
         return {};
@@ -136,6 +149,23 @@ QString MessageDelegateHelperText::urlAt(const QModelIndex &index, QPoint relati
 
 void MessageDelegateHelperText::draw(QPainter *painter, QRect rect, const QModelIndex &index, const QStyleOptionViewItem &option)
 {
+    if (const auto *layout = textLayoutForIndex(index, rect.width(), true)) {
+        int selectionStart = -1;
+        int selectionEnd = -1;
+        TextSelection *textSelection = mTextSelectionImpl->textSelection();
+        if (textSelection->containsRow(index)) {
+            // Selection positions are computed on the document, only created for the selected rows
+            const QTextCursor cursor = textSelection->selectionForIndex(index, documentForIndex(index));
+            if (!cursor.isNull()) {
+                selectionStart = cursor.selectionStart();
+                selectionEnd = cursor.selectionEnd();
+            }
+        }
+        const bool grayText = MessageDelegateUtils::useItalicsForMessage(index) || MessageDelegateUtils::pendingMessage(index);
+        const QColor textColor = grayText ? QColor(Qt::gray) : option.palette.color(QPalette::Text);
+        layout->draw(painter, rect.topLeft(), textColor, option.palette, selectionStart, selectionEnd);
+        return;
+    }
     auto *doc = documentForIndex(index, rect.width(), true);
     if (!doc) {
         return;
@@ -146,10 +176,38 @@ void MessageDelegateHelperText::draw(QPainter *painter, QRect rect, const QModel
 QSize MessageDelegateHelperText::sizeHint(const QModelIndex &index, int maxWidth, const QStyleOptionViewItem &option, qreal *pBaseLine) const
 {
     Q_UNUSED(option)
+    if (const auto *layout = textLayoutForIndex(index, maxWidth, true)) {
+        *pBaseLine = layout->baseLine();
+        return layout->size();
+    }
     auto *doc = documentForIndex(index, maxWidth, true);
     return MessageDelegateUtils::textSizeHint(doc, pBaseLine);
 }
 
+bool MessageDelegateHelperText::hitTest(const QModelIndex &index, int width, QPoint pos, Qt::HitTestAccuracy accuracy, bool connectToUpdates, int &charPos) const
+{
+    if (const auto *layout = textLayoutForIndex(index, width, connectToUpdates)) {
+        charPos = layout->hitTest(pos, accuracy);
+        return true;
+    }
+    if (const auto *doc = documentForIndex(index, width, connectToUpdates)) {
+        charPos = doc->documentLayout()->hitTest(pos, accuracy);
+        return true;
+    }
+    return false;
+}
+
+QString MessageDelegateHelperText::anchorAt(const QModelIndex &index, int width, QPoint pos) const
+{
+    if (const auto *layout = textLayoutForIndex(index, width, true)) {
+        return layout->anchorAt(pos);
+    }
+    if (const auto *doc = documentForIndex(index, width, true)) {
+        return doc->documentLayout()->anchorAt(pos);
+    }
+    return {};
+}
+
 bool MessageDelegateHelperText::handleMouseEvent(QMouseEvent *mouseEvent, QRect messageRect, const QStyleOptionViewItem &option, const QModelIndex &index)
 {
     Q_UNUSED(option)
@@ -159,17 +217,19 @@ bool MessageDelegateHelperText::handleMouseEvent(QMouseEvent *mouseEvent, QRect
 
     const QPoint pos = mouseEvent->pos() - messageRect.topLeft();
     const QEvent::Type eventType = mouseEvent->type();
+    int charPos = -1;
     // Text selection
     switch (eventType) {
     case QEvent::MouseButtonPress:
         mTextSelectionImpl->setMightStartDrag(false);
-        if (const auto *doc = documentForIndex(index, messageRect.width(), true)) {
-            const int charPos = doc->documentLayout()->hitTest(pos, Qt::FuzzyHit);
+        if (hitTest(index, messageRect.width(), pos, Qt::FuzzyHit, true, charPos)) {
             qCDebug(RUQOLAWIDGETS_SELECTION_LOG) << "pressed at pos" << charPos;
             if (charPos == -1) {
                 return false;
             }
-            if (mTextSelectionImpl->textSelection()->contains(index, charPos) && doc->documentLayout()->hitTest(pos, Qt::ExactHit) != -1) {
+            int exactCharPos = -1;
+            if (mTextSelectionImpl->textSelection()->contains(index, charPos) && hitTest(index, messageRect.width(), pos, Qt::ExactHit, true, exactCharPos)
+                && exactCharPos != -1) {
                 mTextSelectionImpl->setMightStartDrag(true);
                 return true;
             }
@@ -185,8 +245,7 @@ bool MessageDelegateHelperText::handleMouseEvent(QMouseEvent *mouseEvent, QRect
         break;
     case QEvent::MouseMove:
         if (!mTextSelectionImpl->mightStartDrag()) {
-            if (const auto *doc = documentForIndex(index, messageRect.width(), true)) {
-                const int charPos = doc->documentLayout()->hitTest(pos, Qt::FuzzyHit);
+            if (hitTest(index, messageRect.width(), pos, Qt::FuzzyHit, true, charPos)) {
                 if (charPos != -1) {
                     // QWidgetTextControl also has code to support isPreediting()/commitPreedit(), selectBlockOnTripleClick
                     mTextSelectionImpl->textSelection()->setTextSelectionEnd(index, charPos);
@@ -200,12 +259,15 @@ bool MessageDelegateHelperText::handleMouseEvent(QMouseEvent *mouseEvent, QRect
         MessageDelegateUtils::setClipboardSelection(mTextSelectionImpl->textSelection());
         // Clicks on links
         if (!mTextSelectionImpl->textSelection()->hasSelection()) {
-            if (const auto *doc = documentForIndex(index, messageRect.width(), true)) {
-                const QString link = doc->documentLayout()->anchorAt(pos);
-                if (!link.isEmpty()) {
-                    Q_EMIT mRocketChatAccount->openLinkRequested(link);
-                    return true;
-                }
+            const QString link = anchorAt(index, messageRect.width(), pos);
+            if (link.startsWith("ruqola:/showfullmessage/"_L1)) {
+                auto model = const_cast<QAbstractItemModel *>(index.model());
+                model->setData(index, true, MessagesModel::ShowFullMessage);
+                return true;
+            }
+            if (!link.isEmpty()) {
+                Q_EMIT mRocketChatAccount->openLinkRequested(link);
+                return true;
             }
         } else if (mTextSelectionImpl->mightStartDrag()) {
             // clicked into selection, didn't start drag, clear it (like kwrite and QTextEdit)
@@ -215,8 +277,7 @@ bool MessageDelegateHelperText::handleMouseEvent(QMouseEvent *mouseEvent, QRect
         break;
     case QEvent::MouseButtonDblClick:
         if (!mTextSelectionImpl->textSelection()->hasSelection()) {
-            if (const auto *doc = documentForIndex(index, messageRect.width(), true)) {
-                const int charPos = doc->documentLayout()->hitTest(pos, Qt::FuzzyHit);
+            if (hitTest(index, messageRect.width(), pos, Qt::FuzzyHit, true, charPos)) {
                 qCDebug(RUQOLAWIDGETS_SELECTION_LOG) << "double-clicked at pos" << charPos;
                 if (charPos == -1) {
                     return false;
@@ -238,13 +299,20 @@ bool MessageDelegateHelperText::handleHelpEvent(QHelpEvent *helpEvent, QRect mes
         return false;
     }
 
+    const QPoint pos = helpEvent->pos() - messageRect.topLeft();
+    QString formattedTooltip;
+    if (const auto *layout = textLayoutForIndex(index, messageRect.width(), true)) {
+        if (MessageDelegateUtils::generateToolTip(layout->formatAt(pos), formattedTooltip)) {
+            QToolTip::showText(helpEvent->globalPos(), formattedTooltip, mListView);
+        }
+        return true;
+    }
+
     const auto *doc = documentForIndex(index, messageRect.width(), true);
     if (!doc) {
         return false;
     }
 
-    const QPoint pos = helpEvent->pos() - messageRect.topLeft();
-    QString formattedTooltip;
     if (MessageDelegateUtils::generateToolTip(doc, pos, formattedTooltip)) {
         QToolTip::showText(helpEvent->globalPos(), formattedTooltip, mListView);
         return true;
@@ -259,9 +327,9 @@ bool MessageDelegateHelperText::maybeStartDrag(QMouseEvent *mouseEvent, QRect me
     }
     if (mTextSelectionImpl->textSelection()->hasSelection()) {
         const QPoint pos = mouseEvent->pos() - messageRect.topLeft();
-        const auto *doc = documentForIndex(index, messageRect.width(), false);
-        const int charPos = doc->documentLayout()->hitTest(pos, Qt::FuzzyHit);
-        if (charPos != -1 && mTextSelectionImpl->textSelection()->contains(index, charPos)) {
+        int charPos = -1;
+        if (hitTest(index, messageRect.width(), pos, Qt::FuzzyHit, false, charPos) && charPos != -1
+            && mTextSelectionImpl->textSelection()->contains(index, charPos)) {
             auto mimeData = new QMimeData;
             mimeData->setHtml(mTextSelectionImpl->textSelection()->selectedText(TextSelection::Format::Html));
             mimeData->setText(mTextSelectionImpl->textSelection()->selectedText(TextSelection::Format::Text));
@@ -312,15 +380,100 @@ QTextDocument *MessageDelegateHelperText::documentForIndex(const QModelIndex &in
     if (text.isEmpty()) {
         return nullptr;
     }
-    auto doc = MessageDelegateUtils::createTextDocument(MessageDelegateUtils::useItalicsForMessage(index), text, width);
+    return createDocument(messageId, persistentIndex, text, width);
+}
+
+QTextDocument *
+MessageDelegateHelperText::createDocument(const QByteArray &messageId, const QPersistentModelIndex &persistentIndex, const QString &text, int width) const
+{
+    auto doc = MessageDelegateUtils::createTextDocument(MessageDelegateUtils::useItalicsForMessage(persistentIndex), text, width);
     auto ret = doc.get();
     connect(&ColorsAndMessageViewStyle::self(), &ColorsAndMessageViewStyle::needToUpdateColors, ret, [this, persistentIndex, ret]() {
         ret->setHtml(makeMessageText(persistentIndex, false));
         auto that = const_cast<MessageDelegateHelperText *>(this);
         that->updateView(persistentIndex);
     });
+    if (text.contains(HighlightedCodeCache::pendingHighlightingMarker())) {
+        // A large code block is highlighted in background, use it when it's done
+        connect(&HighlightedCodeCache::self(), &HighlightedCodeCache::codeHighlighted, ret, [this, persistentIndex, ret]() {
+            if (!persistentIndex.isValid()) {
+                return;
+            }
+            const QString newText = makeMessageText(persistentIndex, false);
+            if (newText.contains(HighlightedCodeCache::pendingHighlightingMarker())) {
+                return;
+            }
+            ret->setHtml(newText);
+            auto that = const_cast<MessageDelegateHelperText *>(this);
+            that->updateView(persistentIndex);
+        });
+    }
     mDocumentCache.insert(messageId, std::move(doc));
     return ret;
 }
 
+MessageTextLayout *MessageDelegateHelperText::textLayoutForIndex(const QModelIndex &index, int width, bool connectToUpdates) const
+{
+    Q_ASSERT(index.isValid());
+    const Message *message = index.data(MessagesModel::MessagePointer).value<Message *>();
+    Q_ASSERT(message);
+    const auto messageId = message->messageId();
+    Q_ASSERT(!messageId.isEmpty());
+
+    auto it = mTextLayoutCache.find(messageId);
+    if (it != mTextLayoutCache.end()) {
+        auto ret = it->value.get();
+        if (ret && width != -1) {
+            ret->setTextWidth(width);
+        }
+        return ret;
+    }
+
+    const auto persistentIndex = QPersistentModelIndex(index);
+    const QString text = makeMessageText(persistentIndex, connectToUpdates);
+    std::unique_ptr<MessageTextLayout> layout;
+    if (!text.isEmpty()) {
+        QFont font = QGuiApplication::font();
+        font.setItalic(MessageDelegateUtils::useItalicsForMessage(index));
+        layout = MessageTextLayout::create(text, font);
+        if (!layout && mDocumentCache.find(messageId) == mDocumentCache.end()) {
+            // Complex content: create the document now, text is already converted
+            (void)createDocument(messageId, persistentIndex, text, width);
+        }
+    }
+    auto ret = layout.get();
+    if (ret && width != -1) {
+        ret->setTextWidth(width);
+    }
+    mTextLayoutCache.insert(messageId, std::move(layout));
+    return ret;
+}
+
+bool MessageDelegateHelperText::isCached(const QModelIndex &index) const
+{
+    const Message *message = index.data(MessagesModel::MessagePointer).value<Message *>();
+    if (!message) {
+        return false;
+    }
+    const auto messageId = message->messageId();
+    auto it = mTextLayoutCache.find(messageId);
+    if (it == mTextLayoutCache.end()) {
+        return false;
+    }
+    // nullptr layout: complex content, drawn with the document
+    return it->value || mDocumentCache.find(messageId) != mDocumentCache.end();
+}
+
+void MessageDelegateHelperText::removeMessageCache(const QByteArray &messageId)
+{
+    MessageDelegateHelperBase::removeMessageCache(messageId);
+    mTextLayoutCache.remove(messageId);
+}
+
+void MessageDelegateHelperText::clearCache()
+{
+    MessageDelegateHelperBase::clearCache();
+    mTextLayoutCache.clear();
+}
+
 #include "moc_messagedelegatehelpertext.cpp"
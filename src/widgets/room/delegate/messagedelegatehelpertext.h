@@ -10,6 +10,7 @@
 #include "delegateutils/textselectionimpl.h"
 
 #include "messagedelegatehelperbase.h"
+#include "messagetextlayout.h"
 
 #include <QModelIndex>
 #include <QSize>
@@ -40,6 +41,13 @@ public:
 
     [[nodiscard]] QString urlAt(const QModelIndex &index, QPoint relativePos) const;
 
+    void removeMessageCache(const QByteArray &messageId) override;
+    // Returns true when the layout (or the document for complex content) of @p index is in cache
+    [[nodiscard]] bool isCached(const QModelIndex &index) const;
+
+protected:
+    void clearCache() override;
+
 private:
     friend class TextSelection; // for documentForIndex
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QString makeMessageText(const QPersistentModelIndex &index, bool connectToUpdates) const;
@@ -51,6 +59,19 @@ private:
      */
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QTextDocument *documentForIndex(const QModelIndex &index) const override;
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QTextDocument *documentForIndex(const QModelIndex &index, int width, bool connectToUpdates) const;
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QTextDocument *
+    createDocument(const QByteArray &messageId, const QPersistentModelIndex &persistentIndex, const QString &text, int width) const;
+    /**
+     * Returns the lightweight layout of @p index, laid out for @p width.
+     * nullptr when the message needs a QTextDocument (complex content) or has no text.
+     */
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT MessageTextLayout *textLayoutForIndex(const QModelIndex &index, int width, bool connectToUpdates) const;
+    // Returns false when message has no text
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT bool
+    hitTest(const QModelIndex &index, int width, QPoint pos, Qt::HitTestAccuracy accuracy, bool connectToUpdates, int &charPos) const;
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QString anchorAt(const QModelIndex &index, int width, QPoint pos) const;
 
+    // nullptr value: message uses a QTextDocument
+    mutable LRUCache<QByteArray, std::unique_ptr<MessageTextLayout>> mTextLayoutCache;
     bool mShowThreadContext = true;
 };
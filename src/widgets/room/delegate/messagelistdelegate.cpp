@@ -89,7 +89,6 @@ MessageListDelegate::MessageListDelegate(RocketChatAccount *account, QListView *
     connect(&ColorsAndMessageViewStyle::self(), &ColorsAndMessageViewStyle::needUpdateMessageStyle, this, &MessageListDelegate::switchMessageLayout);
     connect(&ColorsAndMessageViewStyle::self(), &ColorsAndMessageViewStyle::needUpdateFontSize, this, &MessageListDelegate::clearAvatarSizeHintCache);
     slotUpdateColors();
-    mSizeHintCache.setMaxEntries(32); // Enough ?
 }
 
 MessageListDelegate::~MessageListDelegate()
@@ -195,6 +194,7 @@ MessageAttachmentDelegateHelperBase *MessageListDelegate::attachmentsHelper(cons
 
 void MessageListDelegate::setSearchText(const QString &newSearchText)
 {
+    const QString oldSearchText = mHelperText->searchText();
     bool needClearDocumentCache = false;
     if (mHelperText->searchText() != newSearchText) {
         mHelperText->setSearchText(newSearchText);
@@ -234,7 +234,28 @@ void MessageListDelegate::setSearchText(const QString &newSearchText)
         needClearDocumentCache = true;
     }
     if (needClearDocumentCache) {
-        mSizeHintCache.clear();
+        // Only messages where the search text was or is highlighted are rendered differently
+        removeSizeHintCache([&oldSearchText, &newSearchText](const Message *message) {
+            const auto containsSearchText = [message](const QString &searchText) {
+                if (searchText.isEmpty()) {
+                    return false;
+                }
+                if (message->text().contains(searchText, Qt::CaseInsensitive)) {
+                    return true;
+                }
+                if (message->attachments()) {
+                    const auto messageAttachments = message->attachments()->messageAttachments();
+                    for (const MessageAttachment &attachment : messageAttachments) {
+                        if (attachment.description().contains(searchText, Qt::CaseInsensitive)
+                            || attachment.text().contains(searchText, Qt::CaseInsensitive)) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            };
+            return containsSearchText(oldSearchText) || containsSearchText(newSearchText);
+        });
     }
 }
 
@@ -310,6 +331,20 @@ void MessageListDelegate::removeSizeHintCache(const QByteArray &messageId)
     mSizeHintCache.remove(messageId);
 }
 
+void MessageListDelegate::removeSizeHintCache(const std::function<bool(const Message *)> &matches)
+{
+    const QAbstractItemModel *model = mListView ? mListView->model() : nullptr;
+    if (!model) {
+        return;
+    }
+    for (int row = 0, total = model->rowCount(); row < total; ++row) {
+        const Message *message = model->index(row, 0).data(MessagesModel::MessagePointer).value<Message *>();
+        if (message && matches(message)) {
+            mSizeHintCache.remove(message->messageId());
+        }
+    }
+}
+
 void MessageListDelegate::needUpdateIndexBackground(const QPersistentModelIndex &index, const QColor &color)
 {
     auto it = std::find_if(mIndexBackgroundColorList.cbegin(), mIndexBackgroundColorList.cend(), [index](const IndexBackgroundColor &key) {
@@ -362,7 +397,10 @@ void MessageListDelegate::removeMessageCache(const Message *message)
 
 void MessageListDelegate::clearTextDocumentCache()
 {
-    mSizeHintCache.clear();
+    // Rendering of the room changed (translation, ignored users...): messages of other rooms keep their sizes
+    removeSizeHintCache([](const Message *) {
+        return true;
+    });
     mHelperText->clearTextDocumentCache();
     mHelperAttachmentImage->clearTextDocumentCache();
     mHelperAttachmentFile->clearTextDocumentCache();
@@ -696,11 +734,20 @@ void MessageListDelegate::clearSizeHintCache()
     mSizeHintCache.clear();
 }
 
-QByteArray MessageListDelegate::cacheIdentifier(const QModelIndex &index) const
+MessageSizeHintStore::Key MessageListDelegate::sizeHintKey(const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
     const Message *message = index.data(MessagesModel::MessagePointer).value<Message *>();
     Q_ASSERT(message);
-    return message->messageId();
+    MessageSizeHintStore::Key key;
+    key.messageId = message->messageId();
+    key.revision = message->updatedAt();
+    key.width = option.rect.width();
+    key.layoutMode = RuqolaGlobalConfig::self()->messageStyle();
+    key.styleRevision = mSizeHintStyleRevision;
+    // Inserting or removing the previous row changes them
+    key.sameSenderAsPreviousMessage = mMessageListLayoutBase->sameSenderAsPreviousMessage(index, message);
+    key.dateDiffersFromPrevious = index.data(MessagesModel::DateDiffersFromPrevious).toBool();
+    return key;
 }
 
 MessageDelegateHelperUrlPreview *MessageListDelegate::helperUrlPreview() const
@@ -711,24 +758,78 @@ MessageDelegateHelperUrlPreview *MessageListDelegate::helperUrlPreview() const
 QSize MessageListDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
 #if USE_SIZEHINT_CACHE_SUPPORT
-    const QByteArray identifier = cacheIdentifier(index);
-    auto it = mSizeHintCache.find(identifier);
-    if (it != mSizeHintCache.end()) {
-        const QSize result = it->value;
+    if (mEstimateSizeHints) {
+        // Visible messages are measured at their exact width by the view
+        const QSize result = mSizeHintCache.sizeHint(sizeHintKey(option, index), MessageSizeHintStore::WidthMatch::Bucket);
+        if (result.isValid()) {
+            qCDebug(RUQOLA_SIZEHINT_CACHE_LOG) << "MessageListDelegate: SizeHint found in cache: " << result;
+            return result;
+        }
+        return {option.rect.width(), estimatedHeight(option)};
+    }
+#endif
+    return measuredSizeHint(option, index);
+}
+
+QSize MessageListDelegate::measuredSizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+#if USE_SIZEHINT_CACHE_SUPPORT
+    const MessageSizeHintStore::Key key = sizeHintKey(option, index);
+    const QSize result = mSizeHintCache.sizeHint(key);
+    if (result.isValid()) {
         qCDebug(RUQOLA_SIZEHINT_CACHE_LOG) << "MessageListDelegate: SizeHint found in cache: " << result;
         return result;
     }
 #endif
 
     const QSize size = mMessageListLayoutBase->sizeHint(option, index);
-#if USE_SIZEHINT_CACHE_SUPPORT
     if (!size.isEmpty()) {
-        mSizeHintCache.insert(identifier, size);
-    }
+#if USE_SIZEHINT_CACHE_SUPPORT
+        mSizeHintCache.insert(key, size);
 #endif
+    }
     return size;
 }
 
+void MessageListDelegate::setEstimateSizeHints(bool estimate)
+{
+    mEstimateSizeHints = estimate;
+}
+
+bool MessageListDelegate::estimateSizeHints() const
+{
+    return mEstimateSizeHints;
+}
+
+int MessageListDelegate::estimatedHeight(const QStyleOptionViewItem &option) const
+{
+    // Author line and a line of text. It doesn't depend on the messages measured until now:
+    // changing it would move all the rows not measured yet, and the scroll range with them
+    return option.fontMetrics.height() * 3;
+}
+
+bool MessageListDelegate::preRender(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    // Rows around the viewport are scheduled again on each scroll, most of them are already done
+    const bool textCached = mHelperText->isCached(index);
+#if USE_SIZEHINT_CACHE_SUPPORT
+    const bool sizeHintCached = mSizeHintCache.sizeHint(sizeHintKey(option, index)).isValid();
+#else
+    // Without cache the view measures the message again anyway, only the text matters
+    const bool sizeHintCached = true;
+#endif
+    if (textCached && sizeHintCached) {
+        return false;
+    }
+    if (sizeHintCached) {
+        // Text cache was purged: layouting creates the text documents again
+        (void)mMessageListLayoutBase->sizeHint(option, index);
+    } else {
+        (void)measuredSizeHint(option, index);
+    }
+    return true;
+}
+
 static void positionPopup(QPoint pos, QWidget *parentWindow, QWidget *popup)
 {
     const QRect screenRect = parentWindow->screen()->availableGeometry();
@@ -1066,7 +1167,8 @@ void MessageListDelegate::slotPrivateSettingsChanged()
 
 void MessageListDelegate::clearAvatarSizeHintCache()
 {
-    clearSizeHintCache();
+    // All messages are rendered differently: their sizes are replaced when they are measured again
+    ++mSizeHintStyleRevision;
     mAvatarCacheManager->clearCache();
 }
 
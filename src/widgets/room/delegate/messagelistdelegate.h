@@ -10,9 +10,10 @@
 #include "messagelistlayout/messagelistlayoutbase.h"
 #include "room.h"
 
-#include "lrucache.h"
+#include "messagesizehintstore.h"
 #include <QItemDelegate>
 #include <QScopedPointer>
+#include <functional>
 
 class QListView;
 class RocketChatAccount;
@@ -60,6 +61,20 @@ public:
 
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
     [[nodiscard]] QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    /// Real size of the message, never an estimation
+    [[nodiscard]] QSize measuredSizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+    /**
+     * When enabled, sizeHint() returns an estimated height for messages which are not measured yet,
+     * so laying out a huge room doesn't layout all its messages. The view measures the visible ones.
+     */
+    void setEstimateSizeHints(bool estimate);
+    [[nodiscard]] bool estimateSizeHints() const;
+    [[nodiscard]] int estimatedHeight(const QStyleOptionViewItem &option) const;
+    /**
+     * Layouts the message ahead of painting: builds its text document and stores its size hint in cache.
+     * Returns false when both were already cached and nothing was done.
+     */
+    bool preRender(const QStyleOptionViewItem &option, const QModelIndex &index) const;
     [[nodiscard]] bool mouseEvent(QEvent *event, const QStyleOptionViewItem &option, const QModelIndex &index);
     [[nodiscard]] bool maybeStartDrag(QMouseEvent *event, const QStyleOptionViewItem &option, const QModelIndex &index);
 
@@ -105,6 +120,8 @@ public:
     void clearSizeHintCache();
 
     void removeSizeHintCache(const QByteArray &messageId);
+    // Removes size hints of the messages of the view for which @p matches returns true
+    void removeSizeHintCache(const std::function<bool(const Message *)> &matches);
 
     void needUpdateIndexBackground(const QPersistentModelIndex &index, const QColor &color);
     void removeNeedUpdateIndexBackground(const QPersistentModelIndex &index);
@@ -126,13 +143,14 @@ private:
     LIBRUQOLAWIDGETS_NO_EXPORT void
     drawModerationDate(QPainter *painter, const QModelIndex &index, const QStyleOptionViewItem &option, const QString &roomName) const;
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT bool isSystemMessage(const Message *message) const;
-    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QByteArray cacheIdentifier(const QModelIndex &index) const;
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT MessageSizeHintStore::Key sizeHintKey(const QStyleOptionViewItem &option, const QModelIndex &index) const;
 
     friend class MessageListDelegateTest;
 
-    // Cache SizeHint value
-    // We need to clear it when we resize widget.
-    mutable LRUCache<QByteArray, QSize> mSizeHintCache;
+    // Cache SizeHint value, keyed by width: no need to clear it when we resize widget.
+    mutable MessageSizeHintStore mSizeHintCache;
+    int mSizeHintStyleRevision = 0;
+    bool mEstimateSizeHints = false;
 
     const QIcon mEditedIcon;
     const QIcon mRolesIcon;
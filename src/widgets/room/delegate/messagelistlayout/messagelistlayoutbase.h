@@ -107,6 +107,8 @@ public:
     [[nodiscard]] RocketChatAccount *rocketChatAccount() const;
     void setRocketChatAccount(RocketChatAccount *newRocketChatAccount);
 
+    [[nodiscard]] bool sameSenderAsPreviousMessage(const QModelIndex &index, const Message *message) const;
+
 protected:
     void generateSenderInfo(Layout &layout, const Message *message, const QStyleOptionViewItem &option, const QModelIndex &index) const;
     void generateAttachmentBlockAndUrlPreviewLayout(MessageListDelegate *delegate,
@@ -117,7 +119,6 @@ protected:
                                                     int maxWidth,
                                                     const QStyleOptionViewItem &option,
                                                     const QModelIndex &index) const;
-    [[nodiscard]] bool sameSenderAsPreviousMessage(const QModelIndex &index, const Message *message) const;
     [[nodiscard]] QString senderText(const Message *message) const;
     RocketChatAccount *mRocketChatAccount = nullptr;
     MessageListDelegate *mDelegate = nullptr;
@@ -0,0 +1,88 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagesizehintstore.h"
+
+int MessageSizeHintStore::widthBucket(int width)
+{
+    return width / widthBucketSize;
+}
+
+bool MessageSizeHintStore::Entry::matches(const Key &key) const
+{
+    return widthBucket(width) == widthBucket(key.width) && revision == key.revision && layoutMode == key.layoutMode && styleRevision == key.styleRevision
+        && sameSenderAsPreviousMessage == key.sameSenderAsPreviousMessage && dateDiffersFromPrevious == key.dateDiffersFromPrevious;
+}
+
+bool MessageSizeHintStore::Entry::isOutdated(const Key &key) const
+{
+    return revision != key.revision || styleRevision != key.styleRevision;
+}
+
+QSize MessageSizeHintStore::sizeHint(const Key &key, WidthMatch widthMatch) const
+{
+    const auto it = mEntries.constFind(key.messageId);
+    if (it == mEntries.constEnd()) {
+        return {};
+    }
+    for (const Entry &entry : it.value()) {
+        if (entry.matches(key)) {
+            if (entry.width == key.width) {
+                return entry.size;
+            }
+            if (widthMatch == WidthMatch::Bucket) {
+                // Width is the one of the view
+                return {entry.size.width() + key.width - entry.width, entry.size.height()};
+            }
+            return {};
+        }
+    }
+    return {};
+}
+
+void MessageSizeHintStore::insert(const Key &key, QSize size)
+{
+    auto it = mEntries.find(key.messageId);
+    if (it == mEntries.end()) {
+        if (mEntries.count() >= maximumMessages) {
+            // More messages than a room can load: start again
+            mEntries.clear();
+        }
+        it = mEntries.insert(key.messageId, {});
+    }
+    QList<Entry> &entries = it.value();
+    // Sizes computed for an older content or style are useless, one size per bucket
+    entries.removeIf([&key](const Entry &entry) {
+        return entry.isOutdated(key) || (widthBucket(entry.width) == widthBucket(key.width) && entry.layoutMode == key.layoutMode);
+    });
+    if (entries.count() >= maximumSizesPerMessage) {
+        entries.removeLast();
+    }
+    Entry entry;
+    entry.revision = key.revision;
+    entry.width = key.width;
+    entry.layoutMode = key.layoutMode;
+    entry.styleRevision = key.styleRevision;
+    entry.sameSenderAsPreviousMessage = key.sameSenderAsPreviousMessage;
+    entry.dateDiffersFromPrevious = key.dateDiffersFromPrevious;
+    entry.size = size;
+    entries.prepend(std::move(entry));
+}
+
+void MessageSizeHintStore::remove(const QByteArray &messageId)
+{
+    mEntries.remove(messageId);
+}
+
+void MessageSizeHintStore::clear()
+{
+    mEntries.clear();
+}
+
+int MessageSizeHintStore::messageCount() const
+{
+    return mEntries.count();
+}
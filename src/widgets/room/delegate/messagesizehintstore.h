@@ -0,0 +1,73 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolawidgets_private_export.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSize>
+
+/**
+ * Size hints of messages, for all messages of the room.
+ * Each message keeps its size for a few width buckets, so resizing back and forth the view
+ * (splitter, maximize...) doesn't lay out messages again.
+ * The size measured in a bucket is an approximation for the other widths of the bucket:
+ * text can wrap differently, the view measures visible messages at their exact width.
+ */
+class LIBRUQOLAWIDGETS_TESTS_EXPORT MessageSizeHintStore
+{
+public:
+    struct LIBRUQOLAWIDGETS_TESTS_EXPORT Key {
+        QByteArray messageId;
+        // Changes when the message content changes (updatedAt)
+        qint64 revision = 0;
+        int width = 0;
+        int layoutMode = 0;
+        // Changes when rendering of all messages changes (font, display preferences)
+        int styleRevision = 0;
+        // Height also depends on the previous row: sender and date headers are hidden when grouped with it
+        bool sameSenderAsPreviousMessage = false;
+        bool dateDiffersFromPrevious = false;
+    };
+
+    enum class WidthMatch : uint8_t {
+        // Size measured at this width
+        Exact,
+        // Size measured at a width of the same bucket
+        Bucket,
+    };
+
+    // Returns an invalid size when not found
+    [[nodiscard]] QSize sizeHint(const Key &key, WidthMatch widthMatch = WidthMatch::Exact) const;
+    void insert(const Key &key, QSize size);
+    void remove(const QByteArray &messageId);
+    void clear();
+
+    [[nodiscard]] int messageCount() const;
+
+    static constexpr int maximumSizesPerMessage = 4;
+    static constexpr int widthBucketSize = 32;
+    static constexpr int maximumMessages = 20000;
+
+private:
+    struct Entry {
+        qint64 revision = 0;
+        int width = 0;
+        int layoutMode = 0;
+        int styleRevision = 0;
+        bool sameSenderAsPreviousMessage = false;
+        bool dateDiffersFromPrevious = false;
+        QSize size;
+
+        [[nodiscard]] bool matches(const Key &key) const;
+        [[nodiscard]] bool isOutdated(const Key &key) const;
+    };
+    [[nodiscard]] static int widthBucket(int width);
+    // Most recent size first
+    QHash<QByteArray, QList<Entry>> mEntries;
+};
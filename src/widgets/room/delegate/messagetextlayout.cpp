@@ -0,0 +1,605 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagetextlayout.h"
+
+#include <QFontDatabase>
+#include <QGuiApplication>
+#include <QHash>
+#include <QPainter>
+#include <QPalette>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QTextLayout>
+#include <QtMath>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+struct ParsedParagraph {
+    QString text;
+    QList<QTextLayout::FormatRange> formats;
+    bool hasMargins = false;
+};
+
+struct OpenTag {
+    QString name;
+    QTextCharFormat format;
+};
+
+// Without wrapping, as QTextDocument with a text width of -1
+constexpr qreal noWrapLineWidth = 1e7;
+
+bool isHtmlSpace(QChar c)
+{
+    return c == u' ' || c == u'\n' || c == u'\t' || c == u'\r' || c == u'\f';
+}
+
+// Decodes the entity starting at @p position (on '&'), @p position is moved after ';'
+bool decodeEntity(QStringView html, qsizetype &position, QString &result)
+{
+    const qsizetype end = html.indexOf(u';', position);
+    if (end == -1 || end - position > 10) {
+        return false;
+    }
+    const QStringView name = html.mid(position + 1, end - position - 1);
+    position = end + 1;
+    if (name == "amp"_L1) {
+        result += u'&';
+    } else if (name == "lt"_L1) {
+        result += u'<';
+    } else if (name == "gt"_L1) {
+        result += u'>';
+    } else if (name == "quot"_L1) {
+        result += u'"';
+    } else if (name == "apos"_L1) {
+        result += u'\'';
+    } else if (name == "nbsp"_L1) {
+        result += QChar(QChar::Nbsp);
+    } else if (name.startsWith(u'#')) {
+        bool ok = false;
+        const uint code = name.startsWith("#x"_L1) || name.startsWith("#X"_L1) ? name.mid(2).toUInt(&ok, 16) : name.mid(1).toUInt(&ok);
+        if (!ok || code > QChar::LastValidCodePoint) {
+            return false;
+        }
+        const char32_t ucs4 = code;
+        result += QString::fromUcs4(&ucs4, 1);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool decodeEntities(QStringView str, QString &result)
+{
+    result.reserve(str.size());
+    qsizetype position = 0;
+    while (position < str.size()) {
+        if (str.at(position) == u'&') {
+            if (!decodeEntity(str, position, result)) {
+                return false;
+            }
+        } else {
+            result += str.at(position++);
+        }
+    }
+    return true;
+}
+
+bool parseAttributes(QStringView str, QHash<QString, QString> &attributes)
+{
+    qsizetype position = 0;
+    while (true) {
+        while (position < str.size() && isHtmlSpace(str.at(position))) {
+            ++position;
+        }
+        if (position >= str.size()) {
+            return true;
+        }
+        const qsizetype nameStart = position;
+        while (position < str.size() && str.at(position) != u'=' && !isHtmlSpace(str.at(position))) {
+            ++position;
+        }
+        const QString name = str.mid(nameStart, position - nameStart).toString().toLower();
+        QStringView value;
+        if (position < str.size() && str.at(position) == u'=') {
+            ++position;
+            if (position < str.size() && (str.at(position) == u'\'' || str.at(position) == u'"')) {
+                const QChar quote = str.at(position);
+                const qsizetype end = str.indexOf(quote, position + 1);
+                if (end == -1) {
+                    return false;
+                }
+                value = str.mid(position + 1, end - position - 1);
+                position = end + 1;
+            } else {
+                const qsizetype valueStart = position;
+                while (position < str.size() && !isHtmlSpace(str.at(position))) {
+                    ++position;
+                }
+                value = str.mid(valueStart, position - valueStart);
+            }
+        }
+        QString decodedValue;
+        if (!decodeEntities(value, decodedValue)) {
+            return false;
+        }
+        attributes.insert(name, decodedValue);
+    }
+}
+
+// Same scale as the css font size keywords in QTextDocument
+qreal fontSizeScale(QStringView keyword)
+{
+    if (keyword == "small"_L1) {
+        return 0.8;
+    } else if (keyword == "medium"_L1) {
+        return 1.0;
+    } else if (keyword == "large"_L1) {
+        return 1.2;
+    } else if (keyword == "x-large"_L1) {
+        return 1.5;
+    } else if (keyword == "xx-large"_L1) {
+        return 2.0;
+    }
+    return 0;
+}
+
+void setFontSizeScale(QTextCharFormat &format, const QFont &font, qreal scale)
+{
+    if (font.pointSizeF() > 0) {
+        format.setFontPointSize(font.pointSizeF() * scale);
+    } else {
+        format.setProperty(QTextFormat::FontPixelSize, qRound(font.pixelSize() * scale));
+    }
+}
+
+bool applyStyle(const QString &style, const QFont &font, QTextCharFormat &format)
+{
+    const QList<QStringView> declarations = QStringView(style).split(u';', Qt::SkipEmptyParts);
+    for (const QStringView declaration : declarations) {
+        const qsizetype colon = declaration.indexOf(u':');
+        if (colon == -1) {
+            if (declaration.trimmed().isEmpty()) {
+                continue;
+            }
+            return false;
+        }
+        const QStringView property = declaration.left(colon).trimmed();
+        const QStringView value = declaration.mid(colon + 1).trimmed();
+        if (property == "color"_L1 || property == "background-color"_L1) {
+            const QColor color = QColor::fromString(value);
+            if (!color.isValid()) {
+                return false;
+            }
+            if (property == "color"_L1) {
+                format.setForeground(color);
+            } else {
+                format.setBackground(color);
+            }
+        } else if (property == "font-weight"_L1) {
+            if (value == "bold"_L1) {
+                format.setFontWeight(QFont::Bold);
+            } else if (value == "normal"_L1) {
+                format.setFontWeight(QFont::Normal);
+            } else {
+                bool ok = false;
+                const int weight = value.toInt(&ok);
+                if (!ok) {
+                    return false;
+                }
+                format.setFontWeight(weight);
+            }
+        } else if (property == "font-style"_L1) {
+            format.setFontItalic(value == "italic"_L1);
+        } else if (property == "font"_L1) {
+            // "<size keyword> <family>", used by unicode emojis
+            const qsizetype space = value.indexOf(u' ');
+            const qreal scale = fontSizeScale(value.left(space));
+            if (space == -1 || scale == 0) {
+                return false;
+            }
+            QStringList families;
+            const QList<QStringView> familyNames = value.mid(space + 1).split(u',', Qt::SkipEmptyParts);
+            for (QStringView family : familyNames) {
+                family = family.trimmed();
+                if (family.size() > 1 && (family.startsWith(u'"') || family.startsWith(u'\''))) {
+                    family = family.mid(1, family.size() - 2);
+                }
+                families.append(family.toString());
+            }
+            setFontSizeScale(format, font, scale);
+            format.setFontFamilies(families);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool applyTag(const QString &name, const QHash<QString, QString> &attributes, const QFont &font, QTextCharFormat &format)
+{
+    if (name == "strong"_L1 || name == "b"_L1) {
+        format.setFontWeight(QFont::Bold);
+    } else if (name == "em"_L1 || name == "i"_L1) {
+        format.setFontItalic(true);
+    } else if (name == "s"_L1 || name == "del"_L1) {
+        format.setFontStrikeOut(true);
+    } else if (name == "u"_L1) {
+        format.setFontUnderline(true);
+    } else if (name == "code"_L1) {
+        format.setFontFixedPitch(true);
+        format.setFontFamilies(QFontDatabase::systemFont(QFontDatabase::FixedFont).families());
+    } else if (name == "a"_L1) {
+        const QString href = attributes.value(u"href"_s);
+        if (!href.isEmpty()) {
+            // Same as QTextDocument
+            format.setAnchor(true);
+            format.setAnchorHref(href);
+            format.setFontUnderline(true);
+            format.setForeground(QGuiApplication::palette().link());
+        }
+    } else if (name != "span"_L1) {
+        return false;
+    }
+    const QString title = attributes.value(u"title"_s);
+    if (!title.isEmpty()) {
+        format.setToolTip(title);
+    }
+    const QString style = attributes.value(u"style"_s);
+    return style.isEmpty() || applyStyle(style, font, format);
+}
+}
+
+MessageTextLayout::MessageTextLayout() = default;
+
+MessageTextLayout::~MessageTextLayout() = default;
+
+std::unique_ptr<MessageTextLayout> MessageTextLayout::create(const QString &html, const QFont &font)
+{
+    std::vector<ParsedParagraph> paragraphs;
+    QList<OpenTag> openTags;
+    bool inParagraph = false;
+    // Collapse white spaces as QTextDocument: none at the beginning of a line, only one between words
+    bool skipWhiteSpace = true;
+    QString buffer;
+
+    const auto flush = [&]() {
+        if (buffer.isEmpty()) {
+            return;
+        }
+        if (!inParagraph) {
+            // Text outside of <p>: anonymous block without margins
+            paragraphs.emplace_back();
+            inParagraph = true;
+        }
+        ParsedParagraph &paragraph = paragraphs.back();
+        const int start = paragraph.text.size();
+        paragraph.text += buffer;
+        const QTextCharFormat format = openTags.isEmpty() ? QTextCharFormat() : openTags.constLast().format;
+        if (!paragraph.formats.isEmpty() && paragraph.formats.constLast().format == format) {
+            paragraph.formats.last().length += buffer.size();
+        } else {
+            paragraph.formats.append({start, static_cast<int>(buffer.size()), format});
+        }
+        buffer.clear();
+    };
+
+    const QStringView htmlView(html);
+    qsizetype position = 0;
+    while (position < htmlView.size()) {
+        const QChar c = htmlView.at(position);
+        if (c == u'<') {
+            if (htmlView.mid(position).startsWith("<!--"_L1)) {
+                // Comments are markers (ex: code block not highlighted yet)
+                return {};
+            }
+            // Look for the end of the tag outside of attribute values
+            qsizetype end = position + 1;
+            QChar quote;
+            for (; end < htmlView.size(); ++end) {
+                const QChar ch = htmlView.at(end);
+                if (!quote.isNull()) {
+                    if (ch == quote) {
+                        quote = QChar();
+                    }
+                } else if (ch == u'\'' || ch == u'"') {
+                    quote = ch;
+                } else if (ch == u'>') {
+                    break;
+                }
+            }
+            if (end >= htmlView.size()) {
+                return {};
+            }
+            QStringView tag = htmlView.mid(position + 1, end - position - 1).trimmed();
+            position = end + 1;
+            const bool closing = tag.startsWith(u'/');
+            if (closing) {
+                tag = tag.mid(1);
+            }
+            if (tag.endsWith(u'/')) {
+                tag.chop(1);
+            }
+            qsizetype nameEnd = 0;
+            while (nameEnd < tag.size() && !isHtmlSpace(tag.at(nameEnd))) {
+                ++nameEnd;
+            }
+            const QString name = tag.left(nameEnd).toString().toLower();
+
+            flush();
+            if (name == "qt"_L1) {
+                continue;
+            } else if (name == "br"_L1) {
+                buffer += QChar(QChar::LineSeparator);
+                skipWhiteSpace = true;
+            } else if (name == "p"_L1) {
+                if (!openTags.isEmpty()) {
+                    return {};
+                }
+                if (closing) {
+                    inParagraph = false;
+                } else {
+                    paragraphs.emplace_back();
+                    paragraphs.back().hasMargins = true;
+                    inParagraph = true;
+                }
+                skipWhiteSpace = true;
+            } else if (closing) {
+                if (openTags.isEmpty() || openTags.constLast().name != name) {
+                    return {};
+                }
+                openTags.removeLast();
+            } else {
+                QHash<QString, QString> attributes;
+                if (!parseAttributes(tag.mid(nameEnd), attributes)) {
+                    return {};
+                }
+                OpenTag openTag;
+                openTag.name = name;
+                openTag.format = openTags.isEmpty() ? QTextCharFormat() : openTags.constLast().format;
+                if (!applyTag(name, attributes, font, openTag.format)) {
+                    return {};
+                }
+                openTags.append(std::move(openTag));
+            }
+        } else if (c == u'&') {
+            if (!decodeEntity(htmlView, position, buffer)) {
+                return {};
+            }
+            skipWhiteSpace = false;
+        } else {
+            ++position;
+            if (isHtmlSpace(c)) {
+                if (skipWhiteSpace) {
+                    continue;
+                }
+                buffer += u' ';
+                skipWhiteSpace = true;
+            } else {
+                buffer += c;
+                skipWhiteSpace = false;
+            }
+        }
+    }
+    flush();
+    if (paragraphs.empty()) {
+        return {};
+    }
+
+    std::unique_ptr<MessageTextLayout> result(new MessageTextLayout);
+    result->mFont = font;
+    result->mParagraphSpacing = paragraphSpacing(font);
+    QTextOption textOption;
+    textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    int documentPosition = 0;
+    result->mParagraphs.reserve(paragraphs.size());
+    for (ParsedParagraph &parsed : paragraphs) {
+        Paragraph paragraph;
+        paragraph.layout = std::make_unique<QTextLayout>(parsed.text, font);
+        paragraph.layout->setTextOption(textOption);
+        paragraph.layout->setFormats(parsed.formats);
+        paragraph.layout->setCacheEnabled(true);
+        paragraph.position = documentPosition;
+        paragraph.hasMargins = parsed.hasMargins;
+        // +1: block separator
+        documentPosition += parsed.text.size() + 1;
+        result->mParagraphs.push_back(std::move(paragraph));
+    }
+    result->setTextWidth(-1);
+    return result;
+}
+
+qreal MessageTextLayout::paragraphSpacing(const QFont &font)
+{
+    // Only used from the gui thread
+    static QHash<QString, qreal> spacings;
+    const QString key = font.key();
+    const auto it = spacings.constFind(key);
+    if (it != spacings.constEnd()) {
+        return it.value();
+    }
+    auto documentHeight = [&font](const QString &html) {
+        QTextDocument document;
+        document.setDefaultFont(font);
+        document.setHtml(html);
+        QTextFrame *frame = document.rootFrame();
+        QTextFrameFormat frameFormat = frame->frameFormat();
+        frameFormat.setMargin(0);
+        frame->setFrameFormat(frameFormat);
+        return document.size().height();
+    };
+    // Same lines, only the paragraph break differs
+    const qreal spacing = qMax<qreal>(0, documentHeight(u"<p>a</p><p>a</p>"_s) - documentHeight(u"<p>a<br />a</p>"_s));
+    spacings.insert(key, spacing);
+    return spacing;
+}
+
+void MessageTextLayout::setTextWidth(int width)
+{
+    if (width == mTextWidth) {
+        return;
+    }
+    mTextWidth = width;
+    const qreal lineWidth = width < 0 ? noWrapLineWidth : width;
+    qreal y = 0;
+    qreal idealWidth = 0;
+    const Paragraph *previous = nullptr;
+    for (Paragraph &paragraph : mParagraphs) {
+        if (previous && (previous->hasMargins || paragraph.hasMargins)) {
+            y += mParagraphSpacing;
+        }
+        paragraph.top = y;
+        QTextLayout *layout = paragraph.layout.get();
+        qreal height = 0;
+        layout->beginLayout();
+        while (true) {
+            QTextLine line = layout->createLine();
+            if (!line.isValid()) {
+                break;
+            }
+            line.setLineWidth(lineWidth);
+            line.setPosition(QPointF(0, height));
+            height += line.height();
+            idealWidth = qMax(idealWidth, line.naturalTextWidth());
+        }
+        layout->endLayout();
+        paragraph.height = height;
+        y += height;
+        previous = &paragraph;
+    }
+    mHeight = y;
+    mIdealWidth = qCeil(idealWidth);
+}
+
+int MessageTextLayout::textWidth() const
+{
+    return mTextWidth;
+}
+
+QSize MessageTextLayout::size() const
+{
+    return {mIdealWidth, qCeil(mHeight)};
+}
+
+qreal MessageTextLayout::baseLine() const
+{
+    const Paragraph &paragraph = mParagraphs.front();
+    if (paragraph.layout->lineCount() == 0) {
+        return 0;
+    }
+    const QTextLine line = paragraph.layout->lineAt(0);
+    return paragraph.top + line.y() + line.ascent();
+}
+
+const MessageTextLayout::Paragraph *MessageTextLayout::paragraphAt(qreal y, bool fuzzy) const
+{
+    for (const Paragraph &paragraph : mParagraphs) {
+        if (y < paragraph.top + paragraph.height) {
+            return (fuzzy || y >= paragraph.top) ? &paragraph : nullptr;
+        }
+    }
+    return fuzzy ? &mParagraphs.back() : nullptr;
+}
+
+int MessageTextLayout::hitTest(QPoint pos, Qt::HitTestAccuracy accuracy, const Paragraph **foundParagraph) const
+{
+    const bool fuzzy = accuracy == Qt::FuzzyHit;
+    const Paragraph *paragraph = paragraphAt(pos.y(), fuzzy);
+    if (!paragraph) {
+        return -1;
+    }
+    const qreal y = pos.y() - paragraph->top;
+    const QTextLayout *layout = paragraph->layout.get();
+    const int lineCount = layout->lineCount();
+    for (int i = 0; i < lineCount; ++i) {
+        const QTextLine line = layout->lineAt(i);
+        if (y < line.y() + line.height() || (fuzzy && i == lineCount - 1)) {
+            if (fuzzy) {
+                if (foundParagraph) {
+                    *foundParagraph = paragraph;
+                }
+                return paragraph->position + line.xToCursor(pos.x(), QTextLine::CursorBetweenCharacters);
+            }
+            if (y < line.y() || pos.x() < line.x() || pos.x() > line.x() + line.naturalTextWidth()) {
+                return -1;
+            }
+            if (foundParagraph) {
+                *foundParagraph = paragraph;
+            }
+            return paragraph->position + line.xToCursor(pos.x(), QTextLine::CursorOnCharacter);
+        }
+    }
+    return -1;
+}
+
+int MessageTextLayout::hitTest(QPoint pos, Qt::HitTestAccuracy accuracy) const
+{
+    return hitTest(pos, accuracy, nullptr);
+}
+
+QTextCharFormat MessageTextLayout::formatAt(QPoint pos) const
+{
+    const Paragraph *paragraph = nullptr;
+    const int position = hitTest(pos, Qt::ExactHit, &paragraph);
+    if (position == -1) {
+        return {};
+    }
+    const int charPosition = position - paragraph->position;
+    const QList<QTextLayout::FormatRange> formats = paragraph->layout->formats();
+    for (const QTextLayout::FormatRange &range : formats) {
+        if (charPosition >= range.start && charPosition < range.start + range.length) {
+            return range.format;
+        }
+    }
+    return {};
+}
+
+QString MessageTextLayout::anchorAt(QPoint pos) const
+{
+    return formatAt(pos).anchorHref();
+}
+
+QString MessageTextLayout::toPlainText() const
+{
+    QString text;
+    for (const Paragraph &paragraph : mParagraphs) {
+        if (paragraph.position > 0) {
+            text += u'\n';
+        }
+        text += paragraph.layout->text();
+    }
+    text.replace(QChar(QChar::LineSeparator), u'\n');
+    text.replace(QChar(QChar::Nbsp), u' ');
+    return text;
+}
+
+int MessageTextLayout::paragraphCount() const
+{
+    return mParagraphs.size();
+}
+
+void MessageTextLayout::draw(QPainter *painter, QPointF topLeft, const QColor &textColor, const QPalette &palette, int selectionStart, int selectionEnd) const
+{
+    painter->save();
+    painter->setPen(textColor);
+    QTextCharFormat selectionFormat;
+    selectionFormat.setBackground(palette.brush(QPalette::Highlight));
+    selectionFormat.setForeground(palette.brush(QPalette::HighlightedText));
+    for (const Paragraph &paragraph : mParagraphs) {
+        QList<QTextLayout::FormatRange> selections;
+        if (selectionStart != -1 && selectionEnd > selectionStart) {
+            const int start = qMax(selectionStart - paragraph.position, 0);
+            const int end = qMin(selectionEnd - paragraph.position, static_cast<int>(paragraph.layout->text().size()));
+            if (start < end) {
+                selections.append({start, end - start, selectionFormat});
+            }
+        }
+        paragraph.layout->draw(painter, topLeft + QPointF(0, paragraph.top), selections);
+    }
+    painter->restore();
+}
@@ -0,0 +1,87 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolawidgets_private_export.h"
+#include <QFont>
+#include <QList>
+#include <QPoint>
+#include <QSize>
+#include <QTextCharFormat>
+#include <memory>
+#include <vector>
+
+class QColor;
+class QPainter;
+class QPalette;
+class QTextLayout;
+
+/**
+ * Lightweight replacement of QTextDocument for the common messages: paragraphs, line breaks,
+ * inline styles, links, unicode emojis and code spans.
+ * Html is parsed once into a few QTextLayout (one per paragraph), line breaks are computed
+ * again only when the width changes.
+ * Character positions are the same as in the QTextDocument created from the same html,
+ * so text selection can still use the document.
+ */
+class LIBRUQOLAWIDGETS_TESTS_EXPORT MessageTextLayout
+{
+public:
+    ~MessageTextLayout();
+
+    /**
+     * Returns nullptr when @p html uses something else than the supported subset
+     * (tables, lists, images...): QTextDocument must be used.
+     */
+    [[nodiscard]] static std::unique_ptr<MessageTextLayout> create(const QString &html, const QFont &font);
+
+    void setTextWidth(int width);
+    [[nodiscard]] int textWidth() const;
+
+    // Ideal width and height, as QTextDocument::idealWidth() and QTextDocument::size()
+    [[nodiscard]] QSize size() const;
+    // Baseline of the first line
+    [[nodiscard]] qreal baseLine() const;
+
+    // Returns -1 when there is no character at @p pos
+    [[nodiscard]] int hitTest(QPoint pos, Qt::HitTestAccuracy accuracy) const;
+    [[nodiscard]] QTextCharFormat formatAt(QPoint pos) const;
+    [[nodiscard]] QString anchorAt(QPoint pos) const;
+
+    // Same as QTextDocument::toPlainText()
+    [[nodiscard]] QString toPlainText() const;
+    [[nodiscard]] int paragraphCount() const;
+
+    /**
+     * Draws text at @p topLeft, characters from @p selectionStart to @p selectionEnd
+     * are drawn with palette highlight colors.
+     */
+    void draw(QPainter *painter, QPointF topLeft, const QColor &textColor, const QPalette &palette, int selectionStart = -1, int selectionEnd = -1) const;
+
+    // Space between two <p> in a QTextDocument using @p font, computed once per font
+    [[nodiscard]] static qreal paragraphSpacing(const QFont &font);
+
+private:
+    struct Paragraph {
+        std::unique_ptr<QTextLayout> layout;
+        // Position of the first character in the document
+        int position = 0;
+        qreal top = 0;
+        qreal height = 0;
+        bool hasMargins = false;
+    };
+    MessageTextLayout();
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT const Paragraph *paragraphAt(qreal y, bool fuzzy) const;
+    [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT int hitTest(QPoint pos, Qt::HitTestAccuracy accuracy, const Paragraph **paragraph) const;
+
+    std::vector<Paragraph> mParagraphs;
+    QFont mFont;
+    int mTextWidth = -2;
+    int mIdealWidth = 0;
+    qreal mHeight = 0;
+    qreal mParagraphSpacing = 0;
+};
@@ -0,0 +1,132 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "messagelistprerenderer.h"
+#include "misc/messagelistviewbase.h"
+#include "room/delegate/messagelistdelegate.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+MessageListPreRenderer::MessageListPreRenderer(MessageListViewBase *view, MessageListDelegate *delegate, QObject *parent)
+    : QObject(parent)
+    , mListView(view)
+    , mDelegate(delegate)
+    , mTimer(new QTimer(this))
+{
+    // Interval 0: run as soon as the event loop has nothing else to do
+    mTimer->setSingleShot(true);
+    mTimer->setInterval(0);
+    connect(mTimer, &QTimer::timeout, this, &MessageListPreRenderer::slotPreRenderRows);
+}
+
+MessageListPreRenderer::~MessageListPreRenderer() = default;
+
+void MessageListPreRenderer::schedule()
+{
+    mNeedRefill = true;
+    if (!mTimer->isActive()) {
+        mTimer->start();
+    }
+}
+
+void MessageListPreRenderer::cancel()
+{
+    mTimer->stop();
+    mPendingIndexes.clear();
+    mNeedRefill = false;
+}
+
+bool MessageListPreRenderer::isActive() const
+{
+    return mTimer->isActive();
+}
+
+int MessageListPreRenderer::rowsAroundViewport() const
+{
+    return mRowsAroundViewport;
+}
+
+void MessageListPreRenderer::setRowsAroundViewport(int rows)
+{
+    mRowsAroundViewport = rows;
+}
+
+int MessageListPreRenderer::timeBudget() const
+{
+    return mTimeBudget;
+}
+
+void MessageListPreRenderer::setTimeBudget(int ms)
+{
+    mTimeBudget = ms;
+}
+
+int MessageListPreRenderer::pendingRowsCount() const
+{
+    return mPendingIndexes.count();
+}
+
+void MessageListPreRenderer::fillPendingRows()
+{
+    mPendingIndexes.clear();
+    const QAbstractItemModel *model = mListView->model();
+    if (!model || !mListView->isVisible() || mRowsAroundViewport <= 0) {
+        return;
+    }
+    const int rowCount = model->rowCount();
+    if (rowCount == 0) {
+        return;
+    }
+    const QRect viewportRect = mListView->viewport()->rect();
+    const QModelIndex firstVisibleIndex = mListView->indexAt(viewportRect.topLeft());
+    const QModelIndex lastVisibleIndex = mListView->indexAt(viewportRect.bottomLeft());
+    const int firstVisibleRow = firstVisibleIndex.isValid() ? firstVisibleIndex.row() : 0;
+    const int lastVisibleRow = lastVisibleIndex.isValid() ? lastVisibleIndex.row() : rowCount - 1;
+
+    // Closest rows first, alternating between the rows below and above the viewport
+    mPendingIndexes.reserve(2 * mRowsAroundViewport);
+    for (int i = 1; i <= mRowsAroundViewport; ++i) {
+        const int belowRow = lastVisibleRow + i;
+        if (belowRow < rowCount) {
+            mPendingIndexes.append(QPersistentModelIndex(model->index(belowRow, 0)));
+        }
+        const int aboveRow = firstVisibleRow - i;
+        if (aboveRow >= 0) {
+            mPendingIndexes.append(QPersistentModelIndex(model->index(aboveRow, 0)));
+        }
+    }
+}
+
+void MessageListPreRenderer::slotPreRenderRows()
+{
+    if (mNeedRefill) {
+        mNeedRefill = false;
+        fillPendingRows();
+    }
+    if (mPendingIndexes.isEmpty()) {
+        return;
+    }
+
+    QStyleOptionViewItem option = mListView->listViewOptions();
+    // Same as QListView when it asks for a sizehint
+    option.rect = mListView->viewport()->rect();
+
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    while (!mPendingIndexes.isEmpty() && elapsedTimer.elapsed() < mTimeBudget) {
+        const QPersistentModelIndex index = mPendingIndexes.takeFirst();
+        if (index.isValid()) {
+            mDelegate->preRender(option, index);
+        }
+    }
+    if (!mPendingIndexes.isEmpty()) {
+        // Give the hand back to the event loop and continue in next slice
+        mTimer->start();
+    }
+}
+
+#include "moc_messagelistprerenderer.cpp"
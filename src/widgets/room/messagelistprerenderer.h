@@ -0,0 +1,52 @@
+/*
+   SPDX-FileCopyrightText: 2026 Laurent Montel <montel@kde.org>
+
+   SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "libruqolawidgets_private_export.h"
+#include <QList>
+#include <QObject>
+#include <QPersistentModelIndex>
+class QTimer;
+class MessageListViewBase;
+class MessageListDelegate;
+/**
+ * Warms the delegate caches (converted text, QTextDocument, size hint) for the rows
+ * just above and below the viewport, during idle time and within a time budget per
+ * event loop slice, so that scrolling hits already laid out messages.
+ */
+class LIBRUQOLAWIDGETS_TESTS_EXPORT MessageListPreRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageListPreRenderer(MessageListViewBase *view, MessageListDelegate *delegate, QObject *parent = nullptr);
+    ~MessageListPreRenderer() override;
+
+    void schedule();
+    void cancel();
+
+    [[nodiscard]] bool isActive() const;
+
+    [[nodiscard]] int rowsAroundViewport() const;
+    void setRowsAroundViewport(int rows);
+
+    // Time budget in ms for each event loop slice
+    [[nodiscard]] int timeBudget() const;
+    void setTimeBudget(int ms);
+
+    [[nodiscard]] int pendingRowsCount() const;
+
+private:
+    LIBRUQOLAWIDGETS_NO_EXPORT void slotPreRenderRows();
+    LIBRUQOLAWIDGETS_NO_EXPORT void fillPendingRows();
+    MessageListViewBase *const mListView;
+    MessageListDelegate *const mDelegate;
+    QTimer *const mTimer;
+    QList<QPersistentModelIndex> mPendingIndexes;
+    int mRowsAroundViewport = 8;
+    int mTimeBudget = 5;
+    bool mNeedRefill = false;
+};
@@ -22,6 +22,7 @@
 #include "delegate/messagelistdelegate.h"
 #include "dialogs/directchannelinfodialog.h"
 #include "dialogs/reportmessagedialog.h"
+#include "messagelistprerenderer.h"
 #include "moderation/moderationreportsjob.h"
 #include "rocketchataccount.h"
 #include "room.h"
@@ -42,7 +43,9 @@
 #include <QKeyEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QScopedValueRollback>
 #include <QScrollBar>
+#include <QTimer>
 
 #include "config-ruqola.h"
 
@@ -54,11 +57,15 @@
 #include <TextTranslator/TranslatorMenu>
 #endif
 using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
 
 MessageListView::MessageListView(RocketChatAccount *account, Mode mode, QWidget *parent)
     : MessageListViewBase(parent)
     , mMode(mode)
     , mMessageListDelegate(new MessageListDelegate(account, this))
+    , mMessageListPreRenderer(new MessageListPreRenderer(this, mMessageListDelegate, this))
+    , mCancelHiddenDownloadsTimer(new QTimer(this))
+    , mMeasureVisibleRowsTimer(new QTimer(this))
     , mCurrentRocketChatAccount(account)
 {
     if (mCurrentRocketChatAccount) {
@@ -67,8 +74,25 @@ MessageListView::MessageListView(RocketChatAccount *account, Mode mode, QWidget
     mMessageListDelegate->setShowThreadContext(mMode != Mode::ThreadEditing);
     mMessageListDelegate->setEnableEmojiMenu(mMode != Mode::Moderation);
     setItemDelegate(mMessageListDelegate);
+#if USE_SIZEHINT_CACHE_SUPPORT
+    // Only visible messages are measured, the others use an estimated height
+    mMessageListDelegate->setEstimateSizeHints(true);
+    // Delayed: these signals are emitted while QListView lays out items, and several times while scrolling
+    mMeasureVisibleRowsTimer->setSingleShot(true);
+    mMeasureVisibleRowsTimer->setInterval(0);
+    connect(mMeasureVisibleRowsTimer, &QTimer::timeout, this, &MessageListView::measureVisibleRows);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, mMeasureVisibleRowsTimer, qOverload<>(&QTimer::start));
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged, mMeasureVisibleRowsTimer, qOverload<>(&QTimer::start));
+#endif
 
     connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &MessageListView::slotVerticalScrollbarChanged);
+    // Keep rows around the viewport warm when we scroll
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, mMessageListPreRenderer, &MessageListPreRenderer::schedule);
+    // When scrolling stops, files of the rows which scrolled out of view are not downloaded anymore
+    mCancelHiddenDownloadsTimer->setSingleShot(true);
+    mCancelHiddenDownloadsTimer->setInterval(300ms);
+    connect(mCancelHiddenDownloadsTimer, &QTimer::timeout, this, &MessageListView::slotCancelHiddenDownloads);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, mCancelHiddenDownloadsTimer, qOverload<>(&QTimer::start));
 
     // ensure the scrolling behavior isn't jumpy
     // we always single step by roughly one line
@@ -82,10 +106,15 @@ MessageListView::MessageListView(RocketChatAccount *account, Mode mode, QWidget
     connect(mMessageListDelegate, &MessageListDelegate::startPrivateConversation, this, &MessageListView::slotStartPrivateConversation);
     connect(mMessageListDelegate, &MessageListDelegate::updateView, this, &MessageListView::slotUpdateView);
     connect(mMessageListDelegate, &MessageListDelegate::replyToThread, this, &MessageListView::replyInThreadRequested);
-    connect(this, &MessageListView::needToClearSizeHintCache, mMessageListDelegate, &MessageListDelegate::clearSizeHintCache);
+    // No need to clear size hints when resizing: they are stored per width bucket, visible messages are measured at their exact width
 }
 
-MessageListView::~MessageListView() = default;
+MessageListView::~MessageListView()
+{
+    if (mCurrentRocketChatAccount) {
+        mCurrentRocketChatAccount->cancelPendingMessageDownloads(this);
+    }
+}
 
 void MessageListView::wheelEvent(QWheelEvent *e)
 {
@@ -112,7 +141,14 @@ void MessageListView::paintEvent(QPaintEvent *e)
             p.drawText(QRect(0, 0, width(), height()), Qt::AlignHCenter | Qt::AlignTop, i18n("Start of conversation"));
         }
     } else {
+        // Files requested by the delegate while painting are downloaded for this view
+        if (mCurrentRocketChatAccount) {
+            mCurrentRocketChatAccount->setDownloadRequester(this);
+        }
         QListView::paintEvent(e);
+        if (mCurrentRocketChatAccount) {
+            mCurrentRocketChatAccount->setDownloadRequester(nullptr);
+        }
     }
 }
 
@@ -142,6 +178,63 @@ void MessageListView::slotVerticalScrollbarChanged(int value)
     }
 }
 
+void MessageListView::slotCancelHiddenDownloads()
+{
+    if (!mCurrentRocketChatAccount) {
+        return;
+    }
+    mCurrentRocketChatAccount->cancelPendingMessageDownloads(this);
+    // Visible rows request their files again when they are painted
+    viewport()->update();
+}
+
+void MessageListView::measureVisibleRows()
+{
+    if (mMeasuringVisibleRows || !model() || !mMessageListDelegate->estimateSizeHints()) {
+        return;
+    }
+    const QScopedValueRollback<bool> guard(mMeasuringVisibleRows, true);
+    const QRect viewportRect = viewport()->rect();
+    const QModelIndex firstVisibleIndex = indexAt(viewportRect.topLeft());
+    if (!firstVisibleIndex.isValid()) {
+        return;
+    }
+    const QModelIndex lastVisibleIndex = indexAt(viewportRect.bottomLeft());
+    const int rowCount = model()->rowCount();
+    const int lastVisibleRow = lastVisibleIndex.isValid() ? lastVisibleIndex.row() : rowCount - 1;
+    // Rows which scroll in during the next viewport are measured too: the items are laid out again
+    // once for all of them, not on each scroll step
+    const int visibleRowCount = lastVisibleRow - firstVisibleIndex.row() + 1;
+    const int firstRow = qMax(0, firstVisibleIndex.row() - visibleRowCount);
+    const int lastRow = qMin(rowCount - 1, lastVisibleRow + visibleRowCount);
+    QStyleOptionViewItem option = listViewOptions();
+    // Same as QListView when it asks for a sizehint
+    option.rect = viewportRect;
+    bool estimatedRowFound = false;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const QModelIndex index = model()->index(row, 0);
+        const QSize size = mMessageListDelegate->measuredSizeHint(option, index);
+        if (!size.isEmpty() && size.height() != visualRect(index).height()) {
+            estimatedRowFound = true;
+        }
+    }
+    if (!estimatedRowFound) {
+        return;
+    }
+    // Layout again with real heights, first visible message must not move.
+    // Other rows keep their fixed estimation: the range only changes by the difference of the measured rows.
+    auto *vbar = verticalScrollBar();
+    const bool atBottom = vbar->value() == vbar->maximum();
+    const QPersistentModelIndex anchorIndex(firstVisibleIndex);
+    const int anchorTop = visualRect(firstVisibleIndex).top();
+    doItemsLayout();
+    if (atBottom) {
+        scrollToBottom();
+    } else if (anchorIndex.isValid()) {
+        vbar->setValue(vbar->value() + visualRect(anchorIndex).top() - anchorTop);
+    }
+}
+
 void MessageListView::goToMessage(const QByteArray &messageId)
 {
     auto messageModel = qobject_cast<MessagesModel *>(model());
@@ -173,7 +266,9 @@ void MessageListView::setModel(QAbstractItemModel *newModel)
     QAbstractItemModel *oldModel = model();
     if (oldModel) {
         disconnect(oldModel, nullptr, this, nullptr);
+        disconnect(oldModel, nullptr, mMessageListPreRenderer, nullptr);
     }
+    mMessageListPreRenderer->cancel();
     QListView::setModel(newModel);
     connect(newModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &MessageListView::checkIfAtBottom);
     connect(newModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &MessageListView::checkIfAtBottom);
@@ -185,23 +280,39 @@ void MessageListView::setModel(QAbstractItemModel *newModel)
     connect(newModel, &QAbstractItemModel::rowsInserted, this, &MessageListView::modelChanged);
     connect(newModel, &QAbstractItemModel::rowsRemoved, this, &MessageListView::modelChanged);
     connect(newModel, &QAbstractItemModel::modelReset, this, &MessageListView::modelChanged);
+    // Prepare messages just above and below the viewport once the new rows are laid out
+    connect(newModel, &QAbstractItemModel::rowsInserted, mMessageListPreRenderer, &MessageListPreRenderer::schedule);
+    connect(newModel, &QAbstractItemModel::modelReset, mMessageListPreRenderer, &MessageListPreRenderer::schedule);
     // Clear document cache when message is updated otherwise image description is not up to date
-    connect(newModel, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &, const QList<int> &roles) {
-        if (roles.contains(MessagesModel::OriginalMessageOrAttachmentDescription) || roles.contains(MessagesModel::LocalTranslation)
-            || roles.contains(MessagesModel::ShowTranslatedMessage)) {
-            const Message *message = topLeft.data(MessagesModel::MessagePointer).value<Message *>();
-            if (message) {
-                mMessageListDelegate->removeMessageCache(message);
-            }
-        } else if (roles.contains(MessagesModel::DisplayUrlPreview) || roles.contains(MessagesModel::DisplayAttachment)) {
-            const Message *message = topLeft.data(MessagesModel::MessagePointer).value<Message *>();
-            if (message) {
-                mMessageListDelegate->removeSizeHintCache(message->messageId());
-            }
-        }
-    });
+    // Neighbouring rows can be changed together (see MessagesModel::emitPendingDataChanged)
+    connect(newModel,
+            &QAbstractItemModel::dataChanged,
+            this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+                const bool messageChanged = roles.contains(MessagesModel::OriginalMessageOrAttachmentDescription)
+                    || roles.contains(MessagesModel::LocalTranslation) || roles.contains(MessagesModel::ShowTranslatedMessage)
+                    || roles.contains(MessagesModel::ShowFullMessage);
+                // No role: local change, e.g. an attachment or avatar was downloaded
+                const bool sizeChanged =
+                    roles.isEmpty() || roles.contains(MessagesModel::DisplayUrlPreview) || roles.contains(MessagesModel::DisplayAttachment);
+                if (!messageChanged && !sizeChanged) {
+                    return;
+                }
+                for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                    const Message *message = topLeft.siblingAtRow(row).data(MessagesModel::MessagePointer).value<Message *>();
+                    if (!message) {
+                        continue;
+                    }
+                    if (messageChanged) {
+                        mMessageListDelegate->removeMessageCache(message);
+                    } else {
+                        mMessageListDelegate->removeSizeHintCache(message->messageId());
+                    }
+                }
+            });
 
     scrollToBottom();
+    mMessageListPreRenderer->schedule();
 }
 
 void MessageListView::handleKeyPressEvent(QKeyEvent *ev)
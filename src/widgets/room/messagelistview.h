@@ -11,6 +11,8 @@
 #include "moderation/moderationreportinfos.h"
 #include <QPointer>
 class MessageListDelegate;
+class MessageListPreRenderer;
+class QTimer;
 class RocketChatAccount;
 class Room;
 namespace TextTranslator
@@ -99,11 +101,17 @@ private:
     LIBRUQOLAWIDGETS_NO_EXPORT void createTranslorMenu();
     LIBRUQOLAWIDGETS_NO_EXPORT void slotShowReportInfo(const ModerationReportInfos &info);
     LIBRUQOLAWIDGETS_NO_EXPORT void slotForwardMessage(const QModelIndex &index);
+    LIBRUQOLAWIDGETS_NO_EXPORT void measureVisibleRows();
+    LIBRUQOLAWIDGETS_NO_EXPORT void slotCancelHiddenDownloads();
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT QString selectedText(const QModelIndex &index) override;
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT bool hasSelection() const override;
     QPointer<Room> mRoom;
     const MessageListView::Mode mMode = MessageListView::Mode::Editing;
     MessageListDelegate *const mMessageListDelegate;
+    MessageListPreRenderer *const mMessageListPreRenderer;
+    QTimer *const mCancelHiddenDownloadsTimer;
+    QTimer *const mMeasureVisibleRowsTimer;
     TextTranslator::TranslatorMenu *mTranslatorMenu = nullptr;
     QPointer<RocketChatAccount> mCurrentRocketChatAccount;
+    bool mMeasuringVisibleRows = false;
 };
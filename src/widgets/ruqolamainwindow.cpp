@@ -34,6 +34,7 @@
 #include "importexportdata/exportdata/exportdatawizard.h"
 #include "importexportdata/importdata/importdatawizard.h"
 #include "localdatabase/localmessagelogger.h"
+#include "messages/message.h"
 #include "misc/accountsoverviewwidget.h"
 #include "misc/messagestylelayoutmenu.h"
 #include "misc/servermenu.h"
@@ -1089,6 +1090,15 @@ bool RuqolaMainWindow::queryClose()
     return false;
 }
 
+bool RuqolaMainWindow::event(QEvent *e)
+{
+    if (e->type() == QEvent::LocaleChange) {
+        // Times of the messages are formatted again on next paint
+        Message::clearDisplayTimeCache();
+    }
+    return KXmlGuiWindow::event(e);
+}
+
 void RuqolaMainWindow::slotClose()
 {
     mReallyClose = true;
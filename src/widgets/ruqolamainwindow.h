@@ -47,6 +47,7 @@ public:
 
 protected:
     [[nodiscard]] bool queryClose() override;
+    [[nodiscard]] bool event(QEvent *e) override;
 
 private:
     [[nodiscard]] LIBRUQOLAWIDGETS_NO_EXPORT bool canCreateChannels() const;